@@ -1,14 +1,18 @@
 #pragma once
 #include <optional>
 #include <atomic>
+#include <cstdint>
+#include <limits>
 #include <mutex>
 #include <condition_variable>
 #include <semaphore>
 #include <chrono>
+#include <iterator>
 #include <vector>
 #include <stdexcept>
 #include <thread>
 #include "defer.h"
+#include "spinlock.h"
 
 /// @brief 严格有界MPMC队列
 /// 基于Dmitry Vyukov的MPMC队列
@@ -22,7 +26,7 @@ public:
     /// @brief 构造函数
     /// @param capacity 严格有界队列容量
     explicit BoundMPMCQueue(std::size_t capacity) : capacity_(round_up_to_power_two(capacity))
-    , mask_(capacity_ - 1), buffer_(capacity_), stopped_(false), active_threads_(0){
+    , mask_(capacity_ - 1), stopped_(false), active_threads_(0), buffer_(capacity_) {
         for(std::size_t i = 0; i < capacity_; ++i) {
             buffer_[i].sequence.store(i, std::memory_order_relaxed);
         }
@@ -59,7 +63,11 @@ public:
     /// @return false 入队失败
     template <class U>
     bool try_enqueue(U&& value) {
-        return enqueue_impl(std::forward<U>(value));
+        if (!enqueue_impl(std::forward<U>(value))) {
+            return false;
+        }
+        not_empty_.notify_one();
+        return true;
     }
 
     /// @brief 阻塞入队
@@ -72,33 +80,10 @@ public:
                 exit_thread(); // 确保退出阻塞接口
         });
 
-        // std::unique_lock<std::mutex> lock(mtx_not_full_);
-        auto pred = [&] { return stopped_.load(std::memory_order_acquire) || !is_full(); };
-        // 防止一直阻塞
-        while(!stopped_) {
-            if(enqueue_impl(std::forward<U>(value))) {
-                cv_not_empty_.notify_one();
-                return;
-            }
-            // 快速入队失败 要么队列刚好满了，要么CAS竞争输了
-            std::unique_lock<std::mutex> lk(mtx_not_full_); // CHANGED: 回退到等待
-            cv_not_full_.wait(lk, pred);                    // 等非满或停止
-            if (stopped_.load(std::memory_order_acquire)) { // CHANGED
-                throw std::runtime_error("enqueue_blocking: queue is stopped");
-            }
-            // 循环重试：释放锁后再尝试无锁入队
-            // （不在锁内做CAS，避免把锁当成“全局串行化”）
+        if (!wait_for_op(not_full_, [&] { return enqueue_impl(std::forward<U>(value)); })) {
+            throw std::runtime_error("enqueue_blocking: queue is stopped");
         }
-        // // 等到非满或 stopped
-        // cv_not_full_.wait(lock, pred);
-        // if(stopped_.load(std::memory_order_acquire)) {
-        //     throw std::runtime_error("enqueue_blocking: queue is stopped");
-        // }
-
-        // while(!enqueue_impl(std::forward<U>(value))) {
-        //     // 理论上可以入队
-        // }
-        // cv_not_empty_.notify_one();
+        not_empty_.notify_one();
     }
 
     /// @brief 阻塞入队，超时返回
@@ -113,36 +98,12 @@ public:
         DEFER([&](){
             exit_thread();
         });
-        // std::unique_lock<std::mutex> lock(mtx_not_full_);
-        auto deadline = timeout + std::chrono::steady_clock::now();
-        auto pred = [&] { return stopped_.load(std::memory_order_acquire) || !is_full(); };
-        while(true) { 
-            if (enqueue_impl(std::forward<U>(value))) {     
-                cv_not_empty_.notify_one(); //可以直接换成notify_all(),增加开销防止真正等待的线程死等              
-                return true;
-            }
-            std::unique_lock<std::mutex> lk(mtx_not_full_);
-            if (!cv_not_full_.wait_until(lk, deadline, pred)) {
-                return false; // 超时
-            }
-            if (stopped_.load(std::memory_order_acquire)) {
-                return false;
-            }
+        auto deadline = std::chrono::steady_clock::now() + timeout;
+        if (!wait_for_op(not_full_, [&] { return enqueue_impl(std::forward<U>(value)); }, &deadline)) {
+            return false;
         }
-
-        
-        // if(!cv_not_full_.wait_until(lock, deadline, pred)) {
-        //     return false; // 超时
-        // }
-        // if(stopped_.load(std::memory_order_acquire)) {
-        //     return false;
-        // }
-        // 这里可能会忙等
-        // while(!enqueue_impl(std::forward<U>(value))) {
-        //     // 理论上可以入队
-        // }
-        // cv_not_empty_.notify_one();
-        // return true;
+        not_empty_.notify_one();
+        return true;
     }
 
     /// @brief 尝试出队
@@ -150,36 +111,57 @@ public:
     /// @return true 出队成功
     /// @return false 出队失败
     bool try_dequeue(T& value) {
-        return dequeue_impl(value);
+        if (!dequeue_impl(value)) {
+            return false;
+        }
+        not_full_.notify_one();
+        return true;
+    }
+
+    /// @brief 尝试批量入队
+    /// 一次CAS预留一段连续位置，再依次写入；队列剩余空间不足时只入队前面放得下的部分
+    /// 入队了几个就最多唤醒几个等待的消费者
+    /// @tparam It 前向迭代器，*it可构造T（用std::make_move_iterator可移动入队）
+    /// @param first 起始迭代器
+    /// @param last 结束迭代器
+    /// @return 实际入队的个数，队列满或已停止时为0
+    template <class It>
+    std::size_t try_enqueue_bulk(It first, It last) {
+        std::size_t n = static_cast<std::size_t>(std::distance(first, last));
+        std::size_t count = enqueue_bulk_impl(first, n);
+        if (count > 0) {
+            not_empty_.notify_n(count);
+        }
+        return count;
+    }
+
+    /// @brief 尝试批量出队
+    /// 一次CAS预留一段连续的已写好的位置，再依次取出；腾出几个位置就最多唤醒几个等待的生产者
+    /// @tparam OutIt 输出迭代器
+    /// @param out 出队的值依次写入out
+    /// @param max 最多出队个数
+    /// @return 实际出队的个数，队列空或已停止时为0
+    template <class OutIt>
+    std::size_t try_dequeue_bulk(OutIt out, std::size_t max) {
+        std::size_t count = dequeue_bulk_impl(out, max);
+        if (count > 0) {
+            not_full_.notify_n(count);
+        }
+        return count;
     }
 
     /// @brief 阻塞出队
     /// @param value 出队参数的值 
     void dequeue_blocking(T& value) {
-        // std::unique_lock<std::mutex> lock(mtx_not_empty_);
-        auto pred = [&] { return stopped_.load(std::memory_order_acquire) || !is_empty(); };
-        // 防止一直阻塞
-        while(true) {
-            if(dequeue_impl(value)) {
-                cv_not_full_.notify_one();
-                return;
-            }
-            std::unique_lock<std::mutex> lk(mtx_not_empty_);
-            cv_not_empty_.wait(lk, pred);
-            if (stopped_.load(std::memory_order_acquire)) {
-                throw std::runtime_error("dequeue_blocking: queue is stopped");
-            }
-        }
-
-        // cv_not_empty_.wait(lock, pred);
-        // // 加上判断队列为空，确保数据不丢失
-        // if(stopped_.load(std::memory_order_acquire) && is_empty()) {
-        //     throw std::runtime_error("dequeue_blocking: queue is stopped");
-        // }
+        enter_thread(); // 进入阻塞接口，析构会等它退出
+        DEFER([&]() {
+                exit_thread();
+        });
 
-        // while(!dequeue_impl(value)) {
-        // }
-        // cv_not_full_.notify_one();
+        if (!wait_for_op(not_empty_, [&] { return dequeue_impl(value); })) {
+            throw std::runtime_error("dequeue_blocking: queue is stopped");
+        }
+        not_full_.notify_one();
     }
 
     /// @brief 阻塞出队，超时返回
@@ -193,47 +175,19 @@ public:
         DEFER([&](){
             exit_thread();
         });
-
-        // std::unique_lock<std::mutex> lock(mtx_not_empty_);
-        auto deadline = timeout + std::chrono::steady_clock::now();
-        auto pred = [&] { return stopped_.load(std::memory_order_acquire) || !is_empty(); };
-        // 防止一直阻塞
-        while(true) {
-            if(dequeue_impl(value)) {
-                cv_not_full_.notify_one();
-                return true;
-            }
-            std::unique_lock<std::mutex> lk(mtx_not_empty_);
-            if (!cv_not_empty_.wait_until(lk, deadline, pred)) {
-                return false; // 超时
-            }
-            if (stopped_.load(std::memory_order_acquire)) {
-                return false;
-            }
+        auto deadline = std::chrono::steady_clock::now() + timeout;
+        if (!wait_for_op(not_empty_, [&] { return dequeue_impl(value); }, &deadline)) {
+            return false;
         }
-
-        // if(!cv_not_empty_.wait_until(lock, deadline, pred)) {
-        //     return false; // 超时
-        // }
-        // if(stopped_.load(std::memory_order_acquire)) {
-        //     return false;
-        // }
-
-        // while(!dequeue_impl(value)) {
-        //     // 理论上可以出队
-        // }
-        // cv_not_full_.notify_one();
-        // return true;
+        not_full_.notify_one();
+        return true;
     }
 
     /// @brief 停止队列，防止入队出队
     void stop() {
         stopped_.store(true, std::memory_order_release);
-        // 确保之前的 side effect 可见
-        // std::atomic_thread_fence(std::memory_order_release);
-
-        cv_not_full_.notify_all();
-        cv_not_empty_.notify_all();
+        not_full_.notify_all();
+        not_empty_.notify_all();
     }
 
     /// @brief 队列近似大小
@@ -359,6 +313,12 @@ private:
             if (diff == 0) {
                 // 该槽位可读，尝试出队，出队成功，更新sequence为pos+capacity_
                 if (dequeue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed, std::memory_order_relaxed)) {
+                    if (!cell.value.has_value()) {
+                        // 批量入队构造失败留下的空槽，直接释放并取下一个位置
+                        cell.sequence.store(pos + capacity_, std::memory_order_release);
+                        pos = dequeue_pos_.load(std::memory_order_relaxed);
+                        continue;
+                    }
                      // 写入数据
                     try {
                         value = std::move(cell.value.value());
@@ -391,6 +351,225 @@ private:
         return false;
     }
 
+    /// @brief 批量入队：从enqueue_pos_起数出连续可写的槽位，一次CAS全部预留
+    /// 槽位sequence == 位置号即可写，且只有预留了该位置的生产者能改回去，所以数出来的结果在CAS前不会失效
+    /// @return 实际入队的个数
+    template <class It>
+    std::size_t enqueue_bulk_impl(It first, std::size_t n) {
+        if (n == 0 || stopped_.load(std::memory_order_acquire)) {
+            return 0;
+        }
+        std::size_t pos = enqueue_pos_.load(std::memory_order_relaxed);
+        std::size_t count = 0;
+        while (!stopped_) {
+            std::size_t seq = buffer_[index_of(pos)].sequence.load(std::memory_order_acquire);
+            auto diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+            if (diff < 0) {
+                return 0;   // 队列满了
+            }
+            if (diff > 0) {
+                // 其他生产者已经预留了这个位置，重读pos
+                pos = enqueue_pos_.load(std::memory_order_relaxed);
+                continue;
+            }
+            count = 1;
+            while (count < n && buffer_[index_of(pos + count)].sequence.load(std::memory_order_acquire) == pos + count) {
+                ++count;
+            }
+            if (enqueue_pos_.compare_exchange_weak(pos, pos + count, std::memory_order_relaxed, std::memory_order_relaxed)) {
+                break;
+            }
+            // CAS失败，pos已更新为当前值，重新数
+            count = 0;
+        }
+        if (count == 0) {
+            return 0;
+        }
+
+        // [pos, pos + count)已归本线程，依次写入并发布
+        std::size_t i = 0;
+        try {
+            for (; i < count; ++i, ++first) {
+                Cell& cell = buffer_[index_of(pos + i)];
+                cell.value.emplace(*first);
+                cell.sequence.store(pos + i + 1, std::memory_order_release);
+            }
+        } catch (...) {
+            // 预留的位置无法退回（后面的位置可能已被其他生产者占用），
+            // 剩下的槽位以空值发布，消费者遇到空槽直接跳过
+            for (; i < count; ++i) {
+                buffer_[index_of(pos + i)].sequence.store(pos + i + 1, std::memory_order_release);
+            }
+            throw;
+        }
+        return count;
+    }
+
+    /// @brief 批量出队：从dequeue_pos_起数出连续已写好的槽位，一次CAS全部预留
+    /// @return 实际出队的个数（不含空槽）
+    template <class OutIt>
+    std::size_t dequeue_bulk_impl(OutIt& out, std::size_t max) {
+        while (max > 0 && !stopped_.load(std::memory_order_acquire)) {
+            std::size_t pos = dequeue_pos_.load(std::memory_order_relaxed);
+            std::size_t seq = buffer_[index_of(pos)].sequence.load(std::memory_order_acquire);
+            auto diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos + 1);
+            if (diff < 0) {
+                return 0;   // 队列空了
+            }
+            if (diff > 0) {
+                continue;   // 其他消费者已经取走这个位置
+            }
+            std::size_t count = 1;
+            while (count < max && buffer_[index_of(pos + count)].sequence.load(std::memory_order_acquire) == pos + count + 1) {
+                ++count;
+            }
+            if (!dequeue_pos_.compare_exchange_weak(pos, pos + count, std::memory_order_relaxed, std::memory_order_relaxed)) {
+                continue;
+            }
+
+            std::size_t taken = 0;
+            for (std::size_t i = 0; i < count; ++i) {
+                Cell& cell = buffer_[index_of(pos + i)];
+                if (cell.value.has_value()) {
+                    *out = std::move(*cell.value);
+                    ++out;
+                    cell.value.reset();
+                    ++taken;
+                }
+                cell.sequence.store(pos + i + capacity_, std::memory_order_release);
+            }
+            if (taken > 0) {
+                return taken;
+            }
+            // 整段都是空槽，继续取
+        }
+        return 0;
+    }
+
+    /// @brief 一个等待方向（非空或非满）
+    /// @details 等待方先有限自旋，仍不满足再登记waiters并挂起在seq上（std::atomic::wait）；
+    /// 通知方只在有登记的等待者时才递增seq并唤醒，无人等待时只有一次fence和一次读，不碰锁也不进内核
+    struct alignas(64) WaitPoint {
+        /// @brief 事件序号，挂起的线程等它变化
+        std::atomic<uint32_t> seq{0};
+        /// @brief 已登记（将要或已经挂起）的等待者数量
+        std::atomic<uint32_t> waiters{0};
+        /// @brief 其中带超时的等待者数量：atomic::wait没有超时版本，它们挂在cv上
+        std::atomic<uint32_t> timed_waiters{0};
+        std::mutex mtx;
+        std::condition_variable cv;
+
+        void notify_one() { notify(false); }
+        void notify_all() { notify(true); }
+
+        /// @brief 批量操作后唤醒最多n个等待者：只有一个名额或一个等待者时同notify_one，否则全部唤醒
+        /// @details atomic::wait没有“唤醒n个”的接口，多唤醒的线程重试失败后会重新挂起
+        void notify_n(std::size_t n) {
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            uint32_t w = waiters.load(std::memory_order_relaxed);
+            if (w == 0) {
+                return;
+            }
+            notify(n > 1 && w > 1);
+        }
+
+        void notify(bool all) {
+            // 与等待方登记后的fence配对：要么这里看到登记，要么等待方重试时看到刚完成的操作
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (!all && waiters.load(std::memory_order_relaxed) == 0) {
+                return;
+            }
+            seq.fetch_add(1, std::memory_order_release);
+            if (all) {
+                seq.notify_all();
+            } else {
+                seq.notify_one();
+            }
+            if (all || timed_waiters.load(std::memory_order_relaxed) > 0) {
+                // 等待方在锁内检查seq，持锁通知不会丢失唤醒
+                std::lock_guard<std::mutex> lk(mtx);
+                if (all) {
+                    cv.notify_all();
+                } else {
+                    cv.notify_one();
+                }
+            }
+        }
+    };
+
+    /// @brief 挂起前的自旋次数；单核机器上自旋只会拖延持有者，直接挂起
+    static int spin_count() {
+        static const int spins = std::thread::hardware_concurrency() > 1 ? 512 : 0;
+        return spins;
+    }
+
+    /// @brief 反复尝试op直到成功：先自旋，再挂起在wp上
+    /// @param wp 等待的方向
+    /// @param op 非阻塞操作，成功返回true
+    /// @param deadline 为nullptr时不超时
+    /// @return op是否成功；队列停止或超时返回false
+    template <class Op>
+    bool wait_for_op(WaitPoint& wp, Op&& op, const std::chrono::steady_clock::time_point* deadline = nullptr) {
+        auto expired = [deadline] {
+            return deadline && std::chrono::steady_clock::now() >= *deadline;
+        };
+        if (expired()) {
+            // 已经超时（如timeout为0）：只试一次，不自旋也不挂起
+            return !stopped() && op();
+        }
+        for (int i = 0, n = spin_count(); i < n; ++i) {
+            if (op()) {
+                return true;
+            }
+            if (stopped()) {
+                return false;
+            }
+            // 每16次看一次时钟，短超时不会被整段自旋拖过
+            if ((i & 15) == 15 && expired()) {
+                return false;
+            }
+            cpu_relax();
+        }
+        while (true) {
+            if (op()) {
+                return true;
+            }
+            if (stopped() || expired()) {
+                return false;
+            }
+            // 登记后再取seq并重试一次，之后的通知一定会改变seq
+            wp.waiters.fetch_add(1, std::memory_order_relaxed);
+            if (deadline) {
+                wp.timed_waiters.fetch_add(1, std::memory_order_relaxed);
+            }
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            uint32_t ticket = wp.seq.load(std::memory_order_acquire);
+            bool ready = op();
+            bool timeout = false;
+            if (!ready && !stopped()) {
+                if (!deadline) {
+                    wp.seq.wait(ticket, std::memory_order_acquire);
+                } else {
+                    std::unique_lock<std::mutex> lk(wp.mtx);
+                    timeout = !wp.cv.wait_until(lk, *deadline, [&] {
+                        return wp.seq.load(std::memory_order_acquire) != ticket;
+                    });
+                }
+            }
+            if (deadline) {
+                wp.timed_waiters.fetch_sub(1, std::memory_order_relaxed);
+            }
+            wp.waiters.fetch_sub(1, std::memory_order_relaxed);
+            if (ready) {
+                return true;
+            }
+            if (timeout) {
+                // 超时前最后再试一次
+                return !stopped() && op();
+            }
+        }
+    }
+
     void enter_thread() {
         active_threads_.fetch_add(1, std::memory_order_acq_rel);
     }
@@ -429,33 +608,14 @@ private:
     std::atomic<std::size_t> active_threads_{0};
 
     /// @brief 队列单元格 序号+值
-    struct /*alignas(64)*/ Cell {
+    /// @details 按缓存行对齐，相邻槽位的生产者和消费者不会伪共享
+    struct alignas(64) Cell {
         /// @brief 序列号，标记当前Cell的状态，是否可读写
         /// sequence为n时，表示该单元格“可被生产者写入”，随后更新为n+1“可被消费者读取”
-        /// 消费者读取数据后，会将sequence从n+1改为n+2,标记数据已消费，单元格可复用
+        /// 消费者读取数据后，会将sequence从n+1改为n+capacity,标记数据已消费，单元格可复用
         std::atomic<std::size_t> sequence{0};
         /// @brief 存储的数据
         std::optional<T> value;
-
-        /// @brief 自然对齐需求  alignof(std::optional<T>)只会返回2的幂      
-        static constexpr std::size_t natural_alignment = std::max(std::size_t{64}, alignof(std::optional<T>));
-
-        /// @brief 强制结构体本身被 natural_alignment字节对齐
-        struct alignas(natural_alignment) Impl
-        {
-            std::atomic<std::size_t> sequence{0};
-            std::optional<T> value;
-        };
-
-        /// @brief 真正存储的对象
-        alignas(natural_alignment) Impl impl;
-
-        /// @brief 填充字节到满足 natural_alignment的整数倍
-        char padding_[(natural_alignment - sizeof(Impl) % natural_alignment) % natural_alignment];
-        
-        // 6. 编译期检查
-        static_assert(sizeof(Cell) % natural_alignment == 0, "size must be multiple of alignment");
-        static_assert(alignof(Cell) == natural_alignment,   "alignment mismatch");
     };
 
     /// @brief 队列缓冲区，一次性分配capacity个槽位，保证不会扩容
@@ -467,14 +627,9 @@ private:
     /// @brief 出队位置（分离的原子计数以减少伪共享）
     alignas(64) std::atomic<std::size_t> dequeue_pos_{0};
 
-    /// @brief 用于阻塞等待的条件变量，当队列满时，入队线程阻塞等待
-    mutable std::mutex mtx_not_full_;
-    /// @brief 用于阻塞等待的条件变量，当队列空时，出队线程阻塞等待
-    mutable std::mutex mtx_not_empty_;
-
-    /// @brief 入队位置的条件变量，当队列满时，入队线程阻塞等待
-    std::condition_variable cv_not_full_;
-    /// @brief 出队位置的条件变量，当队列空时，出队线程阻塞等待
-    std::condition_variable cv_not_empty_;
+    /// @brief 队列非空：消费者在此等待
+    WaitPoint not_empty_;
+    /// @brief 队列非满：生产者在此等待
+    WaitPoint not_full_;
 
 };
\ No newline at end of file
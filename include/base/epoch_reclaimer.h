@@ -1,6 +1,9 @@
 #pragma once
+#include <algorithm>
 #include <atomic>
 #include <cstdint>
+#include <memory>
+#include <thread>
 #include <vector>
 
 class EpochReclaimer {
@@ -14,14 +17,21 @@ public:
     };
 
     /// @brief 描述一个参与内存回收的线程的状态
-    struct Participant {
+    /// @details 按缓存行对齐：每次进出临界区都会写local_epoch/active，避免和其他线程的节点伪共享
+    struct alignas(64) Participant {
         std::atomic<Epoch> local_epoch{0};  // 线程进入临界区时记录的epoch
-        std::atomic<bool> active{true};     // 线程是否活跃（是否在访问共享结构）
+        std::atomic<bool> active{false};    // 线程是否活跃（是否在访问共享结构）
         // 将要回收的对象分桶，方便在”落后两代“时整体回收
+        // 只有所属线程读写自己的桶，回收时不会和其他线程重复释放
         std::vector<RetiredBase> retired[3]; // 线程当前活跃的epoch的待回收对象,分桶存放
         Participant* next{nullptr}; // 链接到全局参与者链表, 全局参与者链表是一个环形链表
+        std::thread::id owner;      // 所属线程，线程在多个回收器间切换时据此找回自己的节点
+        std::weak_ptr<void> alive;  // 所属线程的存活标记，注册时写入；失效后桶由推进epoch的线程代为回收
+        std::atomic<bool> adopting{false}; // 代为回收时的互斥
+        std::atomic<bool> drained{false};  // 所属线程已退出且桶已清空，不再检查
 
         uint32_t probe_counter{0};// 周期性探测，避免长时间不触发推进
+        uint32_t pending_retired{0};// 尚未计入global_retired_count_的退休数
     };
 
     /// @brief 守卫对象，用于线程注册和注销
@@ -42,8 +52,8 @@ public:
     };
 
     /// @brief 使用CAS把本线程的Participant节点挂到participants头上，
-    /// 并保存在thread_local tls_participant_中，只注册一次
-    /// @return 本线程的Participant节点
+    /// 并记入thread_local的tls_slots_，每个回收器只注册一次
+    /// @return 本线程在本回收器中的Participant节点
     Participant* register_thread();
 
     /// @brief 延迟释放对象    
@@ -51,21 +61,32 @@ public:
     /// 当g_epoch前进两代后，这个桶里的对象就必然安全，可以统一释放
     template <class T>
     void retire(T* ptr) {
+        retire(ptr, &deleter_impl<T>);
+    }
+
+    /// @brief 延迟回收，宽限期过后调用reclaim而不是delete
+    /// 用于把节点放回空闲链表复用：此时已没有线程持有它，复用不会产生ABA
+    /// 在Guard内调用时，推进和回收留给Guard析构统一做一次
+    /// @param ptr 待回收对象
+    /// @param reclaim 回收函数
+    template <class T>
+    void retire(T* ptr, void (*reclaim)(void*)) {
         auto* self = register_thread();
         Epoch g = global_epoch_.load(std::memory_order_acquire);
         
         // 选择当前epoch对应的桶
         std::size_t b = static_cast<std::size_t>(g % 3);
 
-        self->retired[b].push_back(RetiredBase{ptr, &deleter_impl<T>});
-
-        // // 达到批量阈值时尝试推进+回收
-        // if (self->retired[b].size() >= retire_batch_) {
-        //     maybe_advance_and_reclaim(self);
-        // }
+        self->retired[b].push_back(RetiredBase{ptr, reclaim});
 
-        global_retired_count_.fetch_add(1, std::memory_order_relaxed);
-        maybe_advance_and_reclaim(self);
+        // 全局计数只在本线程每攒够一批时累加一次，避免所有线程每次退休都争用同一个缓存行
+        if (++self->pending_retired >= kRetireCountBatch) {
+            global_retired_count_.fetch_add(self->pending_retired, std::memory_order_relaxed);
+            self->pending_retired = 0;
+        }
+        if (!self->active.load(std::memory_order_relaxed)) {
+            maybe_advance_and_reclaim(self);
+        }
     }
 
     // template <typename T>
@@ -92,13 +113,24 @@ public:
     void force_reclaim_all_unsafe();
 
 private:
+    static constexpr uint32_t kRetireCountBatch = 16;
+
+    /// @brief 回收器实例编号，区分thread_local缓存属于哪个回收器（地址可能被复用）
+    const uint64_t id_;
+
     std::atomic<Epoch> global_epoch_{0};
 
     /// @brief 全局参与者链表头节点，存放所有已注册线程的参与者
     std::atomic<Participant*> participants_{nullptr};
 
-    /// @brief 线程本地局部变量
-    /*inline */static thread_local Participant* tls_participant_;
+    /// @brief 线程本地的回收器id_ -> 本线程节点的小映射，最近用过的排在最前；
+    /// 同一线程交替使用几个回收器时不用每次扫描参与者链表
+    struct TlsSlot {
+        uint64_t owner = 0;
+        Participant* participant = nullptr;
+    };
+    static constexpr std::size_t kTlsSlots = 4;
+    static thread_local TlsSlot tls_slots_[kTlsSlots];
     // std::size_t retire_batch_ = 64;
     std::atomic<std::size_t> base_batch_ {32};
     std::atomic<std::size_t> retire_batch_{32};
@@ -109,6 +141,9 @@ private:
     template <class T>
     static void deleter_impl(void* p) { delete static_cast<T*>(p); }
 
+    /// @brief 新建本线程的参与者节点并挂到链表头
+    Participant* new_participant(std::thread::id tid);
+
     /// @brief 扫描所有参与者，如果所有活跃线程的local_epoch >= cur，则说明”没有线程还在用cur-1代的数据“，
     /// 此时可以安全地把global_epoch从cur推进到cur+1
     /// @param cur 
@@ -123,11 +158,20 @@ private:
     /// @param self 本线程的Participant节点
     void maybe_advance_and_reclaim(Participant* self);
     
-    /// @brief 回收所有安全桶(落后两代)
-    /// 1. 遍历所有Participant节点
-    /// 2. 对每个节点，调用reclaim_safe_bukets(node->local_epoch)
+    /// @brief 回收本线程的安全桶(落后两代)
+    /// 只清理自己的桶：多个线程同时扫所有参与者会重复释放同一批对象
+    /// @param self 本线程的Participant节点
+    /// @param g_now 当前global_epoch
+    void reclaim_safe_bukets(Participant* self, Epoch g_now);
+
+    /// @brief 代已退出的线程回收其安全桶，由推进了epoch的线程调用
+    /// @param self 本线程的Participant节点
+    /// @param g_now 当前global_epoch
+    void reclaim_orphan_bukets(Participant* self, Epoch g_now);
+
+    /// @brief 回收所有参与者的安全桶，仅在无并发时（析构）使用
     /// @param g_now 当前global_epoch
-    void reclaim_safe_bukets(Epoch g_now);
+    void reclaim_all_safe_bukets(Epoch g_now);
 
     /// @brief 循环推进几次并回收，保证所有桶都被扫到
     void drain_all();
@@ -0,0 +1,150 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+#include "singleton.h"
+
+/// @brief 指标类型
+enum class MetricType {
+    Counter,    // 单调递增计数
+    Gauge       // 瞬时值
+};
+
+/// @brief 指标标签 {key, value}，按注册顺序输出
+using MetricLabels = std::vector<std::pair<std::string, std::string>>;
+
+/// @brief 一次抓取得到的指标样本
+struct MetricSample {
+    std::string name;
+    std::string help;
+    MetricType type = MetricType::Gauge;
+    MetricLabels labels;
+    double value = 0.0;
+};
+
+/// @brief 抓取时由 collector 写入样本
+class MetricsWriter {
+public:
+    void Add(const std::string& name, MetricType type, const std::string& help,
+             const MetricLabels& labels, double value) {
+        samples_.push_back(MetricSample{name, help, type, labels, value});
+    }
+
+    std::vector<MetricSample>& samples() noexcept { return samples_; }
+private:
+    std::vector<MetricSample> samples_;
+};
+
+class MetricsRegistry;
+
+/// @brief 注册句柄，析构时自动注销
+/// @details 持有者必须比被引用的计数器先析构（成员声明在计数器之后）
+class MetricsHandle {
+public:
+    MetricsHandle() = default;
+    MetricsHandle(MetricsRegistry* registry, uint64_t id) : registry_(registry), id_(id) {}
+    ~MetricsHandle();
+
+    MetricsHandle(MetricsHandle&& other) noexcept;
+    MetricsHandle& operator=(MetricsHandle&& other) noexcept;
+    MetricsHandle(const MetricsHandle&) = delete;
+    MetricsHandle& operator=(const MetricsHandle&) = delete;
+
+    /// @brief 主动注销
+    void reset() noexcept;
+
+    bool valid() const noexcept { return registry_ != nullptr; }
+private:
+    MetricsRegistry* registry_ = nullptr;
+    uint64_t id_ = 0;
+};
+
+/// @brief 进程级指标注册表
+/// @details 热路径只做原子自增；注册/注销走写锁并发布新的只读快照，
+/// 抓取只原子加载快照，逐条目加锁读取，不与热路径或注册争锁
+class MetricsRegistry : public Singleton<MetricsRegistry> {
+    friend class Singleton<MetricsRegistry>;
+public:
+    using Collector = std::function<void(MetricsWriter&)>;
+    using GaugeFunc = std::function<double()>;
+
+    /// @brief 注册计数器，抓取时 relaxed 读取
+    /// @param name 指标名，例如 media_codec_frames_total
+    /// @param help 指标说明
+    /// @param labels 指标标签
+    /// @param counter 计数器地址，生命周期需覆盖返回的句柄
+    MetricsHandle RegisterCounter(const std::string& name, const std::string& help,
+                                  const MetricLabels& labels, const std::atomic<uint64_t>* counter);
+
+    /// @brief 注册瞬时值，抓取时调用 fn
+    MetricsHandle RegisterGauge(const std::string& name, const std::string& help,
+                                const MetricLabels& labels, GaugeFunc fn);
+
+    /// @brief 注册批量采集函数，一次产出多条样本（如设备池快照）
+    MetricsHandle RegisterCollector(Collector collector);
+
+    /// @brief 注册队列深度与容量，标签queue=queue_name
+    /// @tparam Queue 需提供 size_approx()，若提供 capacity() 一并导出
+    /// @param labels 附加标签，同名队列有多个实例时用来区分
+    template <class Queue>
+    std::vector<MetricsHandle> RegisterQueue(const std::string& queue_name, const Queue& queue, MetricLabels labels = {}) {
+        std::vector<MetricsHandle> handles;
+        labels.insert(labels.begin(), {"queue", queue_name});
+        handles.push_back(RegisterGauge("media_queue_depth", "Approximate number of queued elements",
+            labels, [&queue] { return static_cast<double>(queue.size_approx()); }));
+        if constexpr (requires { queue.capacity(); }) {
+            handles.push_back(RegisterGauge("media_queue_capacity", "Queue capacity",
+                labels, [&queue] { return static_cast<double>(queue.capacity()); }));
+        }
+        return handles;
+    }
+
+    /// @brief 注销指标，返回前保证没有正在进行的抓取还在引用它
+    /// @details 只等待正在读取该条目的抓取，可在gauge/collector回调里调用
+    void Unregister(uint64_t id);
+
+    /// @brief 采集当前全部样本
+    std::vector<MetricSample> Collect() const;
+
+    /// @brief Prometheus text exposition format (0.0.4)
+    std::string RenderPrometheus() const;
+
+    /// @brief JSON格式 {"metrics":[{"name":..,"type":..,"labels":{..},"value":..}]}
+    std::string RenderJson() const;
+
+    /// @brief 已注册条目数
+    std::size_t size() const;
+
+private:
+    MetricsRegistry();
+    ~MetricsRegistry() = default;
+
+    struct Entry {
+        uint64_t id;
+        std::string name;
+        std::string help;
+        MetricType type;
+        MetricLabels labels;
+        const std::atomic<uint64_t>* counter = nullptr;
+        GaugeFunc gauge;
+        Collector collector;
+        /// @brief 抓取读取与注销互斥；递归锁允许回调里注销自身
+        mutable std::recursive_mutex mtx;
+        /// @brief 注销后置false，拿着旧快照的抓取据此跳过
+        mutable bool alive = true;
+    };
+    using Table = std::vector<std::shared_ptr<const Entry>>;
+
+    MetricsHandle add(std::shared_ptr<Entry> entry);
+
+    /// @brief 注册/注销之间互斥，抓取不加锁
+    std::mutex write_mtx_;
+    /// @brief 当前只读快照
+    std::atomic<std::shared_ptr<const Table>> table_;
+    uint64_t next_id_ = 1;
+};
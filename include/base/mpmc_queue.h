@@ -5,8 +5,12 @@
 #include <condition_variable>
 #include <mutex>
 #include <chrono>
+#include <cstddef>
+#include <vector>
 
 /// @brief 无界无锁队列
+/// 基于Michael-Scott队列，出队的节点经EBR宽限期后回到线程本地空闲链表复用，
+/// 稳态下入队不再走分配器；enqueue_bulk/try_dequeue_bulk一次CAS挂上/摘下一整条链
 /// @tparam T 参数类型
 template <typename T>
 class MPMCQueue {
@@ -36,29 +40,47 @@ public:
     template <class U>
     void enqueue(U&& value) {
         EpochReclaimer::Guard guard(gc_);
-        // Node* new_node = new Node(std::forward<U>(value));
-        Node* new_node = std::make_unique<Node>(std::forward<U>(value));
-        while(true) {
-            Node* last = tail_.load(std::memory_order_acquire);
-            Node* next = last->next.load(std::memory_order_acquire);
-            if(last == tail_.load(std::memory_order_acquire)){
-                if(next == nullptr) {
-                    if(last->next.compare_exchange_weak(next, new_node, std::memory_order_release, std::memory_order_acquire)){
-                        tail_.compare_exchange_strong(last, new_node, std::memory_order_release, std::memory_order_acquire);
-                        
-                        // 加锁？
-                        cv_.notify_one();   // 通知一个等待的消费者
-                        
-                        approximate_size_.fetch_add(1, std::memory_order_relaxed);
-
-                        new_node.release(); // 手动释放内存
-                        return;
-                    }
-                } else {
-                    tail_.compare_exchange_strong(last, next, std::memory_order_release, std::memory_order_acquire);
-                }
+        Node* new_node = make_node(std::forward<U>(value));
+        link(new_node, new_node);
+        approximate_size_.fetch_add(1, std::memory_order_relaxed);
+        cv_.notify_one();   // 通知一个等待的消费者
+    }
+
+    /// @brief 批量入队
+    /// 先在本线程内把节点串成链，再用一次CAS挂到队尾，同一批元素在队列中保持连续
+    /// @tparam It 输入迭代器，*it可构造T（用std::make_move_iterator可移动入队）
+    /// @param first 起始迭代器
+    /// @param last 结束迭代器
+    /// @return 入队的元素个数
+    template <class It>
+    std::size_t enqueue_bulk(It first, It last) {
+        if (first == last) {
+            return 0;
+        }
+        EpochReclaimer::Guard guard(gc_);
+        Node* head = make_node(*first);
+        Node* tail = head;
+        std::size_t count = 1;
+        try {
+            for (++first; first != last; ++first, ++count) {
+                Node* n = make_node(*first);
+                tail->next.store(n, std::memory_order_relaxed);
+                tail = n;
             }
+        } catch (...) {
+            // 构造失败，已建好的链直接放回空闲链表（尚未发布，没有其他线程可见）
+            while (head) {
+                Node* n = head->next.load(std::memory_order_relaxed);
+                recycle_node(head);
+                head = n;
+            }
+            throw;
         }
+        link(head, tail);
+        approximate_size_.fetch_add(count, std::memory_order_relaxed);
+        // 一批只唤醒一个消费者，醒来的消费者继续出队即可取走整批
+        cv_.notify_one();
+        return count;
     }
 
     /// @brief 非阻塞出队
@@ -95,11 +117,12 @@ public:
                     // 成功后，当前线程独占这个出队操作
                     // 安全地move数据(不会导致后一个线程访问时是已经move了的节点)
                     
-                    // 取值
+                    // 取值，新dummy不再持有值
                     if(next->value.has_value()) {
                         value = std::move(next->value.value());
+                        next->value.reset();
                     }
-                    gc_.retire(first);  // 交给EBR延迟释放
+                    gc_.retire(first, &recycle_node);  // 交给EBR，宽限期后回到空闲链表
                     approximate_size_.fetch_sub(1, std::memory_order_relaxed);// 计数器-1
                     return true;
                 }
@@ -108,6 +131,67 @@ public:
         }
     }
 
+    /// @brief 非阻塞批量出队
+    /// 从head往后数出最多max个节点，一次CAS把整段摘下；被摘下的节点中间不会被其他线程取走
+    /// @tparam OutIt 输出迭代器
+    /// @param out 出队的值依次写入out
+    /// @param max 最多出队个数
+    /// @return 实际出队个数，队列为空时为0
+    template <class OutIt>
+    std::size_t try_dequeue_bulk(OutIt out, std::size_t max) {
+        if (max == 0) {
+            return 0;
+        }
+        EpochReclaimer::Guard guard(gc_);
+        while(true) {
+            Node* first = head_.load(std::memory_order_acquire);    // dummy
+            Node* last = tail_.load(std::memory_order_acquire);
+            Node* next = first->next.load(std::memory_order_acquire);
+            if(first != head_.load(std::memory_order_acquire)) {
+                continue;
+            }
+            if(next == nullptr) {
+                return 0;   // 队列为空
+            }
+
+            // tail不能落在被摘下的[first, end)里，否则入队线程会读到已退休的节点
+            // 和单个出队一样，head == tail时先帮忙推进tail再重试
+            if(first == last) {
+                tail_.compare_exchange_strong(last, next, std::memory_order_release, std::memory_order_acquire);
+                continue;
+            }
+
+            // 往后数，end是摘下后的新dummy，最远数到tail为止
+            Node* end = next;
+            std::size_t count = 1;
+            while(count < max && end != last) {
+                Node* n = end->next.load(std::memory_order_acquire);
+                if(n == nullptr) {
+                    break;
+                }
+                end = n;
+                ++count;
+            }
+
+            if(head_.compare_exchange_weak(first, end, std::memory_order_acq_rel, std::memory_order_acquire)) {
+                // [first->next, end]的值归本线程，[first, end)的节点交给EBR
+                Node* n = first;
+                while(n != end) {
+                    Node* v = n->next.load(std::memory_order_relaxed);
+                    if(v->value.has_value()) {
+                        *out = std::move(v->value.value());
+                        ++out;
+                        v->value.reset();
+                    }
+                    gc_.retire(n, &recycle_node);
+                    n = v;
+                }
+                approximate_size_.fetch_sub(count, std::memory_order_relaxed);
+                return count;
+            }
+        }
+    }
+
     /// @brief 阻塞出队
     /// @return 出队的值
     T dequeue_blocking() {
@@ -151,6 +235,11 @@ public:
     std::size_t size() const {
         return approximate_size_.load(std::memory_order_relaxed);
     }
+
+    /// @brief 与BoundMPMCQueue一致的近似大小接口，供指标导出
+    std::size_t size_approx() const noexcept {
+        return approximate_size_.load(std::memory_order_relaxed);
+    }
 private:
     struct Node {
         /// @brief std::optional允许节点”有值“或”无值“，方便处理dummy节点
@@ -162,6 +251,136 @@ private:
         explicit Node(const T& v) : value(v) {}
     };
 
+    /// @brief 本地空闲链表超过2批时，整批转到中转站
+    static constexpr std::size_t kCacheBatch = 64;
+    /// @brief 中转站最多暂存的批数，超出的直接释放
+    static constexpr std::size_t kDepotChains = 256;
+
+    /// @brief 线程本地空闲节点栈，用next串起来
+    /// 节点在回收线程（通常是消费者）这里回到空闲链表，而分配发生在生产者，
+    /// 所以按批经中转站流动：每kCacheBatch个节点才加一次锁
+    struct NodeCache {
+        Node* head = nullptr;
+        std::size_t count = 0;
+        ~NodeCache() {
+            cache_closed_ = true;
+            free_chain(head);
+        }
+    };
+
+    /// @brief 全局中转站，同类型的队列共用
+    struct Depot {
+        std::mutex mtx;
+        std::vector<std::pair<Node*, std::size_t>> chains;
+    };
+
+    static NodeCache& local_cache() {
+        static thread_local NodeCache cache;
+        return cache;
+    }
+
+    static Depot& depot() {
+        // 故意不析构：静态存储的队列析构时EBR还会把节点回收到这里
+        static Depot* d = new Depot();
+        return *d;
+    }
+
+    static void free_chain(Node* n) {
+        while (n) {
+            Node* next = n->next.load(std::memory_order_relaxed);
+            delete n;
+            n = next;
+        }
+    }
+
+    /// @brief 取一个空闲节点并构造值，没有空闲节点时才new
+    template <class U>
+    static Node* make_node(U&& value) {
+        if (cache_closed_) {
+            return new Node(std::forward<U>(value));
+        }
+        NodeCache& cache = local_cache();
+        if (!cache.head) {
+            Depot& d = depot();
+            std::lock_guard<std::mutex> lk(d.mtx);
+            if (!d.chains.empty()) {
+                cache.head = d.chains.back().first;
+                cache.count = d.chains.back().second;
+                d.chains.pop_back();
+            }
+        }
+        Node* n = cache.head;
+        if (!n) {
+            return new Node(std::forward<U>(value));
+        }
+        cache.head = n->next.load(std::memory_order_relaxed);
+        --cache.count;
+        n->next.store(nullptr, std::memory_order_relaxed);
+        try {
+            n->value.emplace(std::forward<U>(value));
+        } catch (...) {
+            recycle_node(n);
+            throw;
+        }
+        return n;
+    }
+
+    /// @brief EBR回收函数：宽限期已过，节点没有其他线程引用，清空后放回本线程空闲链表
+    static void recycle_node(void* p) {
+        Node* n = static_cast<Node*>(p);
+        n->value.reset();
+        if (cache_closed_) {
+            delete n;
+            return;
+        }
+        NodeCache& cache = local_cache();
+        n->next.store(cache.head, std::memory_order_relaxed);
+        cache.head = n;
+        if (++cache.count < 2 * kCacheBatch) {
+            return;
+        }
+        // 摘下栈顶一批转给中转站
+        Node* chain = cache.head;
+        Node* cut = chain;
+        for (std::size_t i = 1; i < kCacheBatch; ++i) {
+            cut = cut->next.load(std::memory_order_relaxed);
+        }
+        cache.head = cut->next.load(std::memory_order_relaxed);
+        cache.count -= kCacheBatch;
+        cut->next.store(nullptr, std::memory_order_relaxed);
+        {
+            Depot& d = depot();
+            std::lock_guard<std::mutex> lk(d.mtx);
+            if (d.chains.size() < kDepotChains) {
+                d.chains.emplace_back(chain, kCacheBatch);
+                return;
+            }
+        }
+        free_chain(chain);
+    }
+
+    /// @brief 把已串好的[head, tail]挂到队尾
+    void link(Node* head, Node* tail) {
+        while(true) {
+            Node* last = tail_.load(std::memory_order_acquire);
+            Node* next = last->next.load(std::memory_order_acquire);
+            if(last == tail_.load(std::memory_order_acquire)){
+                if(next == nullptr) {
+                    if(last->next.compare_exchange_weak(next, head, std::memory_order_release, std::memory_order_acquire)){
+                        // 失败说明其他线程已在帮忙逐个推进，交给它们
+                        tail_.compare_exchange_strong(last, tail, std::memory_order_release, std::memory_order_acquire);
+                        return;
+                    }
+                } else {
+                    tail_.compare_exchange_strong(last, next, std::memory_order_release, std::memory_order_acquire);
+                }
+            }
+        }
+    }
+
+    /// @brief 本线程的NodeCache已析构（线程退出阶段），之后节点直接new/delete
+    static inline thread_local bool cache_closed_ = false;
+
     /// @brief 
     alignas(64) std::atomic<Node*> head_;
     /// @brief 
@@ -0,0 +1,64 @@
+#pragma once
+#include <cstddef>
+#include <type_traits>
+#include <vector>
+
+/// @brief 前N个元素放在对象内部的小向量，常见规模下不分配堆内存
+/// @details 超过N个后整体搬到堆上的std::vector，clear()保留堆容量供下一轮复用。
+/// 只用于可平凡复制的小结构（视图、下标等），不负责元素析构。
+template <typename T, std::size_t N>
+class SmallVector {
+    static_assert(std::is_trivially_copyable<T>::value, "SmallVector only holds trivially copyable types");
+    static_assert(N > 0, "SmallVector needs inline capacity");
+public:
+    SmallVector() = default;
+
+    void push_back(const T& value) {
+        if (!spilled_) {
+            if (size_ < N) {
+                inline_[size_++] = value;
+                return;
+            }
+            spill();
+        }
+        heap_.push_back(value);
+        ++size_;
+    }
+
+    /// @brief 清空元素，已溢出到堆上的容量保留
+    void clear() noexcept {
+        size_ = 0;
+        spilled_ = false;
+        heap_.clear();
+    }
+
+    std::size_t size() const noexcept { return size_; }
+    bool empty() const noexcept { return size_ == 0; }
+    /// @brief 是否已经溢出到堆上
+    bool spilled() const noexcept { return spilled_; }
+
+    T* data() noexcept { return spilled_ ? heap_.data() : inline_; }
+    const T* data() const noexcept { return spilled_ ? heap_.data() : inline_; }
+
+    T& operator[](std::size_t i) noexcept { return data()[i]; }
+    const T& operator[](std::size_t i) const noexcept { return data()[i]; }
+    T& back() noexcept { return data()[size_ - 1]; }
+    const T& back() const noexcept { return data()[size_ - 1]; }
+
+    T* begin() noexcept { return data(); }
+    T* end() noexcept { return data() + size_; }
+    const T* begin() const noexcept { return data(); }
+    const T* end() const noexcept { return data() + size_; }
+
+private:
+    void spill() {
+        heap_.reserve(N * 2);
+        heap_.assign(inline_, inline_ + size_);
+        spilled_ = true;
+    }
+
+    T inline_[N];
+    std::size_t size_ = 0;
+    bool spilled_ = false;
+    std::vector<T> heap_;
+};
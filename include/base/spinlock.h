@@ -1,13 +1,31 @@
 #pragma once
 #include <atomic>
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+/// @brief 自旋等待时让出流水线，降低功耗并减少对持有者的干扰
+inline void cpu_relax() noexcept {
+#if defined(__x86_64__) || defined(__i386__)
+    _mm_pause();
+#elif defined(__aarch64__) || defined(__arm__)
+    asm volatile("yield" ::: "memory");
+#else
+    std::atomic_signal_fence(std::memory_order_seq_cst);
+#endif
+}
 
 class SpinLock {
 public:
     void lock() {
         bool expected = false;
         // 原子对象当前的值等于expected, 则将原子对象的值设置为true
-        while(!flag_.compare_exchange_weak(expected, true, std::memory_order_qcquire, 
+        while(!flag_.compare_exchange_weak(expected, true, std::memory_order_acquire, 
             std::memory_order_relaxed)) {
+                // 锁被占用时只读等待，不反复发起CAS抢缓存行
+                while(flag_.load(std::memory_order_relaxed)) {
+                    cpu_relax();
+                }
                 expected = false;   
         }
     }
@@ -18,5 +36,4 @@ public:
 
 private:
     std::atomic<bool> flag_ = {false};
-}
-
+};
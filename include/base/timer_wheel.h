@@ -0,0 +1,91 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <functional>
+#include <vector>
+
+/// @brief 分层哈希时间轮（Varghese & Lauck），用于大量会话/事务/保活超时
+/// @details 4层：第0层256个槽，每槽一个tick；第1~3层各64个槽，每槽覆盖下一层的一整圈，
+/// 可表示2^26个tick（tick为10ms时约7.7天），更远的到期时间按最大值处理。
+/// 定时器节点放在连续数组里，槽内为基于下标的双向链表，增删和重设均为O(1)；
+/// 每个tick整槽取下到期节点，上层槽在下层转完一圈时整体下沉（cascade）。
+/// 非线程安全，需在同一线程或strand上使用；跨线程使用见net::AsioTimerWheel。
+class TimerWheel {
+public:
+    struct Config {
+        /// @brief tick精度（毫秒）
+        int64_t tick_ms = 10;
+    };
+
+    /// @brief 定时器句柄，低32位为节点下标，高32位为代数；0表示无效
+    using TimerId = uint64_t;
+    using Callback = std::function<void()>;
+
+    /// @param now_ms 起始时间，之后Schedule/Advance使用同一时间基准（通常为steady_clock毫秒）
+    explicit TimerWheel(int64_t now_ms = 0);
+    TimerWheel(const Config& cfg, int64_t now_ms);
+
+    TimerWheel(const TimerWheel&) = delete;
+    TimerWheel& operator=(const TimerWheel&) = delete;
+    TimerWheel(TimerWheel&&) = default;
+    TimerWheel& operator=(TimerWheel&&) = default;
+
+    /// @brief delay_ms之后到期，不会提前，最多晚一个tick
+    TimerId Schedule(int64_t delay_ms, Callback cb);
+    /// @brief 取消尚未到期的定时器，已到期或句柄无效返回false
+    bool Cancel(TimerId id);
+    /// @brief 重新设置到期时间（从当前tick起算），保留回调，已到期返回false
+    bool Reschedule(TimerId id, int64_t delay_ms);
+
+    /// @brief 推进到now_ms，到期定时器的回调按到期顺序移入expired（追加），由调用方在锁外执行
+    /// @return 本次到期的个数
+    std::size_t Advance(int64_t now_ms, std::vector<Callback>& expired);
+    /// @brief 推进到now_ms并直接执行到期回调，回调中可以再Schedule/Cancel
+    std::size_t Advance(int64_t now_ms);
+
+    std::size_t size() const noexcept { return size_; }
+    bool empty() const noexcept { return size_ == 0; }
+    int64_t tick_ms() const noexcept { return cfg_.tick_ms; }
+    /// @brief 下一个待处理tick的时间点，驱动方据此设置底层定时器
+    int64_t next_tick_ms() const noexcept { return origin_ms_ + static_cast<int64_t>(current_) * cfg_.tick_ms; }
+
+private:
+    static constexpr int kLevel0Bits = 8;
+    static constexpr int kLevelBits = 6;
+    static constexpr int kLevels = 4;
+    static constexpr uint32_t kLevel0Size = 1u << kLevel0Bits;
+    static constexpr uint32_t kLevelSize = 1u << kLevelBits;
+    static constexpr uint32_t kSlotCount = kLevel0Size + (kLevels - 1) * kLevelSize;
+    static constexpr uint64_t kMaxTicks = (1ull << (kLevel0Bits + (kLevels - 1) * kLevelBits)) - 1;
+    static constexpr uint32_t kNil = 0xFFFFFFFFu;
+
+    struct Node {
+        uint64_t expires = 0;
+        uint32_t prev = kNil;
+        uint32_t next = kNil;
+        /// @brief 所在槽，kNil表示空闲
+        uint32_t slot = kNil;
+        uint32_t generation = 1;
+        Callback cb;
+    };
+
+    Node* lookup(TimerId id) noexcept;
+    uint64_t ticks_for(int64_t delay_ms) const noexcept;
+    /// @brief 按到期tick放入对应层的槽
+    void place(uint32_t index);
+    void link(uint32_t slot, uint32_t index) noexcept;
+    void unlink(uint32_t index) noexcept;
+    void release(uint32_t index);
+    /// @brief 把上层某个槽的节点重新分配到下层
+    void cascade(int level);
+
+    Config cfg_;
+    int64_t origin_ms_;
+    /// @brief 下一个待处理的tick
+    uint64_t current_ = 0;
+    std::vector<Node> nodes_;
+    uint32_t free_ = kNil;
+    std::size_t size_ = 0;
+    std::vector<uint32_t> heads_;
+    std::vector<Callback> scratch_;
+};
@@ -5,6 +5,7 @@ extern "C" {
 }
 
 #include "ffmpeg_avformat.h"
+#include "metrics.h"
 
 #include <stdexcept>
 #include <string>
@@ -334,6 +335,11 @@ public:
     /// @brief 获取接收的包数（编码器）
     std::atomic<uint64_t>& getPacketRecv() noexcept;
 
+    /// @brief 将收发计数器注册到MetricsRegistry
+    /// @param labels 指标标签，如 {{"stream", "cam01"}, {"role", "decoder"}}
+    /// @note 注册随对象析构注销；移动后的对象需重新绑定
+    void BindMetrics(const MetricLabels& labels);
+
 protected:
     AVCodecContext* codec_ctx_ = nullptr;
     AVCodec* codec_ = nullptr;
@@ -369,6 +375,9 @@ private:
     /// @brief 发送的帧数（编码器）
     std::atomic<uint64_t> frames_send_{ 0 };
 
+    /// @brief 指标注册句柄，声明在计数器之后，保证先于计数器注销
+    std::vector<MetricsHandle> metrics_handles_;
+
 };
 
 // class CodecSession {
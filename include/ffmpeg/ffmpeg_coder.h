@@ -120,6 +120,9 @@ struct AudioCodecParams {
 class VideoDecoder : protected CodecContext, protected FormatContext {
 
 public:
+    /// @brief 导出收发计数器，见 CodecContext::BindMetrics
+    using CodecContext::BindMetrics;
+
     /// @brief 构造函数 创建解码器
     /// @param url 视频文件路径
     VideoDecoder(const std::string& url, bool is_hw = false, AVDictionary** options = nullptr);
@@ -162,6 +165,9 @@ private:
 
 class VideoEncoder : protected CodecContext, protected FormatContext {
 public:
+    /// @brief 导出收发计数器，见 CodecContext::BindMetrics
+    using CodecContext::BindMetrics;
+
     
     /// @brief 构造函数 创建编码器
     /// @param codec_name 编码器名称
@@ -222,6 +228,9 @@ private:
 
 class AudioDecoder :protected CodecContext, protected FormatContext {
 public:
+    /// @brief 导出收发计数器，见 CodecContext::BindMetrics
+    using CodecContext::BindMetrics;
+
     /// @brief 构造函数 创建解码器
     /// @param url 视频文件路径
     AudioDecoder(const std::string& url, bool is_hw = false, AVDictionary** options = nullptr);
@@ -265,6 +274,9 @@ private:
 
 class AudioEncoder :protected CodecContext, protected FormatContext {
 public:
+    /// @brief 导出收发计数器，见 CodecContext::BindMetrics
+    using CodecContext::BindMetrics;
+
     
     /// @brief 构造函数 创建音频编码器
     /// @param codec_name 编码器名字
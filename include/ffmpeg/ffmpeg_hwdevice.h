@@ -10,6 +10,7 @@ extern "C" {
 #include <condition_variable>
 #include <optional>
 #include <thread>
+#include "metrics.h"
 
 namespace FFmpeg {
     
@@ -220,6 +221,10 @@ public:
 
     /// @brief 设置设备重试延迟基数(ms)
     void SetRetryBackoff(int milsec);
+
+    /// @brief 将设备负载/健康状态注册到MetricsRegistry，抓取时读取snapshots()
+    /// @param pool_name 设备池名称标签
+    void BindMetrics(const std::string& pool_name);
 private:
     /// @brief 根据策略挑选一个可用entry，不改变active_count
     /// @param strategy 策略
@@ -266,6 +271,9 @@ private:
     /// @brief 轮询索引
     mutable std::atomic<std::size_t> rr_cursor_{0};
 
+    /// @brief 指标注册句柄，最后声明保证最先注销
+    MetricsHandle metrics_handle_;
+
 };
 
 
@@ -2,6 +2,7 @@
 
 #include "async_logger.h"
 #include "log_queue.h"
+#include "metrics.h"
 
 
 #include <boost/log/core.hpp>
@@ -35,4 +36,6 @@ private:
     std::unique_ptr<LogQueue<AsyncLogger::LogItem>> queue_;
     std::atomic<bool> running_;
     std::thread worker_;
+    /// @brief 日志队列的深度/容量指标，先于队列析构
+    std::vector<MetricsHandle> queue_metrics_;
 };
\ No newline at end of file
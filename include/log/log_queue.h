@@ -5,7 +5,7 @@ template <typename T>
 class LogQueue {
 public:
     LogQueue(std::size_t capacity = 64)
-        : queue_(capacity)
+        : capacity_(capacity), queue_(capacity)
     {
     }
     ~LogQueue() {
@@ -57,11 +57,17 @@ public:
         return queue_.size_approx();
     }
 
+    /// @brief 不分配内存的push可用的容量
+    std::size_t capacity() const noexcept {
+        return capacity_;
+    }
+
     void stop() {
         // 放一个空包, 通知消费者退出
         queue_.enqueue({});
     }
 private:
+    std::size_t capacity_;
     // BoundMPMCQueue<T> queue_;
     moodycamel::BlockingConcurrentQueue<T> queue_;
 };
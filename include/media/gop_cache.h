@@ -0,0 +1,143 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+/// @brief GopCache的容量与裁剪策略
+struct GopCacheConfig {
+    /// @brief 缓存字节数上限，超出时裁到下一个起播点，没有则清空等下一个关键帧
+    /// @details 回放会一次性压进订阅者的发送队列，不宜超过其上限（interleaved默认2MB）
+    std::size_t max_bytes = 2 * 1024 * 1024;
+    /// @brief 缓存帧数上限（含音频帧）
+    std::size_t max_frames = 1024;
+    /// @brief 遇到起播点（如带recovery point SEI的帧）就丢弃之前的缓存，缩短新观看者追赶的时长；
+    /// 关闭时只在关键帧处重置
+    bool trim_to_start_point = false;
+};
+
+/// @brief 直播流的GOP缓存：保存最近一个关键帧（或起播点）之后的所有帧，新观看者加入时先回放再接实时流
+/// @details 与协议无关，T为各协议已封装好的一帧（RTP包组、FLV tag、TS片段等），以shared_ptr共享，
+/// 回放不拷贝负载。多轨道按推入顺序交错保存，音频帧在第一个视频关键帧之前不缓存。
+/// 线程安全：推流线程Push，信令线程Snapshot。
+template <typename T>
+class GopCache {
+public:
+    enum Flags : uint8_t {
+        kKeyframe   = 0x01, // IDR/IRAP，缓存从这里重新开始
+        kStartPoint = 0x02  // 可以起播的非关键帧
+    };
+
+    struct Entry {
+        uint8_t track = 0;
+        uint8_t flags = 0;
+        std::size_t bytes = 0;
+        std::shared_ptr<const T> frame;
+    };
+
+    struct Stats {
+        std::size_t frames = 0;
+        std::size_t bytes = 0;
+        /// @brief 因关键帧或起播点重置的次数
+        uint64_t resets = 0;
+        /// @brief 超出上限且无法裁剪、整体清空的次数
+        uint64_t overflows = 0;
+    };
+
+    GopCache() = default;
+    explicit GopCache(const GopCacheConfig& cfg) : cfg_(cfg) {}
+
+    GopCache(const GopCache&) = delete;
+    GopCache& operator=(const GopCache&) = delete;
+
+    /// @return 该帧是否进入缓存（还没等到关键帧或溢出时返回false）
+    bool Push(uint8_t track, uint8_t flags, std::size_t bytes, std::shared_ptr<const T> frame) {
+        std::lock_guard<std::mutex> lock(mtx_);
+        if (flags & kKeyframe) {
+            reset();
+            waiting_ = false;
+        } else if (waiting_) {
+            return false;
+        } else if (cfg_.trim_to_start_point && (flags & kStartPoint)) {
+            reset();
+        }
+        entries_.push_back(Entry{track, flags, bytes, std::move(frame)});
+        bytes_ += bytes;
+        while (bytes_ > cfg_.max_bytes || entries_.size() > cfg_.max_frames) {
+            if (!trim_front()) {
+                entries_.clear();
+                bytes_ = 0;
+                waiting_ = true;
+                ++overflows_;
+                return false;
+            }
+        }
+        return true;
+    }
+
+    /// @brief 当前缓存的副本，按推入顺序，第一帧为关键帧或起播点；只复制引用计数
+    std::vector<Entry> Snapshot() const {
+        std::lock_guard<std::mutex> lock(mtx_);
+        return std::vector<Entry>(entries_.begin(), entries_.end());
+    }
+
+    /// @brief 清空并等待下一个关键帧，用于码流参数变化或断流
+    void Clear() {
+        std::lock_guard<std::mutex> lock(mtx_);
+        entries_.clear();
+        bytes_ = 0;
+        waiting_ = true;
+    }
+
+    bool empty() const {
+        std::lock_guard<std::mutex> lock(mtx_);
+        return entries_.empty();
+    }
+
+    Stats stats() const {
+        std::lock_guard<std::mutex> lock(mtx_);
+        Stats s;
+        s.frames = entries_.size();
+        s.bytes = bytes_;
+        s.resets = resets_;
+        s.overflows = overflows_;
+        return s;
+    }
+
+private:
+    void reset() {
+        if (!entries_.empty()) {
+            ++resets_;
+        }
+        entries_.clear();
+        bytes_ = 0;
+    }
+
+    /// @brief 丢弃队首直到下一个关键帧/起播点，没有可用的起播点返回false
+    bool trim_front() {
+        auto it = entries_.begin();
+        for (++it; it != entries_.end(); ++it) {
+            if (it->flags & (kKeyframe | kStartPoint)) {
+                break;
+            }
+        }
+        if (it == entries_.end()) {
+            return false;
+        }
+        for (auto e = entries_.begin(); e != it; ++e) {
+            bytes_ -= e->bytes;
+        }
+        entries_.erase(entries_.begin(), it);
+        return true;
+    }
+
+    GopCacheConfig cfg_;
+    mutable std::mutex mtx_;
+    std::deque<Entry> entries_;
+    std::size_t bytes_ = 0;
+    bool waiting_ = true;
+    uint64_t resets_ = 0;
+    uint64_t overflows_ = 0;
+};
@@ -0,0 +1,146 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <array>
+#include <span>
+#include <vector>
+#include <sys/uio.h>
+#include "rtp_packetizer.h"
+
+#define PS_PACK_START_CODE     0xBA
+#define PS_SYSTEM_HEADER_CODE  0xBB
+#define PS_MAP_CODE            0xBC
+#define PS_END_CODE            0xB9
+#define PS_PACK_HEADER_SIZE    14
+#define PS_PES_HEADER_MAX_SIZE 19
+
+/// @brief PS中的基本流编码（PSM的stream_type，含GB28181扩展）
+enum class PsCodec : uint8_t {
+    Unknown,
+    H264,
+    H265,
+    Mpeg4,
+    Svac,
+    Aac,
+    G711A,
+    G711U,
+    G7221,
+    G7231,
+    G729,
+};
+
+namespace Ps {
+    /// @brief PSM stream_type与编码互转
+    PsCodec CodecFromStreamType(uint8_t stream_type) noexcept;
+    uint8_t StreamTypeFromCodec(PsCodec codec) noexcept;
+    bool IsVideo(PsCodec codec) noexcept;
+
+    /// @brief 写MPEG-2 pack头（14字节，无填充），SCR单位90kHz
+    std::size_t WritePackHeader(uint8_t* dst, uint64_t scr, uint32_t mux_rate);
+    /// @brief 写PES头，pts/dts小于0表示不携带
+    /// @param payload_size PES负载字节数，与头合计不能超过PES_packet_length上限
+    /// @return 头部字节数（9/14/19）
+    std::size_t WritePesHeader(uint8_t* dst, uint8_t stream_id, std::size_t payload_size, int64_t pts, int64_t dts);
+}
+
+/// @brief 解复用得到的一个基本流访问单元
+/// @details segments直接指向PsDemuxer::Input的缓冲区（一帧跨多个PES时为多段），
+/// 仅在下一次Input前有效，不拷贝负载。
+struct PsFrame {
+    uint8_t stream_id = 0;
+    PsCodec codec = PsCodec::Unknown;
+    /// @brief 90kHz，不携带时为-1
+    int64_t pts = -1;
+    int64_t dts = -1;
+    std::vector<iovec> segments;
+    std::size_t size = 0;
+    /// @brief 视频帧含IDR/IRAP或参数集
+    bool keyframe = false;
+    /// @brief 最后一个PES在缓冲区末尾被截断
+    bool truncated = false;
+
+    /// @brief 拼接成连续字节（送解码器需要连续缓冲区时）
+    /// @return 写入字节数，cap不足返回0
+    std::size_t Flatten(uint8_t* dst, std::size_t cap) const noexcept;
+};
+
+/// @brief GB28181 PS流解复用
+/// @details 在RTP重组后的缓冲区（通常是以marker结束的一帧）上原地解析pack/system/PSM/PES头，
+/// 产出H.264/H.265/AAC/G.711等访问单元视图。同一stream_id上不带PTS（或PTS相同）的后续PES
+/// 归入前一个访问单元，因此大帧拆成多个PES时得到一个多段视图。
+/// PSM记录的编码映射跨Input保持；在收到PSM之前，访问单元的codec为Unknown。
+class PsDemuxer {
+public:
+    PsDemuxer();
+
+    /// @brief 解析一段完整的PS数据
+    /// @return 没有找到任何PS结构返回false
+    bool Input(const uint8_t* data, std::size_t size);
+
+    /// @brief 本次Input得到的访问单元
+    std::span<const PsFrame> frames() const noexcept { return {frames_.data(), frame_count_}; }
+
+    PsCodec codec_of(uint8_t stream_id) const noexcept { return codecs_[stream_id]; }
+    /// @brief 为找不到起始码而跳过的字节数（累计）
+    uint64_t skipped_bytes() const noexcept { return skipped_; }
+
+    void Reset();
+
+private:
+    /// @return 消耗的字节数，0表示数据不完整
+    std::size_t parse_psm(const uint8_t* p, std::size_t avail);
+    std::size_t parse_pes(const uint8_t* p, std::size_t avail);
+    void append(uint8_t stream_id, int64_t pts, int64_t dts, const uint8_t* payload, std::size_t size, bool truncated);
+    static bool detect_keyframe(PsCodec codec, const PsFrame& frame) noexcept;
+
+    std::array<PsCodec, 256> codecs_;
+    /// @brief 复用的访问单元，frame_count_之后的元素只保留容量
+    std::vector<PsFrame> frames_;
+    std::size_t frame_count_ = 0;
+    uint64_t skipped_ = 0;
+};
+
+/// @brief PS over RTP打包器（GB28181，a=rtpmap:96 PS/90000）
+/// @details 一帧封装为 pack头 [+ system头 + PSM，仅关键帧] + 若干PES，
+/// 再按MTU切成RTP包，最后一个包置marker。PS字节流不落地：
+/// pack头、PES头这类随帧变化的头写进RtpPacketView的slab，
+/// system头和PSM在构造时生成、由iovec引用，NALU负载直接引用编码器输出，
+/// 起始码引用静态常量，因此整帧不拷贝负载。
+/// 打包器本身必须在包发出前保持存活（system头/PSM归打包器所有）。
+class PsRtpPacketizer : public RtpPacketizer {
+public:
+    static constexpr uint8_t kVideoStreamId = 0xE0;
+    static constexpr uint8_t kAudioStreamId = 0xC0;
+
+    /// @param video 视频编码（H264/H265），决定PSM内容与关键帧判断
+    /// @param audio 音频编码，Unknown表示无音频
+    PsRtpPacketizer(const Config& cfg, PsCodec video, PsCodec audio = PsCodec::Unknown);
+
+    /// @brief 打包一个视频访问单元，timestamp同时作为PTS/SCR（90kHz）
+    std::size_t PacketizeNalus(const NalUnitView* nalus, std::size_t count, uint32_t timestamp, RtpPacketBatch& out) override;
+
+    /// @brief 打包一个音频帧（ADTS或G.711负载），timestamp为90kHz
+    std::size_t PacketizeAudio(const uint8_t* data, std::size_t size, uint32_t timestamp, RtpPacketBatch& out);
+
+private:
+    /// @brief PS字节流中的一段：动态头内联保存，其余引用外部内存
+    struct Piece {
+        const uint8_t* data = nullptr;
+        uint32_t size = 0;
+        bool inline_bytes = false;
+        uint8_t bytes[PS_PES_HEADER_MAX_SIZE];
+    };
+
+    void push_ref(const uint8_t* data, std::size_t size);
+    void push_inline(const uint8_t* data, std::size_t size);
+    /// @brief 把[items, items+count)作为一个基本流访问单元拆成PES
+    void push_pes(uint8_t stream_id, const NalUnitView* items, std::size_t count, bool start_codes, int64_t pts);
+    /// @brief 把pieces_切成RTP包
+    std::size_t emit(uint32_t timestamp, uint8_t flags, RtpPacketBatch& out);
+
+    PsCodec video_;
+    PsCodec audio_;
+    std::vector<uint8_t> system_header_;
+    std::vector<uint8_t> psm_;
+    std::vector<Piece> pieces_;
+};
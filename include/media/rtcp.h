@@ -0,0 +1,225 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <functional>
+#include <random>
+#include <span>
+#include <string>
+#include <unordered_map>
+#include "rtp.h"
+
+#define RTCP_HEADER_SIZE 4
+#define RTCP_REPORT_BLOCK_SIZE 24
+#define RTCP_SENDER_INFO_SIZE 20
+#define RTCP_MAX_REPORT_BLOCKS 31
+/// @brief RTPFB的FMT：通用NACK
+#define RTCP_FMT_NACK 1
+
+/// @brief 64位NTP时间
+struct NtpTime {
+    uint32_t sec = 0;
+    uint32_t frac = 0;
+
+    /// @brief 中间32位，用于LSR/RTT计算（单位1/65536秒）
+    uint32_t middle() const noexcept { return (sec << 16) | (frac >> 16); }
+    /// @brief 当前墙钟
+    static NtpTime Now();
+};
+
+/// @brief SR的发送方信息
+struct RtcpSenderInfo {
+    NtpTime ntp;
+    uint32_t rtp_ts = 0;
+    uint32_t packet_count = 0;
+    uint32_t octet_count = 0;
+};
+
+/// @brief SR/RR中的接收报告块
+struct RtcpReportBlock {
+    uint32_t ssrc = 0;
+    uint8_t fraction_lost = 0;
+    /// @brief 累计丢包，24位有符号
+    int32_t cumulative_lost = 0;
+    uint32_t ext_highest_seq = 0;
+    uint32_t jitter = 0;
+    uint32_t lsr = 0;
+    uint32_t dlsr = 0;
+};
+
+/// @brief 单个源的接收统计（RFC 3550 附录A.1/A.3/A.8）
+class RtpReceiveStats {
+public:
+    explicit RtpReceiveStats(uint32_t ssrc = 0, uint32_t clock_rate = 90000);
+
+    /// @brief 收到一个RTP包
+    /// @param arrival_ms 到达时间（单调时钟）
+    /// @return 序号不可信（试用期或大跳变待确认）返回false
+    bool Update(uint16_t seq, uint32_t rtp_ts, int64_t arrival_ms);
+
+    /// @brief 收到该源的SR，记录LSR
+    void OnSenderReport(const NtpTime& ntp, int64_t now_ms);
+
+    /// @brief 生成接收报告块，并开始新的统计区间
+    void FillReportBlock(RtcpReportBlock& block, int64_t now_ms);
+
+    uint32_t ssrc() const noexcept { return ssrc_; }
+    uint32_t ext_highest_seq() const noexcept { return cycles_ + max_seq_; }
+    uint32_t expected() const noexcept { return ext_highest_seq() - base_seq_ + 1; }
+    uint32_t received() const noexcept { return received_; }
+    /// @brief 累计丢包（重复包可能使其为负）
+    int64_t lost() const noexcept { return static_cast<int64_t>(expected()) - received_; }
+    /// @brief 抖动，单位为RTP时钟
+    uint32_t jitter() const noexcept { return static_cast<uint32_t>(jitter_ >> 4); }
+    /// @brief 自上次报告后是否收到过包（RFC 3550 只为这类源生成报告块）
+    bool active() const noexcept { return received_ != received_prior_; }
+    int64_t last_rtp_ms() const noexcept { return last_rtp_ms_; }
+
+private:
+    void init_seq(uint16_t seq);
+
+    uint32_t ssrc_;
+    uint32_t clock_rate_;
+    uint16_t max_seq_ = 0;
+    uint32_t cycles_ = 0;
+    uint32_t base_seq_ = 0;
+    uint32_t bad_seq_ = 0;
+    uint32_t probation_ = 0;
+    bool initialized_ = false;
+    uint32_t received_ = 0;
+    uint32_t expected_prior_ = 0;
+    uint32_t received_prior_ = 0;
+    int32_t transit_ = 0;
+    bool transit_valid_ = false;
+    /// @brief 抖动*16，按A.8的整数实现
+    uint32_t jitter_ = 0;
+    uint32_t lsr_ = 0;
+    int64_t lsr_recv_ms_ = 0;
+    int64_t last_rtp_ms_ = 0;
+};
+
+/// @brief 复合RTCP包的解析回调，默认忽略
+class RtcpHandler {
+public:
+    virtual ~RtcpHandler() = default;
+    virtual void OnSenderReport(uint32_t /*ssrc*/, const RtcpSenderInfo& /*info*/, const RtcpReportBlock* /*blocks*/, std::size_t /*count*/) {}
+    virtual void OnReceiverReport(uint32_t /*ssrc*/, const RtcpReportBlock* /*blocks*/, std::size_t /*count*/) {}
+    virtual void OnBye(const uint32_t* /*ssrcs*/, std::size_t /*count*/) {}
+    /// @brief 通用NACK（RFC 4585 6.2.1），PID/BLP已展开为序号；很长的NACK会分多次回调
+    virtual void OnNack(uint32_t /*sender_ssrc*/, uint32_t /*media_ssrc*/, const uint16_t* /*seqs*/, std::size_t /*count*/) {}
+    /// @brief 其他类型（SDES/APP/PSFB及非NACK的RTPFB），data含4字节公共头
+    virtual void OnPacket(uint8_t /*packet_type*/, const uint8_t* /*data*/, std::size_t /*size*/) {}
+};
+
+namespace Rtcp {
+    /// @brief 写SR，返回写入字节数，缓冲区不足返回0
+    std::size_t WriteSenderReport(std::span<uint8_t> buf, uint32_t ssrc, const RtcpSenderInfo& info,
+                                  const RtcpReportBlock* blocks, std::size_t count);
+    /// @brief 写RR，返回写入字节数，缓冲区不足返回0
+    std::size_t WriteReceiverReport(std::span<uint8_t> buf, uint32_t ssrc,
+                                    const RtcpReportBlock* blocks, std::size_t count);
+    /// @brief 写BYE
+    std::size_t WriteBye(std::span<uint8_t> buf, uint32_t ssrc);
+    /// @brief 写通用NACK，相邻17个以内的序号合并为一个PID/BLP
+    /// @param seqs 丢失的序号，按发送顺序排列
+    /// @return 写入字节数，缓冲区不足返回0
+    std::size_t WriteNack(std::span<uint8_t> buf, uint32_t sender_ssrc, uint32_t media_ssrc,
+                          const uint16_t* seqs, std::size_t count);
+
+    /// @brief 按RFC 3550 A.2校验并解析复合包，逐个回调；也接受以RTPFB/PSFB开头的精简包（RFC 5506）
+    /// @return 格式非法返回false（已回调的部分不回滚）
+    bool ParseCompound(const uint8_t* data, std::size_t size, RtcpHandler& handler);
+
+    /// @brief RFC 3550 A.7 报告间隔（秒），已包含随机化与补偿
+    /// @param rtcp_bw RTCP带宽，字节/秒
+    /// @param avg_rtcp_size 平均RTCP包大小（含UDP/IP头）
+    /// @param min_interval 最小间隔Tmin，首次报告取一半
+    double ComputeInterval(int members, int senders, double rtcp_bw, bool we_sent,
+                           double avg_rtcp_size, bool initial, double min_interval, std::minstd_rand& rng);
+}
+
+/// @brief 单个RTP会话的RTCP状态：各源接收统计、本端发送统计、报告定时
+/// @details 每个会话独立持有，无全局状态；报告直接写入调用方缓冲区。
+/// 非线程安全，与该会话的收发包在同一线程调用。
+class RtcpSession : private RtcpHandler {
+public:
+    struct Config {
+        uint32_t ssrc = 0;
+        uint32_t clock_rate = 90000;
+        /// @brief 会话带宽，比特/秒，RTCP占5%
+        double session_bandwidth = 4000000;
+        /// @brief 最小报告间隔（秒）
+        double min_interval = 5.0;
+        /// @brief SDES CNAME，非空时每个报告都附带SDES组成复合包
+        std::string cname;
+    };
+
+    /// @brief 对端对本端流的最近一次报告，供拥塞控制与监控使用
+    struct RemoteReport {
+        bool valid = false;
+        uint8_t fraction_lost = 0;
+        int32_t cumulative_lost = 0;
+        uint32_t jitter = 0;
+        /// @brief 往返时延（毫秒），对端未带LSR时为-1
+        double rtt_ms = -1;
+        int64_t received_ms = 0;
+    };
+
+    explicit RtcpSession(const Config& cfg);
+
+    /// @brief 本端发出一个RTP包
+    void OnRtpSent(std::size_t payload_size, uint32_t rtp_ts, int64_t now_ms);
+    /// @brief 收到一个RTP包
+    bool OnRtpReceived(const RtpHeaderView& hdr, int64_t now_ms);
+    /// @brief 收到一个复合RTCP包
+    bool OnRtcpReceived(const uint8_t* data, std::size_t size, int64_t now_ms);
+
+    /// @brief 是否到了发送报告的时间，首次调用时按初始间隔安排
+    bool ReportDue(int64_t now_ms);
+
+    /// @brief 生成复合包SR（最近发过包）或RR + SDES，并安排下一次报告时间
+    /// @return 写入字节数，缓冲区不足返回0
+    std::size_t BuildReport(std::span<uint8_t> buf, int64_t now_ms);
+
+    /// @brief 对端请求重传本端的包（media_ssrc为本端SSRC时回调），一般转给RtpRtxCache
+    using NackHandler = std::function<void(const uint16_t* seqs, std::size_t count)>;
+    void SetNackHandler(NackHandler handler) { nack_handler_ = std::move(handler); }
+
+    const RemoteReport& remote_report() const noexcept { return remote_; }
+    /// @brief 本端SDES，可追加NAME/TOOL等条目
+    RTCPSdes& sdes() noexcept { return sdes_; }
+    const RtpReceiveStats* source(uint32_t ssrc) const;
+    std::size_t source_count() const noexcept { return sources_.size(); }
+    uint32_t ssrc() const noexcept { return cfg_.ssrc; }
+
+private:
+    void OnSenderReport(uint32_t ssrc, const RtcpSenderInfo& info, const RtcpReportBlock* blocks, std::size_t count) override;
+    void OnReceiverReport(uint32_t ssrc, const RtcpReportBlock* blocks, std::size_t count) override;
+    void OnBye(const uint32_t* ssrcs, std::size_t count) override;
+    void OnNack(uint32_t sender_ssrc, uint32_t media_ssrc, const uint16_t* seqs, std::size_t count) override;
+
+    void on_report_blocks(const RtcpReportBlock* blocks, std::size_t count);
+    void schedule(int64_t now_ms);
+    bool we_sent(int64_t now_ms) const noexcept;
+
+    Config cfg_;
+    std::unordered_map<uint32_t, RtpReceiveStats> sources_;
+    RTCPSdes sdes_;
+    std::minstd_rand rng_;
+
+    uint32_t packet_count_ = 0;
+    uint32_t octet_count_ = 0;
+    uint32_t last_rtp_ts_ = 0;
+    int64_t last_sent_ms_ = -1;
+
+    bool initial_ = true;
+    double avg_rtcp_size_ = 128;
+    /// @brief -1表示尚未安排
+    int64_t next_report_ms_ = -1;
+    int64_t last_report_ms_ = 0;
+    int64_t now_ms_ = 0;
+    /// @brief 活跃源超过一个报告能容纳的块数时，下次报告从第几个活跃源开始
+    std::size_t report_start_ = 0;
+
+    RemoteReport remote_;
+    NackHandler nack_handler_;
+};
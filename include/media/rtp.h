@@ -3,14 +3,18 @@
 #include <vector>
 #include <cstring>
 #include <string>
+#include <string_view>
+#include <array>
+#include <span>
 #include <arpa/inet.h>
-#include "singleton.h"
 
 #define RTCP_PACKET_TYPE_SR 200 // SR包，发送方报告
 #define RTCP_PACKET_TYPE_RR 201 // RR包，接收方报告
 #define RTCP_PACKET_TYPE_SDES 202   // SDES包，会话描述
 #define RTCP_PACKET_TYPE_BYE 203    // BYE包，会话结束
 #define RTCP_PACKET_TYPE_APP 204    // APP包，应用自定义
+#define RTCP_PACKET_TYPE_RTPFB 205  // 传输层反馈（RFC 4585），FMT=1为通用NACK
+#define RTCP_PACKET_TYPE_PSFB 206   // 负载相关反馈，PLI/FIR
 
 struct RTPHeader {
     // RTP头部的版本号，通常为2  
@@ -79,6 +83,82 @@ struct RTPHeader {
     }
 };
 
+/// @brief RTP固定头长度（无CSRC、无扩展）
+#define RTP_FIXED_HEADER_SIZE 12
+
+/// @brief 直接按网络字节序写入12字节RTP固定头，不经过RTPHeader位域结构
+/// @param buf 至少12字节
+inline void WriteRtpHeader(uint8_t* buf, uint8_t pt, bool marker, uint16_t seq, uint32_t ts, uint32_t ssrc) {
+    buf[0] = 0x80;  // V=2 P=0 X=0 CC=0
+    buf[1] = static_cast<uint8_t>((marker ? 0x80 : 0x00) | (pt & 0x7F));
+    buf[2] = static_cast<uint8_t>(seq >> 8);
+    buf[3] = static_cast<uint8_t>(seq);
+    buf[4] = static_cast<uint8_t>(ts >> 24);
+    buf[5] = static_cast<uint8_t>(ts >> 16);
+    buf[6] = static_cast<uint8_t>(ts >> 8);
+    buf[7] = static_cast<uint8_t>(ts);
+    buf[8] = static_cast<uint8_t>(ssrc >> 24);
+    buf[9] = static_cast<uint8_t>(ssrc >> 16);
+    buf[10] = static_cast<uint8_t>(ssrc >> 8);
+    buf[11] = static_cast<uint8_t>(ssrc);
+}
+
+/// @brief 序列号比较（考虑65535回绕），a在b之前返回true
+inline bool RtpSeqBefore(uint16_t a, uint16_t b) {
+    return static_cast<int16_t>(static_cast<uint16_t>(a - b)) < 0;
+}
+
+/// @brief 在接收缓冲区上原地解析的RTP头，不经过RTPHeader位域结构、不拷贝负载
+/// @details payload已跳过CSRC、扩展头并去掉padding，指向原缓冲区
+struct RtpHeaderView {
+    uint8_t payload_type = 0;
+    bool marker = false;
+    uint16_t seq = 0;
+    uint32_t timestamp = 0;
+    uint32_t ssrc = 0;
+    const uint8_t* payload = nullptr;
+    size_t payload_size = 0;
+
+    /// @brief 解析，版本号不为2或长度字段越界返回false
+    bool Parse(const uint8_t* buf, size_t len) {
+        if (!buf || len < RTP_FIXED_HEADER_SIZE || (buf[0] >> 6) != 2) {
+            return false;
+        }
+        size_t off = RTP_FIXED_HEADER_SIZE + 4 * (buf[0] & 0x0F);
+        if (off > len) {
+            return false;
+        }
+        if (buf[0] & 0x10) {
+            // 扩展头：profile(2) + length(2, 单位32bit)
+            if (off + 4 > len) {
+                return false;
+            }
+            off += 4 + 4 * ((static_cast<size_t>(buf[off + 2]) << 8) | buf[off + 3]);
+            if (off > len) {
+                return false;
+            }
+        }
+        size_t end = len;
+        if (buf[0] & 0x20) {
+            uint8_t pad = buf[len - 1];
+            if (pad == 0 || pad > end - off) {
+                return false;
+            }
+            end -= pad;
+        }
+        marker = (buf[1] & 0x80) != 0;
+        payload_type = buf[1] & 0x7F;
+        seq = static_cast<uint16_t>((buf[2] << 8) | buf[3]);
+        timestamp = (static_cast<uint32_t>(buf[4]) << 24) | (static_cast<uint32_t>(buf[5]) << 16)
+                  | (static_cast<uint32_t>(buf[6]) << 8) | buf[7];
+        ssrc = (static_cast<uint32_t>(buf[8]) << 24) | (static_cast<uint32_t>(buf[9]) << 16)
+             | (static_cast<uint32_t>(buf[10]) << 8) | buf[11];
+        payload = buf + off;
+        payload_size = end - off;
+        return true;
+    }
+};
+
 struct RTPPacket {
     // RTP头部
     RTPHeader header;
@@ -107,6 +187,7 @@ public:
 };
 
 // H.264 RTP包
+// 整个NALU作为单个负载并拷贝一次，超过MTU的NALU请使用H264RtpPacketizer
 class RtpPacketH264 : public RtpPacket {
 public:
     RtpPacketH264(uint16_t seq, uint32_t ts, uint32_t ssrc, const uint8_t* nalu, size_t nalu_size)
@@ -114,6 +195,7 @@ public:
 };
 
 // H.265 RTP包
+// 整个NALU作为单个负载并拷贝一次，超过MTU的NALU请使用H265RtpPacketizer
 class RtpPacketH265 : public RtpPacket {
 public:
     RtpPacketH265(uint16_t seq, uint32_t ts, uint32_t ssrc, const uint8_t* nalu, size_t nalu_size)
@@ -122,6 +204,7 @@ public:
 
 
 
+// SR包头布局，仅作说明；生成与解析见rtcp.h的Rtcp::WriteSenderReport/ParseCompound
 struct RTCP_SR_PACKET {
 #if __BYTE_ORDER__ == __ORDER_BIG_ENDIN__
     //  RTP/RTCP版本
@@ -166,18 +249,33 @@ enum class RTCP_SdesItemType : uint8_t{
     RTCP_SDES_PRIV  = 8     // 会话名称
 };
 
-// SDES Item
-struct RTCP_SdesItem{
-    RTCP_SdesItemType type;  // 
-    std::vector<uint8_t> data;
-
-    RTCP_SdesItem(RTCP_SdesItemType t, const std::vector<uint8_t>& d) : type(t), data(d) {}
+// SDES Item视图，指向所属chunk的内联存储
+struct RTCP_SdesItem {
+    RTCP_SdesItemType type = RTCP_SdesItemType::RTCP_SDES_END;
+    std::string_view value;
 };
 
 // SDES 条目（一个 SSRC + 多个 item）
+// item按线上格式(type|length|data)内联存放在固定数组里，打包时直接拷贝
 struct RTCP_SdesChunk {
-    uint32_t ssrc;  // 标识符，标识媒体流来源
-    std::vector<RTCP_SdesItem> items;
+    // 标准item类型（CNAME..PRIV）各一个
+    static constexpr size_t kMaxItems = 8;
+    // 所有item的type+length+data总字节上限：每个item都能放下255字节的最大值
+    static constexpr size_t kMaxItemBytes = kMaxItems * (2 + 255);
+
+    uint32_t ssrc = 0;  // 标识符，标识媒体流来源
+    uint16_t used = 0;
+    uint8_t items[kMaxItemBytes];
+
+    // 设置item，已存在则替换，空间不足返回false
+    bool Set(RTCP_SdesItemType type, std::string_view value);
+    void Remove(RTCP_SdesItemType type);
+    // 不存在返回空
+    std::string_view Get(RTCP_SdesItemType type) const;
+    // 按顺序访问第index个item，越界返回false
+    bool At(size_t index, RTCP_SdesItem& item) const;
+    // 线上字节数：SSRC + items + END + 4字节对齐
+    size_t wire_size() const { return 4 + ((used + 1 + 3) & ~size_t(3)); }
 };
 
 // 0                   1                   2                   3
@@ -194,20 +292,29 @@ struct RTCP_SdesChunk {
 // |     END=0     |    padding...                                ...
 // +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
 
-class RTCPSdes : public Singleton<RTCPSdes> {
-    friend class Singleton<RTCPSdes>;
+// 单个RTP会话的SDES状态，由会话（如RtcpSession）持有，不再是进程级单例
+// chunk存放在固定数组中，增删改与打包都不分配内存
+class RTCPSdes {
 public:
+    static constexpr size_t kMaxChunks = 4;
 
+    // 写入调用方缓冲区，返回写入字节数；没有chunk或缓冲区不足返回0
+    size_t PackInto(std::span<uint8_t> buf) const;
     std::vector<uint8_t> Pack() const;
+    // 解析SDES包，替换当前内容；格式非法抛std::runtime_error，超出容量的chunk/item被忽略
     void Parse(const uint8_t* data, size_t size);
-    // 添加一个SDES条目
-    void AddItem(uint32_t ssrc, RTCP_SdesItemType type, const std::string& value);
+    // 添加一个SDES条目，chunk数或空间超限返回false
+    bool AddItem(uint32_t ssrc, RTCP_SdesItemType type, std::string_view value);
     void RemoveItem(uint32_t ssrc, RTCP_SdesItemType type);
+    std::string_view GetItem(uint32_t ssrc, RTCP_SdesItemType type) const;
+    const RTCP_SdesChunk* GetChunk(uint32_t ssrc) const { return findChunk(ssrc); }
+    size_t chunk_count() const { return count_; }
+    void Clear() { count_ = 0; }
 private:
-    static void writeU32(std::vector<uint8_t>& buf, uint32_t val);
     static uint32_t readU32(const uint8_t* p);
-    RTCP_SdesChunk& findOrCreateChunk(uint32_t ssrc);
+    RTCP_SdesChunk* findOrCreateChunk(uint32_t ssrc);
     RTCP_SdesChunk* findChunk(uint32_t ssrc);
     const RTCP_SdesChunk* findChunk(uint32_t ssrc) const;
-    std::vector<RTCP_SdesChunk> chunks_;
+    std::array<RTCP_SdesChunk, kMaxChunks> chunks_;
+    size_t count_ = 0;
 };
@@ -0,0 +1,117 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <memory>
+#include <vector>
+#include <sys/uio.h>
+
+/// @brief 解包得到的访问单元，segments依次拼接即为Annex-B码流
+/// @details 起始码指向静态常量，FU重建的NALU头写在内联arena里（用完后溢出到堆上的块），其余段直接指向RTP负载，
+/// 负载所在的接收缓冲区在访问单元被消费前必须保持有效。segments含arena内指针，因此不可拷贝。
+struct AccessUnitView {
+    /// @brief 重建NALU头的内联空间，每个FU分片的NALU占1~2字节；溢出块也按这个大小分配
+    static constexpr std::size_t kArenaSize = 64;
+
+    std::vector<iovec> segments;
+    uint32_t timestamp = 0;
+    /// @brief 拼接后的总字节数
+    std::size_t size = 0;
+    /// @brief 含IDR/IRAP
+    bool keyframe = false;
+    /// @brief 收到marker，访问单元结束
+    bool complete = false;
+    /// @brief 中途丢包或负载非法，码流不完整
+    bool corrupted = false;
+
+    AccessUnitView() { segments.reserve(64); }
+    AccessUnitView(const AccessUnitView&) = delete;
+    AccessUnitView& operator=(const AccessUnitView&) = delete;
+
+    /// @brief 清空，保留容量
+    void clear() noexcept;
+
+    /// @brief 追加一段
+    void push(const uint8_t* data, std::size_t len) {
+        segments.push_back({const_cast<uint8_t*>(data), len});
+        size += len;
+    }
+
+    /// @brief 从arena申请n字节，内联空间用完后从溢出块申请；n超过kArenaSize返回nullptr
+    uint8_t* alloc(std::size_t n) {
+        if (arena_used_ + n > kArenaSize) {
+            return spill(n);
+        }
+        uint8_t* p = arena_ + arena_used_;
+        arena_used_ += n;
+        return p;
+    }
+
+    /// @brief 拼接为连续缓冲区（送解码器时使用）
+    /// @return 写入字节数，cap不足返回0
+    std::size_t Flatten(uint8_t* dst, std::size_t cap) const noexcept;
+
+private:
+    /// @brief 多slice大帧的内联空间不够时，从溢出块分配；已分配的块不移动，clear后复用
+    uint8_t* spill(std::size_t n);
+
+    uint8_t arena_[kArenaSize];
+    std::size_t arena_used_ = 0;
+    std::vector<std::unique_ptr<uint8_t[]>> spill_blocks_;
+    /// @brief 当前帧用到的溢出块数，最后一块已用spill_used_字节
+    std::size_t spill_count_ = 0;
+    std::size_t spill_used_ = 0;
+};
+
+/// @brief RTP解包器基类，输入按序的RTP负载，输出零拷贝的访问单元
+/// @details 典型用法：jitter buffer按序号出包 -> Push -> ready()后取access_unit()
+/// 送解码/转封装 -> Reset()。时间戳变化而上一帧未收到marker时，上一帧被丢弃。
+class RtpDepacketizer {
+public:
+    RtpDepacketizer() = default;
+    virtual ~RtpDepacketizer() = default;
+
+    /// @brief 按序输入一个RTP包的负载（不含RTP头）
+    /// @param timestamp RTP时间戳
+    /// @param marker RTP头M位，置位表示访问单元结束
+    /// @return 负载格式非法返回false，当前访问单元置corrupted
+    virtual bool Push(const uint8_t* payload, std::size_t size, uint32_t timestamp, bool marker) = 0;
+
+    /// @brief 通知检测到丢包，当前访问单元置corrupted
+    void MarkLoss() noexcept;
+
+    /// @brief 访问单元是否已结束
+    bool ready() const noexcept { return au_.complete; }
+
+    AccessUnitView& access_unit() noexcept { return au_; }
+
+    /// @brief 消费完访问单元后调用，准备接收下一帧
+    void Reset() noexcept;
+
+    /// @brief 因缺少marker被丢弃的帧数
+    uint64_t dropped() const noexcept { return dropped_; }
+
+protected:
+    /// @brief 处理时间戳切换，返回false表示负载应被忽略（上一帧已完成但未被消费）
+    bool begin(uint32_t timestamp);
+    /// @brief 追加一个完整NALU（带起始码）
+    void push_nal(const uint8_t* nal, std::size_t size);
+    /// @brief 完成当前访问单元
+    void finish(bool marker) noexcept;
+
+    AccessUnitView au_;
+    /// @brief 正在重组分片
+    bool in_fu_ = false;
+    uint64_t dropped_ = 0;
+};
+
+/// @brief RFC 6184 H.264解包器，支持Single NAL、STAP-A、FU-A（packetization-mode=0/1）
+class H264RtpDepacketizer : public RtpDepacketizer {
+public:
+    bool Push(const uint8_t* payload, std::size_t size, uint32_t timestamp, bool marker) override;
+};
+
+/// @brief RFC 7798 H.265解包器，支持Single NAL、AP、FU（不支持DONL与PACI）
+class H265RtpDepacketizer : public RtpDepacketizer {
+public:
+    bool Push(const uint8_t* payload, std::size_t size, uint32_t timestamp, bool marker) override;
+};
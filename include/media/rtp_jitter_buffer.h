@@ -0,0 +1,129 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <memory>
+#include <vector>
+#include "rtp.h"
+#include "rtp_depacketizer.h"
+
+/// @brief RTP接收端抖动缓冲：按序号重排、检测丢包、组装访问单元
+/// @details 存储为固定大小的槽位环，每个槽位对应一块预分配的收包缓冲区，
+/// 收包直接写入GetWriteBuffer()返回的空闲缓冲区，Commit时与目标槽位交换，不拷贝不分配。
+/// 完整帧到齐立即出帧；遇到空洞时按实测抖动(RFC 3550)自适应等待，超时判定丢包并跳过。
+/// 非线程安全，设计为在同一个收包线程里交替调用Commit/Pop。
+class RtpJitterBuffer {
+public:
+    struct Config {
+        /// @brief 槽位数，须为2的幂
+        std::size_t capacity = 512;
+        /// @brief 单个槽位缓冲区字节数，需不小于最大RTP包
+        std::size_t slot_size = 1500;
+        /// @brief 时钟频率，视频为90000
+        uint32_t clock_rate = 90000;
+        /// @brief 空洞等待下限/上限
+        uint32_t min_delay_ms = 10;
+        uint32_t max_delay_ms = 500;
+        /// @brief 等待时间 = jitter_factor * 实测抖动
+        double jitter_factor = 4.0;
+    };
+
+    enum class InsertResult {
+        Ok,
+        Duplicate,  // 重复包
+        Late,       // 已出帧或已判丢之后才到达
+        Invalid,    // RTP头非法
+        Reset       // 序号大跳变或SSRC变化，缓冲区已重置
+    };
+
+    struct Stats {
+        uint64_t received = 0;
+        uint64_t duplicate = 0;
+        uint64_t late = 0;
+        uint64_t lost = 0;
+        uint64_t reordered = 0;
+        uint64_t frames = 0;
+        uint64_t corrupted_frames = 0;
+        uint64_t resets = 0;
+        /// @brief 到达间隔抖动，单位ms
+        double jitter_ms = 0;
+        /// @brief 当前空洞等待时间
+        uint32_t target_delay_ms = 0;
+    };
+
+    /// @param depacketizer 与负载格式对应的解包器
+    RtpJitterBuffer(const Config& cfg, std::unique_ptr<RtpDepacketizer> depacketizer);
+
+    RtpJitterBuffer(const RtpJitterBuffer&) = delete;
+    RtpJitterBuffer& operator=(const RtpJitterBuffer&) = delete;
+
+    /// @brief 空闲缓冲区，大小为slot_size，供recv直接写入
+    uint8_t* GetWriteBuffer() noexcept { return buffer(spare_); }
+    std::size_t write_buffer_size() const noexcept { return cfg_.slot_size; }
+
+    /// @brief 提交已写入GetWriteBuffer()的一个RTP包
+    /// @param now_ms 到达时间（单调时钟）
+    InsertResult Commit(std::size_t len, int64_t now_ms);
+
+    /// @brief 拷贝一次后提交，用于数据不在GetWriteBuffer()里的场景
+    InsertResult Insert(const uint8_t* data, std::size_t len, int64_t now_ms);
+
+    /// @brief 取出下一个访问单元
+    /// @return 没有可出的帧返回nullptr。返回的访问单元指向槽位缓冲区，
+    /// 在下一次Pop()或触发Reset的Commit()之前有效
+    AccessUnitView* Pop(int64_t now_ms);
+
+    const Stats& stats() const noexcept { return stats_; }
+
+    /// @brief 已锁定的SSRC
+    uint32_t ssrc() const noexcept { return ssrc_; }
+
+private:
+    struct Slot {
+        uint32_t buf = 0;           // 缓冲区下标
+        uint32_t payload_off = 0;
+        uint32_t payload_len = 0;
+        uint32_t timestamp = 0;
+        int64_t arrival_ms = 0;
+        uint16_t seq = 0;
+        bool present = false;
+        bool marker = false;
+    };
+
+    uint8_t* buffer(uint32_t idx) noexcept { return pool_.data() + static_cast<std::size_t>(idx) * cfg_.slot_size; }
+    Slot& slot(uint16_t seq) noexcept { return slots_[seq & mask_]; }
+
+    /// @brief 以seq为起点重新开始
+    void restart(uint16_t seq);
+    /// @brief 释放已出帧占用的槽位
+    void release();
+    /// @brief RFC 3550 到达抖动
+    void update_jitter(uint32_t timestamp, int64_t now_ms);
+
+    Config cfg_;
+    std::size_t mask_;
+    std::vector<uint8_t> pool_;
+    std::vector<Slot> slots_;
+    uint32_t spare_;
+    std::unique_ptr<RtpDepacketizer> depacketizer_;
+
+    bool started_ = false;
+    /// @brief 重新开始后是否已有包出队
+    bool consumed_ = false;
+    uint32_t ssrc_ = 0;
+    /// @brief 下一个待出帧的序号
+    uint16_t head_ = 0;
+    /// @brief 最早仍被占用（含已出帧未释放）的序号
+    uint16_t release_ = 0;
+    /// @brief 收到的最大序号
+    uint16_t highest_ = 0;
+    /// @brief 序号大幅回退时的确认序号（RFC 3550 probation）
+    uint16_t bad_seq_ = 0;
+    bool bad_seq_valid_ = false;
+
+    bool jitter_init_ = false;
+    int64_t last_transit_ = 0;
+    /// @brief 抖动，单位为RTP时钟
+    double jitter_ = 0;
+
+    Stats stats_;
+};
@@ -0,0 +1,167 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "rtp_packetizer.h"
+
+class RtpPacer;
+
+/// @brief 一路被平滑发送的RTP流，由RtpPacer::AddStream创建
+/// @details 生产者（编码线程）调用Enqueue把一帧的包放进有界环形队列，
+/// 发送由所属RtpPacer的线程按令牌桶节奏完成。
+/// RtpPacer必须比所有仍在Enqueue的流活得更久。
+class PacedRtpStream : public std::enable_shared_from_this<PacedRtpStream> {
+public:
+    /// @brief 发送回调，在发送线程中调用，packets在回调期间有效
+    /// @return 实际发出的包数，发送缓冲区满时可能小于count（剩余包稍后重试），出错返回-1（丢弃这些包）
+    using SendFn = std::function<int(const RtpPacketView* packets, std::size_t count)>;
+
+    struct Stats {
+        uint64_t enqueued = 0;
+        uint64_t sent = 0;
+        /// @brief 队列满或发送出错丢弃的包数
+        uint64_t dropped = 0;
+        std::size_t queued_packets = 0;
+        std::size_t queued_bytes = 0;
+    };
+
+    PacedRtpStream(RtpPacer& pacer, std::size_t capacity, SendFn send);
+
+    PacedRtpStream(const PacedRtpStream&) = delete;
+    PacedRtpStream& operator=(const PacedRtpStream&) = delete;
+
+    /// @brief 入队一帧（打包器输出的batch），并按窗口重算发送速率
+    /// @param keepalive 负载所属缓冲区（如AVPacket）的持有者，包发出或丢弃后释放
+    /// @return 整帧被丢弃返回false
+    /// @details 队列放不下时，不被参考的帧直接丢弃；否则从队头按整帧丢弃旧包，
+    /// 让新到的帧（尤其是关键帧）尽快发出。单帧超过队列容量时整帧丢弃。
+    bool Enqueue(const RtpPacketBatch& batch, std::shared_ptr<const void> keepalive = nullptr);
+
+    /// @brief 停止发送并释放队列中的包，发送线程随后将其移出调度
+    void Close();
+
+    Stats stats() const;
+
+private:
+    friend class RtpPacer;
+
+    /// @brief 发送线程调用：补充令牌并尽量发包
+    /// @return 下一次需要服务的时间（微秒），队列已空或流已关闭返回-1
+    int64_t service(int64_t now_us);
+    void pop_front() noexcept;
+    /// @brief 丢弃队头直到下一个帧起始包
+    void drop_front_frame() noexcept;
+    std::size_t free_slots() const noexcept { return packets_.size() - count_; }
+
+    RtpPacer& pacer_;
+    SendFn send_;
+
+    mutable std::mutex mtx_;
+    /// @brief 固定容量环形队列，构造时分配；包连续存放，便于整段交给SendFn
+    std::vector<RtpPacketView> packets_;
+    /// @brief 与packets_一一对应的负载持有者
+    std::vector<std::shared_ptr<const void>> keepalive_;
+    std::size_t head_ = 0;
+    std::size_t count_ = 0;
+    std::size_t queued_bytes_ = 0;
+
+    /// @brief 令牌桶，单位字节；允许透支一个包
+    double tokens_ = 0;
+    /// @brief 速率，字节/微秒
+    double rate_ = 0;
+    int64_t last_refill_us_ = -1;
+
+    /// @brief 已在发送线程的调度堆中（或待加入）
+    bool scheduled_ = false;
+    bool closed_ = false;
+
+    Stats stats_;
+};
+
+/// @brief RTP发送节拍器：一个高精度定时线程按令牌桶平滑发送大量流
+/// @details 关键帧可能是几百个连续的RTP包，直接背靠背发出会打满交换机缓存和摄像机侧接收缓冲。
+/// 每个流入队一帧时，速率按"积压字节 / window"重算，使该帧在window内均匀发出。
+/// 发送线程用最小堆按下一次发送时间组织有积压的流，空闲的流不占调度开销；
+/// 同一tick内到期的流合并处理，每个流一次把可发的包整批交给SendFn（配合sendmmsg/GSO）。
+class RtpPacer {
+public:
+    struct Config {
+        /// @brief 每帧的发送窗口（毫秒），一般取帧间隔或略小
+        double window_ms = 20;
+        /// @brief 调度粒度（微秒），到期时间相差不足一个tick的流合并在同一次唤醒中发送
+        int64_t tick_us = 500;
+        /// @brief 令牌桶深度（字节），限制单次突发
+        std::size_t burst_bytes = 4 * 1500;
+        /// @brief 最低速率（比特/秒），避免小帧被拖得太慢
+        double min_rate_bps = 500000;
+        /// @brief 发送缓冲区满时的重试间隔（微秒）
+        int64_t retry_us = 1000;
+        /// @brief 每个流默认的队列容量（包）
+        std::size_t queue_capacity = 2048;
+        /// @brief 单次SendFn最多交付的包数
+        std::size_t max_batch = 64;
+    };
+
+    RtpPacer();
+    explicit RtpPacer(const Config& cfg);
+    ~RtpPacer();
+
+    RtpPacer(const RtpPacer&) = delete;
+    RtpPacer& operator=(const RtpPacer&) = delete;
+
+    /// @brief 启动发送线程
+    void Start();
+    /// @brief 停止发送线程，未发出的包保留在各流队列中
+    void Stop();
+
+    /// @brief 新建一路流
+    /// @param capacity 队列容量（包），0取Config::queue_capacity
+    std::shared_ptr<PacedRtpStream> AddStream(PacedRtpStream::SendFn send, std::size_t capacity = 0);
+
+    /// @brief 处理now_us前（含一个tick内）到期的流，返回最早的下一次到期时间，无待发流返回-1
+    /// @details 发送线程内部使用；未Start时可由调用方驱动（如测试或已有的事件循环）
+    int64_t Poll(int64_t now_us);
+
+    /// @brief 单调时钟，微秒
+    static int64_t NowUs();
+
+    const Config& config() const noexcept { return cfg_; }
+    /// @brief 当前有积压、处于调度中的流数
+    std::size_t active_streams() const noexcept { return active_.load(std::memory_order_relaxed); }
+
+private:
+    friend class PacedRtpStream;
+
+    struct Timer {
+        int64_t due_us;
+        std::shared_ptr<PacedRtpStream> stream;
+    };
+    struct TimerLater {
+        bool operator()(const Timer& a, const Timer& b) const noexcept { return a.due_us > b.due_us; }
+    };
+
+    /// @brief 流从空闲变为有积压时调用（持有流的锁）
+    void activate(PacedRtpStream* stream);
+    void run();
+
+    Config cfg_;
+
+    /// @brief 保护pending_与running_，并用于唤醒发送线程
+    std::mutex mtx_;
+    std::condition_variable cv_;
+    /// @brief 新激活、待加入调度堆的流
+    std::vector<std::shared_ptr<PacedRtpStream>> pending_;
+    std::vector<std::shared_ptr<PacedRtpStream>> pending_swap_;
+    bool running_ = false;
+    std::thread thread_;
+
+    /// @brief 调度堆，只由发送线程（或Poll的调用方）访问
+    std::vector<Timer> heap_;
+    std::atomic<std::size_t> active_{0};
+};
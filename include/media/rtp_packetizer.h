@@ -0,0 +1,191 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <algorithm>
+#include <vector>
+#include <sys/uio.h>
+#include "rtp.h"
+
+/// @brief NALU视图（不含起始码），指向调用方的码流缓冲区
+struct NalUnitView {
+    const uint8_t* data = nullptr;
+    std::size_t size = 0;
+};
+
+namespace NaluHelper {
+    /// @brief 按Annex-B起始码(00 00 01 / 00 00 00 01)切分NALU，不拷贝
+    /// @param data 码流，通常为AVPacket::data
+    /// @param size 码流长度
+    /// @param out 输出，追加写入（调用方负责clear，便于复用容量）
+    void SplitAnnexB(const uint8_t* data, std::size_t size, std::vector<NalUnitView>& out);
+
+    /// @brief 按长度前缀(AVCC/HVCC)切分NALU，不拷贝
+    /// @param length_size 长度字段字节数 1/2/4
+    /// @return 长度字段越界返回false
+    bool SplitLengthPrefixed(const uint8_t* data, std::size_t size, int length_size, std::vector<NalUnitView>& out);
+}
+
+/// @brief 单个RTP包的零拷贝描述
+/// @details RTP头、FU/AP头和聚合包的长度字段写在内联的小slab里，
+/// 负载iovec直接指向编码器输出（AVPacket::data），整帧不发生拷贝。
+/// 拷贝/移动时自动把指向slab的iovec重定位到新对象。
+/// 负载指向的码流在发送完成前必须保持有效。
+struct RtpPacketView {
+    /// @brief 单个聚合包(STAP-A/AP)最多容纳的NALU数
+    static constexpr std::size_t kMaxAggregate = 8;
+    /// @brief 聚合包第2个及以后NALU的长度字段在slab中的起始偏移
+    static constexpr std::size_t kSizeFieldOffset = 16;
+    /// @brief PS封装时一个包内可能出现的动态头：pack头(14) + 带PTS/DTS的PES头(19)
+    static constexpr std::size_t kPsHeaderRoom = 14 + 19;
+    /// @brief slab大小：RTP头 + 负载头 + 聚合长度字段，且能放下PS的动态头
+    static constexpr std::size_t kSlabSize = std::max(kSizeFieldOffset + 2 * kMaxAggregate, RTP_FIXED_HEADER_SIZE + kPsHeaderRoom);
+    /// @brief iovec最大个数
+    static constexpr std::size_t kMaxIov = 2 * kMaxAggregate;
+
+    /// @brief 包属性，供调度/丢弃策略使用
+    enum Flags : uint8_t {
+        kKeyframe   = 0x01, // 所属访问单元含IDR/IRAP
+        kDisposable = 0x02, // 所属访问单元不被参考，可优先丢弃
+        kFrameStart = 0x04  // 访问单元的第一个包
+    };
+
+    uint8_t slab[kSlabSize];
+    iovec iov[kMaxIov];
+    uint8_t iov_cnt = 0;
+    uint8_t flags = 0;
+    uint16_t seq = 0;
+    uint32_t timestamp = 0;
+    /// @brief 整包字节数（含RTP头）
+    std::size_t size = 0;
+
+    RtpPacketView() = default;
+    RtpPacketView(const RtpPacketView& other) { copy_from(other); }
+    RtpPacketView& operator=(const RtpPacketView& other) {
+        if (this != &other) {
+            copy_from(other);
+        }
+        return *this;
+    }
+
+    bool marker() const noexcept { return (slab[1] & 0x80) != 0; }
+
+    /// @brief 追加slab内的一段作为iovec
+    void push_slab(std::size_t offset, std::size_t len) noexcept {
+        iov[iov_cnt].iov_base = slab + offset;
+        iov[iov_cnt].iov_len = len;
+        ++iov_cnt;
+        size += len;
+    }
+
+    /// @brief 追加外部负载作为iovec
+    void push_data(const uint8_t* data, std::size_t len) noexcept {
+        iov[iov_cnt].iov_base = const_cast<uint8_t*>(data);
+        iov[iov_cnt].iov_len = len;
+        ++iov_cnt;
+        size += len;
+    }
+
+    /// @brief 拼接成连续字节，用于需要连续缓冲区的路径（如重传缓存、调试）
+    /// @return 写入字节数，cap不足返回0
+    std::size_t Flatten(uint8_t* dst, std::size_t cap) const noexcept;
+
+private:
+    void copy_from(const RtpPacketView& other) noexcept;
+};
+
+/// @brief 一个访问单元打包得到的RTP包集合，clear()保留容量，稳定后打包不再分配
+struct RtpPacketBatch {
+    std::vector<RtpPacketView> packets;
+
+    void clear() noexcept { packets.clear(); }
+    std::size_t size() const noexcept { return packets.size(); }
+    bool empty() const noexcept { return packets.empty(); }
+    /// @brief 总字节数
+    std::size_t bytes() const noexcept;
+};
+
+/// @brief RTP打包器基类，维护SSRC/序列号并负责Annex-B切分
+class RtpPacketizer {
+public:
+    struct Config {
+        uint8_t payload_type = 96;
+        uint32_t ssrc = 0;
+        uint16_t initial_seq = 0;
+        /// @brief 单个RTP包最大字节数（含RTP头，不含UDP/IP头）
+        std::size_t mtu = 1400;
+        /// @brief 是否将小NALU聚合(STAP-A/AP)
+        bool aggregate = true;
+    };
+
+    explicit RtpPacketizer(const Config& cfg);
+    virtual ~RtpPacketizer() = default;
+
+    /// @brief 打包一个Annex-B访问单元（编码器输出的AVPacket::data/size）
+    /// @param timestamp RTP时间戳
+    /// @param out 追加写入的包集合，最后一个包置marker
+    /// @return 本次产生的包数
+    std::size_t PacketizeAnnexB(const uint8_t* data, std::size_t size, uint32_t timestamp, RtpPacketBatch& out);
+
+    /// @brief 打包已切分好的一个访问单元
+    virtual std::size_t PacketizeNalus(const NalUnitView* nalus, std::size_t count, uint32_t timestamp, RtpPacketBatch& out) = 0;
+
+    uint16_t next_seq() const noexcept { return seq_; }
+    uint32_t ssrc() const noexcept { return cfg_.ssrc; }
+    uint8_t payload_type() const noexcept { return cfg_.payload_type; }
+    std::size_t mtu() const noexcept { return cfg_.mtu; }
+
+protected:
+    /// @brief 新建一个包并写好RTP头，负载头由子类写入slab[12..]
+    RtpPacketView& begin_packet(RtpPacketBatch& out, uint32_t timestamp, bool marker, uint8_t flags);
+
+    /// @brief 单包负载上限
+    std::size_t max_payload() const noexcept { return cfg_.mtu - RTP_FIXED_HEADER_SIZE; }
+
+    Config cfg_;
+    uint16_t seq_;
+    /// @brief 复用的NALU切分结果
+    std::vector<NalUnitView> nalus_;
+};
+
+/// @brief RFC 6184 H.264打包器，packetization-mode=1
+/// @details 小于MTU的NALU走Single NAL，相邻小NALU(SPS/PPS/SEI)聚合为STAP-A，
+/// 超过MTU的NALU拆分为FU-A
+class H264RtpPacketizer : public RtpPacketizer {
+public:
+    static constexpr uint8_t kStapA = 24;
+    static constexpr uint8_t kFuA = 28;
+
+    explicit H264RtpPacketizer(const Config& cfg);
+
+    std::size_t PacketizeNalus(const NalUnitView* nalus, std::size_t count, uint32_t timestamp, RtpPacketBatch& out) override;
+
+private:
+    void emit_single(const NalUnitView& nal, uint32_t ts, bool marker, uint8_t flags, RtpPacketBatch& out);
+    void emit_stap_a(const NalUnitView* nalus, std::size_t count, uint32_t ts, bool marker, uint8_t flags, RtpPacketBatch& out);
+    void emit_fu_a(const NalUnitView& nal, uint32_t ts, bool marker, uint8_t flags, RtpPacketBatch& out);
+};
+
+/// @brief RFC 7798 H.265打包器（不携带DONL，sprop-max-don-diff=0）
+/// @details 小于MTU的NALU走Single NAL，相邻小NALU(VPS/SPS/PPS/SEI)聚合为AP，
+/// 超过MTU的NALU拆分为FU
+class H265RtpPacketizer : public RtpPacketizer {
+public:
+    static constexpr uint8_t kAp = 48;
+    static constexpr uint8_t kFu = 49;
+
+    explicit H265RtpPacketizer(const Config& cfg);
+
+    std::size_t PacketizeNalus(const NalUnitView* nalus, std::size_t count, uint32_t timestamp, RtpPacketBatch& out) override;
+
+    /// @brief NALU类型
+    static uint8_t NalType(const uint8_t* nal) noexcept { return (nal[0] >> 1) & 0x3F; }
+    /// @brief 是否为IRAP(BLA/IDR/CRA)
+    static bool IsIrap(uint8_t type) noexcept { return type >= 16 && type <= 23; }
+    /// @brief 是否为子层非参考图像(TRAIL_N/TSA_N/STSA_N/RADL_N/RASL_N/RSV_VCL_N*)
+    static bool IsNonReference(uint8_t type) noexcept { return type < 16 && (type & 1) == 0; }
+
+private:
+    void emit_single(const NalUnitView& nal, uint32_t ts, bool marker, uint8_t flags, RtpPacketBatch& out);
+    void emit_ap(const NalUnitView* nalus, std::size_t count, uint32_t ts, bool marker, uint8_t flags, RtpPacketBatch& out);
+    void emit_fu(const NalUnitView& nal, uint32_t ts, bool marker, uint8_t flags, RtpPacketBatch& out);
+};
@@ -0,0 +1,105 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "net/udp_batch_socket.h"
+
+/// @brief RTP接收端口池
+/// @details 构造时把[port_min, port_max)内的端口对（RTP偶数，RTCP+1）全部打开、设好SO_RCVBUF并绑定，
+/// 呼叫风暴时每个INVITE/SETUP只是从空闲栈里取一个下标，不再现场socket/setsockopt/bind。
+/// 归还的端口先隔离quarantine_ms，让上一个会话对端还在路上的包过期，再回到空闲栈；
+/// 重新借出前清空socket里残留的数据报。借出和归还都是O(1)。
+/// 需通过std::make_shared创建，Lease持有池的引用。
+class RtpPortPool : public std::enable_shared_from_this<RtpPortPool> {
+public:
+    struct Config {
+        std::string ip = "0.0.0.0";
+        uint16_t port_min = 40000;
+        uint16_t port_max = 40400;
+        /// @brief 是否同时占用RTP+1作为RTCP端口
+        bool rtcp = true;
+        /// @brief RTP socket的SO_RCVBUF，码流突发或处理线程短暂卡顿时不丢包
+        int recv_buffer = 4 * 1024 * 1024;
+        /// @brief 接收slab，单个数据报上限和一次recvmmsg的个数；slab随池常驻，端口多时注意内存
+        std::size_t datagram_size = 1500;
+        std::size_t batch = 16;
+        /// @brief 归还后隔离的时长（毫秒）
+        int64_t quarantine_ms = 2000;
+    };
+
+    struct Stats {
+        std::size_t capacity = 0;
+        std::size_t free = 0;
+        std::size_t leased = 0;
+        std::size_t quarantined = 0;
+        uint64_t acquired = 0;
+        /// @brief 没有可用端口的Acquire次数
+        uint64_t exhausted = 0;
+    };
+
+    /// @brief 借出的一对端口，析构时归还
+    class Lease {
+    public:
+        Lease() = default;
+        ~Lease() { Release(); }
+        Lease(Lease&& other) noexcept;
+        Lease& operator=(Lease&& other) noexcept;
+        Lease(const Lease&) = delete;
+        Lease& operator=(const Lease&) = delete;
+
+        explicit operator bool() const noexcept { return pool_ != nullptr; }
+        uint16_t port() const noexcept;
+        net::UdpBatchSocket& rtp() const noexcept;
+        /// @brief 未启用RTCP时为nullptr
+        net::UdpBatchSocket* rtcp() const noexcept;
+        /// @brief 停止接收并归还，之后Lease为空；需在接收回调所在的executor上调用
+        void Release();
+
+    private:
+        friend class RtpPortPool;
+        Lease(std::shared_ptr<RtpPortPool> pool, uint32_t index) : pool_(std::move(pool)), index_(index) {}
+
+        std::shared_ptr<RtpPortPool> pool_;
+        uint32_t index_ = 0;
+    };
+
+    /// @brief 预绑定所有端口，被占用的端口跳过
+    RtpPortPool(ASIO::IoContext& io, const Config& cfg);
+
+    RtpPortPool(const RtpPortPool&) = delete;
+    RtpPortPool& operator=(const RtpPortPool&) = delete;
+
+    /// @brief 借一对端口，耗尽时返回空Lease
+    Lease Acquire();
+
+    Stats stats() const;
+    std::size_t capacity() const noexcept { return entries_.size(); }
+    const Config& config() const noexcept { return cfg_; }
+
+private:
+    struct Entry {
+        std::unique_ptr<net::UdpBatchSocket> rtp;
+        std::unique_ptr<net::UdpBatchSocket> rtcp;
+        uint16_t port = 0;
+        int64_t released_ms = 0;
+    };
+
+    void release(uint32_t index);
+    /// @brief 持锁调用：隔离期满的端口回到空闲栈
+    void reclaim(int64_t now_ms);
+    static int64_t now_ms();
+
+    Config cfg_;
+    std::vector<Entry> entries_;
+
+    mutable std::mutex mtx_;
+    std::vector<uint32_t> free_;
+    /// @brief 按归还时间排序
+    std::deque<uint32_t> quarantine_;
+    uint64_t acquired_ = 0;
+    uint64_t exhausted_ = 0;
+};
@@ -0,0 +1,95 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include "rtp_packetizer.h"
+
+/// @brief 发送端RTP重传缓存，响应RTCP通用NACK
+/// @details 按序号低位索引的环形表保存最近发出的包：保存的是RtpPacketView（RTP头/负载头在slab里）
+/// 加上负载所属缓冲区的引用计数，不拷贝负载。收到NACK时按原SSRC/序号重发（不使用RFC 4588的RTX封装），
+/// 重传字节走独立的令牌桶，速率上限取实时发送码率的一定比例，避免重传挤占直播流量。
+/// 同一个包在一个RTT内只重传一次，超过max_age的包已错过对端播放点，不再重传。
+/// 线程安全：发送线程Store，RTCP接收线程OnNack。
+class RtpRtxCache {
+public:
+    struct Config {
+        /// @brief 缓存包数，向上取2的幂
+        std::size_t capacity = 1024;
+        /// @brief 超过该时长的包不再重传（毫秒）
+        int64_t max_age_ms = 1000;
+        /// @brief 同一个包两次重传的最小间隔（毫秒），取一个RTT左右
+        int64_t min_resend_interval_ms = 20;
+        /// @brief 重传码率上限占实时发送码率的比例
+        double max_ratio = 0.25;
+        /// @brief 重传码率下限（比特/秒），码率统计尚未稳定或码率很低时使用
+        double min_bitrate_bps = 256000;
+    };
+
+    struct Stats {
+        uint64_t stored = 0;
+        uint64_t requested = 0;
+        uint64_t resent = 0;
+        /// @brief 已被覆盖或从未发出
+        uint64_t missing = 0;
+        uint64_t expired = 0;
+        /// @brief 一个RTT内重复请求
+        uint64_t duplicate = 0;
+        /// @brief 超出重传码率被放弃
+        uint64_t throttled = 0;
+    };
+
+    /// @brief 待重传的包，keepalive保证发送完成前负载有效
+    struct RtxPacket {
+        RtpPacketView packet;
+        std::shared_ptr<const void> keepalive;
+    };
+
+    RtpRtxCache();
+    explicit RtpRtxCache(const Config& cfg);
+
+    /// @brief 记录一个已发出的包
+    void Store(const RtpPacketView& packet, const std::shared_ptr<const void>& keepalive, int64_t now_ms);
+    /// @brief 记录batch中的全部包
+    void Store(const RtpPacketBatch& batch, const std::shared_ptr<const void>& keepalive, int64_t now_ms);
+
+    /// @brief 处理NACK请求的序号，可重传的包追加到out（调用方负责clear，便于复用容量）
+    /// @return 本次追加的包数
+    std::size_t OnNack(const uint16_t* seqs, std::size_t count, int64_t now_ms, std::vector<RtxPacket>& out);
+
+    /// @brief 当前重传码率上限（比特/秒）
+    double budget_bps() const;
+    Stats stats() const;
+    void Clear();
+
+private:
+    struct Slot {
+        RtpPacketView packet;
+        std::shared_ptr<const void> keepalive;
+        int64_t sent_ms = 0;
+        /// @brief 最近一次重传时间，-1表示未重传过
+        int64_t resent_ms = -1;
+        bool valid = false;
+    };
+
+    /// @brief 持有mtx_调用
+    double budget_locked() const noexcept;
+    void refill(int64_t now_ms) noexcept;
+
+    Config cfg_;
+    mutable std::mutex mtx_;
+    std::vector<Slot> slots_;
+    std::size_t mask_;
+
+    /// @brief 实时发送码率统计（比特/秒），按窗口平滑
+    double live_bps_ = 0;
+    uint64_t window_bytes_ = 0;
+    int64_t window_start_ms_ = -1;
+
+    /// @brief 重传令牌（字节）
+    double tokens_ = 0;
+    int64_t last_refill_ms_ = -1;
+
+    Stats stats_;
+};
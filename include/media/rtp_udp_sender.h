@@ -0,0 +1,38 @@
+#pragma once
+#include <vector>
+#include "rtp_packetizer.h"
+#include "net/udp_batch_socket.h"
+
+/// @brief 把打包器输出的RtpPacketBatch一次性交给UdpBatchSocket
+/// @details 同一帧的FU分片除最后一个外等长，UdpBatchSocket会把它们合并为一个GSO发送，
+/// 其余包走sendmmsg。iovec直接指向RtpPacketView，不拷贝负载。
+class RtpUdpSender {
+public:
+    explicit RtpUdpSender(net::UdpBatchSocket& socket) : socket_(socket) {}
+
+    /// @brief 发送batch中从first开始的包
+    /// @return 实际发出的包数，发送缓冲区满时可能小于剩余包数，出错返回-1
+    int Send(const ASIO::UdpEndpoint& to, const RtpPacketBatch& batch, std::size_t first = 0) {
+        if (first >= batch.packets.size()) {
+            return 0;
+        }
+        return Send(to, batch.packets.data() + first, batch.packets.size() - first);
+    }
+
+    /// @brief 发送连续的count个包，可直接用作PacedRtpStream::SendFn
+    int Send(const ASIO::UdpEndpoint& to, const RtpPacketView* packets, std::size_t count) {
+        out_.clear();
+        for (std::size_t i = 0; i < count; ++i) {
+            out_.push_back({packets[i].iov, packets[i].iov_cnt});
+        }
+        if (out_.empty()) {
+            return 0;
+        }
+        return socket_.SendBatch(to, out_.data(), out_.size());
+    }
+
+private:
+    net::UdpBatchSocket& socket_;
+    /// @brief 复用容量，稳定后不再分配
+    std::vector<net::UdpOutDatagram> out_;
+};
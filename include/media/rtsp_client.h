@@ -0,0 +1,176 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+#include "rtsp.h"
+#include "sdp.h"
+#include "rtcp.h"
+#include "rtp_jitter_buffer.h"
+#include "rtsp_interleaved.h"
+#include "rtp_port_pool.h"
+#include "net/udp_batch_socket.h"
+
+/// @brief 原生RTSP拉流客户端，替代每路一个avformat_open_input阻塞线程的方式
+/// @details 完全异步：解析 -> 连接 -> OPTIONS -> DESCRIBE -> SETUP(每个视频轨道) -> PLAY，
+/// 之后用GET_PARAMETER（服务端不支持时用OPTIONS）保活。所有回调在客户端自己的strand上执行，
+/// 任意多个客户端共享少量io线程。
+/// 支持URL中的user:pass@，遇到401时按WWW-Authenticate做Digest（RFC 2617，含qop=auth）或Basic认证。
+/// RTP直接写入每个轨道的RtpJitterBuffer，按序组帧后以零拷贝的AccessUnitView回调；
+/// 同时按RFC 3550发送接收报告，部分摄像机依赖RR判断会话存活。
+/// 需通过std::make_shared创建。
+class RtspClient : public Rtsp {
+public:
+    struct Config {
+        /// @brief true为RTP/AVP/TCP interleaved，false为UDP单播
+        bool tcp = true;
+        /// @brief 连接和每个请求等待应答的超时（毫秒）
+        int timeout_ms = 5000;
+        /// @brief 播放中超过该时长没有收到媒体判定断流（毫秒）
+        int media_timeout_ms = 10000;
+        /// @brief 保活间隔（秒），0表示取服务端Session timeout的一半
+        int keepalive_s = 0;
+        /// @brief TCP接收缓冲大小，需能容纳一个最大的interleaved帧
+        std::size_t recv_buffer_size = 128 * 1024;
+        std::string user_agent = "media-rtsp-client";
+        RtpJitterBuffer::Config jitter;
+        /// @brief UDP模式下从端口池借预绑定的端口对，为空时每次SETUP现开socket
+        /// @details 池的datagram_size需不小于jitter.slot_size
+        std::shared_ptr<RtpPortPool> port_pool;
+    };
+
+    enum class State {
+        Idle,
+        Connecting,
+        Options,
+        Describe,
+        Setup,
+        Play,
+        Playing,
+        Closed
+    };
+
+    struct Stats {
+        uint64_t bytes = 0;
+        uint64_t rtp_packets = 0;
+        uint64_t frames = 0;
+        uint64_t corrupted_frames = 0;
+    };
+
+    /// @brief 一个完整访问单元，au在回调返回前有效
+    using FrameHandler = std::function<void(const SdpTrack& track, AccessUnitView& au)>;
+    /// @brief 会话异常结束（连接失败、认证失败、应答超时、断流、对端关闭），之后可重新Start
+    using ErrorHandler = std::function<void(const std::string& reason)>;
+
+    RtspClient(ASIO::IoContext& io, const Config& cfg);
+    explicit RtspClient(ASIO::IoContext& io);
+    ~RtspClient() override;
+
+    /// @brief 开始拉流，url非法返回false
+    bool Start(const std::string& url);
+    /// @brief 停止拉流，不触发ErrorHandler，可在任意线程调用
+    void Stop();
+
+    /// @brief 需在Start之前设置
+    void SetFrameHandler(FrameHandler handler) { frame_handler_ = std::move(handler); }
+    void SetErrorHandler(ErrorHandler handler) { error_handler_ = std::move(handler); }
+
+    State state() const noexcept { return state_.load(std::memory_order_relaxed); }
+    Stats stats() const;
+
+    /// @brief 计算Digest认证的response（RFC 2617），qop为空时使用RFC 2069的简化形式
+    static std::string DigestResponse(const std::string& username, const std::string& realm, const std::string& password,
+                                      const std::string& method, const std::string& uri, const std::string& nonce,
+                                      const std::string& nc, const std::string& cnonce, const std::string& qop);
+
+private:
+    struct Track {
+        SdpTrack sdp;
+        /// @brief SETUP使用的URL
+        std::string url;
+        std::unique_ptr<RtpJitterBuffer> jitter;
+        std::unique_ptr<RtcpSession> rtcp;
+        uint8_t rtp_channel = 0;
+        uint8_t rtcp_channel = 1;
+        /// @brief UDP模式下的本地端口对和服务端RTCP地址
+        /// @details rtp_socket/rtcp_socket指向自己打开的socket或从端口池借来的socket
+        std::unique_ptr<net::UdpBatchSocket> owned_rtp;
+        std::unique_ptr<net::UdpBatchSocket> owned_rtcp;
+        RtpPortPool::Lease lease;
+        net::UdpBatchSocket* rtp_socket = nullptr;
+        net::UdpBatchSocket* rtcp_socket = nullptr;
+        ASIO::UdpEndpoint server_rtcp;
+        /// @brief 只接收来自服务端地址的RTP/RTCP
+        boost::asio::ip::address server_address;
+    };
+
+    std::shared_ptr<RtspClient> self() { return std::static_pointer_cast<RtspClient>(shared_from_this()); }
+
+    void do_resolve();
+    void do_connect(const boost::asio::ip::tcp::resolver::results_type& endpoints);
+    void do_read();
+    /// @return false时已结束会话
+    bool process();
+    void on_response(const RtspMessage& msg);
+    void on_describe(const RtspMessage& msg);
+    void on_setup(const RtspMessage& msg);
+    void send_setup();
+    void send_request(const std::string& method, const std::string& url, const std::string& extra = std::string());
+    /// @brief 按挑战生成Authorization头（含结尾CRLF），尚无挑战时为空
+    std::string authorization(const std::string& method, const std::string& url);
+    /// @brief 解析401应答中的挑战，不支持的认证方式返回false
+    bool parse_challenge(const RtspMessage& msg);
+    bool open_udp(Track& track);
+
+    void on_rtp(Track& track, const uint8_t* data, std::size_t size);
+    void on_rtcp(Track& track, const uint8_t* data, std::size_t size);
+    void drain(Track& track, int64_t now_ms);
+
+    void arm_timer();
+    void on_tick();
+    void fail(const std::string& reason);
+    void close();
+    /// @brief 丢弃当前轨道，须在close()之后调用；自有socket延后析构，见实现
+    void retire_tracks();
+    static int64_t now_ms();
+
+    Config cfg_;
+    boost::asio::strand<ASIO::IoContext::executor_type> strand_;
+    ASIO::TcpSocket socket_;
+    boost::asio::ip::tcp::resolver resolver_;
+    boost::asio::steady_timer timer_;
+    std::shared_ptr<RtspInterleavedTransport> transport_;
+    std::vector<uint8_t> rbuf_;
+    std::size_t used_ = 0;
+
+    std::atomic<State> state_{State::Idle};
+    /// @brief 递增的会话代数，Stop/重新Start后丢弃旧会话的迟到回调
+    uint64_t generation_ = 0;
+
+    int cseq_ = 0;
+    std::string method_;
+    std::string request_url_;
+    std::string request_extra_;
+    int64_t request_deadline_ms_ = -1;
+    bool auth_retried_ = false;
+
+    std::string public_;
+    std::string content_base_;
+    std::string session_;
+    int session_timeout_s_ = 60;
+    std::vector<std::unique_ptr<Track>> tracks_;
+    std::size_t setup_index_ = 0;
+    int64_t last_media_ms_ = 0;
+    int64_t next_keepalive_ms_ = 0;
+
+    FrameHandler frame_handler_;
+    ErrorHandler error_handler_;
+
+    std::atomic<uint64_t> bytes_{0};
+    std::atomic<uint64_t> rtp_packets_{0};
+    std::atomic<uint64_t> frames_{0};
+    std::atomic<uint64_t> corrupted_frames_{0};
+};
@@ -0,0 +1,130 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <array>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "rtp_packetizer.h"
+#include "net/asio_socket.h"
+
+/// @brief RTSP interleaved帧头 '$' + channel + 2字节长度（RFC 2326 10.12）
+#define RTSP_INTERLEAVED_HEADER_SIZE 4
+
+/// @brief RTP/RTCP over RTSP（TCP interleaved）发送端
+/// @details 每个RTP包以'$'帧头 + 打包器的iovec（RTP头、FU头在RtpPacketView的slab里，负载指向编码器输出）
+/// 组成gather buffer，一批包一次async_write，负载不做拷贝。
+/// 每个连接的待发队列按字节有界，慢客户端积压时依次：
+/// 丢弃新到的不被参考帧 -> 丢弃队列里的不被参考帧 -> 关键帧到来时清空积压的媒体包 ->
+/// 丢弃参考帧并在该通道进入"等关键帧"状态，直到下一个关键帧（可通过回调请求编码器出关键帧）。
+/// RTSP应答和RTCP作为控制数据永不丢弃。
+/// Send*可在任意线程调用，写操作在socket所属的io_context线程执行。
+class RtspInterleavedTransport : public std::enable_shared_from_this<RtspInterleavedTransport> {
+public:
+    struct Config {
+        /// @brief 待发队列上限（字节，不含正在写的一批）
+        std::size_t max_queued_bytes = 2 * 1024 * 1024;
+        /// @brief 积压低于该值时writable()为true，供上层做流控
+        std::size_t low_watermark = 256 * 1024;
+    };
+
+    enum class SendResult {
+        Queued,
+        /// @brief 因积压被丢弃
+        Dropped,
+        Closed
+    };
+
+    struct Stats {
+        uint64_t sent_packets = 0;
+        uint64_t sent_bytes = 0;
+        uint64_t dropped_packets = 0;
+        uint64_t dropped_frames = 0;
+        std::size_t queued_bytes = 0;
+    };
+
+    using KeyframeRequestHandler = std::function<void(uint8_t channel)>;
+    using ErrorHandler = std::function<void(const boost::system::error_code& ec)>;
+
+    RtspInterleavedTransport(ASIO::TcpSocket& socket, const Config& cfg);
+    explicit RtspInterleavedTransport(ASIO::TcpSocket& socket);
+
+    RtspInterleavedTransport(const RtspInterleavedTransport&) = delete;
+    RtspInterleavedTransport& operator=(const RtspInterleavedTransport&) = delete;
+
+    /// @brief 发送一个访问单元的RTP包
+    /// @param channel interleaved通道号（SETUP中的interleaved=0-1里的RTP通道）
+    /// @param keepalive 负载所属缓冲区的持有者，写完或丢弃后释放
+    SendResult SendRtp(uint8_t channel, const RtpPacketBatch& batch, std::shared_ptr<const void> keepalive = nullptr);
+
+    /// @brief 发送RTCP包（拷贝），不受丢弃策略影响
+    SendResult SendRtcp(uint8_t channel, const uint8_t* data, std::size_t size);
+
+    /// @brief 发送RTSP应答等文本（拷贝），与媒体包按顺序写出
+    SendResult SendControl(std::string text);
+
+    /// @brief 丢弃待发数据并关闭socket
+    void Close();
+
+    void SetKeyframeRequestHandler(KeyframeRequestHandler handler);
+    void SetErrorHandler(ErrorHandler handler);
+
+    /// @brief 积压低于低水位
+    bool writable() const;
+    Stats stats() const;
+
+    /// @brief 从接收缓冲中解析一个interleaved帧
+    /// @param data 以'$'开头的数据
+    /// @return 整帧字节数（含4字节头），数据不完整返回0
+    static std::size_t ParseFrame(const uint8_t* data, std::size_t size, uint8_t& channel,
+                                  const uint8_t*& payload, std::size_t& payload_size);
+
+private:
+    struct Entry {
+        uint8_t prefix[RTSP_INTERLEAVED_HEADER_SIZE];
+        /// @brief 媒体包，iov_cnt为0表示控制数据
+        RtpPacketView packet;
+        /// @brief 控制数据（RTSP文本或RTCP，RTCP已带帧头）
+        std::string raw;
+        std::shared_ptr<const void> keepalive;
+        uint8_t channel = 0;
+        bool media = false;
+
+        std::size_t bytes() const noexcept {
+            return media ? RTSP_INTERLEAVED_HEADER_SIZE + packet.size : raw.size();
+        }
+    };
+
+    /// @brief 持有mtx_调用：按丢弃策略为新帧腾出空间
+    /// @return 新帧应被丢弃返回false
+    bool make_room(uint8_t channel, uint8_t flags, std::size_t bytes);
+    /// @brief 持有mtx_调用：丢弃pending_中满足条件的媒体包
+    template <class Pred>
+    void drop_pending_if(Pred pred);
+    /// @brief 持有mtx_调用：必要时投递一次写
+    void kick();
+    void start_write();
+    void on_write(const boost::system::error_code& ec);
+
+    ASIO::TcpSocket& socket_;
+    Config cfg_;
+
+    mutable std::mutex mtx_;
+    /// @brief 待发队列，写出时整体与writing_交换，两者容量稳定后不再分配
+    std::vector<Entry> pending_;
+    std::size_t pending_bytes_ = 0;
+    /// @brief 正在写的一批，写完成前buffers_指向其中的包
+    std::vector<Entry> writing_;
+    std::vector<boost::asio::const_buffer> buffers_;
+    /// @brief 已投递写操作或正在写
+    bool write_scheduled_ = false;
+    bool closed_ = false;
+    /// @brief 各通道是否在等关键帧
+    std::array<bool, 256> wait_keyframe_{};
+
+    KeyframeRequestHandler keyframe_handler_;
+    ErrorHandler error_handler_;
+    Stats stats_;
+};
@@ -0,0 +1,311 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <array>
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "sdp.h"
+#include "gop_cache.h"
+#include "rtp_pacer.h"
+#include "rtp_packetizer.h"
+#include "rtp_rtx_cache.h"
+#include "rtp_udp_sender.h"
+#include "rtsp_interleaved.h"
+#include "net/udp_batch_socket.h"
+#include "net/asio_timer_wheel.h"
+
+/// @brief 一个源最多的媒体轨道数（视频 + 音频）
+#define RTSP_MAX_TRACKS 2
+
+/// @brief 一个观看者在某个源上的发送目的地
+/// @details 由RTSP会话在SETUP时建立，PLAY时挂到源的订阅者索引上，TEARDOWN或连接断开时摘除。
+/// 源的推流线程只读这些字段（wait_keyframe除外），建立后不再修改。
+struct RtspSubscriber {
+    struct Sink {
+        bool enabled = false;
+        /// @brief true走RTSP连接的interleaved通道，false走UDP
+        bool interleaved = false;
+        uint8_t channel = 0;
+        ASIO::UdpEndpoint rtp_to;
+        /// @brief UDP观看者发RTCP的地址（client_port的第二个端口），源据此把接收报告交给会话
+        ASIO::UdpEndpoint rtcp_from;
+        /// @brief 源配置了节拍器时UDP目的地的发送队列，挂到源上时建立，摘除时关闭
+        std::shared_ptr<PacedRtpStream> paced;
+        /// @brief 新加入的订阅者从关键帧开始收，只由该轨道的推流线程修改
+        std::atomic<bool> wait_keyframe{true};
+    };
+
+    std::array<Sink, RTSP_MAX_TRACKS> sinks;
+    /// @brief interleaved发送端，纯UDP的订阅者也用它回RTSP应答
+    std::shared_ptr<RtspInterleavedTransport> transport;
+    /// @brief 持有RTSP会话（transport引用其socket），从索引摘除后随最后一个快照释放
+    std::shared_ptr<const void> owner;
+    /// @brief UDP观看者发来的RTCP，在源的io线程回调，data只在回调期间有效
+    std::function<void(std::size_t track, const uint8_t* data, std::size_t size)> rtcp_handler;
+};
+
+/// @brief 一路直播源：编码输出只打包一次，同一批RTP包发给所有订阅者
+/// @details 每个轨道一个打包器，所有订阅者共享SSRC和序列号（PLAY应答的RTP-Info告知起始序号），
+/// UDP订阅者经该轨道的UdpBatchSocket用sendmmsg/GSO发出，interleaved订阅者把同一批RtpPacketView
+/// 交给各自连接的发送队列，负载始终指向编码器输出，靠keepalive延长生命周期。
+/// 订阅者索引是不可变的快照，读侧只做一次原子load，增删订阅者时复制后整体替换，
+/// 推流线程不会与RTSP信令线程争锁。
+/// 开启GOP缓存时，打包好的RTP包组（连同负载引用）按帧缓存，新订阅者先收到从最近关键帧开始的缓存包，
+/// 序号与随后的实时包连续，首帧无需等待下一个关键帧。
+/// 配置了RtpPacer时，UDP订阅者的包（含GOP回放）只在推流锁内入队，由节拍器线程在锁外平滑发出。
+/// 发给UDP订阅者的包同时记入轨道的重传缓存，观看者的NACK经其会话的RtcpSession转到Retransmit。
+/// 同一轨道的Push*需串行调用，不同轨道可在不同线程调用。
+class RtspMediaSource : public std::enable_shared_from_this<RtspMediaSource> {
+public:
+    struct Config {
+        /// @brief H264/H265，Unknown表示无视频
+        SdpCodec video_codec = SdpCodec::H264;
+        /// @brief 编码器的Annex-B extradata（SPS/PPS[/VPS]），为空时从首个关键帧中提取
+        std::vector<uint8_t> video_extradata;
+        /// @brief PCMA/PCMU，Unknown表示无音频
+        SdpCodec audio_codec = SdpCodec::Unknown;
+        uint32_t audio_sample_rate = 8000;
+        std::size_t mtu = 1400;
+        std::string session_name = "live";
+        /// @brief 有新的观看者时请求编码器出关键帧，缩短首屏等待
+        bool request_keyframe_on_join = true;
+        /// @brief 缓存最近一个GOP回放给新订阅者；回放为空时才向编码器请求关键帧
+        bool enable_gop_cache = true;
+        GopCacheConfig gop_cache;
+        /// @brief UDP订阅者共用的发送节拍器，为空时在推流线程直接发送（回放一次性突发）
+        std::shared_ptr<RtpPacer> pacer;
+        /// @brief 缓存发给UDP订阅者的包，响应观看者的NACK
+        bool enable_rtx = true;
+        RtpRtxCache::Config rtx;
+    };
+
+    struct Stats {
+        uint64_t frames = 0;
+        uint64_t packets = 0;
+        /// @brief 发往所有订阅者的包数
+        uint64_t fanout_packets = 0;
+        /// @brief UDP发送缓冲满未发出的包数
+        uint64_t udp_dropped = 0;
+        /// @brief 被interleaved发送队列丢弃的帧数
+        uint64_t tcp_dropped_frames = 0;
+        std::size_t subscribers = 0;
+        /// @brief 回放给新订阅者的缓存帧数
+        uint64_t replayed_frames = 0;
+        /// @brief 从UDP观看者收到并交给其会话的RTCP包数
+        uint64_t viewer_rtcp = 0;
+        /// @brief 按NACK重传的包数
+        uint64_t retransmitted = 0;
+        std::size_t gop_cache_frames = 0;
+        std::size_t gop_cache_bytes = 0;
+    };
+
+    /// @brief 订阅者收到的第一个包的序号和时间戳，用于RTP-Info
+    struct TrackPosition {
+        uint16_t seq = 0;
+        uint32_t rtptime = 0;
+    };
+    using TrackPositions = std::array<TrackPosition, RTSP_MAX_TRACKS>;
+
+    using SubscriberList = std::vector<std::shared_ptr<RtspSubscriber>>;
+    using KeyframeRequestHandler = std::function<void()>;
+    /// @brief 订阅者挂上之后、第一个媒体包发出之前调用，用于先回PLAY应答
+    using JoinHandler = std::function<void(const TrackPositions& positions)>;
+
+    explicit RtspMediaSource(const Config& cfg);
+    ~RtspMediaSource();
+
+    RtspMediaSource(const RtspMediaSource&) = delete;
+    RtspMediaSource& operator=(const RtspMediaSource&) = delete;
+
+    /// @brief 推入一个Annex-B视频访问单元
+    /// @param timestamp 90kHz RTP时间戳
+    /// @param keepalive data所属缓冲区的持有者，interleaved队列写完前保持有效
+    bool PushVideo(const uint8_t* data, std::size_t size, uint32_t timestamp, std::shared_ptr<const void> keepalive = nullptr);
+    /// @brief 推入一帧G.711音频，timestamp为采样率时钟
+    bool PushAudio(const uint8_t* data, std::size_t size, uint32_t timestamp, std::shared_ptr<const void> keepalive = nullptr);
+
+    /// @brief 生成DESCRIBE应答的SDP
+    std::string Describe(const std::string& origin_ip) const;
+
+    std::size_t track_count() const noexcept { return track_count_; }
+    /// @brief 轨道的a=control，如"trackID=0"
+    std::string track_control(std::size_t track) const;
+    uint32_t track_ssrc(std::size_t track) const;
+    /// @brief 下一个包的序号和最近的RTP时间戳，用于RTP-Info
+    void track_position(std::size_t track, uint16_t& seq, uint32_t& rtptime) const;
+
+    /// @brief 为轨道挂上UDP发送socket（RTP/RTCP一对），已有时忽略
+    /// @details RTCP socket收到的观看者报告按来源地址交给对应订阅者；源需由shared_ptr持有
+    /// @return 轨道已有UDP socket或挂载成功
+    bool AttachUdp(std::size_t track, std::unique_ptr<net::UdpBatchSocket> rtp, std::unique_ptr<net::UdpBatchSocket> rtcp);
+    bool has_udp(std::size_t track) const;
+    /// @brief 轨道的UDP RTP端口，RTCP为+1，未挂载返回0
+    uint16_t udp_port(std::size_t track) const;
+    /// @brief 把NACK请求的包从重传缓存发往to，缓存里没有、过期或超出重传码率的跳过
+    /// @return 重传的包数
+    std::size_t Retransmit(std::size_t track, const ASIO::UdpEndpoint& to, const uint16_t* seqs, std::size_t count);
+
+    /// @brief 挂上订阅者并回放GOP缓存
+    /// @param on_join 在持有各轨道推流锁时调用，不能回调本源的Push*
+    void AddSubscriber(std::shared_ptr<RtspSubscriber> subscriber, const JoinHandler& on_join = nullptr);
+    void RemoveSubscriber(const RtspSubscriber* subscriber);
+    /// @brief 当前订阅者快照
+    std::shared_ptr<const SubscriberList> subscribers() const;
+
+    /// @brief 编码器出关键帧的请求入口（新观看者加入、TCP观看者积压丢帧）
+    void SetKeyframeRequestHandler(KeyframeRequestHandler handler);
+    void RequestKeyframe();
+
+    /// @brief 摘除全部订阅者并关闭其RTSP连接，释放UDP端口
+    /// @details 源持有的UDP socket在io线程中关闭；未调用Close时需在io_context停止后析构源
+    void Close();
+
+    Stats stats() const;
+
+private:
+    /// @brief GOP缓存中的一帧：打包结果和负载的持有者，推流方没有给keepalive时负载拷贝到data
+    struct CachedFrame {
+        RtpPacketBatch batch;
+        std::shared_ptr<const void> keepalive;
+        std::vector<uint8_t> data;
+    };
+
+    struct Track {
+        SdpTrack sdp;
+        /// @brief 串行化同一轨道的推流，保护打包状态和UDP发送缓冲
+        mutable std::mutex mtx;
+        std::unique_ptr<RtpPacketizer> packetizer;
+        RtpPacketBatch batch;
+        /// @brief 音频轨道自己维护序号
+        uint32_t ssrc = 0;
+        uint16_t seq = 0;
+        uint32_t last_timestamp = 0;
+        std::unique_ptr<net::UdpBatchSocket> rtp_socket;
+        std::unique_ptr<net::UdpBatchSocket> rtcp_socket;
+        std::unique_ptr<RtpUdpSender> sender;
+        /// @brief UDP发送的重传缓存，挂上UDP socket时建立
+        std::unique_ptr<RtpRtxCache> rtx;
+        /// @brief Retransmit的输出，持有mtx复用
+        std::vector<RtpRtxCache::RtxPacket> rtx_out;
+        /// @brief 节拍器线程经sender发送时持有，替换sender时在mtx之后加锁
+        std::mutex send_mtx;
+        /// @brief 缓存帧复用池，按创建顺序排列；前free_frames个已确认只剩池持有
+        std::deque<std::shared_ptr<CachedFrame>> frame_pool;
+        std::size_t free_frames = 0;
+    };
+
+    /// @brief 持有track.mtx调用：把track.batch发给所有订阅者
+    /// @param frame 本帧在GOP缓存中的副本，可为空；平滑发送的订阅者需要时再建
+    void fan_out(std::size_t index, Track& track, const uint8_t* data, std::size_t size,
+                 const std::shared_ptr<const void>& keepalive, std::shared_ptr<const CachedFrame> frame);
+    /// @brief 持有track.mtx调用：把batch发给一个订阅者的一个轨道
+    /// @return 发出（或进入发送队列）的包数
+    std::size_t send_to(RtspSubscriber& sub, RtspSubscriber::Sink& sink, Track& track, const RtpPacketBatch& batch,
+                        const std::shared_ptr<const void>& keepalive, uint64_t& udp_dropped);
+    /// @brief 持有track.mtx调用：从复用池取一个缓存帧，稳态下不分配
+    std::shared_ptr<CachedFrame> acquire_frame(Track& track);
+    /// @brief 持有track.mtx调用：把track.batch装入一个缓存帧，负载没有持有者时拷贝
+    std::shared_ptr<CachedFrame> hold_frame(Track& track, const uint8_t* data, std::size_t size,
+                                            const std::shared_ptr<const void>& keepalive);
+    /// @brief 持有track.mtx调用：把track.batch放入GOP缓存
+    std::shared_ptr<const CachedFrame> cache_frame(std::size_t index, Track& track, const uint8_t* data, std::size_t size,
+                                                   const std::shared_ptr<const void>& keepalive, uint8_t flags);
+    /// @brief 节拍器线程调用：经轨道的UDP socket发出，轨道已关闭返回-1
+    int paced_send(std::size_t index, const ASIO::UdpEndpoint& to, const RtpPacketView* packets, std::size_t count);
+    /// @brief io线程调用：把观看者发到轨道RTCP端口的报告按来源地址分给订阅者
+    void on_viewer_rtcp(std::size_t index, const net::UdpDatagram* dgrams, std::size_t count);
+    /// @brief 持有track.mtx调用：G.711按MTU切包
+    void packetize_audio(Track& track, const uint8_t* data, std::size_t size, uint32_t timestamp);
+
+    Config cfg_;
+    std::array<Track, RTSP_MAX_TRACKS> tracks_;
+    std::size_t track_count_ = 0;
+    int video_track_ = -1;
+    int audio_track_ = -1;
+    /// @brief 参数集是否已就绪（来自extradata或关键帧）
+    bool have_parameter_sets_ = false;
+
+    /// @brief 订阅者索引，读侧无锁；写侧在mtx_下复制替换
+    std::atomic<std::shared_ptr<const SubscriberList>> subscribers_;
+    mutable std::mutex mtx_;
+    KeyframeRequestHandler keyframe_handler_;
+    std::unique_ptr<GopCache<CachedFrame>> gop_cache_;
+
+    std::atomic<uint64_t> frames_{0};
+    std::atomic<uint64_t> packets_{0};
+    std::atomic<uint64_t> fanout_packets_{0};
+    std::atomic<uint64_t> udp_dropped_{0};
+    std::atomic<uint64_t> tcp_dropped_frames_{0};
+    std::atomic<uint64_t> replayed_frames_{0};
+    std::atomic<uint64_t> viewer_rtcp_{0};
+    std::atomic<uint64_t> retransmitted_{0};
+};
+
+class RtspServerSession;
+
+/// @brief RTSP服务端：OPTIONS/DESCRIBE/SETUP/PLAY/TEARDOWN/GET_PARAMETER
+/// @details 每个TCP连接一个会话（会话运行在自己的strand上），SETUP支持RTP/AVP（UDP单播）和
+/// RTP/AVP/TCP（interleaved）。UDP端口在某个源第一次有UDP观看者时从[rtp_port_min, rtp_port_max)分配，
+/// 同一源的所有UDP观看者共用这一对端口。
+/// 会话超时挂在服务端共享的时间轮上，每个会话一个轮上节点，不再各自占用一个steady_timer。
+/// 需通过std::make_shared创建。
+class RtspServer : public std::enable_shared_from_this<RtspServer> {
+public:
+    struct Config {
+        uint16_t port = 554;
+        /// @brief 服务端RTP端口范围，成对分配（RTP偶数，RTCP+1）
+        uint16_t rtp_port_min = 30000;
+        uint16_t rtp_port_max = 31000;
+        /// @brief UDP观看者无RTSP保活时的会话超时（秒）
+        int session_timeout_s = 60;
+        /// @brief 单条RTSP请求的上限
+        std::size_t max_request_size = 16 * 1024;
+        RtspInterleavedTransport::Config interleaved;
+        /// @brief UDP观看者经服务端共享的节拍器平滑发送，源的Config::pacer为空时注入
+        bool pace_udp = true;
+        RtpPacer::Config pacer;
+    };
+
+    RtspServer(ASIO::IoContext& io, const Config& cfg);
+    ~RtspServer();
+
+    void Start();
+    /// @brief 停止监听，断开所有会话并关闭各源的UDP端口
+    void Stop();
+
+    /// @brief 注册一路源，path为URL中host之后的部分，如"live/stream1"
+    /// @return 已存在同名源时返回nullptr
+    std::shared_ptr<RtspMediaSource> AddSource(const std::string& path, const RtspMediaSource::Config& cfg);
+    /// @brief 注销源，并断开其所有观看者
+    void RemoveSource(const std::string& path);
+    std::shared_ptr<RtspMediaSource> FindSource(const std::string& path) const;
+
+    /// @brief 确保源的某轨道已有UDP端口
+    bool EnsureUdp(RtspMediaSource& source, std::size_t track);
+
+    const Config& config() const noexcept { return cfg_; }
+    ASIO::IoContext& io_context() noexcept { return io_; }
+    net::AsioTimerWheel& timers() noexcept { return *timers_; }
+    uint16_t port() const;
+
+private:
+    void do_accept();
+
+    ASIO::IoContext& io_;
+    Config cfg_;
+    boost::asio::ip::tcp::acceptor acceptor_;
+    std::shared_ptr<net::AsioTimerWheel> timers_;
+    std::shared_ptr<RtpPacer> pacer_;
+
+    mutable std::mutex mtx_;
+    std::map<std::string, std::shared_ptr<RtspMediaSource>> sources_;
+    std::vector<std::weak_ptr<RtspServerSession>> sessions_;
+    /// @brief 下一次尝试分配的RTP端口
+    uint16_t next_port_;
+};
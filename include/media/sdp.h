@@ -0,0 +1,57 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/// @brief SDP中出现的编码
+enum class SdpCodec {
+    Unknown,
+    H264,
+    H265,
+    PCMA,
+    PCMU
+};
+
+/// @brief 一路媒体（m=行）的描述
+/// @details 服务端由编码器参数填写后生成SDP，参数集为空时接收端依赖码流内的SPS/PPS
+struct SdpTrack {
+    SdpCodec codec = SdpCodec::Unknown;
+    bool video = true;
+    uint8_t payload_type = 96;
+    uint32_t clock_rate = 90000;
+    int channels = 1;
+    /// @brief 参数集（不含起始码），H.264只用sps/pps
+    std::string vps;
+    std::string sps;
+    std::string pps;
+    /// @brief a=control，相对Content-Base的路径，如"trackID=0"
+    std::string control;
+};
+
+namespace Sdp {
+    const char* CodecName(SdpCodec codec) noexcept;
+
+    std::string Base64Encode(const void* data, std::size_t size);
+    /// @brief 忽略末尾'='，遇到非法字符返回false
+    bool Base64Decode(std::string_view in, std::string& out);
+
+    /// @brief 从Annex-B码流（extradata或关键帧）中取出VPS/SPS/PPS写入track
+    /// @return 找到了至少一个参数集
+    bool ExtractParameterSets(const uint8_t* data, std::size_t size, SdpTrack& track);
+
+    /// @brief 解码所需的参数集是否齐全：H.264要SPS+PPS，H.265要VPS+SPS+PPS
+    bool HasParameterSets(const SdpTrack& track) noexcept;
+
+    /// @brief a=fmtp的参数部分，无参数返回空串
+    std::string Fmtp(const SdpTrack& track);
+
+    /// @brief 生成会话描述（RFC 4566），直播会话range为npt=now-
+    /// @param origin_ip o=行的地址，通常为本端RTSP监听地址
+    std::string Generate(const std::string& session_name, const std::string& origin_ip, const std::vector<SdpTrack>& tracks);
+
+    /// @brief 解析DESCRIBE应答中的SDP，每个m=行对应一个SdpTrack，不认识的编码为Unknown
+    /// @return 没有任何m=行返回false
+    bool Parse(std::string_view sdp, std::vector<SdpTrack>& tracks);
+}
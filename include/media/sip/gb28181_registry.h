@@ -0,0 +1,171 @@
+#pragma once
+
+/**
+ * @brief GB28181设备注册表
+ * @details 维护设备的REGISTER状态、有效期和心跳（GB/T 28181 9.1、9.6）
+ */
+
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "net/asio_timer_wheel.h"
+#include "sip/sip_transaction.h"
+
+/// @brief 设备注册表
+/// @details 设备按编码哈希分片，每片一把锁，网络恢复后成千上万台设备同时重新注册时落在不同分片上。
+/// 每台设备在时间轮上只有一个节点，到期时间取注册有效期和心跳超时中较早的一个；
+/// 心跳只更新时间戳不动定时器，定时器到期时发现还没真正超时就按剩余时间重新挂上。
+/// 心跳MESSAGE只在分片锁内查一次是否已注册，未注册的回403让设备重新注册；
+/// 已注册的回200并把时间戳记入调用线程（reactor）自己的批次，批次攒满或定时刷新时按分片排序，
+/// 每个分片只加一次锁批量更新，各reactor之间不争同一把锁。
+/// 需通过std::make_shared创建，并在事务层的请求回调里调用HandleRequest。
+class GbDeviceRegistry : public std::enable_shared_from_this<GbDeviceRegistry> {
+public:
+    struct Config {
+        std::size_t shards = 64;
+        /// @brief 预计设备数，提前给各分片预留桶，注册风暴时不触发rehash
+        std::size_t expected_devices = 0;
+        /// @brief 心跳批次槽位数，一般取reactor线程数，向上取整到2的幂
+        std::size_t reactors = 8;
+        /// @brief 批次攒到这么多条就立即合并
+        std::size_t batch_size = 256;
+        /// @brief 批次定时合并间隔（毫秒）
+        int64_t flush_interval_ms = 50;
+        /// @brief 请求没带有效期时使用（秒）
+        uint32_t default_expires = 3600;
+        /// @brief 小于此值的非0有效期回423
+        uint32_t min_expires = 60;
+        uint32_t max_expires = 86400;
+        /// @brief 心跳周期（秒）和允许丢失的次数，超过判为离线（GB/T 28181 9.6.1默认60秒、3次）
+        uint32_t keepalive_interval = 60;
+        uint32_t keepalive_timeout_count = 3;
+    };
+
+    struct Stats {
+        uint64_t registered = 0;
+        uint64_t refreshed = 0;
+        uint64_t unregistered = 0;
+        uint64_t expired = 0;
+        /// @brief 心跳超时判为离线
+        uint64_t offline = 0;
+        uint64_t keepalives = 0;
+        /// @brief 未注册设备的心跳（回403）
+        uint64_t unknown_keepalives = 0;
+        uint64_t batches = 0;
+    };
+
+    enum class Event {
+        /// @brief 新设备注册（或离线后重新注册）
+        Registered,
+        Unregistered,
+        /// @brief 注册有效期到了没有刷新
+        Expired,
+        /// @brief 连续丢失心跳
+        Offline,
+        /// @brief 收到未注册设备的心跳，上层可以据此要求设备重新注册
+        UnknownKeepalive
+    };
+    using EventHandler = std::function<void(Event event, const std::string& device_id)>;
+
+    /// @brief 设备状态快照
+    struct DeviceInfo {
+        std::string id;
+        /// @brief 最近一次REGISTER/心跳的来源地址，NAT后面的设备据此回送
+        SipTransport::Peer peer;
+        int64_t registered_ms = 0;
+        int64_t expires_at_ms = 0;
+        int64_t last_keepalive_ms = 0;
+    };
+
+    GbDeviceRegistry(std::shared_ptr<SipTransactionLayer> layer, std::shared_ptr<net::AsioTimerWheel> timers,
+                     const Config& cfg);
+    GbDeviceRegistry(std::shared_ptr<SipTransactionLayer> layer, std::shared_ptr<net::AsioTimerWheel> timers);
+    ~GbDeviceRegistry();
+
+    GbDeviceRegistry(const GbDeviceRegistry&) = delete;
+    GbDeviceRegistry& operator=(const GbDeviceRegistry&) = delete;
+
+    /// @brief 启动心跳批次的定时合并
+    void Start();
+    /// @brief 停止定时器，清空注册表
+    void Stop();
+
+    /// @brief 处理REGISTER和Keepalive MESSAGE并应答
+    /// @return 不是这两类请求返回false，交给调用方继续处理
+    bool HandleRequest(const SipMessageView& request);
+
+    /// @brief 立即合并所有reactor的心跳批次
+    void Flush();
+
+    void SetEventHandler(EventHandler handler) { event_handler_ = std::move(handler); }
+
+    bool Find(StringView device_id, DeviceInfo& out) const;
+    bool Contains(StringView device_id) const;
+    std::size_t size() const noexcept { return devices_.load(std::memory_order_relaxed); }
+    Stats stats() const;
+    const Config& config() const noexcept { return cfg_; }
+
+    /// @brief 从From头的SIP URI取设备编码（user部分）
+    static StringView DeviceId(const SipMessageView& msg) noexcept;
+    /// @brief MESSAGE消息体是否是Keepalive通知
+    static bool IsKeepalive(const SipMessageView& msg) noexcept;
+
+private:
+    struct Device;
+    struct Shard;
+    struct Reactor;
+    struct Keepalive;
+
+    struct IdHash {
+        using is_transparent = void;
+        std::size_t operator()(std::string_view s) const noexcept { return std::hash<std::string_view>()(s); }
+    };
+    using Table = std::unordered_map<std::string, std::shared_ptr<Device>, IdHash, std::equal_to<>>;
+
+    void on_register(const SipMessageView& request);
+    void on_keepalive(const SipMessageView& request);
+    void on_timer(std::size_t shard, const std::weak_ptr<Device>& device);
+    void on_flush_timer();
+
+    std::size_t shard_index(StringView device_id) const noexcept;
+    /// @brief 持锁调用：按有效期和心跳中较早的时间挂定时器
+    void arm(std::size_t shard, const std::shared_ptr<Device>& device, int64_t now_ms);
+    /// @brief 持锁调用
+    void disarm(Device& device);
+    /// @brief 合并一个reactor的批次
+    void flush(Reactor& reactor);
+    void apply(std::vector<Keepalive>& batch);
+    void notify(Event event, const std::string& device_id);
+
+    std::shared_ptr<SipTransactionLayer> layer_;
+    std::shared_ptr<net::AsioTimerWheel> timers_;
+    Config cfg_;
+    std::vector<std::unique_ptr<Shard>> shards_;
+    std::size_t shard_mask_ = 0;
+    std::vector<std::unique_ptr<Reactor>> reactors_;
+    std::size_t reactor_mask_ = 0;
+    /// @brief 用于REGISTER应答的To tag
+    std::string tag_;
+
+    EventHandler event_handler_;
+    std::atomic<bool> stopped_{false};
+    std::atomic<std::size_t> devices_{0};
+    std::mutex flush_timer_mtx_;
+    net::AsioTimerWheel::TimerId flush_timer_ = 0;
+
+    std::atomic<uint64_t> registered_{0};
+    std::atomic<uint64_t> refreshed_{0};
+    std::atomic<uint64_t> unregistered_{0};
+    std::atomic<uint64_t> expired_{0};
+    std::atomic<uint64_t> offline_{0};
+    std::atomic<uint64_t> keepalives_{0};
+    std::atomic<uint64_t> unknown_keepalives_{0};
+    std::atomic<uint64_t> batches_{0};
+};
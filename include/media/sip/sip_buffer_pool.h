@@ -0,0 +1,64 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+/// @brief SIP发送缓冲池
+/// @details 缓冲用完自动归还并保留容量，稳态下序列化和发送不再分配内存。
+/// 句柄是带回收器的unique_ptr，可以移交给异步发送（TCP写队列），发完析构即归还；
+/// 池本身先析构时句柄仍然有效，归还时直接释放。线程安全。
+class SipBufferPool {
+public:
+    struct Config {
+        /// @brief 空闲缓冲上限，超出的直接释放
+        std::size_t max_idle = 256;
+        /// @brief 容量超过该值的缓冲（大NOTIFY/目录XML）不回收，避免长期占用
+        std::size_t max_capacity = 64 * 1024;
+        /// @brief 新缓冲的初始容量，覆盖常见的应答和保活
+        std::size_t initial_capacity = 1024;
+    };
+
+    struct Stats {
+        uint64_t acquired = 0;
+        uint64_t reused = 0;
+        uint64_t dropped = 0;
+    };
+
+private:
+    struct State {
+        Config cfg;
+        std::mutex mtx;
+        std::vector<std::string*> idle;
+        Stats stats;
+
+        ~State();
+    };
+
+public:
+    /// @brief 归还缓冲，持有池状态，池先析构也安全
+    class Recycler {
+    public:
+        Recycler() = default;
+        explicit Recycler(std::shared_ptr<State> state) : state_(std::move(state)) {}
+        void operator()(std::string* buffer) const;
+    private:
+        std::shared_ptr<State> state_;
+    };
+
+    using Buffer = std::unique_ptr<std::string, Recycler>;
+
+    SipBufferPool();
+    explicit SipBufferPool(const Config& cfg);
+
+    /// @brief 取一个空缓冲（size为0，容量保留）
+    Buffer Acquire();
+
+    Stats stats() const;
+    std::size_t idle() const;
+
+private:
+    std::shared_ptr<State> state_;
+};
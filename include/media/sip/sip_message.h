@@ -0,0 +1,289 @@
+#pragma once
+
+/**
+ * @brief SIP消息
+ * @details SipMessage用于构造要发送的消息；SipMessageView是接收路径上的零拷贝解析结果
+ */
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <map>
+#include <memory>
+#include <boost/asio/ip/address.hpp>
+#include "base/stringview.h"
+#include "base/small_vector.h"
+
+class SipMessageView;
+
+// @brief SIP消息
+class SipMessage {
+public:
+    struct RemoteInfo {
+        std::string protocol;   // "UDP" "TCP" "TLS" "WebSocket"
+        std::string ip;
+        uint16_t port = 0;
+
+        RemoteInfo() = default;
+        RemoteInfo(const std::string& ptcl, const std::string& addr, uint16_t pt)
+            : protocol(ptcl), ip(addr), port(pt) {}
+    };
+
+    SipMessage() = default;
+    /// @brief 从字符串解析SIP消息
+    /// @param  msg 字符串
+    /// @return 解析后的SIP消息
+    /// @note 头字段保留为解析视图，第一次访问headers()或set_header()时才建立std::map；
+    /// 接收路径请直接用SipMessageView
+    static SipMessage Parse(const std::string&);
+
+    /// @brief 将SipMessage转换为字符串
+    /// @return 字符串
+    std::string ToString() const;
+
+    /// @brief 序列化后的准确字节数
+    std::size_t SerializedSize() const;
+    /// @brief 起始行、头字段、Content-Length和消息体一次写入dst
+    /// @return 写入的字节数，capacity不足时返回0且不写
+    std::size_t SerializeInto(char* dst, std::size_t capacity) const;
+    /// @brief 覆盖写入buffer，容量足够时不分配（配合SipBufferPool）
+    std::size_t SerializeInto(std::string& buffer) const;
+        // ---- setters ----
+    void set_method(const std::string& method) { method_ = method; }
+    void set_uri(const std::string& uri) { uri_ = uri; }
+    void set_version(const std::string& version) { version_ = version; }
+    void set_status_code(int code) { status_code_ = code; }
+    void set_reason(const std::string& reason) { reason_ = reason; }
+    void set_body(const std::string& body) { body_ = body; }
+    void set_header(const std::string& key, const std::string& value) {
+        materialize();
+        headers_[key] = value;
+    }
+    void set_remote(const RemoteInfo& remote) { remote_ = remote; }
+
+    // ---- getters ----
+    const std::string& method() const { return method_; }
+    const std::string& uri() const { return uri_; }
+    const std::string& version() const { return version_; }
+    int status_code() const { return status_code_; }
+    const std::string& reason() const { return reason_; }
+    const std::string& body() const { return body_; }
+    /// @brief 解析得到的消息在第一次调用时建立，同一个对象的首次调用不能在多个线程并发
+    const std::map<std::string, std::string>& headers() const {
+        materialize();
+        return headers_;
+    }
+    const RemoteInfo& remote() const { return remote_; }
+
+private:
+    friend class SipMessageView;
+
+    /// @brief 把parsed_中的头字段并入headers_（同SipMessageView::ToMessage的合并规则）
+    void materialize() const {
+        if (parsed_) {
+            build_headers();
+        }
+    }
+    void build_headers() const;
+
+    std::string method_; // 请求方法 INVITE/REGISTER/ACK/BYE/...
+    std::string uri_;    // 请求行中的Request-URI
+    std::string version_;    // SIP/2.0
+    int status_code_ = 0;    //如果是响应报文
+    std::string reason_;     //响应原因
+    mutable std::map<std::string, std::string> headers_; // 头字段
+    /// @brief 解析来源（持有缓冲的视图），头字段尚未拷进headers_时非空
+    mutable std::shared_ptr<const SipMessageView> parsed_;
+    std::string body_; // 消息体(SDP/XML/JSON)
+    RemoteInfo remote_; // 传输协议
+};
+
+/// @brief 常用头字段，解析时按名字哈希识别一次，之后按编号查找只比较一个字节
+enum class SipHeaderId : uint8_t {
+    Other = 0,
+    Via,
+    From,
+    To,
+    CallId,
+    CSeq,
+    Contact,
+    MaxForwards,
+    Expires,
+    ContentLength,
+    ContentType,
+    ContentEncoding,
+    Supported,
+    Subject,
+    Event,
+    AllowEvents,
+    Allow,
+    Route,
+    RecordRoute,
+    Authorization,
+    WwwAuthenticate,
+    ProxyAuthorization,
+    ProxyAuthenticate,
+    UserAgent,
+    Date,
+    SubscriptionState,
+    Count
+};
+
+/// @brief 一个头字段，名字和值都指向消息缓冲
+struct SipHeaderField {
+    /// @brief 报文中的原始写法，紧凑形式（如"v"）保持原样
+    StringView name;
+    /// @brief 去掉首尾空白；折行（RFC 3261 7.3.1）的值保留中间的CRLF和空白
+    StringView value;
+    /// @brief 名字按小写计算的FNV-1a，查找未知头时先比哈希
+    uint32_t hash = 0;
+    SipHeaderId id = SipHeaderId::Other;
+};
+
+/// @brief SipMessageView::SerializeResponse的可选内容
+struct SipResponseOptions {
+    /// @brief 请求的To没有tag时补上（对话外请求的应答需要），空表示不加
+    StringView to_tag;
+    /// @brief 附加的头字段（Contact/Expires/Date等），只用name和value
+    const SipHeaderField* extra_headers = nullptr;
+    std::size_t extra_count = 0;
+    StringView content_type;
+    StringView body;
+};
+
+/// @brief SIP消息的零拷贝解析结果
+/// @details 起始行、头字段名/值和消息体都是指向接收缓冲的StringView，解析过程不分配内存
+/// （头字段超过kInlineHeaders个才会溢出到堆上）。紧凑形式按完整名字识别；
+/// 同名多行和Via/Contact/Route等逗号分隔的列表用ForEachValue逐个取值。
+/// 默认视图只在缓冲有效期内可用（如UDP收包回调内），需要跨回调保存时调用Retain()，
+/// 或用持有shared_ptr缓冲的Parse重载。
+class SipMessageView {
+public:
+    enum class ParseResult {
+        Ok,
+        /// @brief 流式解析时数据还不完整，等更多字节
+        Incomplete,
+        Error
+    };
+
+    /// @brief 消息来源
+    struct Peer {
+        const char* protocol = "";  // "UDP" "TCP"，只指向字面量
+        boost::asio::ip::address address;
+        uint16_t port = 0;
+    };
+
+    static constexpr std::size_t kInlineHeaders = 24;
+    /// @brief 单条消息最多的头字段数，超出视为非法，防止构造报文撑大内存
+    static constexpr std::size_t kMaxHeaders = 256;
+
+    using Headers = SmallVector<SipHeaderField, kInlineHeaders>;
+
+    SipMessageView() = default;
+
+    /// @brief 解析data开头的一条消息，结果直接指向data，不拷贝
+    /// @param out 复用的输出对象，之前的内容被覆盖
+    /// @param consumed 成功时写入这条消息占用的字节数（含前导CRLF），流式解析据此切分下一条
+    /// @param stream 流式（TCP）：没有Content-Length时消息体为空，数据不足返回Incomplete；
+    ///               数据报（UDP）：没有Content-Length时消息体为剩余全部字节，不足返回Error
+    static ParseResult Parse(const char* data, std::size_t size, SipMessageView& out,
+                             std::size_t* consumed = nullptr, bool stream = false);
+    /// @brief 解析整个buffer为一条数据报消息，视图持有buffer
+    static ParseResult Parse(std::shared_ptr<const std::string> buffer, SipMessageView& out);
+
+    /// @brief 若还没有持有缓冲，把消息拷贝一份并让所有视图改指向它，之后可以跨回调保存
+    void Retain();
+    bool retained() const noexcept { return storage_ != nullptr; }
+
+    bool is_request() const noexcept { return status_code_ == 0; }
+    StringView method() const noexcept { return method_; }
+    StringView uri() const noexcept { return uri_; }
+    StringView version() const noexcept { return version_; }
+    int status_code() const noexcept { return status_code_; }
+    StringView reason() const noexcept { return reason_; }
+    StringView body() const noexcept { return body_; }
+    /// @brief 整条消息（起始行到消息体结束）
+    StringView raw() const noexcept { return raw_; }
+    const Headers& headers() const noexcept { return headers_; }
+
+    /// @brief 第一个该头字段的整行值，没有返回空
+    StringView header(SipHeaderId id) const noexcept;
+    /// @brief 按名字查找（大小写不敏感，常用头也匹配紧凑形式）
+    StringView header(StringView name) const noexcept;
+    bool has_header(SipHeaderId id) const noexcept;
+
+    /// @brief 按出现顺序遍历该头字段的每个值：同名多行逐行给出，列表型头字段再按逗号拆开
+    template <typename Fn>
+    void ForEachValue(SipHeaderId id, Fn&& fn) const {
+        const bool list = IsListHeader(id);
+        for (const SipHeaderField& h : headers_) {
+            if (h.id != id) {
+                continue;
+            }
+            if (!list) {
+                fn(h.value);
+                continue;
+            }
+            StringView rest = h.value;
+            while (!rest.empty()) {
+                StringView v = NextListValue(rest);
+                if (!v.empty()) {
+                    fn(v);
+                }
+            }
+        }
+    }
+    std::size_t CountValues(SipHeaderId id) const;
+
+    // ---- 常用字段 ----
+    StringView call_id() const noexcept { return header(SipHeaderId::CallId); }
+    /// @brief 解析CSeq，格式不对返回false
+    bool cseq(uint32_t& seq, StringView& method) const noexcept;
+    /// @brief 最上面一个Via的branch参数，事务匹配用
+    StringView top_via_branch() const noexcept;
+    StringView from_tag() const noexcept { return Param(header(SipHeaderId::From), "tag"); }
+    StringView to_tag() const noexcept { return Param(header(SipHeaderId::To), "tag"); }
+
+    const Peer& peer() const noexcept { return peer_; }
+    void set_peer(const Peer& peer) { peer_ = peer; }
+
+    /// @brief 按本请求直接写应答到buffer（覆盖），不经过SipMessage
+    /// @details 按RFC 3261 8.2.6.2原样带回所有Via以及From/To/Call-ID/CSeq，
+    /// 视图直接拷进缓冲，缓冲容量足够时整个过程不分配内存
+    /// @return 写入的字节数
+    std::size_t SerializeResponse(int status_code, StringView reason, std::string& buffer,
+                                  const SipResponseOptions& opts = SipResponseOptions()) const;
+
+    /// @brief 拷贝成SipMessage；常用头使用完整名字，列表型的同名多行合并为逗号分隔
+    /// @details 头字段随视图的一份持有副本交给SipMessage，用到时才拷成std::map
+    SipMessage ToMessage() const;
+
+    // ---- 工具函数 ----
+    /// @brief 名字识别为常用头，紧凑形式映射到对应的完整头
+    static SipHeaderId HeaderId(StringView name) noexcept;
+    /// @brief 常用头的规范名字，Other返回空
+    static StringView HeaderName(SipHeaderId id) noexcept;
+    /// @brief 大小写不敏感的FNV-1a
+    static uint32_t HeaderHash(StringView name) noexcept;
+    /// @brief 值可以是逗号分隔列表的头字段
+    static bool IsListHeader(SipHeaderId id) noexcept;
+    /// @brief 从rest中取出下一个逗号分隔的值（跳过引号和尖括号内的逗号），rest前移
+    static StringView NextListValue(StringView& rest) noexcept;
+    /// @brief 取头字段值中的";name=value"参数（跳过<...>内URI自带的参数），没有返回空
+    static StringView Param(StringView value, StringView name) noexcept;
+
+private:
+    void reset() noexcept;
+    void rebase(const char* from, const char* to) noexcept;
+
+    StringView raw_;
+    StringView method_;
+    StringView uri_;
+    StringView version_;
+    int status_code_ = 0;
+    StringView reason_;
+    Headers headers_;
+    StringView body_;
+    Peer peer_;
+    std::shared_ptr<const std::string> storage_;
+};
@@ -0,0 +1,158 @@
+#pragma once
+
+/**
+ * @brief SIP事务层（RFC 3261 17，含RFC 6026的Accepted状态）
+ * @details 位于SipTransport之上、应用（TU）之下：重传请求在这里吸收或重发上次应答，
+ * UDP上的请求/应答重传、超时由事务定时器驱动，TU只看到每个事务的第一条请求和有意义的应答
+ */
+
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "net/asio_timer_wheel.h"
+#include "sip/sip_transport.h"
+
+/// @brief 事务层
+/// @details 服务端事务按(top Via branch, 方法)匹配，ACK归到对应的INVITE事务；没有RFC 3261魔术前缀的
+/// 旧式branch退回到(Call-ID, CSeq, From tag, 方法)。事务放在按key哈希分片的表里，每片一把锁，
+/// 并发的传输回调（多条TCP连接、多个UDP socket）落在不同分片上互不阻塞。
+/// 事务对象连同哈希表节点一起在分片内复用（unordered_map的node handle），稳态下新建事务不分配内存。
+/// Timer A~K（以及RFC 6026的L/M）都挂在共享的时间轮上，每个事务最多两个节点（重传+超时）。
+/// TU回调在锁外执行，回调中可以再调用Respond/SendRequest。需通过std::make_shared创建。
+class SipTransactionLayer : public std::enable_shared_from_this<SipTransactionLayer> {
+public:
+    struct Config {
+        /// @brief RTT估计（毫秒），重传初始间隔，超时为64*T1
+        int64_t t1_ms = 500;
+        /// @brief 非INVITE请求和INVITE应答的最大重传间隔
+        int64_t t2_ms = 4000;
+        /// @brief 网络中消息的最长存活时间，UDP上Timer I/K使用
+        int64_t t4_ms = 5000;
+        /// @brief 分片数，向上取整到2的幂
+        std::size_t shards = 64;
+        /// @brief 同时存在的事务上限，超出时新请求直接无状态回503
+        std::size_t max_transactions = 200000;
+        /// @brief 收到INVITE立即回100 Trying（RFC 3261允许提前发送），抑制对端重传
+        bool auto_trying = true;
+        /// @brief TU迟迟不给最终应答时服务端事务的保护超时（毫秒）
+        int64_t server_guard_ms = 180000;
+    };
+
+    struct Stats {
+        uint64_t server_created = 0;
+        uint64_t client_created = 0;
+        /// @brief 被吸收的重传请求/应答，没有交给TU
+        uint64_t absorbed = 0;
+        /// @brief 定时器触发的重传和对重传请求重发的应答
+        uint64_t retransmitted = 0;
+        uint64_t timeouts = 0;
+        /// @brief 超过上限被拒绝的请求
+        uint64_t rejected = 0;
+        /// @brief 找不到事务的应答
+        uint64_t stray_responses = 0;
+    };
+
+    /// @brief 新的服务端事务的第一条请求，以及不属于任何事务的ACK（2xx的ACK）
+    using RequestHandler = std::function<void(const SipMessageView& request)>;
+    /// @brief 客户端事务的应答；nullptr表示事务超时（Timer B/F）
+    using ResponseHandler = std::function<void(const SipMessageView* response)>;
+
+    SipTransactionLayer(SipTransport::Ptr transport, std::shared_ptr<net::AsioTimerWheel> timers, const Config& cfg);
+    SipTransactionLayer(SipTransport::Ptr transport, std::shared_ptr<net::AsioTimerWheel> timers);
+    ~SipTransactionLayer();
+
+    SipTransactionLayer(const SipTransactionLayer&) = delete;
+    SipTransactionLayer& operator=(const SipTransactionLayer&) = delete;
+
+    /// @brief 接管传输层的消息回调
+    void Start();
+    /// @brief 丢弃所有事务，之后收到的消息不再处理
+    /// @details 事务对象放回复用池而不释放，已从时间轮取下的回调仍可安全核对generation
+    void Stop();
+
+    void SetRequestHandler(RequestHandler handler) { request_handler_ = std::move(handler); }
+    /// @brief 找不到客户端事务的应答（如INVITE事务结束后迟到的2xx重传）
+    void SetStrayResponseHandler(SipTransport::MessageHandler handler) { stray_handler_ = std::move(handler); }
+
+    /// @brief 对服务端事务应答：按请求找到事务、推进状态并发送，UDP上保存应答用于重传
+    /// @details 请求不属于任何事务（已结束或被拒绝）时无状态发送
+    /// @return 传输层接受发送返回true；事务已给过最终应答返回false
+    bool Respond(const SipMessageView& request, int status_code, StringView reason,
+                 const SipResponseOptions& opts = SipResponseOptions());
+
+    /// @brief 发起客户端事务；请求须带Via（sent-by），没有branch时自动生成
+    /// @details ACK不建事务，直接发送
+    /// @return 请求非法、同branch事务已存在或超过上限时返回false
+    bool SendRequest(SipMessage request, ResponseHandler on_response);
+
+    std::size_t size() const noexcept { return active_.load(std::memory_order_relaxed); }
+    Stats stats() const;
+    const Config& config() const noexcept { return cfg_; }
+
+    /// @brief 生成带RFC 3261魔术前缀的随机branch
+    static std::string NewBranch();
+
+private:
+    struct Transaction;
+    struct Shard;
+    /// @brief 锁外要做的事：发送和通知TU
+    struct Actions;
+
+    enum class TimerKind : uint8_t {
+        /// @brief Timer A/E/G
+        Retransmit,
+        /// @brief Timer B/D/F/H/I/J/K/L/M以及服务端保护超时
+        Timeout
+    };
+
+    struct KeyHash {
+        using is_transparent = void;
+        std::size_t operator()(std::string_view s) const noexcept { return std::hash<std::string_view>()(s); }
+    };
+    using Table = std::unordered_map<std::string, std::unique_ptr<Transaction>, KeyHash, std::equal_to<>>;
+
+    void on_message(const SipMessageView& msg);
+    void on_request(const SipMessageView& msg);
+    void on_response(const SipMessageView& msg);
+    /// @brief 分片下标由回调带入，先确认未停止、持锁核对generation后才读事务
+    void on_timer(std::size_t shard_index, Transaction* txn, uint32_t generation, TimerKind kind);
+
+    Shard& shard_for(std::string_view key) noexcept;
+    /// @brief 持锁调用：取一个复用的事务对象并登记到表里
+    Transaction* acquire(Shard& shard, std::string_view key);
+    /// @brief 持锁调用：取消定时器、从表里摘下并放回复用池
+    void release(Transaction* txn);
+    /// @brief 持锁调用
+    void schedule(Transaction* txn, TimerKind kind, int64_t delay_ms);
+    void cancel(Transaction* txn, TimerKind kind);
+    /// @brief 持锁调用：可靠传输上等待时间为0的状态直接结束，否则挂超时
+    void finish_after(Transaction* txn, int64_t delay_ms);
+
+    void run(Actions& actions);
+
+    SipTransport::Ptr transport_;
+    std::shared_ptr<net::AsioTimerWheel> timers_;
+    Config cfg_;
+    std::vector<std::unique_ptr<Shard>> shards_;
+    std::size_t shard_mask_ = 0;
+
+    RequestHandler request_handler_;
+    SipTransport::MessageHandler stray_handler_;
+    std::atomic<bool> stopped_{false};
+    std::atomic<std::size_t> active_{0};
+
+    std::atomic<uint64_t> server_created_{0};
+    std::atomic<uint64_t> client_created_{0};
+    std::atomic<uint64_t> absorbed_{0};
+    std::atomic<uint64_t> retransmitted_{0};
+    std::atomic<uint64_t> timeouts_{0};
+    std::atomic<uint64_t> rejected_{0};
+    std::atomic<uint64_t> stray_responses_{0};
+};
@@ -23,73 +23,34 @@
 
 
 #include <string>
-#include <map>
-#include <sstream>
 #include <functional>
+#include <map>
 #include <memory>
+#include <mutex>
+#include <thread>
 #include <vector>
+#include "base/bound_mpmc_queue.h"
+#include "base/metrics.h"
 #include "net/asio_socket.h"
-
-// @brief SIP消息
-class SipMessage {
-public:
-    struct RemoteInfo {
-        std::string protocol;   // "UDP" "TCP" "TLS" "WebSocket"
-        std::string ip;
-        uint16_t port = 0;
-
-        RemoteInfo() = default;
-        RemoteInfo(const std::string& ptcl, const std::string& addr, uint16_t pt)
-            : protocol(ptcl), ip(addr), port(pt) {}
-    };
-
-    SipMessage() = default;
-    /// @brief 从字符串解析SIP消息
-    /// @param  msg 字符串
-    /// @return 解析后的SIP消息
-    static SipMessage Parse(const std::string&);
-
-    /// @brief 将SipMessage转换为字符串
-    /// @return 字符串
-    std::string ToString() const;
-        // ---- setters ----
-    void set_method(const std::string& method) { method_ = method; }
-    void set_uri(const std::string& uri) { uri_ = uri; }
-    void set_version(const std::string& version) { version_ = version; }
-    void set_status_code(int code) { status_code_ = code; }
-    void set_reason(const std::string& reason) { reason_ = reason; }
-    void set_body(const std::string& body) { body_ = body; }
-    void set_header(const std::string& key, const std::string& value) { headers_[key] = value; }
-    void set_remote(const RemoteInfo& remote) { remote_ = remote; }
-
-    // ---- getters ----
-    const std::string& method() const { return method_; }
-    const std::string& uri() const { return uri_; }
-    const std::string& version() const { return version_; }
-    int status_code() const { return status_code_; }
-    const std::string& reason() const { return reason_; }
-    const std::string& body() const { return body_; }
-    const std::map<std::string, std::string>& headers() const { return headers_; }
-    const RemoteInfo& remote() const { return remote_; }
-
-private:
-    std::string method_; // 请求方法 INVITE/REGISTER/ACK/BYE/...
-    std::string uri_;    // 请求行中的Request-URI
-    std::string version_;    // SIP/2.0
-    int status_code_ = 0;    //如果是响应报文
-    std::string reason_;     //响应原因
-    std::map<std::string, std::string> headers_; // 头字段
-    std::string body_; // 消息体(SDP/XML/JSON)
-    RemoteInfo remote_; // 传输协议
-};
+#include "net/asio_timer_wheel.h"
+#include "net/udp_batch_socket.h"
+#include "sip/sip_message.h"
+#include "sip/sip_buffer_pool.h"
 
 // @brief SIP传输层
 class SipTransport {
 public:
     using Ptr = std::shared_ptr<SipTransport>;
-    using MessageHandler = std::function<void(const SipMessage&)>;
+    /// @brief 收到的消息只在回调期间有效，需要保存时调用SipMessageView::Retain()或ToMessage()
+    using MessageHandler = std::function<void(const SipMessageView&)>;
+    using Peer = SipMessageView::Peer;
+    using Buffer = SipBufferPool::Buffer;
+
+    SipTransport() = default;
+    virtual ~SipTransport();
 
-    virtual ~SipTransport() = default;
+    SipTransport(const SipTransport&) = delete;
+    SipTransport& operator=(const SipTransport&) = delete;
 
     // 启动传输
     virtual void Start() = 0;
@@ -97,8 +58,17 @@ public:
     // 停止传输
     virtual void Stop() = 0;
 
-    // 发送SIP消息
-    virtual void Send(const SipMessage& msg) = 0;
+    // 发送SIP消息，序列化进池化缓冲后交给SendBuffer
+    virtual void Send(const SipMessage& msg);
+
+    /// @brief 发送已序列化的消息，缓冲由传输层接管，发完归还到池
+    virtual bool SendBuffer(const Peer& to, Buffer buffer) = 0;
+
+    /// @brief 按请求直接生成应答并发回请求来源，稳态下不分配内存
+    bool SendResponse(const SipMessageView& request, int status_code, StringView reason,
+                      const SipResponseOptions& opts = SipResponseOptions());
+
+    SipBufferPool& buffer_pool() { return pool_; }
 
     // 设置收到消息的回调
     void SetMsgHandler(MessageHandler handler) {
@@ -106,44 +76,146 @@ public:
         handler_ = std::move(handler);
     }
 
-    void SetTapHandler(MessageHandler handler) {
-        tap_handlers_.push_back(std::move(handler));
-    }
+    /// @brief 添加旁路监听（抓包、调试日志等）
+    /// @details 监听不在收包线程上执行：消息拷贝一份放进有界队列，由独立的tap线程依次交给各监听；
+    /// 队列满时丢弃并计数，慢监听不会拖慢呼叫处理。第一次添加时启动tap线程，
+    /// 并以queue="sip_tap"导出队列深度和容量
+    void SetTapHandler(MessageHandler handler);
+
+    /// @brief 因tap队列满而没有交给监听的消息数
+    uint64_t tap_dropped() const noexcept { return tap_dropped_.load(std::memory_order_relaxed); }
+
+    static constexpr std::size_t kTapQueueCapacity = 1024;
 
 protected:
     // 内部触发消息分发
-    void dispatch_message(const SipMessage& msg) {
-        // 先通知 tap 监听
-        for (auto& h : tap_handlers_) {
-            if (h) h(msg);
+    void dispatch_message(const SipMessageView& msg) {
+        // 有监听时只拷贝入队，由tap线程通知
+        if (tap_active_.load(std::memory_order_acquire)) {
+            post_tap(msg);
         }
-        // 再交给主 handler
+        // 交给主 handler
         if (handler_) {
             handler_(msg);
         }
     }
 
+    /// @brief 停止tap线程，派生类析构前调用可以保证不再回调监听
+    void stop_taps();
+
     MessageHandler handler_;    // 给到Transaction层的回调函数
+    SipBufferPool pool_;    // 发送缓冲
+
+private:
+    void post_tap(const SipMessageView& msg);
+    void tap_loop();
+
+    std::mutex tap_mtx_;
     std::vector<MessageHandler> tap_handlers_;
+    std::unique_ptr<BoundMPMCQueue<SipMessageView>> tap_queue_;
+    /// @brief tap队列的指标，先于队列析构
+    std::vector<MetricsHandle> tap_metrics_;
+    std::thread tap_thread_;
+    std::atomic<bool> tap_active_{false};
+    std::atomic<uint64_t> tap_dropped_{0};
 };
 
 /// @brief UDP SIP传输层
+/// @details 基于UdpBatchSocket，一次可读事件用recvmmsg收取多条SIP消息。
+/// 可以在同一端口上开多个SO_REUSEPORT socket分布到多个reactor：内核按源地址四元组哈希分流，
+/// 同一对端的报文总落在同一个socket上，按序在同一个strand里处理；发送也按目的地址选同一个socket。
 class UdpSipTransport : public SipTransport{
 public:
-    UdpSipTransport(ASIO::IoContext& ctx, const std::string& listen_ip, uint16_t port)
-        : socket_(ctx, ASIO::UdpEndpoint(boost::asio::ip::make_address(listen_ip), port)) {}
+    struct Config {
+        std::string listen_ip = "0.0.0.0";
+        uint16_t port = 5060;
+        /// @brief SO_REUSEPORT socket数，0表示按CPU核数
+        std::size_t sockets = 1;
+        /// @brief 每个socket的SO_RCVBUF，注册风暴时内核缓冲要扛住突发，0保持系统默认
+        int recv_buffer = 0;
+    };
+
+    UdpSipTransport(ASIO::IoContext& ctx, const std::string& listen_ip, uint16_t port);
+    /// @brief 所有socket在同一个io_context上，各自一个strand，由多个线程run时并行收包
+    UdpSipTransport(ASIO::IoContext& ctx, const Config& cfg);
+    /// @brief 每个reactor一个io_context（一个线程一个），socket依次分到各reactor
+    UdpSipTransport(const std::vector<ASIO::IoContext*>& reactors, const Config& cfg);
+    ~UdpSipTransport() override;
 
     void Start() override;
 
     void Stop() override;
 
-    void Send(const SipMessage& msg) override;
+    bool SendBuffer(const Peer& to, Buffer buffer) override;
+
+    ASIO::UdpEndpoint local_endpoint() const { return sockets_.front()->local_endpoint(); }
+    std::size_t socket_count() const noexcept { return sockets_.size(); }
     
 private:
-
-    std::string serialize(const SipMessage& msg);
-    std::string parseSipMsg();
-    ASIO::UdpSocket socket_;
-    ASIO::UdpEndpoint endpoint_;
+    static net::UdpBatchSocket::Config socketConfig();
+    /// @brief 第一个socket绑定后，端口为0时其余socket绑定到它实际分到的端口
+    void open_sockets(const std::vector<boost::asio::any_io_executor>& executors, const Config& cfg);
+    void onDatagrams(const net::UdpDatagram* dgrams, size_t count);
+    std::vector<std::unique_ptr<net::UdpBatchSocket>> sockets_;
 };
 
+class TcpSipConnection;
+
+/// @brief TCP SIP传输层
+/// @details 按Content-Length从字节流切分消息（RFC 3261 18.3）：消息在读缓冲里连续时直接就地解析，
+/// 只把不完整的尾部挪到缓冲开头，放不下时按倍数扩容到max_message_size。
+/// 每个对端地址一条连接，收到的连接和主动发起的连接都按对端地址登记，发往同一对端的请求和应答复用它；
+/// 双CRLF保活（RFC 5626）回单个CRLF。空闲超时挂在时间轮上，每条连接一个轮上节点。
+/// 各连接在自己的strand上分发消息，不同连接的回调可能并发。需通过std::make_shared创建。
+class TcpSipTransport : public SipTransport, public std::enable_shared_from_this<TcpSipTransport> {
+public:
+    struct Config {
+        std::string listen_ip = "0.0.0.0";
+        uint16_t port = 5060;
+        /// @brief 连接无收发多久后关闭（毫秒）
+        int64_t idle_timeout_ms = 180000;
+        /// @brief 主动连接的超时（毫秒）
+        int64_t connect_timeout_ms = 5000;
+        /// @brief 初始读缓冲
+        std::size_t read_buffer_size = 8 * 1024;
+        /// @brief 单条消息（含消息体）上限，超过视为异常，断开连接
+        std::size_t max_message_size = 1024 * 1024;
+        /// @brief 单连接排队未写出的消息上限，超过认为对端不收，断开连接
+        std::size_t max_write_queue = 1024;
+    };
+
+    /// @param timers 空闲超时使用的时间轮，为空时自己创建一个
+    TcpSipTransport(ASIO::IoContext& io, const Config& cfg, std::shared_ptr<net::AsioTimerWheel> timers = nullptr);
+    ~TcpSipTransport() override;
+
+    void Start() override;
+
+    /// @brief 停止监听并断开所有连接
+    void Stop() override;
+
+    /// @brief 有到该对端的连接就复用，没有则发起连接，连上后按序写出
+    bool SendBuffer(const Peer& to, Buffer buffer) override;
+
+    ASIO::TcpEndpoint local_endpoint() const;
+    std::size_t connection_count() const;
+    const Config& config() const noexcept { return cfg_; }
+    net::AsioTimerWheel& timers() noexcept { return *timers_; }
+
+private:
+    friend class TcpSipConnection;
+
+    void do_accept();
+    void on_message(const SipMessageView& msg) { dispatch_message(msg); }
+    /// @brief 连接关闭时注销，只有登记的仍是conn时才移除
+    void remove(const ASIO::TcpEndpoint& remote, const TcpSipConnection* conn);
+
+    ASIO::IoContext& io_;
+    Config cfg_;
+    boost::asio::ip::tcp::acceptor acceptor_;
+    std::shared_ptr<net::AsioTimerWheel> timers_;
+    bool own_timers_;
+
+    mutable std::mutex mtx_;
+    std::map<ASIO::TcpEndpoint, std::shared_ptr<TcpSipConnection>> connections_;
+    bool stopped_ = false;
+};
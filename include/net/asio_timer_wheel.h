@@ -0,0 +1,59 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <boost/asio/steady_timer.hpp>
+#include <boost/asio/strand.hpp>
+#include "net/asio_socket.h"
+#include "base/timer_wheel.h"
+
+namespace net {
+
+/// @brief 用一个steady_timer驱动TimerWheel，供同一io_context上的所有会话共享
+/// @details 任意线程可Schedule/Cancel/Reschedule（一把互斥锁，O(1)）；到期回调在轮自己的strand上批量执行，
+/// 执行时不持锁，需要回到会话strand的由回调自行post。
+/// 只有存在未到期定时器时才按tick唤醒，空闲时不占用reactor；会话数量不影响每tick的开销，
+/// 只有到期的那些节点被处理。
+/// 回调被取出后才执行，此时Cancel返回false，回调仍会执行，调用方需用weak_ptr等方式容忍。
+/// 需通过std::make_shared创建。
+class AsioTimerWheel : public std::enable_shared_from_this<AsioTimerWheel> {
+public:
+    using TimerId = TimerWheel::TimerId;
+    using Callback = TimerWheel::Callback;
+
+    AsioTimerWheel(ASIO::IoContext& io, const TimerWheel::Config& cfg);
+    explicit AsioTimerWheel(ASIO::IoContext& io);
+
+    AsioTimerWheel(const AsioTimerWheel&) = delete;
+    AsioTimerWheel& operator=(const AsioTimerWheel&) = delete;
+
+    TimerId Schedule(int64_t delay_ms, Callback cb);
+    bool Cancel(TimerId id);
+    bool Reschedule(TimerId id, int64_t delay_ms);
+
+    /// @brief 丢弃所有定时器并停止驱动，之后的Schedule返回0
+    void Stop();
+
+    std::size_t size() const;
+
+    /// @brief 轮使用的时间基准（steady_clock毫秒）
+    static int64_t now_ms();
+
+private:
+    /// @brief 持锁调用：轮从空闲变为非空时启动驱动
+    void kick_locked(bool& start);
+    void arm(int64_t at_ms);
+    void on_tick();
+
+    boost::asio::strand<ASIO::IoContext::executor_type> strand_;
+    boost::asio::steady_timer timer_;
+    mutable std::mutex mtx_;
+    TimerWheel wheel_;
+    bool armed_ = false;
+    bool stopped_ = false;
+    std::vector<Callback> expired_;
+};
+
+}
@@ -7,7 +7,8 @@
 using tcp = boost::asio::ip::tcp;
 
 // 继承std::enable_shared_from_this用于安全获取自身的shared_ptr
-class BoostHttpServer : public HttpServerBase, protected std::enable_shared_from_this<BoostHttpServer> {
+// 需通过std::make_shared创建，start()内部依赖shared_from_this()
+class BoostHttpServer : public HttpServerBase, public std::enable_shared_from_this<BoostHttpServer> {
 public:
     /// 构造函数，传入Boost.Asio的IO上下文和监听端口
     explicit BoostHttpServer(boost::asio::io_context& io, uint16_t port);
@@ -16,6 +17,11 @@ public:
     void start() override;
     void stop() override;
 
+    /// @brief 挂载指标接口，默认输出Prometheus文本格式
+    /// @details 请求带 ?format=json 或 Accept: application/json 时输出JSON
+    /// @param path 路径，默认 "/metrics"
+    void EnableMetrics(const std::string& path = "/metrics");
+
 private:
     // Boost.Asio IO上下文
     boost::asio::io_context& io_;
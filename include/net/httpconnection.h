@@ -0,0 +1,28 @@
+#pragma once
+#include "net/httpserver_base.h"
+#include <boost/asio.hpp>
+#include <boost/beast/core.hpp>
+#include <boost/beast/http.hpp>
+#include <memory>
+
+/// @brief 单个HTTP连接，读请求 -> 路由 -> 写响应，支持keep-alive
+class HttpConnection : public std::enable_shared_from_this<HttpConnection> {
+public:
+    /// @param socket 已accept的连接
+    /// @param server 路由来源，需保证生命周期长于连接
+    HttpConnection(boost::asio::ip::tcp::socket socket, std::shared_ptr<const HttpServerBase> server);
+
+    void start();
+
+private:
+    void do_read();
+    void on_read(boost::beast::error_code ec);
+    void do_write();
+    void close();
+
+    boost::beast::tcp_stream stream_;
+    boost::beast::flat_buffer buffer_;
+    boost::beast::http::request<boost::beast::http::string_body> req_;
+    boost::beast::http::response<boost::beast::http::string_body> resp_;
+    std::shared_ptr<const HttpServerBase> server_;
+};
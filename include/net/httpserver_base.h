@@ -1,11 +1,15 @@
 #pragma once
 #include <string>
 #include <functional>
+#include <unordered_map>
 
 // HTTP请求结构体（可根据需要扩展）
 struct HttpRequest {
     std::string method;
     std::string uri;
+    std::string path;   // uri 中 '?' 之前的部分
+    std::string query;  // uri 中 '?' 之后的部分
+    std::string accept; // Accept 头
     std::string body;
     // ... 可扩展 header、参数等
 };
@@ -13,6 +17,7 @@ struct HttpRequest {
 // HTTP响应结构体（可根据需要扩展）
 struct HttpResponse {
     int status_code = 200;
+    std::string content_type = "text/plain; charset=utf-8";
     std::string body;
     // ... 可扩展 header 等
 };
@@ -20,12 +25,33 @@ struct HttpResponse {
 // HTTP服务抽象基类
 class HttpServerBase {
 public:
+    using Handler = std::function<void(const HttpRequest&, HttpResponse&)>;
+
     explicit HttpServerBase(uint16_t port) : port_(port) {}
     virtual ~HttpServerBase() = default;
     // 启动服务，监听端口
     virtual void start() = 0;
     // 停止服务
     virtual void stop() = 0;
+
+    /// @brief 注册路由，需在start()之前调用，运行期只读
+    /// @param path 精确匹配的路径，如 "/metrics"
+    /// @param handler 处理函数
+    void AddRoute(const std::string& path, Handler handler) {
+        routes_[path] = std::move(handler);
+    }
+
+    /// @brief 按路径分发请求，未命中返回404
+    void Dispatch(const HttpRequest& req, HttpResponse& resp) const {
+        auto it = routes_.find(req.path);
+        if (it == routes_.end()) {
+            resp.status_code = 404;
+            resp.body = "not found\n";
+            return;
+        }
+        it->second(req, resp);
+    }
 protected:
     uint16_t port_;
+    std::unordered_map<std::string, Handler> routes_;
 };
@@ -0,0 +1,134 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <vector>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include "net/asio_socket.h"
+
+namespace net {
+
+/// @brief 收到的一个数据报，data指向接收slab，仅在回调期间有效
+struct UdpDatagram {
+    const uint8_t* data = nullptr;
+    size_t size = 0;
+    ASIO::UdpEndpoint from;
+    /// @brief 数据报超过datagram_size被截断
+    bool truncated = false;
+};
+
+/// @brief 待发送的一个数据报，由若干iovec拼成（如RtpPacketView的头+负载）
+struct UdpOutDatagram {
+    const iovec* iov = nullptr;
+    size_t iov_cnt = 0;
+};
+
+/// @brief 批量UDP收发：recvmmsg一次收多个数据报到预分配slab，sendmmsg/UDP_SEGMENT一次发多个
+/// @details 接收由Asio的async_wait(wait_read)驱动，就绪后非阻塞地循环recvmmsg直到EAGAIN，
+/// 每批回调一次。发送时连续等长的数据报合并为一个GSO超级包（最后一个可以更短），
+/// 内核或网卡不支持GSO时自动回退为普通sendmmsg。
+/// 收发缓冲在构造时分配，稳定运行不再分配。
+class UdpBatchSocket {
+public:
+    struct Config {
+        /// @brief 单次recvmmsg/sendmmsg最多处理的数据报数
+        size_t batch = 64;
+        /// @brief 接收slab中每个数据报的字节数
+        size_t datagram_size = 2048;
+        /// @brief 每次可读事件最多收多少批，避免单个socket饿死同线程的其他socket
+        size_t max_batches_per_wakeup = 8;
+        /// @brief SO_REUSEPORT，多socket分流同一端口时使用
+        bool reuse_port = false;
+        /// @brief SO_RCVBUF/SO_SNDBUF，0保持系统默认
+        int recv_buffer = 0;
+        int send_buffer = 0;
+        /// @brief 是否尝试UDP GSO
+        bool enable_gso = true;
+    };
+
+    using BatchHandler = std::function<void(const UdpDatagram* dgrams, size_t count)>;
+
+    UdpBatchSocket(ASIO::IoContext& ctx, const ASIO::UdpEndpoint& local, const Config& cfg);
+    UdpBatchSocket(ASIO::IoContext& ctx, const ASIO::UdpEndpoint& local);
+    /// @brief 回调在指定executor（如会话的strand）上执行
+    UdpBatchSocket(const boost::asio::any_io_executor& executor, const ASIO::UdpEndpoint& local, const Config& cfg);
+    ~UdpBatchSocket();
+
+    UdpBatchSocket(const UdpBatchSocket&) = delete;
+    UdpBatchSocket& operator=(const UdpBatchSocket&) = delete;
+
+    /// @brief 开始异步接收，handler在io_context线程中按批回调
+    void StartReceive(BatchHandler handler);
+    /// @brief 开始异步接收，handler在指定executor（如会话的strand）上回调
+    /// @details 用于socket先在别处创建好（如端口池预绑定），再交给某个会话使用
+    void StartReceive(BatchHandler handler, const boost::asio::any_io_executor& executor);
+    /// @brief 停止异步接收但保留绑定，之后可再次StartReceive
+    /// @details 需在handler所在的executor上调用；已排队的旧回调不会再交给handler
+    void StopReceive();
+    /// @brief 停止异步接收，等已发起的async_wait全部完成后在handler的executor上调用on_stopped
+    /// @details 此后Asio不再持有指向本socket的回调，on_stopped里可以析构socket；
+    /// on_stopped被调用前不要再次StartReceive
+    void StopReceive(std::function<void()> on_stopped);
+
+    /// @brief 非阻塞收一批，返回收到的个数（无数据返回0，出错返回-1）
+    /// @details 结果写入内部数组，通过datagrams()访问，下一次调用前有效
+    int ReceiveBatch();
+    const UdpDatagram* datagrams() const noexcept { return datagrams_.data(); }
+
+    /// @brief 批量发送到同一目的地址
+    /// @return 实际发出的数据报数，发送缓冲区满时可能小于count，出错返回-1
+    int SendBatch(const ASIO::UdpEndpoint& to, const UdpOutDatagram* dgrams, size_t count);
+
+    /// @brief 发送单个数据报
+    bool SendTo(const ASIO::UdpEndpoint& to, const void* data, size_t size);
+
+    void Close();
+
+    ASIO::UdpEndpoint local_endpoint() const;
+    bool gso_enabled() const noexcept { return gso_; }
+    ASIO::UdpSocket& socket() noexcept { return socket_; }
+
+private:
+    void arm();
+    void on_readable(uint64_t generation);
+    /// @brief 把[begin, end)中的数据报填进一条mmsghdr，返回消耗的数据报数
+    size_t build_message(const ASIO::UdpEndpoint& to, const UdpOutDatagram* dgrams, size_t count, size_t msg_index);
+    int send_messages(size_t msg_count);
+
+    Config cfg_;
+    ASIO::UdpSocket socket_;
+    BatchHandler handler_;
+    /// @brief handler所在的executor，为空时用socket自己的
+    boost::asio::any_io_executor handler_executor_;
+    /// @brief 每次StartReceive/StopReceive递增，过期的等待完成后直接丢弃
+    std::atomic<uint64_t> receive_generation_{0};
+    bool receiving_ = false;
+    /// @brief 未完成的async_wait计数，由等待回调共同持有：被取消的等待在socket析构后完成也只访问它
+    struct WaitState {
+        size_t pending = 0;
+        /// @brief StopReceive(on_stopped)登记的回调，最后一个等待完成时调用
+        std::function<void()> on_stopped;
+    };
+    std::shared_ptr<WaitState> wait_state_ = std::make_shared<WaitState>();
+    bool gso_ = false;
+
+    // 接收
+    std::vector<uint8_t> slab_;
+    std::vector<mmsghdr> recv_msgs_;
+    std::vector<iovec> recv_iov_;
+    std::vector<sockaddr_storage> recv_addrs_;
+    std::vector<UdpDatagram> datagrams_;
+
+    // 发送
+    std::vector<mmsghdr> send_msgs_;
+    std::vector<iovec> send_iov_;
+    std::vector<uint8_t> send_cmsg_;
+    /// @brief 每条mmsghdr包含的原始数据报数，用于换算部分发送
+    std::vector<size_t> send_counts_;
+    size_t send_iov_used_ = 0;
+};
+
+}
@@ -1,9 +1,17 @@
 #include "epoch_reclaimer.h"
 
 
-thread_local EpochReclaimer::Participant* EpochReclaimer::tls_participant_ = nullptr;
+thread_local EpochReclaimer::TlsSlot EpochReclaimer::tls_slots_[EpochReclaimer::kTlsSlots];
 
-EpochReclaimer::EpochReclaimer() : global_epoch_(0), participants_(nullptr) {
+static std::atomic<uint64_t> g_reclaimer_id{0};
+
+/// @brief 本线程的存活标记，线程退出时释放，参与者节点里的weak_ptr随之失效
+static const std::shared_ptr<void>& thread_token() {
+    thread_local const std::shared_ptr<void> token = std::make_shared<char>();
+    return token;
+}
+
+EpochReclaimer::EpochReclaimer() : id_(++g_reclaimer_id), global_epoch_(0), participants_(nullptr) {
 
 }
 
@@ -18,32 +26,62 @@ EpochReclaimer::~EpochReclaimer() {
 }
 
 EpochReclaimer::Participant* EpochReclaimer::register_thread() {
-    // 已注册
-    if(tls_participant_) {
-        return tls_participant_;
+    // 已注册，常见情况命中第一个槽
+    if(tls_slots_[0].owner == id_) {
+        return tls_slots_[0].participant;
+    }
+    for(std::size_t i = 1; i < kTlsSlots; ++i) {
+        if(tls_slots_[i].owner == id_) {
+            TlsSlot hit = tls_slots_[i];
+            std::copy_backward(tls_slots_, tls_slots_ + i, tls_slots_ + i + 1);
+            tls_slots_[0] = hit;
+            return hit.participant;
+        }
+    }
+    // 缓存里没有：本线程用过的回收器比槽多，回到这个回收器时从链表找回之前注册的节点；
+    // 线程号可能被复用，已退出线程的节点不认领
+    const auto tid = std::this_thread::get_id();
+    Participant* p = nullptr;
+    for(Participant* q = participants_.load(std::memory_order_acquire); q; q = q->next) {
+        if(q->owner == tid && !q->alive.expired()) {
+            p = q;
+            break;
+        }
+    }
+    if(!p) {
+        p = new_participant(tid);
     }
+    // 挤掉最久没用的槽；id_不复用，已析构回收器留下的槽不会被误命中
+    std::copy_backward(tls_slots_, tls_slots_ + kTlsSlots - 1, tls_slots_ + kTlsSlots);
+    tls_slots_[0] = TlsSlot{id_, p};
+    return p;
+}
+
+EpochReclaimer::Participant* EpochReclaimer::new_participant(std::thread::id tid) {
     // 每个线程只有一个Paritcipant，记录它的local_epoch、active、退休节点
     auto* p = new Participant();
+    p->owner = tid;
+    p->alive = thread_token();
     Participant* old_head = participants_.load(std::memory_order_acquire);
     do {
         // 将新节点插入到全局参与者链表的头部
         p->next = old_head;
         // 循环重试，直至old_head更新成新注册的participants
     } while(!participants_.compare_exchange_weak(old_head, p, std::memory_order_release, std::memory_order_acquire));
-    // 注册成功，将线程本地变量指向新注册的participant
-    tls_participant_ = p;
     return p;
 }
 
 EpochReclaimer::Guard::Guard(EpochReclaimer& reclaimer) : reclaimer_(reclaimer) {
     // 获取当前线程对应的Participant节点
     self_ = reclaimer_.register_thread();
-    // 将线程标记为active
-    self_->active.store(true, std::memory_order_release);
-
     // 读取并将线程本地的epoch更新为全局epoch，表明线程正在使用该epoch内的数据
-    Epoch g = reclaimer_.global_epoch_.load(std::memory_order_acquire);
-    self_->local_epoch.store(g, std::memory_order_release);
+    Epoch g = reclaimer_.global_epoch_.load(std::memory_order_relaxed);
+    self_->local_epoch.store(g, std::memory_order_relaxed);
+    // 将线程标记为active
+    self_->active.store(true, std::memory_order_relaxed);
+    // 与can_advance里的fence配对：active/local_epoch的写必须先于之后对共享结构的读可见（store-load），
+    // 否则推进方可能看到active=false，连推两代后回收本线程马上要读的节点；一次fence代替三次seq_cst写
+    std::atomic_thread_fence(std::memory_order_seq_cst);
 }
 
 EpochReclaimer::Guard::~Guard() {
@@ -58,6 +96,7 @@ void EpochReclaimer::quiescent_point() {
 
 
 bool EpochReclaimer::can_advance(Epoch cur) {
+    std::atomic_thread_fence(std::memory_order_seq_cst);
     Participant* p = participants_.load(std::memory_order_acquire);
     while(p) {
         // 线程活跃则读取它的local_epoch，线程还停留在旧的epoch就不能推进
@@ -110,9 +149,9 @@ void EpochReclaimer::maybe_advance_and_reclaim(Participant* self) {
     // }
 
 
-    std::size_t threads = active_thread_count();
-    std::size_t threshold = base_batch_.load(std::memory_order_relaxed) * threads;
-    retire_batch_.store(threshold, std::memory_order_relaxed);
+    // 这里每次出入临界区都会走到，先只做本线程内的廉价判断；
+    // 阈值沿用上次推进时按活跃线程数算好的值，需要推进时才扫描参与者链表
+    std::size_t threshold = retire_batch_.load(std::memory_order_relaxed);
 
     // 本线程累计retired数
     std::size_t local_retired = 0;
@@ -127,8 +166,8 @@ void EpochReclaimer::maybe_advance_and_reclaim(Participant* self) {
     std::size_t stride = probe_stride_.load(std::memory_order_relaxed);
     bool probe = (cnt % stride == 0);
 
-    // 取出全局累计retired数，并清零
-    std::size_t global_retired = take_and_reset_global_retired_count();
+    // 全局累计retired数，只读不清零，达到阈值的线程负责清零
+    std::size_t global_retired = global_retired_count_.load(std::memory_order_relaxed);
     
     // 触发条件：
     // 1. 本线程达到阈值
@@ -137,21 +176,56 @@ void EpochReclaimer::maybe_advance_and_reclaim(Participant* self) {
     if(!(local_retired >= threshold || global_retired >= threshold || probe)) {
         return;
     }
+    if(global_retired >= threshold) {
+        take_and_reset_global_retired_count();
+    }
+
+    std::size_t threads = active_thread_count();
+    retire_batch_.store(base_batch_.load(std::memory_order_relaxed) * threads, std::memory_order_relaxed);
 
     Epoch cur = global_epoch_.load(std::memory_order_acquire);
-    if(can_advance(cur)) {
-        // 将global_epoch推进到cur+1，这是一个原子操作
-        global_epoch_.store(cur + 1, std::memory_order_release);
-        // 回收这个epoch对应的安全桶(落后该epoch两代)
-        reclaim_safe_bukets(cur + 1);
+    // 将global_epoch推进到cur+1；多个线程同时推进时只有一个成功，不会跳代
+    if(can_advance(cur) &&
+       global_epoch_.compare_exchange_strong(cur, cur + 1, std::memory_order_seq_cst, std::memory_order_acquire)) {
+        // 已退出的线程不会再走到这里，它们的桶由推进成功的线程顺带清理
+        reclaim_orphan_bukets(self, cur + 1);
     }
     
-    //无论是否推进，仍然尝试清理当前安全桶
-    reclaim_safe_bukets(global_epoch_.load(std::memory_order_acquire));
+    // 无论是否推进，清理本线程的安全桶(落后当前epoch两代)
+    reclaim_safe_bukets(self, global_epoch_.load(std::memory_order_acquire));
+
+}
+
+void EpochReclaimer::reclaim_safe_bukets(Participant* self, Epoch g_now) {
+    std::size_t safe_buket = static_cast<std::size_t>((g_now + 1) % 3);
+    auto& vec = self->retired[safe_buket];
+    // 回收函数可能把对象放回空闲链表，不会再退休新对象，可以直接遍历
+    for(auto& ele : vec) {
+        ele.deleter(ele.ptr);
+    }
+    vec.clear();
+}
 
+void EpochReclaimer::reclaim_orphan_bukets(Participant* self, Epoch g_now) {
+    for(Participant* p = participants_.load(std::memory_order_acquire); p; p = p->next) {
+        if(p == self || p->drained.load(std::memory_order_relaxed) || !p->alive.expired()) {
+            continue;
+        }
+        // 其他推进线程正在清理它
+        if(p->adopting.exchange(true, std::memory_order_acquire)) {
+            continue;
+        }
+        // 与线程退出时释放存活标记配对，看到它退出前写入的桶
+        std::atomic_thread_fence(std::memory_order_acquire);
+        reclaim_safe_bukets(p, g_now);
+        if(p->retired[0].empty() && p->retired[1].empty() && p->retired[2].empty()) {
+            p->drained.store(true, std::memory_order_relaxed);
+        }
+        p->adopting.store(false, std::memory_order_release);
+    }
 }
 
-void EpochReclaimer::reclaim_safe_bukets(Epoch g_now) {
+void EpochReclaimer::reclaim_all_safe_bukets(Epoch g_now) {
     std::size_t safe_buket = static_cast<std::size_t>((g_now + 1) % 3);
     Participant* p = participants_.load(std::memory_order_acquire);
     while(p) {
@@ -168,11 +242,11 @@ void EpochReclaimer::drain_all() {
     for(int i = 0; i < 4; ++i) {
         Epoch cur = global_epoch_.load(std::memory_order_acquire);
         global_epoch_.store(cur + 1, std::memory_order_release);
-        reclaim_safe_bukets(cur + 1);
+        reclaim_all_safe_bukets(cur + 1);
     }
 
     //再扫一遍当前的安全桶
-    reclaim_safe_bukets(global_epoch_.load(std::memory_order_acquire));
+    reclaim_all_safe_bukets(global_epoch_.load(std::memory_order_acquire));
     //清零全局计数
     global_retired_count_.store(0, std::memory_order_relaxed);
 }
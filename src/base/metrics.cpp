@@ -0,0 +1,246 @@
+#include "metrics.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <json/json.h>
+
+namespace {
+
+/// @brief Prometheus 标签值转义：反斜杠、双引号、换行
+void append_escaped(std::string& out, const std::string& value) {
+    for (char c : value) {
+        switch (c) {
+        case '\\': out += "\\\\"; break;
+        case '"':  out += "\\\""; break;
+        case '\n': out += "\\n";  break;
+        default:   out += c;      break;
+        }
+    }
+}
+
+void append_value(std::string& out, double value) {
+    if (std::isnan(value)) {
+        out += "NaN";
+        return;
+    }
+    if (std::isinf(value)) {
+        out += value > 0 ? "+Inf" : "-Inf";
+        return;
+    }
+    char buf[32];
+    // 整数值按整数输出，避免 1e+06 这种写法
+    if (value == std::floor(value) && std::fabs(value) < 1e15) {
+        std::snprintf(buf, sizeof(buf), "%.0f", value);
+    } else {
+        std::snprintf(buf, sizeof(buf), "%.6g", value);
+    }
+    out += buf;
+}
+
+const char* type_name(MetricType type) {
+    return type == MetricType::Counter ? "counter" : "gauge";
+}
+
+} // namespace
+
+/************************************MetricsHandle***********************************/
+MetricsHandle::~MetricsHandle() {
+    reset();
+}
+
+MetricsHandle::MetricsHandle(MetricsHandle&& other) noexcept
+    : registry_(other.registry_), id_(other.id_) {
+    other.registry_ = nullptr;
+    other.id_ = 0;
+}
+
+MetricsHandle& MetricsHandle::operator=(MetricsHandle&& other) noexcept {
+    if (this != &other) {
+        reset();
+        registry_ = other.registry_;
+        id_ = other.id_;
+        other.registry_ = nullptr;
+        other.id_ = 0;
+    }
+    return *this;
+}
+
+void MetricsHandle::reset() noexcept {
+    if (registry_) {
+        registry_->Unregister(id_);
+        registry_ = nullptr;
+        id_ = 0;
+    }
+}
+
+/************************************MetricsRegistry***********************************/
+MetricsRegistry::MetricsRegistry() : table_(std::make_shared<const Table>()) {
+
+}
+
+MetricsHandle MetricsRegistry::RegisterCounter(const std::string& name, const std::string& help,
+                                               const MetricLabels& labels, const std::atomic<uint64_t>* counter) {
+    auto entry = std::make_shared<Entry>();
+    entry->name = name;
+    entry->help = help;
+    entry->type = MetricType::Counter;
+    entry->labels = labels;
+    entry->counter = counter;
+    return add(std::move(entry));
+}
+
+MetricsHandle MetricsRegistry::RegisterGauge(const std::string& name, const std::string& help,
+                                             const MetricLabels& labels, GaugeFunc fn) {
+    auto entry = std::make_shared<Entry>();
+    entry->name = name;
+    entry->help = help;
+    entry->type = MetricType::Gauge;
+    entry->labels = labels;
+    entry->gauge = std::move(fn);
+    return add(std::move(entry));
+}
+
+MetricsHandle MetricsRegistry::RegisterCollector(Collector collector) {
+    auto entry = std::make_shared<Entry>();
+    entry->type = MetricType::Gauge;
+    entry->collector = std::move(collector);
+    return add(std::move(entry));
+}
+
+MetricsHandle MetricsRegistry::add(std::shared_ptr<Entry> entry) {
+    std::lock_guard<std::mutex> lock(write_mtx_);
+    entry->id = next_id_++;
+    uint64_t id = entry->id;
+
+    // copy-on-write：复制旧表追加后整体发布
+    auto old_table = table_.load();
+    auto new_table = std::make_shared<Table>(*old_table);
+    new_table->push_back(std::move(entry));
+    table_.store(std::move(new_table));
+    return MetricsHandle(this, id);
+}
+
+void MetricsRegistry::Unregister(uint64_t id) {
+    std::shared_ptr<const Entry> removed;
+    {
+        std::lock_guard<std::mutex> lock(write_mtx_);
+        auto old_table = table_.load();
+        auto new_table = std::make_shared<Table>();
+        new_table->reserve(old_table->size());
+        for (auto& e : *old_table) {
+            if (e->id != id) {
+                new_table->push_back(e);
+            } else {
+                removed = e;
+            }
+        }
+        table_.store(std::move(new_table));
+    }
+    if (!removed) {
+        return;
+    }
+    // 等正在读取该条目的抓取读完；之后拿着旧快照的抓取会跳过它，调用方即可安全销毁被引用的计数器
+    std::lock_guard<std::recursive_mutex> lock(removed->mtx);
+    removed->alive = false;
+}
+
+std::vector<MetricSample> MetricsRegistry::Collect() const {
+    auto table = table_.load();
+
+    MetricsWriter writer;
+    writer.samples().reserve(table->size());
+    for (auto& e : *table) {
+        std::lock_guard<std::recursive_mutex> lock(e->mtx);
+        if (!e->alive) {
+            continue;
+        }
+        if (e->collector) {
+            try {
+                e->collector(writer);
+            } catch (...) {
+                // 单个collector失败不影响整体抓取
+            }
+        } else if (e->counter) {
+            writer.Add(e->name, e->type, e->help, e->labels,
+                       static_cast<double>(e->counter->load(std::memory_order_relaxed)));
+        } else if (e->gauge) {
+            writer.Add(e->name, e->type, e->help, e->labels, e->gauge());
+        }
+    }
+
+    // 同名指标需要连续输出
+    auto& samples = writer.samples();
+    std::stable_sort(samples.begin(), samples.end(), [](const MetricSample& a, const MetricSample& b) {
+        return a.name < b.name;
+    });
+    return std::move(samples);
+}
+
+std::string MetricsRegistry::RenderPrometheus() const {
+    auto samples = Collect();
+    std::string out;
+    out.reserve(samples.size() * 96);
+
+    const std::string* last_name = nullptr;
+    for (auto& s : samples) {
+        if (!last_name || *last_name != s.name) {
+            if (!s.help.empty()) {
+                out += "# HELP ";
+                out += s.name;
+                out += ' ';
+                out += s.help;
+                out += '\n';
+            }
+            out += "# TYPE ";
+            out += s.name;
+            out += ' ';
+            out += type_name(s.type);
+            out += '\n';
+            last_name = &s.name;
+        }
+        out += s.name;
+        if (!s.labels.empty()) {
+            out += '{';
+            for (std::size_t i = 0; i < s.labels.size(); ++i) {
+                if (i) {
+                    out += ',';
+                }
+                out += s.labels[i].first;
+                out += "=\"";
+                append_escaped(out, s.labels[i].second);
+                out += '"';
+            }
+            out += '}';
+        }
+        out += ' ';
+        append_value(out, s.value);
+        out += '\n';
+    }
+    return out;
+}
+
+std::string MetricsRegistry::RenderJson() const {
+    auto samples = Collect();
+    Json::Value root;
+    Json::Value& metrics = root["metrics"];
+    metrics = Json::Value(Json::arrayValue);
+    for (auto& s : samples) {
+        Json::Value item;
+        item["name"] = s.name;
+        item["type"] = type_name(s.type);
+        Json::Value labels(Json::objectValue);
+        for (auto& [k, v] : s.labels) {
+            labels[k] = v;
+        }
+        item["labels"] = labels;
+        item["value"] = s.value;
+        metrics.append(item);
+    }
+    Json::StreamWriterBuilder builder;
+    builder["indentation"] = "";
+    return Json::writeString(builder, root);
+}
+
+std::size_t MetricsRegistry::size() const {
+    return table_.load()->size();
+}
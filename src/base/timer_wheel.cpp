@@ -0,0 +1,199 @@
+#include "timer_wheel.h"
+
+TimerWheel::TimerWheel(int64_t now_ms) : TimerWheel(Config{}, now_ms) {
+
+}
+
+TimerWheel::TimerWheel(const Config& cfg, int64_t now_ms)
+    : cfg_(cfg), origin_ms_(now_ms), heads_(kSlotCount, kNil) {
+    if (cfg_.tick_ms <= 0) {
+        cfg_.tick_ms = 1;
+    }
+}
+
+TimerWheel::Node* TimerWheel::lookup(TimerId id) noexcept {
+    uint32_t index = static_cast<uint32_t>(id);
+    uint32_t generation = static_cast<uint32_t>(id >> 32);
+    if (index >= nodes_.size()) {
+        return nullptr;
+    }
+    Node& n = nodes_[index];
+    if (n.generation != generation || n.slot == kNil) {
+        return nullptr;
+    }
+    return &n;
+}
+
+uint64_t TimerWheel::ticks_for(int64_t delay_ms) const noexcept {
+    if (delay_ms <= 0) {
+        return 0;
+    }
+    // current_是下一个待处理的tick，当前时刻落在它之前的一个tick内，向上取整保证不提前到期
+    return static_cast<uint64_t>((delay_ms + cfg_.tick_ms - 1) / cfg_.tick_ms);
+}
+
+TimerWheel::TimerId TimerWheel::Schedule(int64_t delay_ms, Callback cb) {
+    uint32_t index;
+    if (free_ != kNil) {
+        index = free_;
+        free_ = nodes_[index].next;
+    } else {
+        index = static_cast<uint32_t>(nodes_.size());
+        nodes_.emplace_back();
+    }
+    Node& n = nodes_[index];
+    n.cb = std::move(cb);
+    n.expires = current_ + ticks_for(delay_ms);
+    place(index);
+    ++size_;
+    return (static_cast<uint64_t>(n.generation) << 32) | index;
+}
+
+bool TimerWheel::Cancel(TimerId id) {
+    if (!lookup(id)) {
+        return false;
+    }
+    uint32_t index = static_cast<uint32_t>(id);
+    unlink(index);
+    release(index);
+    return true;
+}
+
+bool TimerWheel::Reschedule(TimerId id, int64_t delay_ms) {
+    Node* n = lookup(id);
+    if (!n) {
+        return false;
+    }
+    uint32_t index = static_cast<uint32_t>(id);
+    unlink(index);
+    n->expires = current_ + ticks_for(delay_ms);
+    place(index);
+    return true;
+}
+
+void TimerWheel::place(uint32_t index) {
+    Node& n = nodes_[index];
+    if (n.expires < current_) {
+        n.expires = current_;
+    }
+    uint64_t delta = n.expires - current_;
+    uint32_t slot;
+    if (delta < kLevel0Size) {
+        slot = static_cast<uint32_t>(n.expires & (kLevel0Size - 1));
+    } else {
+        if (delta > kMaxTicks) {
+            n.expires = current_ + kMaxTicks;
+            delta = kMaxTicks;
+        }
+        int level = 1;
+        while (level < kLevels - 1 && delta >= (1ull << (kLevel0Bits + level * kLevelBits))) {
+            ++level;
+        }
+        int shift = kLevel0Bits + (level - 1) * kLevelBits;
+        slot = kLevel0Size + (level - 1) * kLevelSize + static_cast<uint32_t>((n.expires >> shift) & (kLevelSize - 1));
+    }
+    link(slot, index);
+}
+
+void TimerWheel::link(uint32_t slot, uint32_t index) noexcept {
+    Node& n = nodes_[index];
+    n.slot = slot;
+    n.prev = kNil;
+    n.next = heads_[slot];
+    if (n.next != kNil) {
+        nodes_[n.next].prev = index;
+    }
+    heads_[slot] = index;
+}
+
+void TimerWheel::unlink(uint32_t index) noexcept {
+    Node& n = nodes_[index];
+    if (n.prev != kNil) {
+        nodes_[n.prev].next = n.next;
+    } else {
+        heads_[n.slot] = n.next;
+    }
+    if (n.next != kNil) {
+        nodes_[n.next].prev = n.prev;
+    }
+    n.prev = kNil;
+    n.next = kNil;
+    n.slot = kNil;
+}
+
+void TimerWheel::release(uint32_t index) {
+    Node& n = nodes_[index];
+    n.cb = nullptr;
+    // 代数递增，旧句柄失效
+    if (++n.generation == 0) {
+        n.generation = 1;
+    }
+    n.next = free_;
+    free_ = index;
+    --size_;
+}
+
+void TimerWheel::cascade(int level) {
+    int shift = kLevel0Bits + (level - 1) * kLevelBits;
+    uint32_t slot = kLevel0Size + (level - 1) * kLevelSize + static_cast<uint32_t>((current_ >> shift) & (kLevelSize - 1));
+    uint32_t index = heads_[slot];
+    heads_[slot] = kNil;
+    while (index != kNil) {
+        uint32_t next = nodes_[index].next;
+        place(index);
+        index = next;
+    }
+}
+
+std::size_t TimerWheel::Advance(int64_t now_ms, std::vector<Callback>& expired) {
+    if (now_ms < origin_ms_) {
+        return 0;
+    }
+    const uint64_t target = static_cast<uint64_t>((now_ms - origin_ms_) / cfg_.tick_ms);
+    std::size_t count = 0;
+    while (current_ <= target) {
+        if (size_ == 0) {
+            // 空轮直接跳到目标，长时间空闲后不必逐个tick空转
+            current_ = target + 1;
+            break;
+        }
+        uint32_t slot = static_cast<uint32_t>(current_ & (kLevel0Size - 1));
+        if (slot == 0) {
+            // 下层转完一圈，依次把上层当前槽下沉
+            for (int level = 1; level < kLevels; ++level) {
+                cascade(level);
+                int shift = kLevel0Bits + (level - 1) * kLevelBits;
+                if (((current_ >> shift) & (kLevelSize - 1)) != 0) {
+                    break;
+                }
+            }
+        }
+        // 整槽取下，槽内节点到期tick都等于current_
+        while (heads_[slot] != kNil) {
+            uint32_t index = heads_[slot];
+            unlink(index);
+            expired.push_back(std::move(nodes_[index].cb));
+            release(index);
+            ++count;
+        }
+        ++current_;
+    }
+    return count;
+}
+
+std::size_t TimerWheel::Advance(int64_t now_ms) {
+    // 回调里可能再次Advance，先把复用的缓冲换出来
+    std::vector<Callback> batch;
+    batch.swap(scratch_);
+    std::size_t count = Advance(now_ms, batch);
+    for (Callback& cb : batch) {
+        if (cb) {
+            cb();
+        }
+    }
+    batch.clear();
+    if (batch.capacity() > scratch_.capacity()) {
+        scratch_.swap(batch);
+    }
+    return count;
+}
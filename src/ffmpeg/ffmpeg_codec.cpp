@@ -665,6 +665,19 @@ std::atomic<uint64_t>& CodecContext::getFrameSend() noexcept {
     return frames_send_;
 }
 
+void CodecContext::BindMetrics(const MetricLabels& labels) {
+    auto& registry = MetricsRegistry::getInstance();
+    metrics_handles_.clear();
+    metrics_handles_.push_back(registry.RegisterCounter("media_codec_packets_sent_total",
+        "Packets sent to the decoder", labels, &packets_send_));
+    metrics_handles_.push_back(registry.RegisterCounter("media_codec_frames_received_total",
+        "Frames received from the decoder", labels, &frames_recv_));
+    metrics_handles_.push_back(registry.RegisterCounter("media_codec_frames_sent_total",
+        "Frames sent to the encoder", labels, &frames_send_));
+    metrics_handles_.push_back(registry.RegisterCounter("media_codec_packets_received_total",
+        "Packets received from the encoder", labels, &packets_recv_));
+}
+
 /************************************CodecSession***********************************/
 // FFmpegResult CodecSession::Decode(::AVFrame* out_frame, int time_out,
 //     ReadFrameFunc read_fc, SendPacketFunc send_fc, SendNullPacketFunc send_null_fc, RecvFrameFunc recv_fc, 
@@ -320,6 +320,20 @@ void HWDevicePool::SetRetryBackoff(int milsec) {
     retry_backoff_ = milsec;
 }
 
+void HWDevicePool::BindMetrics(const std::string& pool_name) {
+    metrics_handle_ = MetricsRegistry::getInstance().RegisterCollector([this, pool_name](MetricsWriter& w) {
+        for (auto& snap : snapshots()) {
+            const char* type = av_hwdevice_get_type_name(snap.type);
+            MetricLabels labels{{"pool", pool_name},
+                                {"device", std::to_string(snap.id)},
+                                {"type", type ? type : "unknown"},
+                                {"name", snap.name}};
+            w.Add("media_hwdevice_load", MetricType::Gauge, "Active handles on the device", labels, snap.load);
+            w.Add("media_hwdevice_healthy", MetricType::Gauge, "1 if the device passed the last health check", labels, snap.healthy ? 1 : 0);
+        }
+    });
+}
+
 std::shared_ptr<HWDeviceEntry> HWDevicePool::pick_entry(SelectionStrategy strategy, std::optional<std::size_t> manual_idx) const {
     if (entries_.empty()) {
         return nullptr;
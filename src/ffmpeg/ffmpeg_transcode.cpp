@@ -65,6 +65,10 @@ VideoTranscoder::VideoTranscoder(const std::string& in_url, const std::string& o
         throw std::runtime_error("avformat_write_header failed");
     }
     std::cout << "FormatContext write header success" << std::endl;
+
+    // 按输入流导出编解码计数
+    decoder_->BindMetrics({{"stream", in_url_}, {"role", "decoder"}});
+    encoder_->BindMetrics({{"stream", in_url_}, {"role", "encoder"}});
 }
 
 VideoTranscoder::~VideoTranscoder() noexcept {
@@ -5,6 +5,7 @@ BoostAsyncLogger::BoostAsyncLogger(std::unique_ptr<LogQueue<AsyncLogger::LogItem
     : queue_(std::move(queue)), running_(true), worker_([this](){ run(); }) {
         
         boost::log::add_common_attributes();
+        queue_metrics_ = MetricsRegistry::getInstance().RegisterQueue("log", *queue_);
 }
 
 BoostAsyncLogger::~BoostAsyncLogger() {
@@ -0,0 +1,554 @@
+#include "mpeg_ps.h"
+#include <algorithm>
+#include <cstring>
+
+namespace {
+    /// @brief program_mux_rate/rate_bound，单位50字节/秒（约4Mbit/s）
+    constexpr uint32_t kMuxRate = 10000;
+    /// @brief 单个PES的负载上限，给PES头留出余量，不超过16位PES_packet_length
+    constexpr std::size_t kMaxPesPayload = 65000;
+    /// @brief 关键帧判断只看访问单元开头的这些字节（参数集/IDR通常在最前面）
+    constexpr std::size_t kKeyframeScanBytes = 1024;
+    const uint8_t kStartCode[4] = {0, 0, 0, 1};
+
+    uint32_t crc32_mpeg(const uint8_t* data, std::size_t size) {
+        uint32_t crc = 0xFFFFFFFF;
+        for (std::size_t i = 0; i < size; ++i) {
+            crc ^= static_cast<uint32_t>(data[i]) << 24;
+            for (int b = 0; b < 8; ++b) {
+                crc = (crc & 0x80000000) ? (crc << 1) ^ 0x04C11DB7 : crc << 1;
+            }
+        }
+        return crc;
+    }
+
+    void write_timestamp(uint8_t* p, uint8_t prefix, uint64_t ts) {
+        p[0] = static_cast<uint8_t>((prefix << 4) | (((ts >> 30) & 0x07) << 1) | 0x01);
+        p[1] = static_cast<uint8_t>(ts >> 22);
+        p[2] = static_cast<uint8_t>((((ts >> 15) & 0x7F) << 1) | 0x01);
+        p[3] = static_cast<uint8_t>(ts >> 7);
+        p[4] = static_cast<uint8_t>(((ts & 0x7F) << 1) | 0x01);
+    }
+
+    int64_t read_timestamp(const uint8_t* p) {
+        return (static_cast<int64_t>((p[0] >> 1) & 0x07) << 30) | (static_cast<int64_t>(p[1]) << 22)
+             | (static_cast<int64_t>(p[2] >> 1) << 15) | (static_cast<int64_t>(p[3]) << 7) | (p[4] >> 1);
+    }
+
+    /// @brief 从pos开始找下一个00 00 01，找不到返回size
+    std::size_t find_start_code(const uint8_t* data, std::size_t pos, std::size_t size) {
+        while (pos + 3 <= size) {
+            if (data[pos + 2] > 1) {
+                pos += 3;
+            } else if (data[pos] == 0 && data[pos + 1] == 0 && data[pos + 2] == 1) {
+                return pos;
+            } else {
+                ++pos;
+            }
+        }
+        return size;
+    }
+
+    bool is_pes_stream(uint8_t id) {
+        return (id >= 0xC0 && id <= 0xEF) || id == 0xBD;
+    }
+}
+
+/************************************Ps***********************************/
+namespace Ps {
+
+PsCodec CodecFromStreamType(uint8_t stream_type) noexcept {
+    switch (stream_type) {
+        case 0x1B: return PsCodec::H264;
+        case 0x24: return PsCodec::H265;
+        case 0x10: return PsCodec::Mpeg4;
+        case 0x80: return PsCodec::Svac;
+        case 0x0F: return PsCodec::Aac;
+        case 0x90: return PsCodec::G711A;
+        case 0x91: return PsCodec::G711U;
+        case 0x92: return PsCodec::G7221;
+        case 0x93: return PsCodec::G7231;
+        case 0x99: return PsCodec::G729;
+        default:   return PsCodec::Unknown;
+    }
+}
+
+uint8_t StreamTypeFromCodec(PsCodec codec) noexcept {
+    switch (codec) {
+        case PsCodec::H264:  return 0x1B;
+        case PsCodec::H265:  return 0x24;
+        case PsCodec::Mpeg4: return 0x10;
+        case PsCodec::Svac:  return 0x80;
+        case PsCodec::Aac:   return 0x0F;
+        case PsCodec::G711A: return 0x90;
+        case PsCodec::G711U: return 0x91;
+        case PsCodec::G7221: return 0x92;
+        case PsCodec::G7231: return 0x93;
+        case PsCodec::G729:  return 0x99;
+        default:             return 0;
+    }
+}
+
+bool IsVideo(PsCodec codec) noexcept {
+    return codec == PsCodec::H264 || codec == PsCodec::H265 || codec == PsCodec::Mpeg4 || codec == PsCodec::Svac;
+}
+
+std::size_t WritePackHeader(uint8_t* p, uint64_t scr, uint32_t mux_rate) {
+    p[0] = 0x00;
+    p[1] = 0x00;
+    p[2] = 0x01;
+    p[3] = PS_PACK_START_CODE;
+    // '01' SCR[32..30] 1 SCR[29..15] 1 SCR[14..0] 1 SCR_ext(0) 1
+    p[4] = static_cast<uint8_t>(0x44 | ((scr >> 27) & 0x38) | ((scr >> 28) & 0x03));
+    p[5] = static_cast<uint8_t>(scr >> 20);
+    p[6] = static_cast<uint8_t>(0x04 | ((scr >> 12) & 0xF8) | ((scr >> 13) & 0x03));
+    p[7] = static_cast<uint8_t>(scr >> 5);
+    p[8] = static_cast<uint8_t>(0x04 | ((scr << 3) & 0xF8));
+    p[9] = 0x01;
+    p[10] = static_cast<uint8_t>(mux_rate >> 14);
+    p[11] = static_cast<uint8_t>(mux_rate >> 6);
+    p[12] = static_cast<uint8_t>(((mux_rate << 2) & 0xFC) | 0x03);
+    p[13] = 0xF8;   // reserved + pack_stuffing_length=0
+    return PS_PACK_HEADER_SIZE;
+}
+
+std::size_t WritePesHeader(uint8_t* p, uint8_t stream_id, std::size_t payload_size, int64_t pts, int64_t dts) {
+    bool has_pts = pts >= 0;
+    bool has_dts = has_pts && dts >= 0 && dts != pts;
+    uint8_t header_data = static_cast<uint8_t>((has_pts ? 5 : 0) + (has_dts ? 5 : 0));
+    std::size_t pes_len = 3 + header_data + payload_size;
+
+    p[0] = 0x00;
+    p[1] = 0x00;
+    p[2] = 0x01;
+    p[3] = stream_id;
+    p[4] = static_cast<uint8_t>(pes_len >> 8);
+    p[5] = static_cast<uint8_t>(pes_len);
+    // '10' + 数据对齐：带PTS的PES从访问单元开头开始
+    p[6] = has_pts ? 0x84 : 0x80;
+    p[7] = has_dts ? 0xC0 : (has_pts ? 0x80 : 0x00);
+    p[8] = header_data;
+    if (has_pts) {
+        write_timestamp(p + 9, has_dts ? 0x03 : 0x02, static_cast<uint64_t>(pts));
+    }
+    if (has_dts) {
+        write_timestamp(p + 14, 0x01, static_cast<uint64_t>(dts));
+    }
+    return 9 + header_data;
+}
+
+} // namespace Ps
+
+/************************************PsFrame***********************************/
+std::size_t PsFrame::Flatten(uint8_t* dst, std::size_t cap) const noexcept {
+    if (cap < size) {
+        return 0;
+    }
+    std::size_t off = 0;
+    for (const iovec& seg : segments) {
+        std::memcpy(dst + off, seg.iov_base, seg.iov_len);
+        off += seg.iov_len;
+    }
+    return off;
+}
+
+/************************************PsDemuxer***********************************/
+PsDemuxer::PsDemuxer() {
+    codecs_.fill(PsCodec::Unknown);
+}
+
+void PsDemuxer::Reset() {
+    codecs_.fill(PsCodec::Unknown);
+    frame_count_ = 0;
+    skipped_ = 0;
+}
+
+bool PsDemuxer::Input(const uint8_t* data, std::size_t size) {
+    frame_count_ = 0;
+    bool found = false;
+    std::size_t pos = 0;
+    while (pos + 4 <= size) {
+        const uint8_t* p = data + pos;
+        if (p[0] != 0 || p[1] != 0 || p[2] != 1) {
+            std::size_t next = find_start_code(data, pos + 1, size);
+            skipped_ += next - pos;
+            pos = next;
+            continue;
+        }
+        const uint8_t id = p[3];
+        const std::size_t avail = size - pos;
+        std::size_t used = 0;
+        if (id == PS_PACK_START_CODE) {
+            if (avail < 12) {
+                break;
+            }
+            if ((p[4] & 0xC0) == 0x40) {
+                // MPEG-2
+                used = avail >= PS_PACK_HEADER_SIZE ? PS_PACK_HEADER_SIZE + (p[13] & 0x07) : 0;
+            } else if ((p[4] & 0xF0) == 0x20) {
+                // MPEG-1
+                used = 12;
+            } else {
+                used = 4;
+            }
+        } else if (id == PS_END_CODE) {
+            used = 4;
+        } else if (id == PS_MAP_CODE) {
+            used = parse_psm(p, avail);
+        } else if (is_pes_stream(id)) {
+            used = parse_pes(p, avail);
+        } else if (id > PS_END_CODE) {
+            // system头、padding、private_stream_2等按长度跳过
+            if (avail >= 6) {
+                used = 6 + ((static_cast<std::size_t>(p[4]) << 8) | p[5]);
+            }
+        } else {
+            // 不是PS层的起始码（如不定长PES里的NALU），重新同步
+            std::size_t next = find_start_code(data, pos + 3, size);
+            skipped_ += next - pos;
+            pos = next;
+            continue;
+        }
+        if (used == 0 || used > avail) {
+            // 末尾不完整的结构
+            break;
+        }
+        found = true;
+        pos += used;
+    }
+
+    for (std::size_t i = 0; i < frame_count_; ++i) {
+        PsFrame& f = frames_[i];
+        f.keyframe = detect_keyframe(f.codec, f);
+    }
+    return found;
+}
+
+std::size_t PsDemuxer::parse_psm(const uint8_t* p, std::size_t avail) {
+    if (avail < 6) {
+        return 0;
+    }
+    std::size_t len = 6 + ((static_cast<std::size_t>(p[4]) << 8) | p[5]);
+    if (len > avail || len < 16) {
+        return len > avail ? 0 : len;
+    }
+    std::size_t info_len = (static_cast<std::size_t>(p[8]) << 8) | p[9];
+    std::size_t pos = 10 + info_len;
+    if (pos + 2 > len - 4) {
+        return len;
+    }
+    std::size_t map_len = (static_cast<std::size_t>(p[pos]) << 8) | p[pos + 1];
+    pos += 2;
+    std::size_t end = std::min(pos + map_len, len - 4);
+    while (pos + 4 <= end) {
+        uint8_t type = p[pos];
+        uint8_t es_id = p[pos + 1];
+        std::size_t es_info_len = (static_cast<std::size_t>(p[pos + 2]) << 8) | p[pos + 3];
+        codecs_[es_id] = Ps::CodecFromStreamType(type);
+        pos += 4 + es_info_len;
+    }
+    return len;
+}
+
+std::size_t PsDemuxer::parse_pes(const uint8_t* p, std::size_t avail) {
+    if (avail < 9) {
+        return 0;
+    }
+    const uint8_t id = p[3];
+    std::size_t pes_len = (static_cast<std::size_t>(p[4]) << 8) | p[5];
+    std::size_t total;
+    bool truncated = false;
+    if (pes_len == 0) {
+        // 不定长PES（部分设备的视频流），延续到下一个pack头
+        total = 6;
+        while (true) {
+            std::size_t next = find_start_code(p, total, avail);
+            if (next + 4 > avail) {
+                total = avail;
+                break;
+            }
+            if (p[next + 3] == PS_PACK_START_CODE) {
+                total = next;
+                break;
+            }
+            total = next + 3;
+        }
+    } else {
+        total = 6 + pes_len;
+        if (total > avail) {
+            total = avail;
+            truncated = true;
+        }
+    }
+
+    if ((p[6] & 0xC0) != 0x80) {
+        // 非MPEG-2 PES头，GB28181不使用，整体跳过
+        return total;
+    }
+    std::size_t header_end = 9 + p[8];
+    if (header_end > total) {
+        return truncated ? 0 : total;
+    }
+    int64_t pts = -1;
+    int64_t dts = -1;
+    const uint8_t flags = p[7];
+    if ((flags & 0x80) && p[8] >= 5) {
+        pts = read_timestamp(p + 9);
+    }
+    if ((flags & 0xC0) == 0xC0 && p[8] >= 10) {
+        dts = read_timestamp(p + 14);
+    }
+    append(id, pts, dts, p + header_end, total - header_end, truncated);
+    return total;
+}
+
+void PsDemuxer::append(uint8_t stream_id, int64_t pts, int64_t dts, const uint8_t* payload, std::size_t size, bool truncated) {
+    // 同一流上不带PTS或PTS相同的PES属于前一个访问单元
+    PsFrame* open = nullptr;
+    for (std::size_t i = frame_count_; i-- > 0;) {
+        if (frames_[i].stream_id == stream_id) {
+            open = &frames_[i];
+            break;
+        }
+    }
+    if (open && (pts < 0 || pts == open->pts)) {
+        if (size > 0) {
+            open->segments.push_back({const_cast<uint8_t*>(payload), size});
+            open->size += size;
+        }
+        open->truncated |= truncated;
+        return;
+    }
+    if (size == 0) {
+        return;
+    }
+
+    if (frame_count_ == frames_.size()) {
+        frames_.emplace_back();
+    }
+    PsFrame& f = frames_[frame_count_++];
+    f.stream_id = stream_id;
+    f.codec = codecs_[stream_id];
+    f.pts = pts;
+    f.dts = dts >= 0 ? dts : pts;
+    f.segments.clear();
+    f.segments.push_back({const_cast<uint8_t*>(payload), size});
+    f.size = size;
+    f.keyframe = false;
+    f.truncated = truncated;
+}
+
+bool PsDemuxer::detect_keyframe(PsCodec codec, const PsFrame& frame) noexcept {
+    if ((codec != PsCodec::H264 && codec != PsCodec::H265) || frame.segments.empty()) {
+        return false;
+    }
+    const uint8_t* data = static_cast<const uint8_t*>(frame.segments[0].iov_base);
+    std::size_t size = std::min(frame.segments[0].iov_len, kKeyframeScanBytes);
+    std::size_t pos = find_start_code(data, 0, size);
+    while (pos + 3 < size) {
+        uint8_t header = data[pos + 3];
+        if (codec == PsCodec::H264) {
+            uint8_t type = header & 0x1F;
+            if (type == 5 || type == 7) {
+                return true;
+            }
+        } else {
+            uint8_t type = H265RtpPacketizer::NalType(&header);
+            if (H265RtpPacketizer::IsIrap(type) || type == 32 || type == 33) {
+                return true;
+            }
+        }
+        pos = find_start_code(data, pos + 3, size);
+    }
+    return false;
+}
+
+/************************************PsRtpPacketizer***********************************/
+PsRtpPacketizer::PsRtpPacketizer(const Config& cfg, PsCodec video, PsCodec audio)
+    : RtpPacketizer(cfg), video_(video), audio_(audio) {
+    const bool has_audio = audio_ != PsCodec::Unknown;
+    const std::size_t streams = has_audio ? 2 : 1;
+
+    // system头：rate_bound、audio_bound、video_bound，再逐流给出P-STD缓冲区
+    std::size_t sys_len = 6 + 3 * streams;
+    system_header_ = {0x00, 0x00, 0x01, PS_SYSTEM_HEADER_CODE,
+                      static_cast<uint8_t>(sys_len >> 8), static_cast<uint8_t>(sys_len),
+                      static_cast<uint8_t>(0x80 | ((kMuxRate >> 15) & 0x7F)),
+                      static_cast<uint8_t>(kMuxRate >> 7),
+                      static_cast<uint8_t>(((kMuxRate << 1) & 0xFE) | 0x01),
+                      static_cast<uint8_t>((has_audio ? 1 : 0) << 2),
+                      0xE1,     // audio_lock/video_lock/marker + video_bound=1
+                      0x7F};
+    // 视频缓冲 400*1024字节，音频 32*128字节
+    system_header_.insert(system_header_.end(), {kVideoStreamId, 0xE1, 0x90});
+    if (has_audio) {
+        system_header_.insert(system_header_.end(), {kAudioStreamId, 0xC0, 0x20});
+    }
+
+    std::size_t psm_len = 10 + 4 * streams;
+    psm_ = {0x00, 0x00, 0x01, PS_MAP_CODE,
+            static_cast<uint8_t>(psm_len >> 8), static_cast<uint8_t>(psm_len),
+            0xE0, 0xFF,     // current_next_indicator=1, version=0
+            0x00, 0x00,     // program_stream_info_length
+            0x00, static_cast<uint8_t>(4 * streams),
+            Ps::StreamTypeFromCodec(video_), kVideoStreamId, 0x00, 0x00};
+    if (has_audio) {
+        psm_.insert(psm_.end(), {Ps::StreamTypeFromCodec(audio_), kAudioStreamId, 0x00, 0x00});
+    }
+    uint32_t crc = crc32_mpeg(psm_.data(), psm_.size());
+    psm_.insert(psm_.end(), {static_cast<uint8_t>(crc >> 24), static_cast<uint8_t>(crc >> 16),
+                             static_cast<uint8_t>(crc >> 8), static_cast<uint8_t>(crc)});
+}
+
+std::size_t PsRtpPacketizer::PacketizeNalus(const NalUnitView* nalus, std::size_t count, uint32_t timestamp, RtpPacketBatch& out) {
+    uint8_t flags = 0;
+    bool has_vcl = false;
+    bool referenced = false;
+    for (std::size_t i = 0; i < count; ++i) {
+        if (nalus[i].size == 0) {
+            continue;
+        }
+        if (video_ == PsCodec::H265) {
+            if (nalus[i].size < 2) {
+                continue;
+            }
+            uint8_t type = H265RtpPacketizer::NalType(nalus[i].data);
+            if (H265RtpPacketizer::IsIrap(type)) {
+                flags |= RtpPacketView::kKeyframe;
+            }
+            if (type < 32) {
+                has_vcl = true;
+                referenced |= !H265RtpPacketizer::IsNonReference(type);
+            }
+        } else {
+            uint8_t type = nalus[i].data[0] & 0x1F;
+            if (type == 5) {
+                flags |= RtpPacketView::kKeyframe;
+            }
+            if (type >= 1 && type <= 5) {
+                has_vcl = true;
+                referenced |= (nalus[i].data[0] & 0x60) != 0;
+            }
+        }
+    }
+    if (has_vcl && !referenced) {
+        flags |= RtpPacketView::kDisposable;
+    }
+
+    pieces_.clear();
+    uint8_t pack[PS_PACK_HEADER_SIZE];
+    push_inline(pack, Ps::WritePackHeader(pack, timestamp, kMuxRate));
+    if (flags & RtpPacketView::kKeyframe) {
+        // GB28181约定关键帧前携带system头和PSM，接收端据此确定编码
+        push_ref(system_header_.data(), system_header_.size());
+        push_ref(psm_.data(), psm_.size());
+    }
+    push_pes(kVideoStreamId, nalus, count, true, timestamp);
+    return emit(timestamp, flags, out);
+}
+
+std::size_t PsRtpPacketizer::PacketizeAudio(const uint8_t* data, std::size_t size, uint32_t timestamp, RtpPacketBatch& out) {
+    if (audio_ == PsCodec::Unknown || size == 0) {
+        return 0;
+    }
+    pieces_.clear();
+    uint8_t pack[PS_PACK_HEADER_SIZE];
+    push_inline(pack, Ps::WritePackHeader(pack, timestamp, kMuxRate));
+    NalUnitView frame{data, size};
+    push_pes(kAudioStreamId, &frame, 1, false, timestamp);
+    return emit(timestamp, 0, out);
+}
+
+void PsRtpPacketizer::push_ref(const uint8_t* data, std::size_t size) {
+    if (size == 0) {
+        return;
+    }
+    Piece& piece = pieces_.emplace_back();
+    piece.data = data;
+    piece.size = static_cast<uint32_t>(size);
+    piece.inline_bytes = false;
+}
+
+void PsRtpPacketizer::push_inline(const uint8_t* data, std::size_t size) {
+    Piece& piece = pieces_.emplace_back();
+    std::memcpy(piece.bytes, data, size);
+    piece.data = nullptr;
+    piece.size = static_cast<uint32_t>(size);
+    piece.inline_bytes = true;
+}
+
+void PsRtpPacketizer::push_pes(uint8_t stream_id, const NalUnitView* items, std::size_t count, bool start_codes, int64_t pts) {
+    const std::size_t prefix = start_codes ? sizeof(kStartCode) : 0;
+    std::size_t remaining = 0;
+    for (std::size_t i = 0; i < count; ++i) {
+        remaining += prefix + items[i].size;
+    }
+
+    std::size_t item = 0;
+    std::size_t off = 0;    // 在当前条目（起始码+NALU）中的偏移
+    bool first = true;
+    while (remaining > 0) {
+        std::size_t chunk = std::min(remaining, kMaxPesPayload);
+        uint8_t header[PS_PES_HEADER_MAX_SIZE];
+        push_inline(header, Ps::WritePesHeader(header, stream_id, chunk, first ? pts : -1, -1));
+        first = false;
+        remaining -= chunk;
+
+        while (chunk > 0) {
+            std::size_t take;
+            if (off < prefix) {
+                take = std::min(prefix - off, chunk);
+                push_ref(kStartCode + off, take);
+            } else {
+                std::size_t nal_off = off - prefix;
+                take = std::min(items[item].size - nal_off, chunk);
+                push_ref(items[item].data + nal_off, take);
+            }
+            chunk -= take;
+            off += take;
+            if (off == prefix + items[item].size) {
+                ++item;
+                off = 0;
+            }
+        }
+    }
+}
+
+std::size_t PsRtpPacketizer::emit(uint32_t timestamp, uint8_t flags, RtpPacketBatch& out) {
+    const std::size_t first = out.packets.size();
+    std::size_t i = 0;
+    std::size_t off = 0;
+    while (i < pieces_.size()) {
+        RtpPacketView& pkt = begin_packet(out, timestamp, false, flags);
+        pkt.push_slab(0, RTP_FIXED_HEADER_SIZE);
+        std::size_t slab_pos = RTP_FIXED_HEADER_SIZE;
+        std::size_t room = max_payload();
+        // RTP包边界与PS结构无关，按字节流切分；动态头可能跨包，各自拷进所在包的slab
+        while (room > 0 && i < pieces_.size() && pkt.iov_cnt < RtpPacketView::kMaxIov) {
+            const Piece& piece = pieces_[i];
+            std::size_t take = std::min<std::size_t>(piece.size - off, room);
+            if (piece.inline_bytes) {
+                take = std::min(take, RtpPacketView::kSlabSize - slab_pos);
+                if (take == 0) {
+                    break;
+                }
+                std::memcpy(pkt.slab + slab_pos, piece.bytes + off, take);
+                pkt.push_slab(slab_pos, take);
+                slab_pos += take;
+            } else {
+                pkt.push_data(piece.data + off, take);
+            }
+            room -= take;
+            off += take;
+            if (off == piece.size) {
+                ++i;
+                off = 0;
+            }
+        }
+    }
+    if (out.packets.size() > first) {
+        out.packets[first].flags |= RtpPacketView::kFrameStart;
+        out.packets.back().slab[1] |= 0x80;
+    }
+    return out.packets.size() - first;
+}
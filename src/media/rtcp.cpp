@@ -0,0 +1,565 @@
+#include "rtcp.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+namespace {
+    constexpr uint32_t kRtpSeqMod = 1u << 16;
+    constexpr uint32_t kMaxDropout = 3000;
+    constexpr uint32_t kMaxMisorder = 100;
+    constexpr uint32_t kMinSequential = 2;
+    /// @brief 1900到1970的秒数
+    constexpr uint64_t kNtpUnixOffset = 2208988800ULL;
+    /// @brief UDP + IPv4头
+    constexpr double kUdpIpOverhead = 28;
+    /// @brief 解析NACK时每次回调最多展开的序号数
+    constexpr std::size_t kNackChunk = 256;
+
+    inline void put_u16(uint8_t* p, uint16_t v) {
+        p[0] = static_cast<uint8_t>(v >> 8);
+        p[1] = static_cast<uint8_t>(v);
+    }
+
+    inline void put_u32(uint8_t* p, uint32_t v) {
+        p[0] = static_cast<uint8_t>(v >> 24);
+        p[1] = static_cast<uint8_t>(v >> 16);
+        p[2] = static_cast<uint8_t>(v >> 8);
+        p[3] = static_cast<uint8_t>(v);
+    }
+
+    inline uint32_t get_u32(const uint8_t* p) {
+        return (static_cast<uint32_t>(p[0]) << 24) | (static_cast<uint32_t>(p[1]) << 16)
+             | (static_cast<uint32_t>(p[2]) << 8) | p[3];
+    }
+
+    inline void put_header(uint8_t* p, uint8_t count, uint8_t pt, std::size_t total) {
+        p[0] = static_cast<uint8_t>((RTCP_VERSION << 6) | (count & 0x1F));
+        p[1] = pt;
+        put_u16(p + 2, static_cast<uint16_t>(total / 4 - 1));
+    }
+
+    uint8_t* put_blocks(uint8_t* p, const RtcpReportBlock* blocks, std::size_t count) {
+        for (std::size_t i = 0; i < count; ++i) {
+            const RtcpReportBlock& b = blocks[i];
+            // 累计丢包截断到24位有符号
+            int32_t lost = std::clamp<int32_t>(b.cumulative_lost, -0x800000, 0x7FFFFF);
+            put_u32(p, b.ssrc);
+            put_u32(p + 4, (static_cast<uint32_t>(b.fraction_lost) << 24) | (static_cast<uint32_t>(lost) & 0xFFFFFF));
+            put_u32(p + 8, b.ext_highest_seq);
+            put_u32(p + 12, b.jitter);
+            put_u32(p + 16, b.lsr);
+            put_u32(p + 20, b.dlsr);
+            p += RTCP_REPORT_BLOCK_SIZE;
+        }
+        return p;
+    }
+
+    void get_blocks(const uint8_t* p, RtcpReportBlock* blocks, std::size_t count) {
+        for (std::size_t i = 0; i < count; ++i) {
+            RtcpReportBlock& b = blocks[i];
+            b.ssrc = get_u32(p);
+            uint32_t w = get_u32(p + 4);
+            b.fraction_lost = static_cast<uint8_t>(w >> 24);
+            // 24位符号扩展
+            b.cumulative_lost = static_cast<int32_t>(w << 8) >> 8;
+            b.ext_highest_seq = get_u32(p + 8);
+            b.jitter = get_u32(p + 12);
+            b.lsr = get_u32(p + 16);
+            b.dlsr = get_u32(p + 20);
+            p += RTCP_REPORT_BLOCK_SIZE;
+        }
+    }
+}
+
+/************************************NtpTime***********************************/
+NtpTime NtpTime::Now() {
+    auto us = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+    NtpTime t;
+    t.sec = static_cast<uint32_t>(us / 1000000 + kNtpUnixOffset);
+    t.frac = static_cast<uint32_t>((static_cast<uint64_t>(us % 1000000) << 32) / 1000000);
+    return t;
+}
+
+/************************************RtpReceiveStats***********************************/
+RtpReceiveStats::RtpReceiveStats(uint32_t ssrc, uint32_t clock_rate)
+    : ssrc_(ssrc), clock_rate_(clock_rate ? clock_rate : 90000) {
+
+}
+
+void RtpReceiveStats::init_seq(uint16_t seq) {
+    base_seq_ = seq;
+    max_seq_ = seq;
+    bad_seq_ = kRtpSeqMod + 1;
+    cycles_ = 0;
+    received_ = 0;
+    received_prior_ = 0;
+    expected_prior_ = 0;
+}
+
+bool RtpReceiveStats::Update(uint16_t seq, uint32_t rtp_ts, int64_t arrival_ms) {
+    if (!initialized_) {
+        // 第一个包，进入试用期
+        init_seq(seq);
+        max_seq_ = static_cast<uint16_t>(seq - 1);
+        probation_ = kMinSequential;
+        initialized_ = true;
+    }
+    last_rtp_ms_ = arrival_ms;
+
+    uint16_t udelta = static_cast<uint16_t>(seq - max_seq_);
+    if (probation_) {
+        // 连续kMinSequential个包后才认为源有效
+        if (seq == static_cast<uint16_t>(max_seq_ + 1)) {
+            --probation_;
+            max_seq_ = seq;
+            if (probation_ == 0) {
+                init_seq(seq);
+            } else {
+                return false;
+            }
+        } else {
+            probation_ = kMinSequential - 1;
+            max_seq_ = seq;
+            return false;
+        }
+    } else if (udelta < kMaxDropout) {
+        if (seq < max_seq_) {
+            cycles_ += kRtpSeqMod;
+        }
+        max_seq_ = seq;
+    } else if (udelta <= kRtpSeqMod - kMaxMisorder) {
+        // 大跳变，连续两个包确认后视为发送端重启
+        if (seq == bad_seq_) {
+            init_seq(seq);
+        } else {
+            bad_seq_ = (static_cast<uint32_t>(seq) + 1) & (kRtpSeqMod - 1);
+            return false;
+        }
+    }
+    // 其余情况为重复或乱序包，照常计数
+    ++received_;
+
+    // A.8 到达抖动
+    int32_t arrival = static_cast<int32_t>(static_cast<uint32_t>(arrival_ms * clock_rate_ / 1000));
+    int32_t transit = static_cast<int32_t>(static_cast<uint32_t>(arrival) - rtp_ts);
+    if (transit_valid_) {
+        int32_t d = transit - transit_;
+        if (d < 0) {
+            d = -d;
+        }
+        jitter_ += static_cast<uint32_t>(d) - ((jitter_ + 8) >> 4);
+    }
+    transit_ = transit;
+    transit_valid_ = true;
+    return true;
+}
+
+void RtpReceiveStats::OnSenderReport(const NtpTime& ntp, int64_t now_ms) {
+    lsr_ = ntp.middle();
+    lsr_recv_ms_ = now_ms;
+}
+
+void RtpReceiveStats::FillReportBlock(RtcpReportBlock& block, int64_t now_ms) {
+    uint32_t exp = expected();
+    int64_t lost_total = lost();
+    uint32_t expected_interval = exp - expected_prior_;
+    uint32_t received_interval = received_ - received_prior_;
+    int64_t lost_interval = static_cast<int64_t>(expected_interval) - received_interval;
+    expected_prior_ = exp;
+    received_prior_ = received_;
+
+    block.ssrc = ssrc_;
+    block.fraction_lost = (expected_interval == 0 || lost_interval <= 0)
+        ? 0 : static_cast<uint8_t>((lost_interval << 8) / expected_interval);
+    block.cumulative_lost = static_cast<int32_t>(std::clamp<int64_t>(lost_total, -0x800000, 0x7FFFFF));
+    block.ext_highest_seq = ext_highest_seq();
+    block.jitter = jitter();
+    block.lsr = lsr_;
+    // DLSR单位1/65536秒
+    block.dlsr = lsr_ ? static_cast<uint32_t>((now_ms - lsr_recv_ms_) * 65536 / 1000) : 0;
+}
+
+/************************************Rtcp***********************************/
+namespace Rtcp {
+
+std::size_t WriteSenderReport(std::span<uint8_t> buf, uint32_t ssrc, const RtcpSenderInfo& info,
+                              const RtcpReportBlock* blocks, std::size_t count) {
+    count = std::min<std::size_t>(count, RTCP_MAX_REPORT_BLOCKS);
+    std::size_t total = RTCP_HEADER_SIZE + 4 + RTCP_SENDER_INFO_SIZE + count * RTCP_REPORT_BLOCK_SIZE;
+    if (buf.size() < total) {
+        return 0;
+    }
+    uint8_t* p = buf.data();
+    put_header(p, static_cast<uint8_t>(count), RTCP_PACKET_TYPE_SR, total);
+    put_u32(p + 4, ssrc);
+    put_u32(p + 8, info.ntp.sec);
+    put_u32(p + 12, info.ntp.frac);
+    put_u32(p + 16, info.rtp_ts);
+    put_u32(p + 20, info.packet_count);
+    put_u32(p + 24, info.octet_count);
+    put_blocks(p + 28, blocks, count);
+    return total;
+}
+
+std::size_t WriteReceiverReport(std::span<uint8_t> buf, uint32_t ssrc,
+                                const RtcpReportBlock* blocks, std::size_t count) {
+    count = std::min<std::size_t>(count, RTCP_MAX_REPORT_BLOCKS);
+    std::size_t total = RTCP_HEADER_SIZE + 4 + count * RTCP_REPORT_BLOCK_SIZE;
+    if (buf.size() < total) {
+        return 0;
+    }
+    uint8_t* p = buf.data();
+    put_header(p, static_cast<uint8_t>(count), RTCP_PACKET_TYPE_RR, total);
+    put_u32(p + 4, ssrc);
+    put_blocks(p + 8, blocks, count);
+    return total;
+}
+
+std::size_t WriteBye(std::span<uint8_t> buf, uint32_t ssrc) {
+    if (buf.size() < 8) {
+        return 0;
+    }
+    put_header(buf.data(), 1, RTCP_PACKET_TYPE_BYE, 8);
+    put_u32(buf.data() + 4, ssrc);
+    return 8;
+}
+
+std::size_t WriteNack(std::span<uint8_t> buf, uint32_t sender_ssrc, uint32_t media_ssrc,
+                      const uint16_t* seqs, std::size_t count) {
+    // 先算FCI个数，确定总长
+    std::size_t fci = 0;
+    for (std::size_t i = 0; i < count;) {
+        uint16_t pid = seqs[i++];
+        while (i < count && static_cast<uint16_t>(seqs[i] - pid) >= 1 && static_cast<uint16_t>(seqs[i] - pid) <= 16) {
+            ++i;
+        }
+        ++fci;
+    }
+    std::size_t total = RTCP_HEADER_SIZE + 8 + 4 * fci;
+    if (fci == 0 || buf.size() < total || total / 4 - 1 > 0xFFFF) {
+        return 0;
+    }
+    uint8_t* p = buf.data();
+    put_header(p, RTCP_FMT_NACK, RTCP_PACKET_TYPE_RTPFB, total);
+    put_u32(p + 4, sender_ssrc);
+    put_u32(p + 8, media_ssrc);
+    uint8_t* f = p + 12;
+    for (std::size_t i = 0; i < count;) {
+        uint16_t pid = seqs[i++];
+        uint16_t blp = 0;
+        while (i < count) {
+            uint16_t diff = static_cast<uint16_t>(seqs[i] - pid);
+            if (diff < 1 || diff > 16) {
+                break;
+            }
+            blp |= static_cast<uint16_t>(1u << (diff - 1));
+            ++i;
+        }
+        put_u16(f, pid);
+        put_u16(f + 2, blp);
+        f += 4;
+    }
+    return total;
+}
+
+bool ParseCompound(const uint8_t* data, std::size_t size, RtcpHandler& handler) {
+    if (!data || size < RTCP_HEADER_SIZE || size % 4 != 0) {
+        return false;
+    }
+    // 复合包第一个必须是SR/RR，且不能带padding；RFC 5506精简RTCP允许单独发送反馈包
+    if ((data[0] & 0xE0) != (RTCP_VERSION << 6)) {
+        return false;
+    }
+    if (data[1] != RTCP_PACKET_TYPE_SR && data[1] != RTCP_PACKET_TYPE_RR
+        && data[1] != RTCP_PACKET_TYPE_RTPFB && data[1] != RTCP_PACKET_TYPE_PSFB) {
+        return false;
+    }
+
+    RtcpReportBlock blocks[RTCP_MAX_REPORT_BLOCKS];
+    uint32_t ssrcs[RTCP_MAX_REPORT_BLOCKS];
+    std::size_t pos = 0;
+    while (pos < size) {
+        if (size - pos < RTCP_HEADER_SIZE) {
+            return false;
+        }
+        const uint8_t* p = data + pos;
+        if ((p[0] >> 6) != RTCP_VERSION) {
+            return false;
+        }
+        std::size_t len = (static_cast<std::size_t>((p[2] << 8) | p[3]) + 1) * 4;
+        if (len > size - pos) {
+            return false;
+        }
+        // 只有最后一个包允许padding
+        if ((p[0] & 0x20) && pos + len != size) {
+            return false;
+        }
+        std::size_t body = len;
+        if (p[0] & 0x20) {
+            uint8_t pad = p[len - 1];
+            if (pad == 0 || pad > len - RTCP_HEADER_SIZE) {
+                return false;
+            }
+            body -= pad;
+        }
+
+        uint8_t count = p[0] & 0x1F;
+        uint8_t pt = p[1];
+        if (pt == RTCP_PACKET_TYPE_SR) {
+            std::size_t need = RTCP_HEADER_SIZE + 4 + RTCP_SENDER_INFO_SIZE + count * RTCP_REPORT_BLOCK_SIZE;
+            if (body < need) {
+                return false;
+            }
+            RtcpSenderInfo info;
+            info.ntp.sec = get_u32(p + 8);
+            info.ntp.frac = get_u32(p + 12);
+            info.rtp_ts = get_u32(p + 16);
+            info.packet_count = get_u32(p + 20);
+            info.octet_count = get_u32(p + 24);
+            get_blocks(p + 28, blocks, count);
+            handler.OnSenderReport(get_u32(p + 4), info, blocks, count);
+        } else if (pt == RTCP_PACKET_TYPE_RR) {
+            std::size_t need = RTCP_HEADER_SIZE + 4 + count * RTCP_REPORT_BLOCK_SIZE;
+            if (body < need) {
+                return false;
+            }
+            get_blocks(p + 8, blocks, count);
+            handler.OnReceiverReport(get_u32(p + 4), blocks, count);
+        } else if (pt == RTCP_PACKET_TYPE_BYE) {
+            if (body < RTCP_HEADER_SIZE + 4u * count) {
+                return false;
+            }
+            for (uint8_t i = 0; i < count; ++i) {
+                ssrcs[i] = get_u32(p + 4 + 4 * i);
+            }
+            handler.OnBye(ssrcs, count);
+        } else if (pt == RTCP_PACKET_TYPE_RTPFB && count == RTCP_FMT_NACK) {
+            // 公共反馈头：发送方SSRC + 媒体源SSRC，之后每4字节一个PID/BLP
+            if (body < RTCP_HEADER_SIZE + 8) {
+                return false;
+            }
+            uint32_t sender = get_u32(p + 4);
+            uint32_t media = get_u32(p + 8);
+            uint16_t seqs[kNackChunk];
+            std::size_t n = 0;
+            for (std::size_t off = RTCP_HEADER_SIZE + 8; off + 4 <= body; off += 4) {
+                if (n + 17 > kNackChunk) {
+                    handler.OnNack(sender, media, seqs, n);
+                    n = 0;
+                }
+                uint16_t pid = static_cast<uint16_t>((p[off] << 8) | p[off + 1]);
+                uint16_t blp = static_cast<uint16_t>((p[off + 2] << 8) | p[off + 3]);
+                seqs[n++] = pid;
+                for (int bit = 0; bit < 16; ++bit) {
+                    if (blp & (1u << bit)) {
+                        seqs[n++] = static_cast<uint16_t>(pid + bit + 1);
+                    }
+                }
+            }
+            if (n > 0) {
+                handler.OnNack(sender, media, seqs, n);
+            }
+        } else {
+            handler.OnPacket(pt, p, body);
+        }
+        pos += len;
+    }
+    return true;
+}
+
+double ComputeInterval(int members, int senders, double rtcp_bw, bool we_sent,
+                       double avg_rtcp_size, bool initial, double min_interval, std::minstd_rand& rng) {
+    // 发送方占RTCP带宽的25%
+    const double kSenderFraction = 0.25;
+    const double kReceiverFraction = 1 - kSenderFraction;
+    // 补偿随机化带来的"定时器重算"偏差，e - 3/2
+    const double kCompensation = 2.71828 - 1.5;
+
+    double t_min = initial ? min_interval / 2 : min_interval;
+    int n = members;
+    if (senders <= members * kSenderFraction) {
+        if (we_sent) {
+            rtcp_bw *= kSenderFraction;
+            n = senders;
+        } else {
+            rtcp_bw *= kReceiverFraction;
+            n -= senders;
+        }
+    }
+    n = std::max(n, 1);
+    double t = rtcp_bw > 0 ? avg_rtcp_size * n / rtcp_bw : t_min;
+    t = std::max(t, t_min);
+
+    std::uniform_real_distribution<double> dist(0.5, 1.5);
+    return t * dist(rng) / kCompensation;
+}
+
+} // namespace Rtcp
+
+/************************************RtcpSession***********************************/
+RtcpSession::RtcpSession(const Config& cfg)
+    : cfg_(cfg), rng_(cfg.ssrc ^ static_cast<uint32_t>(std::chrono::steady_clock::now().time_since_epoch().count())) {
+    if (!cfg_.cname.empty()) {
+        sdes_.AddItem(cfg_.ssrc, RTCP_SdesItemType::RTCP_SDES_CNAME, cfg_.cname);
+    }
+}
+
+void RtcpSession::OnRtpSent(std::size_t payload_size, uint32_t rtp_ts, int64_t now_ms) {
+    ++packet_count_;
+    octet_count_ += static_cast<uint32_t>(payload_size);
+    last_rtp_ts_ = rtp_ts;
+    last_sent_ms_ = now_ms;
+}
+
+bool RtcpSession::OnRtpReceived(const RtpHeaderView& hdr, int64_t now_ms) {
+    auto it = sources_.find(hdr.ssrc);
+    if (it == sources_.end()) {
+        it = sources_.emplace(hdr.ssrc, RtpReceiveStats(hdr.ssrc, cfg_.clock_rate)).first;
+    }
+    return it->second.Update(hdr.seq, hdr.timestamp, now_ms);
+}
+
+bool RtcpSession::OnRtcpReceived(const uint8_t* data, std::size_t size, int64_t now_ms) {
+    now_ms_ = now_ms;
+    bool ok = Rtcp::ParseCompound(data, size, *this);
+    // 平均RTCP包大小，含UDP/IP头
+    avg_rtcp_size_ += (size + kUdpIpOverhead - avg_rtcp_size_) / 16.0;
+    return ok;
+}
+
+bool RtcpSession::ReportDue(int64_t now_ms) {
+    if (next_report_ms_ < 0) {
+        schedule(now_ms);
+        return false;
+    }
+    return now_ms >= next_report_ms_;
+}
+
+std::size_t RtcpSession::BuildReport(std::span<uint8_t> buf, int64_t now_ms) {
+    RtcpReportBlock blocks[RTCP_MAX_REPORT_BLOCKS];
+    std::size_t count = 0;
+    std::size_t active = 0;
+    for (auto& kv : sources_) {
+        active += kv.second.active() ? 1 : 0;
+    }
+    // 一个报告放不下所有活跃源时轮转起点，否则排在后面的源永远得不到报告块
+    std::size_t start = active > RTCP_MAX_REPORT_BLOCKS ? report_start_ % active : 0;
+    // 第一轮跳过前start个活跃源；填过报告块的源不再活跃，第二轮从头补齐剩下的
+    for (int pass = 0; pass < 2 && count < RTCP_MAX_REPORT_BLOCKS; ++pass) {
+        std::size_t skip = pass == 0 ? start : 0;
+        for (auto& [ssrc, stats] : sources_) {
+            if (count == RTCP_MAX_REPORT_BLOCKS) {
+                break;
+            }
+            if (!stats.active()) {
+                continue;
+            }
+            if (skip > 0) {
+                --skip;
+                continue;
+            }
+            stats.FillReportBlock(blocks[count++], now_ms);
+        }
+    }
+    report_start_ = start + count;
+
+    std::size_t n = 0;
+    if (we_sent(now_ms)) {
+        RtcpSenderInfo info;
+        info.ntp = NtpTime::Now();
+        // 把最后一个包的RTP时间戳外推到当前时刻
+        info.rtp_ts = last_rtp_ts_ + static_cast<uint32_t>((now_ms - last_sent_ms_) * cfg_.clock_rate / 1000);
+        info.packet_count = packet_count_;
+        info.octet_count = octet_count_;
+        n = Rtcp::WriteSenderReport(buf, cfg_.ssrc, info, blocks, count);
+    } else {
+        n = Rtcp::WriteReceiverReport(buf, cfg_.ssrc, blocks, count);
+    }
+    if (n > 0 && sdes_.chunk_count() > 0) {
+        std::size_t m = sdes_.PackInto(buf.subspan(n));
+        n = m > 0 ? n + m : 0;
+    }
+    if (n > 0) {
+        avg_rtcp_size_ += (n + kUdpIpOverhead - avg_rtcp_size_) / 16.0;
+        initial_ = false;
+        last_report_ms_ = now_ms;
+        schedule(now_ms);
+    }
+    return n;
+}
+
+const RtpReceiveStats* RtcpSession::source(uint32_t ssrc) const {
+    auto it = sources_.find(ssrc);
+    return it == sources_.end() ? nullptr : &it->second;
+}
+
+void RtcpSession::OnSenderReport(uint32_t ssrc, const RtcpSenderInfo& info, const RtcpReportBlock* blocks, std::size_t count) {
+    auto it = sources_.find(ssrc);
+    if (it == sources_.end()) {
+        it = sources_.emplace(ssrc, RtpReceiveStats(ssrc, cfg_.clock_rate)).first;
+    }
+    it->second.OnSenderReport(info.ntp, now_ms_);
+    on_report_blocks(blocks, count);
+}
+
+void RtcpSession::OnReceiverReport(uint32_t /*ssrc*/, const RtcpReportBlock* blocks, std::size_t count) {
+    on_report_blocks(blocks, count);
+}
+
+void RtcpSession::OnBye(const uint32_t* ssrcs, std::size_t count) {
+    for (std::size_t i = 0; i < count; ++i) {
+        sources_.erase(ssrcs[i]);
+    }
+}
+
+void RtcpSession::OnNack(uint32_t /*sender_ssrc*/, uint32_t media_ssrc, const uint16_t* seqs, std::size_t count) {
+    if (media_ssrc == cfg_.ssrc && nack_handler_) {
+        nack_handler_(seqs, count);
+    }
+}
+
+void RtcpSession::on_report_blocks(const RtcpReportBlock* blocks, std::size_t count) {
+    for (std::size_t i = 0; i < count; ++i) {
+        const RtcpReportBlock& b = blocks[i];
+        if (b.ssrc != cfg_.ssrc) {
+            continue;
+        }
+        remote_.valid = true;
+        remote_.fraction_lost = b.fraction_lost;
+        remote_.cumulative_lost = b.cumulative_lost;
+        remote_.jitter = b.jitter;
+        remote_.received_ms = now_ms_;
+        if (b.lsr != 0) {
+            // RTT = A - LSR - DLSR，单位1/65536秒
+            uint32_t a = NtpTime::Now().middle();
+            int32_t rtt = static_cast<int32_t>(a - b.lsr - b.dlsr);
+            remote_.rtt_ms = rtt > 0 ? rtt * 1000.0 / 65536.0 : 0;
+        }
+    }
+}
+
+void RtcpSession::schedule(int64_t now_ms) {
+    int members = static_cast<int>(sources_.size()) + 1;
+    bool sending = we_sent(now_ms);
+    int senders = sending ? 1 : 0;
+    int64_t window = static_cast<int64_t>(cfg_.min_interval * 2000);
+    for (auto& [ssrc, stats] : sources_) {
+        if (stats.received() > 0 && now_ms - stats.last_rtp_ms() <= window) {
+            ++senders;
+        }
+    }
+    double rtcp_bw = cfg_.session_bandwidth / 8 * 0.05;
+    double interval = Rtcp::ComputeInterval(members, senders, rtcp_bw, sending, avg_rtcp_size_,
+                                            initial_, cfg_.min_interval, rng_);
+    next_report_ms_ = now_ms + static_cast<int64_t>(interval * 1000);
+}
+
+bool RtcpSession::we_sent(int64_t now_ms) const noexcept {
+    // RFC 3550: 最近两个报告间隔内发过RTP包即为发送方
+    if (last_sent_ms_ < 0) {
+        return false;
+    }
+    int64_t window = static_cast<int64_t>(cfg_.min_interval * 2000);
+    return now_ms - last_sent_ms_ <= window;
+}
@@ -1,31 +1,111 @@
 #include "rtp.h"
 #include <stdexcept>
 #include <algorithm>
-std::vector<uint8_t> RTCPSdes::Pack() const {
-    std::vector<uint8_t> buf;
-    uint8_t chunks_size = static_cast<uint8_t>(chunks_.size());
-    //头部, v=2, p=0, rc
-    buf.push_back((2 << 6) | (0 << 5) | (chunks_size & 0x1F));  
-    buf.push_back(RTCP_PACKET_TYPE_SDES);
-    buf.push_back(0);buf.push_back(0);  //占位
-    
-    for(auto& chunk : chunks_) {
-        writeU32(buf, chunk.ssrc);
-        for(auto& item : chunk.items) {
-            buf.push_back(static_cast<uint8_t>(item.type));
-            buf.push_back(static_cast<uint8_t>(item.data.size()));
-            buf.insert(buf.end(), item.data.begin(), item.data.end());
+
+/************************************RTCP_SdesChunk***********************************/
+bool RTCP_SdesChunk::Set(RTCP_SdesItemType type, std::string_view value) {
+    if (type == RTCP_SdesItemType::RTCP_SDES_END || value.size() > 255) {
+        return false;
+    }
+    // 先算替换后的空间，避免删掉旧值后新值放不下
+    size_t old_len = 0;
+    std::string_view old = Get(type);
+    if (old.data()) {
+        old_len = 2 + old.size();
+    }
+    if (used - old_len + 2 + value.size() > kMaxItemBytes) {
+        return false;
+    }
+    Remove(type);
+    items[used] = static_cast<uint8_t>(type);
+    items[used + 1] = static_cast<uint8_t>(value.size());
+    std::memcpy(items + used + 2, value.data(), value.size());
+    used += static_cast<uint16_t>(2 + value.size());
+    return true;
+}
+
+void RTCP_SdesChunk::Remove(RTCP_SdesItemType type) {
+    size_t pos = 0;
+    while (pos + 2 <= used) {
+        size_t len = 2 + items[pos + 1];
+        if (items[pos] == static_cast<uint8_t>(type)) {
+            std::memmove(items + pos, items + pos + len, used - pos - len);
+            used -= static_cast<uint16_t>(len);
+            return;
+        }
+        pos += len;
+    }
+}
+
+std::string_view RTCP_SdesChunk::Get(RTCP_SdesItemType type) const {
+    size_t pos = 0;
+    while (pos + 2 <= used) {
+        if (items[pos] == static_cast<uint8_t>(type)) {
+            return std::string_view(reinterpret_cast<const char*>(items + pos + 2), items[pos + 1]);
         }
-        buf.push_back(0);  //结束,插入一个type为0的条目
-        while(buf.size() % 4 != 0) {
-            buf.push_back(0);
+        pos += 2 + items[pos + 1];
+    }
+    return {};
+}
+
+bool RTCP_SdesChunk::At(size_t index, RTCP_SdesItem& item) const {
+    size_t pos = 0;
+    while (pos + 2 <= used) {
+        if (index == 0) {
+            item.type = static_cast<RTCP_SdesItemType>(items[pos]);
+            item.value = std::string_view(reinterpret_cast<const char*>(items + pos + 2), items[pos + 1]);
+            return true;
         }
+        --index;
+        pos += 2 + items[pos + 1];
+    }
+    return false;
+}
+
+/************************************RTCPSdes***********************************/
+size_t RTCPSdes::PackInto(std::span<uint8_t> buf) const {
+    if (count_ == 0) {
+        return 0;
+    }
+    size_t total = 4;
+    for (size_t i = 0; i < count_; ++i) {
+        total += chunks_[i].wire_size();
     }
+    if (buf.size() < total) {
+        return 0;
+    }
+
+    uint8_t* p = buf.data();
+    //头部, v=2, p=0, sc
+    p[0] = static_cast<uint8_t>((RTCP_VERSION << 6) | (count_ & 0x1F));
+    p[1] = RTCP_PACKET_TYPE_SDES;
+    uint16_t length_words = static_cast<uint16_t>(total / 4 - 1); //减去头部
+    p[2] = static_cast<uint8_t>(length_words >> 8);
+    p[3] = static_cast<uint8_t>(length_words);
+    p += 4;
+
+    for (size_t i = 0; i < count_; ++i) {
+        const RTCP_SdesChunk& chunk = chunks_[i];
+        p[0] = static_cast<uint8_t>(chunk.ssrc >> 24);
+        p[1] = static_cast<uint8_t>(chunk.ssrc >> 16);
+        p[2] = static_cast<uint8_t>(chunk.ssrc >> 8);
+        p[3] = static_cast<uint8_t>(chunk.ssrc);
+        std::memcpy(p + 4, chunk.items, chunk.used);
+        //结束项及对齐填充都为0
+        size_t size = chunk.wire_size();
+        std::memset(p + 4 + chunk.used, 0, size - 4 - chunk.used);
+        p += size;
+    }
+    return total;
+}
 
-    //更新长度字段
-    uint16_t length_words = (buf.size() / 4) - 1; //减去头部
-    buf[2] = (length_words >> 8) & 0xFF;
-    buf[3] = length_words & 0xFF;
+std::vector<uint8_t> RTCPSdes::Pack() const {
+    size_t total = 4;
+    for (size_t i = 0; i < count_; ++i) {
+        total += chunks_[i].wire_size();
+    }
+    std::vector<uint8_t> buf(total);
+    buf.resize(PackInto(buf));
     return buf;
 }
 
@@ -33,7 +113,7 @@ void RTCPSdes::Parse(const uint8_t* data, size_t size) {
     if(size < 4) {
         throw std::runtime_error("Invalid SDES packet size");
     }
-    chunks_.clear();
+    count_ = 0;
 
     uint8_t v = data[0] >> 6;
     if(v != 2) {
@@ -57,9 +137,14 @@ void RTCPSdes::Parse(const uint8_t* data, size_t size) {
         uint32_t ssrc = readU32(p);
         p += 4;
 
-        RTCP_SdesChunk chunk{ssrc, {}};
+        // 超出容量的chunk只校验不保存
+        RTCP_SdesChunk* chunk = count_ < kMaxChunks ? &chunks_[count_++] : nullptr;
+        if (chunk) {
+            chunk->ssrc = ssrc;
+            chunk->used = 0;
+        }
         while(true) {
-            if(p > data + size) {
+            if(p >= data + size) {
                 throw std::runtime_error("Invalid SDES packet Truncated");
             }
             uint8_t type = *p++;
@@ -78,25 +163,21 @@ void RTCPSdes::Parse(const uint8_t* data, size_t size) {
             if(p + len > data + size) {
                 throw std::runtime_error("Invalid SDES packet Truncated");
             }
-            chunk.items.push_back({static_cast<RTCP_SdesItemType>(type), std::vector<uint8_t>(p, p + len)});
+            if (chunk) {
+                chunk->Set(static_cast<RTCP_SdesItemType>(type),
+                           std::string_view(reinterpret_cast<const char*>(p), len));
+            }
             p += len;
         }
-        //存到chunks_中
-        chunks_.push_back(chunk);
     }
 }
-void RTCPSdes::AddItem(uint32_t ssrc, RTCP_SdesItemType type, const std::string& value){
-    auto& chunk = findOrCreateChunk(ssrc);
-    // 查找是否已存在相同类型的项
-    auto it = std::find_if(chunk.items.begin(), chunk.items.end(), [&](const RTCP_SdesItem& item){
-        return item.type == type;
-    });
-    // 如果已存在，更新数据
-    if(it != chunk.items.end()) {
-        it->data.assign(value.begin(), value.end());
-    } else {
-        chunk.items.push_back({type, std::vector<uint8_t>(value.begin(), value.end())});
+
+bool RTCPSdes::AddItem(uint32_t ssrc, RTCP_SdesItemType type, std::string_view value){
+    auto* chunk = findOrCreateChunk(ssrc);
+    if (!chunk) {
+        return false;
     }
+    return chunk->Set(type, value);
 }
 
 void RTCPSdes::RemoveItem(uint32_t ssrc, RTCP_SdesItemType type) {
@@ -104,49 +185,46 @@ void RTCPSdes::RemoveItem(uint32_t ssrc, RTCP_SdesItemType type) {
     if(!chunk) {
         return;
     }
-    // 查找并删除指定类型的项
-    chunk->items.erase(std::remove_if(
-        chunk->items.begin(), 
-        chunk->items.end(), 
-        [&](const RTCP_SdesItem& item){
-            return item.type == type;
-        }),
-        chunk->items.end()
-    );
+    chunk->Remove(type);
 }
-void RTCPSdes::writeU32(std::vector<uint8_t>& buf, uint32_t val) {
-    buf.push_back((val >> 24) & 0xFF);
-    buf.push_back((val >> 16) & 0xFF);
-    buf.push_back((val >> 8) & 0xFF);
-    buf.push_back(val & 0xFF);
+
+std::string_view RTCPSdes::GetItem(uint32_t ssrc, RTCP_SdesItemType type) const {
+    const RTCP_SdesChunk* chunk = findChunk(ssrc);
+    return chunk ? chunk->Get(type) : std::string_view{};
 }
 
 uint32_t RTCPSdes::readU32(const uint8_t* p) {
-    return static_cast<uint32_t>(p[0] << 24) | (p[1] << 16) | (p[2] << 8) | p[3];   
+    return (static_cast<uint32_t>(p[0]) << 24) | (static_cast<uint32_t>(p[1]) << 16)
+         | (static_cast<uint32_t>(p[2]) << 8) | p[3];
 }
 
-RTCP_SdesChunk& RTCPSdes::findOrCreateChunk(uint32_t ssrc) {
+RTCP_SdesChunk* RTCPSdes::findOrCreateChunk(uint32_t ssrc) {
     auto* chunk = findChunk(ssrc);
     if(!chunk) {
-        chunks_.push_back({ssrc, {}});
-        return chunks_.back();
+        if (count_ == kMaxChunks) {
+            return nullptr;
+        }
+        chunk = &chunks_[count_++];
+        chunk->ssrc = ssrc;
+        chunk->used = 0;
     }
-    return *chunk;
+    return chunk;
 }
+
 RTCP_SdesChunk* RTCPSdes::findChunk(uint32_t ssrc) {
-    for (auto& c : chunks_) { 
-        if (c.ssrc == ssrc) {
-            return &c; 
-        } 
-        return nullptr;
+    for (size_t i = 0; i < count_; ++i) {
+        if (chunks_[i].ssrc == ssrc) {
+            return &chunks_[i];
+        }
     }
+    return nullptr;
 }
+
 const RTCP_SdesChunk* RTCPSdes::findChunk(uint32_t ssrc) const {
-    for (auto& c : chunks_) { 
-        if (c.ssrc == ssrc) {
-            return &c; 
-        } 
-        return nullptr;
+    for (size_t i = 0; i < count_; ++i) {
+        if (chunks_[i].ssrc == ssrc) {
+            return &chunks_[i];
+        }
     }
+    return nullptr;
 }
-
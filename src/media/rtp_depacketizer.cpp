@@ -0,0 +1,262 @@
+#include "rtp_depacketizer.h"
+#include <cstring>
+
+namespace {
+    const uint8_t kStartCode[4] = {0, 0, 0, 1};
+}
+
+/************************************AccessUnitView***********************************/
+void AccessUnitView::clear() noexcept {
+    segments.clear();
+    timestamp = 0;
+    size = 0;
+    keyframe = false;
+    complete = false;
+    corrupted = false;
+    arena_used_ = 0;
+    spill_count_ = 0;
+    spill_used_ = 0;
+}
+
+uint8_t* AccessUnitView::spill(std::size_t n) {
+    if (n > kArenaSize) {
+        return nullptr;
+    }
+    if (spill_count_ == 0 || spill_used_ + n > kArenaSize) {
+        if (spill_count_ == spill_blocks_.size()) {
+            spill_blocks_.push_back(std::make_unique<uint8_t[]>(kArenaSize));
+        }
+        ++spill_count_;
+        spill_used_ = 0;
+    }
+    uint8_t* p = spill_blocks_[spill_count_ - 1].get() + spill_used_;
+    spill_used_ += n;
+    return p;
+}
+
+std::size_t AccessUnitView::Flatten(uint8_t* dst, std::size_t cap) const noexcept {
+    if (cap < size) {
+        return 0;
+    }
+    std::size_t off = 0;
+    for (auto& seg : segments) {
+        std::memcpy(dst + off, seg.iov_base, seg.iov_len);
+        off += seg.iov_len;
+    }
+    return off;
+}
+
+/************************************RtpDepacketizer***********************************/
+void RtpDepacketizer::MarkLoss() noexcept {
+    au_.corrupted = true;
+    in_fu_ = false;
+}
+
+void RtpDepacketizer::Reset() noexcept {
+    au_.clear();
+    in_fu_ = false;
+}
+
+bool RtpDepacketizer::begin(uint32_t timestamp) {
+    // 空帧上的corrupted来自MarkLoss，保留给新帧（无法确定丢的包属于哪一帧）
+    bool started = au_.size > 0;
+    if (au_.complete) {
+        if (timestamp == au_.timestamp) {
+            // marker之后同时间戳的包（重复/乱序残留），忽略
+            return false;
+        }
+        // 上一帧未被消费，视为丢弃
+        ++dropped_;
+        Reset();
+    } else if (started && timestamp != au_.timestamp) {
+        // 丢了marker包，上一帧不完整
+        ++dropped_;
+        Reset();
+    }
+    au_.timestamp = timestamp;
+    return true;
+}
+
+void RtpDepacketizer::push_nal(const uint8_t* nal, std::size_t size) {
+    au_.push(kStartCode, sizeof(kStartCode));
+    au_.push(nal, size);
+}
+
+void RtpDepacketizer::finish(bool marker) noexcept {
+    if (marker) {
+        au_.complete = true;
+        if (in_fu_) {
+            // 分片没有收到结束位
+            au_.corrupted = true;
+            in_fu_ = false;
+        }
+    }
+}
+
+/************************************H264RtpDepacketizer***********************************/
+bool H264RtpDepacketizer::Push(const uint8_t* payload, std::size_t size, uint32_t timestamp, bool marker) {
+    if (!begin(timestamp)) {
+        return true;
+    }
+    if (!payload || size < 1) {
+        au_.corrupted = true;
+        finish(marker);
+        return false;
+    }
+
+    bool ok = true;
+    const uint8_t type = payload[0] & 0x1F;
+    if (type >= 1 && type <= 23) {
+        if (type == 5) {
+            au_.keyframe = true;
+        }
+        push_nal(payload, size);
+    } else if (type == 24) {
+        // STAP-A: 1字节头 + [size(2) + NALU]...
+        std::size_t pos = 1;
+        while (pos + 2 <= size) {
+            std::size_t len = (static_cast<std::size_t>(payload[pos]) << 8) | payload[pos + 1];
+            pos += 2;
+            if (len == 0 || len > size - pos) {
+                ok = false;
+                break;
+            }
+            if ((payload[pos] & 0x1F) == 5) {
+                au_.keyframe = true;
+            }
+            push_nal(payload + pos, len);
+            pos += len;
+        }
+        if (pos != size) {
+            ok = false;
+        }
+    } else if (type == 28) {
+        // FU-A: FU indicator(1) + FU header(1) + 分片
+        if (size < 3) {
+            ok = false;
+        } else {
+            const uint8_t fu = payload[1];
+            if (fu & 0x80) {
+                uint8_t* hdr = au_.alloc(1);
+                if (!hdr) {
+                    ok = false;
+                } else {
+                    if (in_fu_) {
+                        au_.corrupted = true;
+                    }
+                    hdr[0] = static_cast<uint8_t>((payload[0] & 0xE0) | (fu & 0x1F));
+                    if ((fu & 0x1F) == 5) {
+                        au_.keyframe = true;
+                    }
+                    au_.push(kStartCode, sizeof(kStartCode));
+                    au_.push(hdr, 1);
+                    au_.push(payload + 2, size - 2);
+                    in_fu_ = true;
+                }
+            } else if (in_fu_) {
+                au_.push(payload + 2, size - 2);
+            } else {
+                au_.corrupted = true;
+            }
+            if (ok && (fu & 0x40)) {
+                in_fu_ = false;
+            }
+        }
+    } else {
+        // STAP-B/MTAP/FU-B需要DON，不支持
+        ok = false;
+    }
+
+    if (!ok) {
+        au_.corrupted = true;
+        in_fu_ = false;
+    }
+    finish(marker);
+    return ok;
+}
+
+/************************************H265RtpDepacketizer***********************************/
+bool H265RtpDepacketizer::Push(const uint8_t* payload, std::size_t size, uint32_t timestamp, bool marker) {
+    if (!begin(timestamp)) {
+        return true;
+    }
+    if (!payload || size < 2) {
+        au_.corrupted = true;
+        finish(marker);
+        return false;
+    }
+
+    bool ok = true;
+    const uint8_t type = (payload[0] >> 1) & 0x3F;
+    auto on_nal_type = [this](uint8_t t) {
+        if (t >= 16 && t <= 23) {
+            au_.keyframe = true;
+        }
+    };
+
+    if (type < 48) {
+        on_nal_type(type);
+        push_nal(payload, size);
+    } else if (type == 48) {
+        // AP: PayloadHdr(2) + [size(2) + NALU]...
+        std::size_t pos = 2;
+        while (pos + 2 <= size) {
+            std::size_t len = (static_cast<std::size_t>(payload[pos]) << 8) | payload[pos + 1];
+            pos += 2;
+            if (len < 2 || len > size - pos) {
+                ok = false;
+                break;
+            }
+            on_nal_type((payload[pos] >> 1) & 0x3F);
+            push_nal(payload + pos, len);
+            pos += len;
+        }
+        if (pos != size) {
+            ok = false;
+        }
+    } else if (type == 49) {
+        // FU: PayloadHdr(2) + FU header(1) + 分片
+        if (size < 4) {
+            ok = false;
+        } else {
+            const uint8_t fu = payload[2];
+            const uint8_t fu_type = fu & 0x3F;
+            if (fu & 0x80) {
+                uint8_t* hdr = au_.alloc(2);
+                if (!hdr) {
+                    ok = false;
+                } else {
+                    if (in_fu_) {
+                        // 上一个分片NALU缺结束位
+                        au_.corrupted = true;
+                    }
+                    hdr[0] = static_cast<uint8_t>((payload[0] & 0x81) | (fu_type << 1));
+                    hdr[1] = payload[1];
+                    on_nal_type(fu_type);
+                    au_.push(kStartCode, sizeof(kStartCode));
+                    au_.push(hdr, 2);
+                    au_.push(payload + 3, size - 3);
+                    in_fu_ = true;
+                }
+            } else if (in_fu_) {
+                au_.push(payload + 3, size - 3);
+            } else {
+                // 丢了起始分片，后续分片无法使用
+                au_.corrupted = true;
+            }
+            if (ok && (fu & 0x40)) {
+                in_fu_ = false;
+            }
+        }
+    } else {
+        // PACI(50)及保留类型不支持
+        ok = false;
+    }
+
+    if (!ok) {
+        au_.corrupted = true;
+        in_fu_ = false;
+    }
+    finish(marker);
+    return ok;
+}
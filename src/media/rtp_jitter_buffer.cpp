@@ -0,0 +1,209 @@
+#include "rtp_jitter_buffer.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <utility>
+
+namespace {
+    /// @brief 允许的最大乱序距离，超过视为序号回退（RFC 3550 MAX_MISORDER）
+    constexpr int kMaxMisorder = 100;
+}
+
+RtpJitterBuffer::RtpJitterBuffer(const Config& cfg, std::unique_ptr<RtpDepacketizer> depacketizer)
+    : cfg_(cfg), depacketizer_(std::move(depacketizer)) {
+    // 容量取整到2的幂，序号直接按掩码映射槽位
+    std::size_t cap = 16;
+    while (cap < cfg_.capacity && cap < 32768) {
+        cap <<= 1;
+    }
+    cfg_.capacity = cap;
+    mask_ = cap - 1;
+    if (cfg_.slot_size < RTP_FIXED_HEADER_SIZE) {
+        cfg_.slot_size = 1500;
+    }
+    // 多一块作为收包的空闲缓冲区
+    pool_.resize((cap + 1) * cfg_.slot_size);
+    slots_.resize(cap);
+    for (std::size_t i = 0; i < cap; ++i) {
+        slots_[i].buf = static_cast<uint32_t>(i);
+    }
+    spare_ = static_cast<uint32_t>(cap);
+    stats_.target_delay_ms = cfg_.min_delay_ms;
+}
+
+RtpJitterBuffer::InsertResult RtpJitterBuffer::Insert(const uint8_t* data, std::size_t len, int64_t now_ms) {
+    if (!data || len > cfg_.slot_size) {
+        return InsertResult::Invalid;
+    }
+    std::memcpy(buffer(spare_), data, len);
+    return Commit(len, now_ms);
+}
+
+RtpJitterBuffer::InsertResult RtpJitterBuffer::Commit(std::size_t len, int64_t now_ms) {
+    RtpHeaderView hdr;
+    if (len > cfg_.slot_size || !hdr.Parse(buffer(spare_), len)) {
+        return InsertResult::Invalid;
+    }
+
+    InsertResult result = InsertResult::Ok;
+    if (!started_) {
+        ssrc_ = hdr.ssrc;
+        restart(hdr.seq);
+    } else if (hdr.ssrc != ssrc_) {
+        // 摄像机重启等导致SSRC变化
+        ssrc_ = hdr.ssrc;
+        ++stats_.resets;
+        restart(hdr.seq);
+        result = InsertResult::Reset;
+    } else {
+        int diff = static_cast<int16_t>(static_cast<uint16_t>(hdr.seq - head_));
+        if (diff < 0 && !consumed_ && diff >= -kMaxMisorder
+            && static_cast<uint16_t>(highest_ - hdr.seq) < cfg_.capacity) {
+            // 尚未出过包时，起始阶段的乱序包前移起点
+            head_ = hdr.seq;
+            release_ = hdr.seq;
+        } else if (diff < 0) {
+            if (diff >= -kMaxMisorder) {
+                ++stats_.late;
+                return InsertResult::Late;
+            }
+            // 大幅回退，连续两个包确认后才认为发送端重新开始
+            if (!bad_seq_valid_ || hdr.seq != bad_seq_) {
+                bad_seq_ = static_cast<uint16_t>(hdr.seq + 1);
+                bad_seq_valid_ = true;
+                ++stats_.late;
+                return InsertResult::Late;
+            }
+            ++stats_.resets;
+            restart(hdr.seq);
+            result = InsertResult::Reset;
+        } else if (static_cast<uint16_t>(hdr.seq - release_) >= cfg_.capacity) {
+            // 超出窗口，之前未到的包全部判丢
+            for (uint16_t s = head_; s != hdr.seq; ++s) {
+                if (!(slot(s).present && slot(s).seq == s)) {
+                    ++stats_.lost;
+                }
+            }
+            ++stats_.resets;
+            restart(hdr.seq);
+            result = InsertResult::Reset;
+        }
+    }
+    bad_seq_valid_ = false;
+
+    Slot& s = slot(hdr.seq);
+    if (s.present && s.seq == hdr.seq) {
+        ++stats_.duplicate;
+        return InsertResult::Duplicate;
+    }
+    s.payload_off = static_cast<uint32_t>(hdr.payload - buffer(spare_));
+    s.payload_len = static_cast<uint32_t>(hdr.payload_size);
+    // 写满的缓冲区换入槽位，槽位原来的空缓冲区作为下一次收包缓冲区
+    std::swap(s.buf, spare_);
+    s.seq = hdr.seq;
+    s.timestamp = hdr.timestamp;
+    s.marker = hdr.marker;
+    s.arrival_ms = now_ms;
+    s.present = true;
+
+    if (RtpSeqBefore(hdr.seq, highest_)) {
+        ++stats_.reordered;
+    } else {
+        highest_ = hdr.seq;
+    }
+    ++stats_.received;
+    update_jitter(hdr.timestamp, now_ms);
+    return result;
+}
+
+AccessUnitView* RtpJitterBuffer::Pop(int64_t now_ms) {
+    release();
+    if (!started_) {
+        return nullptr;
+    }
+
+    // 起始阶段无法判断第一个包之前是否还有乱序包，先等一个目标延迟
+    if (!consumed_ && slot(head_).present && now_ms - slot(head_).arrival_ms < stats_.target_delay_ms) {
+        return nullptr;
+    }
+
+    while (!RtpSeqBefore(highest_, head_)) {
+        Slot& s = slot(head_);
+        if (s.present && s.seq == head_) {
+            depacketizer_->Push(buffer(s.buf) + s.payload_off, s.payload_len, s.timestamp, s.marker);
+            ++head_;
+            consumed_ = true;
+            if (depacketizer_->ready()) {
+                AccessUnitView& au = depacketizer_->access_unit();
+                ++stats_.frames;
+                if (au.corrupted) {
+                    ++stats_.corrupted_frames;
+                }
+                return &au;
+            }
+            continue;
+        }
+
+        // 空洞：以空洞后第一个已到达包的到达时间为起点等待
+        uint16_t next = static_cast<uint16_t>(head_ + 1);
+        while (!(slot(next).present && slot(next).seq == next)) {
+            ++next;
+        }
+        bool overflow = static_cast<uint16_t>(highest_ - release_) >= cfg_.capacity / 2;
+        if (!overflow && now_ms - slot(next).arrival_ms < stats_.target_delay_ms) {
+            return nullptr;
+        }
+        stats_.lost += static_cast<uint16_t>(next - head_);
+        consumed_ = true;
+        depacketizer_->MarkLoss();
+        head_ = next;
+    }
+    return nullptr;
+}
+
+void RtpJitterBuffer::restart(uint16_t seq) {
+    depacketizer_->Reset();
+    for (auto& s : slots_) {
+        s.present = false;
+    }
+    head_ = seq;
+    release_ = seq;
+    highest_ = seq;
+    bad_seq_valid_ = false;
+    jitter_init_ = false;
+    consumed_ = false;
+    started_ = true;
+}
+
+void RtpJitterBuffer::release() {
+    AccessUnitView& au = depacketizer_->access_unit();
+    if (au.complete) {
+        depacketizer_->Reset();
+    }
+    // 解包器里还有未完成的帧时，其引用的槽位不能释放
+    if (au.size > 0) {
+        return;
+    }
+    while (release_ != head_) {
+        slot(release_).present = false;
+        ++release_;
+    }
+}
+
+void RtpJitterBuffer::update_jitter(uint32_t timestamp, int64_t now_ms) {
+    int64_t arrival = now_ms * cfg_.clock_rate / 1000;
+    int64_t transit = static_cast<int32_t>(static_cast<uint32_t>(arrival) - timestamp);
+    if (!jitter_init_) {
+        last_transit_ = transit;
+        jitter_init_ = true;
+        return;
+    }
+    int64_t d = static_cast<int32_t>(static_cast<uint32_t>(transit - last_transit_));
+    last_transit_ = transit;
+    jitter_ += (std::fabs(static_cast<double>(d)) - jitter_) / 16.0;
+
+    stats_.jitter_ms = jitter_ * 1000.0 / cfg_.clock_rate;
+    double target = cfg_.jitter_factor * stats_.jitter_ms;
+    stats_.target_delay_ms = static_cast<uint32_t>(std::clamp(target,
+        static_cast<double>(cfg_.min_delay_ms), static_cast<double>(cfg_.max_delay_ms)));
+}
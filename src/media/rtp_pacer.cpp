@@ -0,0 +1,273 @@
+#include "rtp_pacer.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <sys/prctl.h>
+
+/************************************PacedRtpStream***********************************/
+PacedRtpStream::PacedRtpStream(RtpPacer& pacer, std::size_t capacity, SendFn send)
+    : pacer_(pacer), send_(std::move(send)), packets_(capacity), keepalive_(capacity) {
+
+}
+
+bool PacedRtpStream::Enqueue(const RtpPacketBatch& batch, std::shared_ptr<const void> keepalive) {
+    const std::size_t n = batch.size();
+    if (n == 0) {
+        return true;
+    }
+    std::lock_guard<std::mutex> lock(mtx_);
+    if (closed_) {
+        return false;
+    }
+    if (n > packets_.size()) {
+        stats_.dropped += n;
+        return false;
+    }
+    if (free_slots() < n) {
+        if (batch.packets[0].flags & RtpPacketView::kDisposable) {
+            stats_.dropped += n;
+            return false;
+        }
+        while (free_slots() < n) {
+            drop_front_frame();
+        }
+    }
+
+    std::size_t tail = head_ + count_;
+    for (const RtpPacketView& p : batch.packets) {
+        if (tail >= packets_.size()) {
+            tail -= packets_.size();
+        }
+        packets_[tail] = p;
+        keepalive_[tail] = keepalive;
+        queued_bytes_ += p.size;
+        ++tail;
+    }
+    count_ += n;
+    stats_.enqueued += n;
+
+    // 按积压重算速率，让积压（通常就是这一帧）在窗口内发完
+    const RtpPacer::Config& cfg = pacer_.config();
+    double min_rate = cfg.min_rate_bps / 8.0 / 1e6;
+    rate_ = std::max(min_rate, static_cast<double>(queued_bytes_) / (cfg.window_ms * 1000.0));
+
+    if (!scheduled_) {
+        scheduled_ = true;
+        pacer_.activate(this);
+    }
+    return true;
+}
+
+void PacedRtpStream::Close() {
+    std::lock_guard<std::mutex> lock(mtx_);
+    closed_ = true;
+    while (count_ > 0) {
+        pop_front();
+    }
+}
+
+PacedRtpStream::Stats PacedRtpStream::stats() const {
+    std::lock_guard<std::mutex> lock(mtx_);
+    Stats s = stats_;
+    s.queued_packets = count_;
+    s.queued_bytes = queued_bytes_;
+    return s;
+}
+
+void PacedRtpStream::pop_front() noexcept {
+    queued_bytes_ -= packets_[head_].size;
+    keepalive_[head_].reset();
+    if (++head_ == packets_.size()) {
+        head_ = 0;
+    }
+    --count_;
+}
+
+void PacedRtpStream::drop_front_frame() noexcept {
+    if (count_ == 0) {
+        return;
+    }
+    pop_front();
+    ++stats_.dropped;
+    while (count_ > 0 && !(packets_[head_].flags & RtpPacketView::kFrameStart)) {
+        pop_front();
+        ++stats_.dropped;
+    }
+}
+
+int64_t PacedRtpStream::service(int64_t now_us) {
+    std::lock_guard<std::mutex> lock(mtx_);
+    if (closed_ || count_ == 0) {
+        scheduled_ = false;
+        return -1;
+    }
+
+    const RtpPacer::Config& cfg = pacer_.config();
+    // 桶深至少容纳两个tick的量，否则调度粒度会压低实际速率
+    double depth = std::max(static_cast<double>(cfg.burst_bytes), rate_ * 2 * cfg.tick_us);
+    if (last_refill_us_ < 0) {
+        tokens_ = depth;
+    } else {
+        tokens_ = std::min(depth, tokens_ + rate_ * static_cast<double>(now_us - last_refill_us_));
+    }
+    last_refill_us_ = now_us;
+
+    while (count_ > 0 && tokens_ > 0) {
+        // 只取环形队列中连续的一段，绕回的部分下一轮再发
+        std::size_t limit = std::min({count_, cfg.max_batch, packets_.size() - head_});
+        std::size_t n = 0;
+        double budget = tokens_;
+        while (n < limit && budget > 0) {
+            budget -= static_cast<double>(packets_[head_ + n].size);
+            ++n;
+        }
+
+        int sent = send_(&packets_[head_], n);
+        if (sent < 0) {
+            // 发送出错（如目的不可达），丢弃这一段，避免反复重试同一批包
+            for (std::size_t i = 0; i < n; ++i) {
+                pop_front();
+            }
+            stats_.dropped += n;
+            break;
+        }
+        for (int i = 0; i < sent; ++i) {
+            tokens_ -= static_cast<double>(packets_[head_].size);
+            pop_front();
+        }
+        stats_.sent += static_cast<uint64_t>(sent);
+        if (static_cast<std::size_t>(sent) < n) {
+            // 发送缓冲区满
+            return now_us + cfg.retry_us;
+        }
+    }
+
+    if (count_ == 0) {
+        scheduled_ = false;
+        return -1;
+    }
+    // 令牌透支，等到补回正值
+    double wait = tokens_ > 0 ? 1.0 : (1.0 - tokens_) / rate_;
+    return now_us + static_cast<int64_t>(std::ceil(wait));
+}
+
+/************************************RtpPacer***********************************/
+RtpPacer::RtpPacer() : RtpPacer(Config{}) {
+
+}
+
+RtpPacer::RtpPacer(const Config& cfg) : cfg_(cfg) {
+    if (cfg_.window_ms <= 0) {
+        cfg_.window_ms = 1;
+    }
+    if (cfg_.tick_us <= 0) {
+        cfg_.tick_us = 1;
+    }
+    if (cfg_.max_batch == 0) {
+        cfg_.max_batch = 1;
+    }
+    if (cfg_.queue_capacity == 0) {
+        cfg_.queue_capacity = 1;
+    }
+}
+
+RtpPacer::~RtpPacer() {
+    Stop();
+}
+
+void RtpPacer::Start() {
+    std::lock_guard<std::mutex> lock(mtx_);
+    if (running_) {
+        return;
+    }
+    running_ = true;
+    thread_ = std::thread(&RtpPacer::run, this);
+}
+
+void RtpPacer::Stop() {
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        if (!running_) {
+            return;
+        }
+        running_ = false;
+    }
+    cv_.notify_all();
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+}
+
+std::shared_ptr<PacedRtpStream> RtpPacer::AddStream(PacedRtpStream::SendFn send, std::size_t capacity) {
+    return std::make_shared<PacedRtpStream>(*this, capacity ? capacity : cfg_.queue_capacity, std::move(send));
+}
+
+void RtpPacer::activate(PacedRtpStream* stream) {
+    active_.fetch_add(1, std::memory_order_relaxed);
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        pending_.push_back(stream->shared_from_this());
+    }
+    cv_.notify_one();
+}
+
+int64_t RtpPacer::Poll(int64_t now_us) {
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        pending_swap_.swap(pending_);
+    }
+    for (auto& stream : pending_swap_) {
+        heap_.push_back({now_us, std::move(stream)});
+        std::push_heap(heap_.begin(), heap_.end(), TimerLater{});
+    }
+    pending_swap_.clear();
+
+    // 一个tick内到期的流合并在这次处理，减少唤醒次数
+    const int64_t horizon = now_us + cfg_.tick_us;
+    while (!heap_.empty() && heap_.front().due_us <= horizon) {
+        std::pop_heap(heap_.begin(), heap_.end(), TimerLater{});
+        Timer timer = std::move(heap_.back());
+        heap_.pop_back();
+
+        int64_t next = timer.stream->service(now_us);
+        if (next < 0) {
+            active_.fetch_sub(1, std::memory_order_relaxed);
+            continue;
+        }
+        // 本轮已按now补过令牌，再次到期至少推迟到下一个tick，避免同一时刻空转
+        timer.due_us = std::max(next, horizon + 1);
+        heap_.push_back(std::move(timer));
+        std::push_heap(heap_.begin(), heap_.end(), TimerLater{});
+    }
+    return heap_.empty() ? -1 : heap_.front().due_us;
+}
+
+int64_t RtpPacer::NowUs() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void RtpPacer::run() {
+    // 默认50us的timer slack会让定时唤醒整体偏晚，发送线程需要微秒级精度
+    ::prctl(PR_SET_TIMERSLACK, 1UL, 0, 0, 0);
+
+    auto wake = [this] { return !running_ || !pending_.empty(); };
+    while (true) {
+        int64_t next = Poll(NowUs());
+
+        std::unique_lock<std::mutex> lock(mtx_);
+        if (!running_) {
+            break;
+        }
+        if (next < 0) {
+            cv_.wait(lock, wake);
+        } else {
+            auto deadline = std::chrono::steady_clock::time_point(std::chrono::microseconds(next));
+            cv_.wait_until(lock, deadline, wake);
+        }
+        if (!running_) {
+            break;
+        }
+    }
+    // 调度堆保留，重新Start后继续发送
+}
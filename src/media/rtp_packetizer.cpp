@@ -0,0 +1,396 @@
+#include "rtp_packetizer.h"
+#include <algorithm>
+#include <cstring>
+
+/************************************NaluHelper***********************************/
+namespace NaluHelper {
+
+void SplitAnnexB(const uint8_t* data, std::size_t size, std::vector<NalUnitView>& out) {
+    if (!data || size < 3) {
+        return;
+    }
+    const uint8_t* end = data + size;
+    const uint8_t* nal_start = nullptr;
+    const uint8_t* p = data;
+    while (p + 3 <= end) {
+        // 跳过不可能构成起始码的位置
+        if (p[2] > 1) {
+            p += 3;
+            continue;
+        }
+        if (p[0] == 0 && p[1] == 0 && p[2] == 1) {
+            if (nal_start) {
+                // 去掉4字节起始码多出的前导0
+                const uint8_t* nal_end = p;
+                while (nal_end > nal_start && nal_end[-1] == 0) {
+                    --nal_end;
+                }
+                if (nal_end > nal_start) {
+                    out.push_back({nal_start, static_cast<std::size_t>(nal_end - nal_start)});
+                }
+            }
+            p += 3;
+            nal_start = p;
+            continue;
+        }
+        ++p;
+    }
+    if (nal_start && nal_start < end) {
+        out.push_back({nal_start, static_cast<std::size_t>(end - nal_start)});
+    } else if (!nal_start) {
+        // 没有起始码，整个缓冲区视为一个NALU
+        out.push_back({data, size});
+    }
+}
+
+bool SplitLengthPrefixed(const uint8_t* data, std::size_t size, int length_size, std::vector<NalUnitView>& out) {
+    if (length_size != 1 && length_size != 2 && length_size != 4) {
+        return false;
+    }
+    std::size_t pos = 0;
+    while (pos + length_size <= size) {
+        std::size_t len = 0;
+        for (int i = 0; i < length_size; ++i) {
+            len = (len << 8) | data[pos + i];
+        }
+        pos += length_size;
+        if (len > size - pos) {
+            return false;
+        }
+        if (len > 0) {
+            out.push_back({data + pos, len});
+        }
+        pos += len;
+    }
+    return pos == size;
+}
+
+} // namespace NaluHelper
+
+/************************************RtpPacketView***********************************/
+void RtpPacketView::copy_from(const RtpPacketView& other) noexcept {
+    std::memcpy(slab, other.slab, kSlabSize);
+    iov_cnt = other.iov_cnt;
+    flags = other.flags;
+    seq = other.seq;
+    timestamp = other.timestamp;
+    size = other.size;
+    const uint8_t* other_begin = other.slab;
+    const uint8_t* other_end = other.slab + kSlabSize;
+    for (uint8_t i = 0; i < iov_cnt; ++i) {
+        auto* base = static_cast<const uint8_t*>(other.iov[i].iov_base);
+        if (base >= other_begin && base < other_end) {
+            // 指向对方slab的段重定位到自己的slab
+            iov[i].iov_base = slab + (base - other_begin);
+        } else {
+            iov[i].iov_base = other.iov[i].iov_base;
+        }
+        iov[i].iov_len = other.iov[i].iov_len;
+    }
+}
+
+std::size_t RtpPacketView::Flatten(uint8_t* dst, std::size_t cap) const noexcept {
+    if (cap < size) {
+        return 0;
+    }
+    std::size_t off = 0;
+    for (uint8_t i = 0; i < iov_cnt; ++i) {
+        std::memcpy(dst + off, iov[i].iov_base, iov[i].iov_len);
+        off += iov[i].iov_len;
+    }
+    return off;
+}
+
+std::size_t RtpPacketBatch::bytes() const noexcept {
+    std::size_t total = 0;
+    for (auto& p : packets) {
+        total += p.size;
+    }
+    return total;
+}
+
+/************************************RtpPacketizer***********************************/
+RtpPacketizer::RtpPacketizer(const Config& cfg) : cfg_(cfg), seq_(cfg.initial_seq) {
+    // 至少要能容纳RTP头 + FU头 + 1字节负载
+    if (cfg_.mtu < RTP_FIXED_HEADER_SIZE + 4) {
+        cfg_.mtu = RTP_FIXED_HEADER_SIZE + 4;
+    }
+    nalus_.reserve(16);
+}
+
+std::size_t RtpPacketizer::PacketizeAnnexB(const uint8_t* data, std::size_t size, uint32_t timestamp, RtpPacketBatch& out) {
+    nalus_.clear();
+    NaluHelper::SplitAnnexB(data, size, nalus_);
+    return PacketizeNalus(nalus_.data(), nalus_.size(), timestamp, out);
+}
+
+RtpPacketView& RtpPacketizer::begin_packet(RtpPacketBatch& out, uint32_t timestamp, bool marker, uint8_t flags) {
+    out.packets.emplace_back();
+    RtpPacketView& pkt = out.packets.back();
+    pkt.iov_cnt = 0;
+    pkt.size = 0;
+    pkt.flags = flags;
+    pkt.seq = seq_;
+    pkt.timestamp = timestamp;
+    WriteRtpHeader(pkt.slab, cfg_.payload_type, marker, seq_, timestamp, cfg_.ssrc);
+    ++seq_;
+    return pkt;
+}
+
+/************************************H264RtpPacketizer***********************************/
+H264RtpPacketizer::H264RtpPacketizer(const Config& cfg) : RtpPacketizer(cfg) {
+
+}
+
+std::size_t H264RtpPacketizer::PacketizeNalus(const NalUnitView* nalus, std::size_t count, uint32_t timestamp, RtpPacketBatch& out) {
+    // 统计整个访问单元的属性：含IDR为关键帧，所有VCL的nal_ref_idc为0则可丢弃
+    uint8_t flags = 0;
+    bool has_vcl = false;
+    bool referenced = false;
+    for (std::size_t i = 0; i < count; ++i) {
+        if (nalus[i].size == 0) {
+            continue;
+        }
+        uint8_t type = nalus[i].data[0] & 0x1F;
+        if (type == 5) {
+            flags |= RtpPacketView::kKeyframe;
+        }
+        if (type >= 1 && type <= 5) {
+            has_vcl = true;
+            referenced |= (nalus[i].data[0] & 0x60) != 0;
+        }
+    }
+    if (has_vcl && !referenced) {
+        flags |= RtpPacketView::kDisposable;
+    }
+
+    // 最后一个非空NALU的包置marker
+    std::size_t last = count;
+    while (last > 0 && nalus[last - 1].size == 0) {
+        --last;
+    }
+
+    const std::size_t first_pkt = out.size();
+    const std::size_t max_pl = max_payload();
+    std::size_t i = 0;
+    while (i < last) {
+        const NalUnitView& nal = nalus[i];
+        if (nal.size == 0) {
+            ++i;
+            continue;
+        }
+        if (nal.size > max_pl) {
+            emit_fu_a(nal, timestamp, i + 1 == last, flags, out);
+            ++i;
+            continue;
+        }
+
+        if (cfg_.aggregate) {
+            // STAP-A: 1字节头 + 每个NALU 2字节长度
+            std::size_t j = i;
+            std::size_t total = 1;
+            while (j < last && j - i < RtpPacketView::kMaxAggregate
+                   && nalus[j].size > 0 && total + 2 + nalus[j].size <= max_pl) {
+                total += 2 + nalus[j].size;
+                ++j;
+            }
+            if (j - i >= 2) {
+                emit_stap_a(nalus + i, j - i, timestamp, j == last, flags, out);
+                i = j;
+                continue;
+            }
+        }
+        emit_single(nal, timestamp, i + 1 == last, flags, out);
+        ++i;
+    }
+
+    if (out.size() > first_pkt) {
+        out.packets[first_pkt].flags |= RtpPacketView::kFrameStart;
+    }
+    return out.size() - first_pkt;
+}
+
+void H264RtpPacketizer::emit_single(const NalUnitView& nal, uint32_t ts, bool marker, uint8_t flags, RtpPacketBatch& out) {
+    RtpPacketView& pkt = begin_packet(out, ts, marker, flags);
+    pkt.push_slab(0, RTP_FIXED_HEADER_SIZE);
+    pkt.push_data(nal.data, nal.size);
+}
+
+void H264RtpPacketizer::emit_stap_a(const NalUnitView* nalus, std::size_t count, uint32_t ts, bool marker, uint8_t flags, RtpPacketBatch& out) {
+    RtpPacketView& pkt = begin_packet(out, ts, marker, flags);
+    // STAP-A头：F取或，NRI取最大
+    uint8_t f = 0;
+    uint8_t nri = 0;
+    for (std::size_t k = 0; k < count; ++k) {
+        f |= nalus[k].data[0] & 0x80;
+        nri = std::max<uint8_t>(nri, nalus[k].data[0] & 0x60);
+    }
+    uint8_t* s = pkt.slab;
+    s[RTP_FIXED_HEADER_SIZE] = static_cast<uint8_t>(f | nri | kStapA);
+    s[RTP_FIXED_HEADER_SIZE + 1] = static_cast<uint8_t>(nalus[0].size >> 8);
+    s[RTP_FIXED_HEADER_SIZE + 2] = static_cast<uint8_t>(nalus[0].size);
+    pkt.push_slab(0, RTP_FIXED_HEADER_SIZE + 3);
+    pkt.push_data(nalus[0].data, nalus[0].size);
+    for (std::size_t k = 1; k < count; ++k) {
+        std::size_t off = RtpPacketView::kSizeFieldOffset + 2 * (k - 1);
+        s[off] = static_cast<uint8_t>(nalus[k].size >> 8);
+        s[off + 1] = static_cast<uint8_t>(nalus[k].size);
+        pkt.push_slab(off, 2);
+        pkt.push_data(nalus[k].data, nalus[k].size);
+    }
+}
+
+void H264RtpPacketizer::emit_fu_a(const NalUnitView& nal, uint32_t ts, bool marker, uint8_t flags, RtpPacketBatch& out) {
+    const uint8_t nal_header = nal.data[0];
+    const uint8_t indicator = static_cast<uint8_t>((nal_header & 0xE0) | kFuA);
+    const uint8_t type = nal_header & 0x1F;
+    // 原NALU头不发送，由FU indicator/header重建
+    const uint8_t* payload = nal.data + 1;
+    std::size_t remaining = nal.size - 1;
+    const std::size_t chunk_max = max_payload() - 2;
+    bool first = true;
+    while (remaining > 0) {
+        std::size_t chunk = std::min(remaining, chunk_max);
+        bool last = chunk == remaining;
+        RtpPacketView& pkt = begin_packet(out, ts, marker && last, flags);
+        pkt.slab[RTP_FIXED_HEADER_SIZE] = indicator;
+        pkt.slab[RTP_FIXED_HEADER_SIZE + 1] = static_cast<uint8_t>((first ? 0x80 : 0x00) | (last ? 0x40 : 0x00) | type);
+        pkt.push_slab(0, RTP_FIXED_HEADER_SIZE + 2);
+        pkt.push_data(payload, chunk);
+        payload += chunk;
+        remaining -= chunk;
+        first = false;
+    }
+}
+
+/************************************H265RtpPacketizer***********************************/
+H265RtpPacketizer::H265RtpPacketizer(const Config& cfg) : RtpPacketizer(cfg) {
+
+}
+
+std::size_t H265RtpPacketizer::PacketizeNalus(const NalUnitView* nalus, std::size_t count, uint32_t timestamp, RtpPacketBatch& out) {
+    // 含IRAP为关键帧，所有VCL均为子层非参考图像则可丢弃
+    uint8_t flags = 0;
+    bool has_vcl = false;
+    bool referenced = false;
+    for (std::size_t i = 0; i < count; ++i) {
+        if (nalus[i].size < 2) {
+            continue;
+        }
+        uint8_t type = NalType(nalus[i].data);
+        if (IsIrap(type)) {
+            flags |= RtpPacketView::kKeyframe;
+        }
+        if (type < 32) {
+            has_vcl = true;
+            referenced |= !IsNonReference(type);
+        }
+    }
+    if (has_vcl && !referenced) {
+        flags |= RtpPacketView::kDisposable;
+    }
+
+    // H.265 NALU头为2字节，小于2字节的视为空
+    std::size_t last = count;
+    while (last > 0 && nalus[last - 1].size < 2) {
+        --last;
+    }
+
+    const std::size_t first_pkt = out.size();
+    const std::size_t max_pl = max_payload();
+    std::size_t i = 0;
+    while (i < last) {
+        const NalUnitView& nal = nalus[i];
+        if (nal.size < 2) {
+            ++i;
+            continue;
+        }
+        if (nal.size > max_pl) {
+            emit_fu(nal, timestamp, i + 1 == last, flags, out);
+            ++i;
+            continue;
+        }
+
+        if (cfg_.aggregate) {
+            // AP: 2字节PayloadHdr + 每个NALU 2字节长度
+            std::size_t j = i;
+            std::size_t total = 2;
+            while (j < last && j - i < RtpPacketView::kMaxAggregate
+                   && nalus[j].size >= 2 && total + 2 + nalus[j].size <= max_pl) {
+                total += 2 + nalus[j].size;
+                ++j;
+            }
+            if (j - i >= 2) {
+                emit_ap(nalus + i, j - i, timestamp, j == last, flags, out);
+                i = j;
+                continue;
+            }
+        }
+        emit_single(nal, timestamp, i + 1 == last, flags, out);
+        ++i;
+    }
+
+    if (out.size() > first_pkt) {
+        out.packets[first_pkt].flags |= RtpPacketView::kFrameStart;
+    }
+    return out.size() - first_pkt;
+}
+
+void H265RtpPacketizer::emit_single(const NalUnitView& nal, uint32_t ts, bool marker, uint8_t flags, RtpPacketBatch& out) {
+    RtpPacketView& pkt = begin_packet(out, ts, marker, flags);
+    pkt.push_slab(0, RTP_FIXED_HEADER_SIZE);
+    pkt.push_data(nal.data, nal.size);
+}
+
+void H265RtpPacketizer::emit_ap(const NalUnitView* nalus, std::size_t count, uint32_t ts, bool marker, uint8_t flags, RtpPacketBatch& out) {
+    RtpPacketView& pkt = begin_packet(out, ts, marker, flags);
+    // PayloadHdr: F取或，LayerId/TID取最小
+    uint8_t f = 0;
+    uint8_t layer_id = 0x3F;
+    uint8_t tid = 0x07;
+    for (std::size_t k = 0; k < count; ++k) {
+        const uint8_t* h = nalus[k].data;
+        f |= h[0] & 0x80;
+        layer_id = std::min<uint8_t>(layer_id, static_cast<uint8_t>(((h[0] & 0x01) << 5) | (h[1] >> 3)));
+        tid = std::min<uint8_t>(tid, h[1] & 0x07);
+    }
+    uint8_t* s = pkt.slab;
+    s[RTP_FIXED_HEADER_SIZE] = static_cast<uint8_t>(f | (kAp << 1) | (layer_id >> 5));
+    s[RTP_FIXED_HEADER_SIZE + 1] = static_cast<uint8_t>(((layer_id & 0x1F) << 3) | tid);
+    s[RTP_FIXED_HEADER_SIZE + 2] = static_cast<uint8_t>(nalus[0].size >> 8);
+    s[RTP_FIXED_HEADER_SIZE + 3] = static_cast<uint8_t>(nalus[0].size);
+    pkt.push_slab(0, RTP_FIXED_HEADER_SIZE + 4);
+    pkt.push_data(nalus[0].data, nalus[0].size);
+    for (std::size_t k = 1; k < count; ++k) {
+        std::size_t off = RtpPacketView::kSizeFieldOffset + 2 * (k - 1);
+        s[off] = static_cast<uint8_t>(nalus[k].size >> 8);
+        s[off + 1] = static_cast<uint8_t>(nalus[k].size);
+        pkt.push_slab(off, 2);
+        pkt.push_data(nalus[k].data, nalus[k].size);
+    }
+}
+
+void H265RtpPacketizer::emit_fu(const NalUnitView& nal, uint32_t ts, bool marker, uint8_t flags, RtpPacketBatch& out) {
+    const uint8_t type = NalType(nal.data);
+    // PayloadHdr沿用原NALU头，仅把Type替换为49
+    const uint8_t hdr0 = static_cast<uint8_t>((nal.data[0] & 0x81) | (kFu << 1));
+    const uint8_t hdr1 = nal.data[1];
+    // 原2字节NALU头不发送，由PayloadHdr与FU header重建
+    const uint8_t* payload = nal.data + 2;
+    std::size_t remaining = nal.size - 2;
+    const std::size_t chunk_max = max_payload() - 3;
+    bool first = true;
+    while (remaining > 0) {
+        std::size_t chunk = std::min(remaining, chunk_max);
+        bool last = chunk == remaining;
+        RtpPacketView& pkt = begin_packet(out, ts, marker && last, flags);
+        pkt.slab[RTP_FIXED_HEADER_SIZE] = hdr0;
+        pkt.slab[RTP_FIXED_HEADER_SIZE + 1] = hdr1;
+        pkt.slab[RTP_FIXED_HEADER_SIZE + 2] = static_cast<uint8_t>((first ? 0x80 : 0x00) | (last ? 0x40 : 0x00) | type);
+        pkt.push_slab(0, RTP_FIXED_HEADER_SIZE + 3);
+        pkt.push_data(payload, chunk);
+        payload += chunk;
+        remaining -= chunk;
+        first = false;
+    }
+}
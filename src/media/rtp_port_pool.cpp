@@ -0,0 +1,135 @@
+#include "rtp_port_pool.h"
+#include <chrono>
+
+/************************************Lease***********************************/
+RtpPortPool::Lease::Lease(Lease&& other) noexcept
+    : pool_(std::move(other.pool_)), index_(other.index_) {
+
+}
+
+RtpPortPool::Lease& RtpPortPool::Lease::operator=(Lease&& other) noexcept {
+    if (this != &other) {
+        Release();
+        pool_ = std::move(other.pool_);
+        index_ = other.index_;
+    }
+    return *this;
+}
+
+uint16_t RtpPortPool::Lease::port() const noexcept {
+    return pool_->entries_[index_].port;
+}
+
+net::UdpBatchSocket& RtpPortPool::Lease::rtp() const noexcept {
+    return *pool_->entries_[index_].rtp;
+}
+
+net::UdpBatchSocket* RtpPortPool::Lease::rtcp() const noexcept {
+    return pool_->entries_[index_].rtcp.get();
+}
+
+void RtpPortPool::Lease::Release() {
+    if (pool_) {
+        pool_->release(index_);
+        pool_.reset();
+    }
+}
+
+/************************************RtpPortPool***********************************/
+RtpPortPool::RtpPortPool(ASIO::IoContext& io, const Config& cfg) : cfg_(cfg) {
+    net::UdpBatchSocket::Config rtp_cfg;
+    rtp_cfg.batch = cfg_.batch;
+    rtp_cfg.datagram_size = cfg_.datagram_size;
+    rtp_cfg.recv_buffer = cfg_.recv_buffer;
+    rtp_cfg.enable_gso = false;
+    net::UdpBatchSocket::Config rtcp_cfg;
+    rtcp_cfg.batch = 4;
+    rtcp_cfg.datagram_size = 1500;
+    rtcp_cfg.enable_gso = false;
+
+    const auto address = boost::asio::ip::make_address(cfg_.ip);
+    const uint32_t step = cfg_.rtcp ? 2 : 1;
+    const uint32_t first = cfg_.rtcp ? (cfg_.port_min & ~1u) : cfg_.port_min;
+    for (uint32_t port = first; port + step - 1 < cfg_.port_max && port <= 0xFFFF; port += step) {
+        Entry entry;
+        try {
+            entry.rtp = std::make_unique<net::UdpBatchSocket>(io, ASIO::UdpEndpoint(address, static_cast<uint16_t>(port)), rtp_cfg);
+            if (cfg_.rtcp) {
+                entry.rtcp = std::make_unique<net::UdpBatchSocket>(io, ASIO::UdpEndpoint(address, static_cast<uint16_t>(port + 1)), rtcp_cfg);
+            }
+        } catch (const boost::system::system_error&) {
+            // 端口被占用，跳过这一对
+            continue;
+        }
+        entry.port = static_cast<uint16_t>(port);
+        entries_.push_back(std::move(entry));
+    }
+    // 小端口号先借出
+    free_.reserve(entries_.size());
+    for (std::size_t i = entries_.size(); i > 0; --i) {
+        free_.push_back(static_cast<uint32_t>(i - 1));
+    }
+}
+
+int64_t RtpPortPool::now_ms() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void RtpPortPool::reclaim(int64_t now) {
+    while (!quarantine_.empty() && entries_[quarantine_.front()].released_ms + cfg_.quarantine_ms <= now) {
+        free_.push_back(quarantine_.front());
+        quarantine_.pop_front();
+    }
+}
+
+RtpPortPool::Lease RtpPortPool::Acquire() {
+    uint32_t index = 0;
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        reclaim(now_ms());
+        if (free_.empty()) {
+            ++exhausted_;
+            return Lease();
+        }
+        index = free_.back();
+        free_.pop_back();
+        ++acquired_;
+    }
+    // 丢弃隔离期间（以及上一个会话残留）的数据报
+    Entry& entry = entries_[index];
+    while (entry.rtp->ReceiveBatch() > 0) {
+    }
+    if (entry.rtcp) {
+        while (entry.rtcp->ReceiveBatch() > 0) {
+        }
+    }
+    return Lease(shared_from_this(), index);
+}
+
+void RtpPortPool::release(uint32_t index) {
+    Entry& entry = entries_[index];
+    entry.rtp->StopReceive();
+    if (entry.rtcp) {
+        entry.rtcp->StopReceive();
+    }
+    std::lock_guard<std::mutex> lock(mtx_);
+    entry.released_ms = now_ms();
+    if (cfg_.quarantine_ms <= 0) {
+        free_.push_back(index);
+    } else {
+        quarantine_.push_back(index);
+    }
+}
+
+RtpPortPool::Stats RtpPortPool::stats() const {
+    std::lock_guard<std::mutex> lock(mtx_);
+    Stats s;
+    s.capacity = entries_.size();
+    s.free = free_.size();
+    s.quarantined = quarantine_.size();
+    s.leased = s.capacity - s.free - s.quarantined;
+    s.acquired = acquired_;
+    s.exhausted = exhausted_;
+    return s;
+}
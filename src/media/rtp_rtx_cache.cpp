@@ -0,0 +1,122 @@
+#include "rtp_rtx_cache.h"
+#include <algorithm>
+
+namespace {
+    /// @brief 发送码率统计窗口
+    constexpr int64_t kRateWindowMs = 500;
+    /// @brief 令牌桶深度对应的时长，允许短时间内集中补一批丢包
+    constexpr double kBurstSeconds = 0.2;
+    /// @brief 令牌桶深度下限（字节），至少能重传两个满MTU的包
+    constexpr double kMinBurstBytes = 3000;
+
+    std::size_t round_up_pow2(std::size_t n) {
+        std::size_t v = 1;
+        while (v < n) {
+            v <<= 1;
+        }
+        return v;
+    }
+}
+
+RtpRtxCache::RtpRtxCache() : RtpRtxCache(Config{}) {
+
+}
+
+RtpRtxCache::RtpRtxCache(const Config& cfg)
+    : cfg_(cfg), slots_(round_up_pow2(std::max<std::size_t>(cfg.capacity, 16))), mask_(slots_.size() - 1) {
+
+}
+
+void RtpRtxCache::Store(const RtpPacketView& packet, const std::shared_ptr<const void>& keepalive, int64_t now_ms) {
+    std::lock_guard<std::mutex> lock(mtx_);
+    Slot& slot = slots_[packet.seq & mask_];
+    slot.packet = packet;
+    slot.keepalive = keepalive;
+    slot.sent_ms = now_ms;
+    slot.resent_ms = -1;
+    slot.valid = true;
+    ++stats_.stored;
+
+    if (window_start_ms_ < 0) {
+        window_start_ms_ = now_ms;
+    }
+    window_bytes_ += packet.size;
+    int64_t elapsed = now_ms - window_start_ms_;
+    if (elapsed >= kRateWindowMs) {
+        double bps = window_bytes_ * 8.0 * 1000.0 / static_cast<double>(elapsed);
+        live_bps_ = live_bps_ == 0 ? bps : 0.7 * live_bps_ + 0.3 * bps;
+        window_bytes_ = 0;
+        window_start_ms_ = now_ms;
+    }
+}
+
+void RtpRtxCache::Store(const RtpPacketBatch& batch, const std::shared_ptr<const void>& keepalive, int64_t now_ms) {
+    for (const RtpPacketView& p : batch.packets) {
+        Store(p, keepalive, now_ms);
+    }
+}
+
+std::size_t RtpRtxCache::OnNack(const uint16_t* seqs, std::size_t count, int64_t now_ms, std::vector<RtxPacket>& out) {
+    std::lock_guard<std::mutex> lock(mtx_);
+    refill(now_ms);
+    std::size_t added = 0;
+    for (std::size_t i = 0; i < count; ++i) {
+        ++stats_.requested;
+        Slot& slot = slots_[seqs[i] & mask_];
+        if (!slot.valid || slot.packet.seq != seqs[i]) {
+            ++stats_.missing;
+            continue;
+        }
+        if (now_ms - slot.sent_ms > cfg_.max_age_ms) {
+            ++stats_.expired;
+            continue;
+        }
+        if (slot.resent_ms >= 0 && now_ms - slot.resent_ms < cfg_.min_resend_interval_ms) {
+            ++stats_.duplicate;
+            continue;
+        }
+        if (tokens_ < static_cast<double>(slot.packet.size)) {
+            ++stats_.throttled;
+            continue;
+        }
+        tokens_ -= static_cast<double>(slot.packet.size);
+        slot.resent_ms = now_ms;
+        out.push_back({slot.packet, slot.keepalive});
+        ++stats_.resent;
+        ++added;
+    }
+    return added;
+}
+
+double RtpRtxCache::budget_bps() const {
+    std::lock_guard<std::mutex> lock(mtx_);
+    return budget_locked();
+}
+
+RtpRtxCache::Stats RtpRtxCache::stats() const {
+    std::lock_guard<std::mutex> lock(mtx_);
+    return stats_;
+}
+
+void RtpRtxCache::Clear() {
+    std::lock_guard<std::mutex> lock(mtx_);
+    for (Slot& slot : slots_) {
+        slot.keepalive.reset();
+        slot.valid = false;
+    }
+}
+
+double RtpRtxCache::budget_locked() const noexcept {
+    return std::max(cfg_.min_bitrate_bps, cfg_.max_ratio * live_bps_);
+}
+
+void RtpRtxCache::refill(int64_t now_ms) noexcept {
+    double bytes_per_sec = budget_locked() / 8.0;
+    double depth = std::max(kMinBurstBytes, bytes_per_sec * kBurstSeconds);
+    if (last_refill_ms_ < 0) {
+        tokens_ = depth;
+    } else if (now_ms > last_refill_ms_) {
+        tokens_ = std::min(depth, tokens_ + bytes_per_sec * static_cast<double>(now_ms - last_refill_ms_) / 1000.0);
+    }
+    last_refill_ms_ = std::max(last_refill_ms_, now_ms);
+}
@@ -0,0 +1,787 @@
+#include "rtsp_client.h"
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <boost/uuid/detail/md5.hpp>
+
+namespace {
+    /// @brief 保活和超时检查的周期
+    constexpr int kTickMs = 1000;
+    /// @brief RTCP包上限，RR + SDES远小于此
+    constexpr std::size_t kMaxRtcpSize = 512;
+
+    uint32_t random_u32() {
+        thread_local std::mt19937 rng{std::random_device{}()};
+        return rng();
+    }
+
+    std::string md5_hex(const std::string& s) {
+        boost::uuids::detail::md5 md5;
+        md5.process_bytes(s.data(), s.size());
+        boost::uuids::detail::md5::digest_type digest;
+        md5.get_digest(digest);
+        static const char kHex[] = "0123456789abcdef";
+        std::string out(32, '0');
+        for (int i = 0; i < 16; ++i) {
+            out[2 * i] = kHex[digest[i] >> 4];
+            out[2 * i + 1] = kHex[digest[i] & 0x0F];
+        }
+        return out;
+    }
+
+    bool iequals_prefix(std::string_view s, std::string_view prefix) {
+        if (s.size() < prefix.size()) {
+            return false;
+        }
+        for (std::size_t i = 0; i < prefix.size(); ++i) {
+            if (std::tolower(static_cast<unsigned char>(s[i])) != std::tolower(static_cast<unsigned char>(prefix[i]))) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    /// @brief 在以';'分隔的参数里找"key=value"
+    bool find_param(std::string_view params, std::string_view key, std::string_view& value) {
+        while (!params.empty()) {
+            std::size_t semi = params.find(';');
+            std::string_view p = params.substr(0, semi);
+            params = semi == std::string_view::npos ? std::string_view() : params.substr(semi + 1);
+            while (!p.empty() && p.front() == ' ') {
+                p.remove_prefix(1);
+            }
+            if (p.size() > key.size() && p.substr(0, key.size()) == key && p[key.size()] == '=') {
+                value = p.substr(key.size() + 1);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    /// @brief 比较主机地址，双栈socket收到的v4映射地址按v4比较
+    bool same_host(const boost::asio::ip::address& a, const boost::asio::ip::address& b) {
+        auto unmap = [](const boost::asio::ip::address& x) -> boost::asio::ip::address {
+            if (x.is_v6() && x.to_v6().is_v4_mapped()) {
+                return boost::asio::ip::make_address_v4(boost::asio::ip::v4_mapped, x.to_v6());
+            }
+            return x;
+        };
+        return unmap(a) == unmap(b);
+    }
+
+    bool parse_pair(std::string_view v, int& a, int& b) {
+        std::size_t dash = v.find('-');
+        if (std::from_chars(v.data(), v.data() + (dash == std::string_view::npos ? v.size() : dash), a).ec != std::errc()) {
+            return false;
+        }
+        b = a + 1;
+        if (dash != std::string_view::npos) {
+            std::from_chars(v.data() + dash + 1, v.data() + v.size(), b);
+        }
+        return true;
+    }
+}
+
+RtspClient::RtspClient(ASIO::IoContext& io) : RtspClient(io, Config{}) {
+
+}
+
+RtspClient::RtspClient(ASIO::IoContext& io, const Config& cfg)
+    : cfg_(cfg), strand_(boost::asio::make_strand(io)), socket_(strand_), resolver_(strand_), timer_(strand_) {
+    rbuf_.resize(std::max<std::size_t>(cfg_.recv_buffer_size, RTSP_INTERLEAVED_HEADER_SIZE + 65535));
+}
+
+RtspClient::~RtspClient() {
+
+}
+
+bool RtspClient::Start(const std::string& url) {
+    auto auth = std::make_shared<RtspUsrAuthInfo>();
+    std::swap(authInfo_, auth);
+    if (!ParseRtspUrl(url)) {
+        std::swap(authInfo_, auth);
+        return false;
+    }
+    boost::asio::post(strand_, [self = self()]() {
+        self->close();
+        ++self->generation_;
+        self->cseq_ = 0;
+        self->auth_retried_ = false;
+        self->public_.clear();
+        self->content_base_.clear();
+        self->session_.clear();
+        self->session_timeout_s_ = 60;
+        self->retire_tracks();
+        self->setup_index_ = 0;
+        self->used_ = 0;
+        self->state_ = State::Connecting;
+        self->request_deadline_ms_ = now_ms() + self->cfg_.timeout_ms;
+        self->arm_timer();
+        self->do_resolve();
+    });
+    return true;
+}
+
+void RtspClient::Stop() {
+    boost::asio::post(strand_, [self = self()]() {
+        self->close();
+        ++self->generation_;
+        self->state_ = State::Idle;
+    });
+}
+
+RtspClient::Stats RtspClient::stats() const {
+    Stats s;
+    s.bytes = bytes_.load(std::memory_order_relaxed);
+    s.rtp_packets = rtp_packets_.load(std::memory_order_relaxed);
+    s.frames = frames_.load(std::memory_order_relaxed);
+    s.corrupted_frames = corrupted_frames_.load(std::memory_order_relaxed);
+    return s;
+}
+
+int64_t RtspClient::now_ms() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void RtspClient::do_resolve() {
+    resolver_.async_resolve(urlInfo_.ip, std::to_string(urlInfo_.port),
+        [self = self(), gen = generation_](const boost::system::error_code& ec,
+                                           boost::asio::ip::tcp::resolver::results_type results) {
+            if (gen != self->generation_) {
+                return;
+            }
+            if (ec) {
+                self->fail("resolve " + self->urlInfo_.ip + ": " + ec.message());
+                return;
+            }
+            self->do_connect(results);
+        });
+}
+
+void RtspClient::do_connect(const boost::asio::ip::tcp::resolver::results_type& endpoints) {
+    boost::asio::async_connect(socket_, endpoints,
+        [self = self(), gen = generation_](const boost::system::error_code& ec, const ASIO::TcpEndpoint&) {
+            if (gen != self->generation_) {
+                return;
+            }
+            if (ec) {
+                self->fail("connect: " + ec.message());
+                return;
+            }
+            boost::system::error_code opt_ec;
+            self->socket_.set_option(boost::asio::ip::tcp::no_delay(true), opt_ec);
+            // 请求、RTCP经同一个发送队列写出
+            self->transport_ = std::make_shared<RtspInterleavedTransport>(self->socket_);
+            self->transport_->SetErrorHandler([weak = std::weak_ptr<RtspClient>(self), gen](const boost::system::error_code& ec) {
+                if (auto client = weak.lock()) {
+                    boost::asio::post(client->strand_, [client, gen, ec]() {
+                        if (gen == client->generation_) {
+                            client->fail("write: " + ec.message());
+                        }
+                    });
+                }
+            });
+            self->state_ = State::Options;
+            self->send_request("OPTIONS", self->urlInfo_.url);
+            self->do_read();
+        });
+}
+
+void RtspClient::do_read() {
+    socket_.async_read_some(boost::asio::buffer(rbuf_.data() + used_, rbuf_.size() - used_),
+        [self = self(), gen = generation_](const boost::system::error_code& ec, std::size_t n) {
+            if (gen != self->generation_) {
+                return;
+            }
+            if (ec) {
+                self->fail("read: " + ec.message());
+                return;
+            }
+            self->used_ += n;
+            self->bytes_.fetch_add(n, std::memory_order_relaxed);
+            if (self->process()) {
+                self->do_read();
+            }
+        });
+}
+
+bool RtspClient::process() {
+    const uint64_t gen = generation_;
+    std::size_t off = 0;
+    while (off < used_) {
+        const uint8_t* data = rbuf_.data() + off;
+        std::size_t avail = used_ - off;
+        if (data[0] == '$') {
+            uint8_t channel = 0;
+            const uint8_t* payload = nullptr;
+            std::size_t payload_size = 0;
+            std::size_t n = RtspInterleavedTransport::ParseFrame(data, avail, channel, payload, payload_size);
+            if (n == 0) {
+                break;
+            }
+            for (auto& t : tracks_) {
+                if (channel == t->rtp_channel) {
+                    on_rtp(*t, payload, payload_size);
+                    break;
+                }
+                if (channel == t->rtcp_channel) {
+                    on_rtcp(*t, payload, payload_size);
+                    break;
+                }
+            }
+            off += n;
+            continue;
+        }
+        RtspMessage msg;
+        long n = RtspMessage::Parse(reinterpret_cast<const char*>(data), avail, msg);
+        if (n < 0) {
+            fail("malformed response");
+            return false;
+        }
+        if (n == 0) {
+            if (avail == rbuf_.size()) {
+                fail("response too large");
+                return false;
+            }
+            break;
+        }
+        off += static_cast<std::size_t>(n);
+        if (msg.request) {
+            // 服务端发来的请求（如ANNOUNCE/GET_PARAMETER），不支持
+            std::string text = "RTSP/1.0 501 Not Implemented\r\nCSeq: " + std::to_string(msg.CSeq()) + "\r\n\r\n";
+            transport_->SendControl(std::move(text));
+        } else {
+            on_response(msg);
+        }
+        if (gen != generation_ || state_ == State::Closed) {
+            return false;
+        }
+    }
+    if (off > 0) {
+        std::memmove(rbuf_.data(), rbuf_.data() + off, used_ - off);
+        used_ -= off;
+    }
+    return true;
+}
+
+void RtspClient::send_request(const std::string& method, const std::string& url, const std::string& extra) {
+    method_ = method;
+    request_url_ = url;
+    request_extra_ = extra;
+    std::string text = method + " " + url + " RTSP/1.0\r\nCSeq: " + std::to_string(++cseq_) + "\r\n";
+    text += "User-Agent: " + cfg_.user_agent + "\r\n";
+    text += authorization(method, url);
+    if (!session_.empty()) {
+        text += "Session: " + session_ + "\r\n";
+    }
+    text += extra;
+    text += "\r\n";
+    request_deadline_ms_ = now_ms() + cfg_.timeout_ms;
+    transport_->SendControl(std::move(text));
+}
+
+std::string RtspClient::authorization(const std::string& method, const std::string& url) {
+    RtspUsrAuthInfo& auth = *authInfo_;
+    if (!auth.has_auth_info_ || auth.auth_domain.empty()) {
+        return std::string();
+    }
+    if (!auth.digest_) {
+        std::string cred = auth.username_ + ":" + auth.password_;
+        return "Authorization: Basic " + Sdp::Base64Encode(cred.data(), cred.size()) + "\r\n";
+    }
+    std::string nc;
+    std::string cnonce;
+    if (!auth.qop_.empty()) {
+        char buf[16];
+        std::snprintf(buf, sizeof(buf), "%08x", ++auth.nonce_count_);
+        nc = buf;
+        std::snprintf(buf, sizeof(buf), "%08x", random_u32());
+        cnonce = buf;
+    }
+    std::string response = DigestResponse(auth.username_, auth.auth_domain, auth.password_, method, url,
+                                          auth.nonce_, nc, cnonce, auth.qop_);
+    std::string text = "Authorization: Digest username=\"" + auth.username_ + "\", realm=\"" + auth.auth_domain
+                     + "\", nonce=\"" + auth.nonce_ + "\", uri=\"" + url + "\", response=\"" + response + "\"";
+    if (!auth.opaque_.empty()) {
+        text += ", opaque=\"" + auth.opaque_ + "\"";
+    }
+    if (!auth.qop_.empty()) {
+        text += ", qop=" + auth.qop_ + ", nc=" + nc + ", cnonce=\"" + cnonce + "\"";
+    }
+    return text + "\r\n";
+}
+
+std::string RtspClient::DigestResponse(const std::string& username, const std::string& realm, const std::string& password,
+                                       const std::string& method, const std::string& uri, const std::string& nonce,
+                                       const std::string& nc, const std::string& cnonce, const std::string& qop) {
+    std::string ha1 = md5_hex(username + ":" + realm + ":" + password);
+    std::string ha2 = md5_hex(method + ":" + uri);
+    if (qop.empty()) {
+        return md5_hex(ha1 + ":" + nonce + ":" + ha2);
+    }
+    return md5_hex(ha1 + ":" + nonce + ":" + nc + ":" + cnonce + ":" + qop + ":" + ha2);
+}
+
+bool RtspClient::parse_challenge(const RtspMessage& msg) {
+    // 可能同时给出Digest和Basic，优先Digest
+    const std::string* basic = nullptr;
+    const std::string* digest = nullptr;
+    for (const auto& h : msg.headers) {
+        if (!iequals_prefix(h.first, "WWW-Authenticate") || h.first.size() != std::strlen("WWW-Authenticate")) {
+            continue;
+        }
+        if (iequals_prefix(h.second, "Digest ")) {
+            digest = &h.second;
+        } else if (iequals_prefix(h.second, "Basic ")) {
+            basic = &h.second;
+        }
+    }
+    RtspUsrAuthInfo& auth = *authInfo_;
+    if (!digest) {
+        if (!basic) {
+            return false;
+        }
+        std::string_view realm;
+        std::string_view v(*basic);
+        v.remove_prefix(6);
+        std::size_t pos = v.find("realm=\"");
+        realm = pos == std::string_view::npos ? std::string_view("basic") : v.substr(pos + 7, v.find('"', pos + 7) - pos - 7);
+        auth.digest_ = false;
+        auth.auth_domain = std::string(realm);
+        return true;
+    }
+
+    // key=value或key="value"，逗号分隔
+    std::string_view v(*digest);
+    v.remove_prefix(7);
+    auth.digest_ = true;
+    auth.opaque_.clear();
+    auth.qop_.clear();
+    std::string nonce;
+    while (!v.empty()) {
+        while (!v.empty() && (v.front() == ' ' || v.front() == ',')) {
+            v.remove_prefix(1);
+        }
+        std::size_t eq = v.find('=');
+        if (eq == std::string_view::npos) {
+            break;
+        }
+        std::string_view key = v.substr(0, eq);
+        v.remove_prefix(eq + 1);
+        std::string_view value;
+        if (!v.empty() && v.front() == '"') {
+            std::size_t end = v.find('"', 1);
+            value = v.substr(1, end == std::string_view::npos ? std::string_view::npos : end - 1);
+            v = end == std::string_view::npos ? std::string_view() : v.substr(end + 1);
+        } else {
+            std::size_t end = v.find(',');
+            value = v.substr(0, end);
+            v = end == std::string_view::npos ? std::string_view() : v.substr(end);
+        }
+        if (key == "realm") {
+            auth.auth_domain = std::string(value);
+        } else if (key == "nonce") {
+            nonce = std::string(value);
+        } else if (key == "opaque") {
+            auth.opaque_ = std::string(value);
+        } else if (key == "qop") {
+            // "auth,auth-int"中只用auth
+            std::size_t pos = value.find("auth");
+            if (pos != std::string_view::npos && (pos + 4 == value.size() || value[pos + 4] == ',')) {
+                auth.qop_ = "auth";
+            }
+        } else if (key == "algorithm") {
+            if (!iequals_prefix(value, "MD5") || value.size() != 3) {
+                return false;
+            }
+        }
+    }
+    if (nonce.empty()) {
+        return false;
+    }
+    if (nonce != auth.nonce_) {
+        auth.nonce_ = nonce;
+        auth.nonce_count_ = 0;
+    }
+    return true;
+}
+
+void RtspClient::on_response(const RtspMessage& msg) {
+    if (msg.CSeq() != cseq_) {
+        return;
+    }
+    request_deadline_ms_ = -1;
+    if (msg.status == 401) {
+        // 每个请求最多按新挑战重试一次；stale=true时nonce变了也会走这里
+        if (!auth_retried_ && authInfo_->has_auth_info_ && parse_challenge(msg)) {
+            auth_retried_ = true;
+            send_request(method_, request_url_, request_extra_);
+            return;
+        }
+        fail(method_ + " unauthorized");
+        return;
+    }
+    auth_retried_ = false;
+    if (msg.status != 200) {
+        // 保活请求不被支持不影响播放
+        if (state_ == State::Playing) {
+            return;
+        }
+        fail(method_ + " " + std::to_string(msg.status) + " " + msg.reason);
+        return;
+    }
+
+    switch (state_.load(std::memory_order_relaxed)) {
+    case State::Options:
+        if (const std::string* p = msg.Header("Public")) {
+            public_ = *p;
+        }
+        state_ = State::Describe;
+        send_request("DESCRIBE", urlInfo_.url, "Accept: application/sdp\r\n");
+        break;
+    case State::Describe:
+        on_describe(msg);
+        break;
+    case State::Setup:
+        on_setup(msg);
+        break;
+    case State::Play:
+        state_ = State::Playing;
+        last_media_ms_ = now_ms();
+        {
+            int interval = cfg_.keepalive_s > 0 ? cfg_.keepalive_s : std::max(1, session_timeout_s_ / 2);
+            next_keepalive_ms_ = last_media_ms_ + interval * 1000;
+        }
+        break;
+    default:
+        break;
+    }
+}
+
+void RtspClient::on_describe(const RtspMessage& msg) {
+    std::vector<SdpTrack> sdp_tracks;
+    if (!Sdp::Parse(msg.body, sdp_tracks)) {
+        fail("DESCRIBE: invalid sdp");
+        return;
+    }
+    if (const std::string* base = msg.Header("Content-Base")) {
+        content_base_ = *base;
+    } else if (const std::string* location = msg.Header("Content-Location")) {
+        content_base_ = *location;
+    } else {
+        content_base_ = urlInfo_.url;
+    }
+
+    for (SdpTrack& sdp : sdp_tracks) {
+        // 目前只接视频；音频需要对应的解包器
+        if (sdp.codec != SdpCodec::H264 && sdp.codec != SdpCodec::H265) {
+            continue;
+        }
+        auto track = std::make_unique<Track>();
+        if (sdp.control.rfind("rtsp://", 0) == 0) {
+            track->url = sdp.control;
+        } else if (sdp.control.empty() || sdp.control == "*") {
+            track->url = content_base_;
+        } else {
+            track->url = content_base_;
+            if (track->url.back() != '/') {
+                track->url += '/';
+            }
+            track->url += sdp.control;
+        }
+        RtpJitterBuffer::Config jcfg = cfg_.jitter;
+        jcfg.clock_rate = sdp.clock_rate;
+        std::unique_ptr<RtpDepacketizer> depacketizer;
+        if (sdp.codec == SdpCodec::H264) {
+            depacketizer = std::make_unique<H264RtpDepacketizer>();
+        } else {
+            depacketizer = std::make_unique<H265RtpDepacketizer>();
+        }
+        track->jitter = std::make_unique<RtpJitterBuffer>(jcfg, std::move(depacketizer));
+        RtcpSession::Config rcfg;
+        rcfg.ssrc = random_u32();
+        rcfg.clock_rate = sdp.clock_rate;
+        rcfg.cname = cfg_.user_agent;
+        track->rtcp = std::make_unique<RtcpSession>(rcfg);
+        track->rtp_channel = static_cast<uint8_t>(2 * tracks_.size());
+        track->rtcp_channel = static_cast<uint8_t>(2 * tracks_.size() + 1);
+        track->sdp = std::move(sdp);
+        tracks_.push_back(std::move(track));
+    }
+    if (tracks_.empty()) {
+        fail("DESCRIBE: no supported video track");
+        return;
+    }
+    state_ = State::Setup;
+    setup_index_ = 0;
+    send_setup();
+}
+
+void RtspClient::send_setup() {
+    Track& t = *tracks_[setup_index_];
+    std::string transport;
+    if (cfg_.tcp) {
+        transport = "Transport: RTP/AVP/TCP;unicast;interleaved=" + std::to_string(t.rtp_channel) + "-"
+                  + std::to_string(t.rtcp_channel) + "\r\n";
+    } else {
+        if (!open_udp(t)) {
+            fail("SETUP: no local udp port");
+            return;
+        }
+        uint16_t port = t.rtp_socket->local_endpoint().port();
+        transport = "Transport: RTP/AVP;unicast;client_port=" + std::to_string(port) + "-" + std::to_string(port + 1) + "\r\n";
+    }
+    send_request("SETUP", t.url, transport);
+}
+
+bool RtspClient::open_udp(Track& t) {
+    if (cfg_.port_pool) {
+        RtpPortPool::Lease lease = cfg_.port_pool->Acquire();
+        if (!lease || !lease.rtcp()) {
+            return false;
+        }
+        t.rtp_socket = &lease.rtp();
+        t.rtcp_socket = lease.rtcp();
+        t.lease = std::move(lease);
+    } else {
+        net::UdpBatchSocket::Config ucfg;
+        ucfg.batch = 32;
+        ucfg.datagram_size = cfg_.jitter.slot_size;
+        ucfg.enable_gso = false;
+        boost::system::error_code ec;
+        auto local = socket_.local_endpoint(ec);
+        auto any = local.address().is_v6() ? ASIO::UdpEndpoint(boost::asio::ip::udp::v6(), 0)
+                                           : ASIO::UdpEndpoint(boost::asio::ip::udp::v4(), 0);
+        // 取一个偶数端口，RTCP为+1
+        for (int attempt = 0; attempt < 16 && !t.rtp_socket; ++attempt) {
+            try {
+                auto rtp = std::make_unique<net::UdpBatchSocket>(strand_, any, ucfg);
+                uint16_t port = rtp->local_endpoint().port();
+                if (port & 1) {
+                    continue;
+                }
+                auto rtcp = std::make_unique<net::UdpBatchSocket>(strand_, ASIO::UdpEndpoint(any.protocol(), port + 1), ucfg);
+                t.owned_rtp = std::move(rtp);
+                t.owned_rtcp = std::move(rtcp);
+                t.rtp_socket = t.owned_rtp.get();
+                t.rtcp_socket = t.owned_rtcp.get();
+            } catch (const boost::system::system_error&) {
+                continue;
+            }
+        }
+        if (!t.rtp_socket) {
+            return false;
+        }
+    }
+    boost::system::error_code ec;
+    t.server_address = socket_.remote_endpoint(ec).address();
+    Track* track = &t;
+    const uint64_t gen = generation_;
+    // 池里的socket绑在池的io_context上，回调显式切回本客户端的strand
+    // 端口是公开的，不是服务端发来的数据报直接丢弃，避免被注入媒体
+    // 自有socket归客户端所有，回调持weak_ptr避免循环引用；track在代数不变时有效
+    std::weak_ptr<RtspClient> weak = self();
+    t.rtp_socket->StartReceive([weak, track, gen](const net::UdpDatagram* dgrams, size_t count) {
+        auto self = weak.lock();
+        if (!self || gen != self->generation_) {
+            return;
+        }
+        for (size_t i = 0; i < count; ++i) {
+            if (!same_host(dgrams[i].from.address(), track->server_address)) {
+                continue;
+            }
+            self->bytes_.fetch_add(dgrams[i].size, std::memory_order_relaxed);
+            self->on_rtp(*track, dgrams[i].data, dgrams[i].size);
+        }
+    }, strand_);
+    t.rtcp_socket->StartReceive([weak, track, gen](const net::UdpDatagram* dgrams, size_t count) {
+        auto self = weak.lock();
+        if (!self || gen != self->generation_) {
+            return;
+        }
+        for (size_t i = 0; i < count; ++i) {
+            if (!same_host(dgrams[i].from.address(), track->server_address)) {
+                continue;
+            }
+            self->on_rtcp(*track, dgrams[i].data, dgrams[i].size);
+        }
+    }, strand_);
+    return true;
+}
+
+void RtspClient::on_setup(const RtspMessage& msg) {
+    if (const std::string* s = msg.Header("Session")) {
+        std::string_view v(*s);
+        std::size_t semi = v.find(';');
+        session_ = std::string(v.substr(0, semi));
+        std::string_view timeout;
+        if (semi != std::string_view::npos && find_param(v.substr(semi + 1), "timeout", timeout)) {
+            std::from_chars(timeout.data(), timeout.data() + timeout.size(), session_timeout_s_);
+        }
+    }
+    Track& t = *tracks_[setup_index_];
+    if (const std::string* tr = msg.Header("Transport")) {
+        std::string_view value;
+        int a = 0;
+        int b = 0;
+        if (cfg_.tcp && find_param(*tr, "interleaved", value) && parse_pair(value, a, b)) {
+            // 以服务端确认的通道为准
+            t.rtp_channel = static_cast<uint8_t>(a);
+            t.rtcp_channel = static_cast<uint8_t>(b);
+        } else if (!cfg_.tcp && find_param(*tr, "server_port", value) && parse_pair(value, a, b)) {
+            boost::system::error_code ec;
+            auto remote = socket_.remote_endpoint(ec);
+            t.server_rtcp = ASIO::UdpEndpoint(remote.address(), static_cast<uint16_t>(b));
+        }
+    }
+    if (++setup_index_ < tracks_.size()) {
+        send_setup();
+        return;
+    }
+    state_ = State::Play;
+    send_request("PLAY", content_base_, "Range: npt=0.000-\r\n");
+}
+
+void RtspClient::on_rtp(Track& t, const uint8_t* data, std::size_t size) {
+    RtpHeaderView hdr;
+    if (!hdr.Parse(data, size)) {
+        return;
+    }
+    int64_t now = now_ms();
+    last_media_ms_ = now;
+    rtp_packets_.fetch_add(1, std::memory_order_relaxed);
+    t.rtcp->OnRtpReceived(hdr, now);
+    t.jitter->Insert(data, size, now);
+    drain(t, now);
+
+    if (t.rtcp->ReportDue(now)) {
+        uint8_t buf[kMaxRtcpSize];
+        std::size_t n = t.rtcp->BuildReport(buf, now);
+        if (n > 0) {
+            if (cfg_.tcp) {
+                transport_->SendRtcp(t.rtcp_channel, buf, n);
+            } else if (t.rtcp_socket && t.server_rtcp.port() != 0) {
+                t.rtcp_socket->SendTo(t.server_rtcp, buf, n);
+            }
+        }
+    }
+}
+
+void RtspClient::on_rtcp(Track& t, const uint8_t* data, std::size_t size) {
+    t.rtcp->OnRtcpReceived(data, size, now_ms());
+}
+
+void RtspClient::drain(Track& t, int64_t now) {
+    while (AccessUnitView* au = t.jitter->Pop(now)) {
+        frames_.fetch_add(1, std::memory_order_relaxed);
+        if (au->corrupted) {
+            corrupted_frames_.fetch_add(1, std::memory_order_relaxed);
+        }
+        if (frame_handler_) {
+            frame_handler_(t.sdp, *au);
+        }
+    }
+}
+
+void RtspClient::arm_timer() {
+    timer_.expires_after(std::chrono::milliseconds(kTickMs));
+    timer_.async_wait([self = self(), gen = generation_](const boost::system::error_code& ec) {
+        if (ec || gen != self->generation_) {
+            return;
+        }
+        self->on_tick();
+    });
+}
+
+void RtspClient::on_tick() {
+    int64_t now = now_ms();
+    if (request_deadline_ms_ >= 0 && now > request_deadline_ms_) {
+        fail(state_ == State::Connecting ? std::string("connect timeout") : method_ + " timeout");
+        return;
+    }
+    if (state_ == State::Playing) {
+        if (now - last_media_ms_ > cfg_.media_timeout_ms) {
+            fail("media timeout");
+            return;
+        }
+        // 空洞等待超时的帧在没有新包到达时也要出
+        for (auto& t : tracks_) {
+            drain(*t, now);
+        }
+        if (now >= next_keepalive_ms_ && request_deadline_ms_ < 0) {
+            bool get_parameter = public_.find("GET_PARAMETER") != std::string::npos;
+            send_request(get_parameter ? "GET_PARAMETER" : "OPTIONS", content_base_);
+            int interval = cfg_.keepalive_s > 0 ? cfg_.keepalive_s : std::max(1, session_timeout_s_ / 2);
+            next_keepalive_ms_ = now + interval * 1000;
+        }
+    }
+    arm_timer();
+}
+
+void RtspClient::fail(const std::string& reason) {
+    if (state_ == State::Closed || state_ == State::Idle) {
+        return;
+    }
+    close();
+    ++generation_;
+    state_ = State::Closed;
+    if (error_handler_) {
+        error_handler_(reason);
+    }
+}
+
+void RtspClient::close() {
+    request_deadline_ms_ = -1;
+    timer_.cancel();
+    resolver_.cancel();
+    if (transport_) {
+        transport_->SetErrorHandler(nullptr);
+        transport_->Close();
+        transport_.reset();
+    } else {
+        boost::system::error_code ec;
+        socket_.close(ec);
+    }
+    for (auto& t : tracks_) {
+        if (t->lease) {
+            // 借来的端口保持绑定，归还给池
+            t->lease.Release();
+        } else if (t->rtp_socket) {
+            t->rtp_socket->Close();
+            t->rtcp_socket->Close();
+        }
+        t->rtp_socket = nullptr;
+        t->rtcp_socket = nullptr;
+    }
+}
+
+void RtspClient::retire_tracks() {
+    if (tracks_.empty()) {
+        return;
+    }
+    // close()关闭了自有socket，但被取消的async_wait可能还排在调度队列里、尚未进入strand，
+    // 它的回调持有socket的裸指针。等每个自有socket的StopReceive确认等待全部完成后再析构
+    auto retired = std::make_shared<std::vector<std::unique_ptr<Track>>>(std::move(tracks_));
+    tracks_.clear();
+    std::vector<net::UdpBatchSocket*> sockets;
+    for (auto& t : *retired) {
+        for (net::UdpBatchSocket* s : {t->owned_rtp.get(), t->owned_rtcp.get()}) {
+            if (s) {
+                sockets.push_back(s);
+            }
+        }
+    }
+    auto remaining = std::make_shared<std::size_t>(sockets.size());
+    for (net::UdpBatchSocket* s : sockets) {
+        // 回调都在strand上执行，计数无需同步；最后一个完成时离开socket的回调栈再析构
+        s->StopReceive([strand = strand_, retired, remaining]() {
+            if (--*remaining == 0) {
+                boost::asio::post(strand, [retired]() {});
+            }
+        });
+    }
+}
@@ -0,0 +1,262 @@
+#include "rtsp_interleaved.h"
+#include <algorithm>
+
+RtspInterleavedTransport::RtspInterleavedTransport(ASIO::TcpSocket& socket)
+    : RtspInterleavedTransport(socket, Config{}) {
+
+}
+
+RtspInterleavedTransport::RtspInterleavedTransport(ASIO::TcpSocket& socket, const Config& cfg)
+    : socket_(socket), cfg_(cfg) {
+
+}
+
+RtspInterleavedTransport::SendResult RtspInterleavedTransport::SendRtp(uint8_t channel, const RtpPacketBatch& batch,
+                                                                       std::shared_ptr<const void> keepalive) {
+    if (batch.empty()) {
+        return SendResult::Queued;
+    }
+    const uint8_t flags = batch.packets[0].flags;
+    const std::size_t bytes = batch.bytes() + batch.size() * RTSP_INTERLEAVED_HEADER_SIZE;
+
+    KeyframeRequestHandler request;
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        if (closed_) {
+            return SendResult::Closed;
+        }
+        bool keep = true;
+        if (wait_keyframe_[channel]) {
+            // 参考链已断，关键帧之前的帧发出去也无法解码
+            keep = (flags & RtpPacketView::kKeyframe) != 0;
+        }
+        if (keep && pending_bytes_ + bytes > cfg_.max_queued_bytes) {
+            keep = make_room(channel, flags, bytes);
+            if (!keep && !(flags & RtpPacketView::kDisposable) && !wait_keyframe_[channel]) {
+                wait_keyframe_[channel] = true;
+                request = keyframe_handler_;
+            }
+        }
+        if (!keep) {
+            stats_.dropped_packets += batch.size();
+            ++stats_.dropped_frames;
+        } else {
+            wait_keyframe_[channel] = false;
+            for (const RtpPacketView& p : batch.packets) {
+                Entry& e = pending_.emplace_back();
+                e.prefix[0] = '$';
+                e.prefix[1] = channel;
+                e.prefix[2] = static_cast<uint8_t>(p.size >> 8);
+                e.prefix[3] = static_cast<uint8_t>(p.size);
+                e.packet = p;
+                e.keepalive = keepalive;
+                e.channel = channel;
+                e.media = true;
+            }
+            pending_bytes_ += bytes;
+            kick();
+            return SendResult::Queued;
+        }
+    }
+    if (request) {
+        request(channel);
+    }
+    return SendResult::Dropped;
+}
+
+RtspInterleavedTransport::SendResult RtspInterleavedTransport::SendRtcp(uint8_t channel, const uint8_t* data, std::size_t size) {
+    if (size > 0xFFFF) {
+        return SendResult::Dropped;
+    }
+    std::lock_guard<std::mutex> lock(mtx_);
+    if (closed_) {
+        return SendResult::Closed;
+    }
+    Entry& e = pending_.emplace_back();
+    e.raw.reserve(RTSP_INTERLEAVED_HEADER_SIZE + size);
+    e.raw.push_back('$');
+    e.raw.push_back(static_cast<char>(channel));
+    e.raw.push_back(static_cast<char>(size >> 8));
+    e.raw.push_back(static_cast<char>(size));
+    e.raw.append(reinterpret_cast<const char*>(data), size);
+    e.channel = channel;
+    pending_bytes_ += e.raw.size();
+    kick();
+    return SendResult::Queued;
+}
+
+RtspInterleavedTransport::SendResult RtspInterleavedTransport::SendControl(std::string text) {
+    std::lock_guard<std::mutex> lock(mtx_);
+    if (closed_) {
+        return SendResult::Closed;
+    }
+    Entry& e = pending_.emplace_back();
+    e.raw = std::move(text);
+    pending_bytes_ += e.raw.size();
+    kick();
+    return SendResult::Queued;
+}
+
+void RtspInterleavedTransport::Close() {
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        if (closed_) {
+            return;
+        }
+        closed_ = true;
+        pending_.clear();
+        pending_bytes_ = 0;
+    }
+    // socket只在io线程操作，关闭会取消正在进行的写
+    boost::asio::post(socket_.get_executor(), [self = shared_from_this()]() {
+        boost::system::error_code ec;
+        self->socket_.close(ec);
+    });
+}
+
+void RtspInterleavedTransport::SetKeyframeRequestHandler(KeyframeRequestHandler handler) {
+    std::lock_guard<std::mutex> lock(mtx_);
+    keyframe_handler_ = std::move(handler);
+}
+
+void RtspInterleavedTransport::SetErrorHandler(ErrorHandler handler) {
+    std::lock_guard<std::mutex> lock(mtx_);
+    error_handler_ = std::move(handler);
+}
+
+bool RtspInterleavedTransport::writable() const {
+    std::lock_guard<std::mutex> lock(mtx_);
+    return !closed_ && pending_bytes_ < cfg_.low_watermark;
+}
+
+RtspInterleavedTransport::Stats RtspInterleavedTransport::stats() const {
+    std::lock_guard<std::mutex> lock(mtx_);
+    Stats s = stats_;
+    s.queued_bytes = pending_bytes_;
+    return s;
+}
+
+std::size_t RtspInterleavedTransport::ParseFrame(const uint8_t* data, std::size_t size, uint8_t& channel,
+                                                 const uint8_t*& payload, std::size_t& payload_size) {
+    if (size < RTSP_INTERLEAVED_HEADER_SIZE || data[0] != '$') {
+        return 0;
+    }
+    std::size_t len = (static_cast<std::size_t>(data[2]) << 8) | data[3];
+    if (size < RTSP_INTERLEAVED_HEADER_SIZE + len) {
+        return 0;
+    }
+    channel = data[1];
+    payload = data + RTSP_INTERLEAVED_HEADER_SIZE;
+    payload_size = len;
+    return RTSP_INTERLEAVED_HEADER_SIZE + len;
+}
+
+bool RtspInterleavedTransport::make_room(uint8_t channel, uint8_t flags, std::size_t bytes) {
+    if (flags & RtpPacketView::kDisposable) {
+        return false;
+    }
+    drop_pending_if([](const Entry& e) {
+        return (e.packet.flags & RtpPacketView::kDisposable) != 0;
+    });
+    if (pending_bytes_ + bytes <= cfg_.max_queued_bytes) {
+        return true;
+    }
+    if (flags & RtpPacketView::kKeyframe) {
+        // 积压的同通道媒体包都早于该关键帧，解码可从关键帧重新开始
+        drop_pending_if([channel](const Entry& e) {
+            return e.channel == channel;
+        });
+    }
+    return pending_bytes_ + bytes <= cfg_.max_queued_bytes;
+}
+
+template <class Pred>
+void RtspInterleavedTransport::drop_pending_if(Pred pred) {
+    auto it = std::remove_if(pending_.begin(), pending_.end(), [&](const Entry& e) {
+        if (!e.media || !pred(e)) {
+            return false;
+        }
+        pending_bytes_ -= e.bytes();
+        ++stats_.dropped_packets;
+        if (e.packet.flags & RtpPacketView::kFrameStart) {
+            ++stats_.dropped_frames;
+        }
+        return true;
+    });
+    pending_.erase(it, pending_.end());
+}
+
+void RtspInterleavedTransport::kick() {
+    if (write_scheduled_) {
+        return;
+    }
+    write_scheduled_ = true;
+    boost::asio::post(socket_.get_executor(), [self = shared_from_this()]() {
+        self->start_write();
+    });
+}
+
+void RtspInterleavedTransport::start_write() {
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        if (closed_ || pending_.empty()) {
+            write_scheduled_ = false;
+            return;
+        }
+        // 整个待发队列作为一批写出，期间生产者写入另一个vector
+        writing_.swap(pending_);
+        pending_bytes_ = 0;
+    }
+
+    buffers_.clear();
+    for (const Entry& e : writing_) {
+        if (e.media) {
+            buffers_.emplace_back(e.prefix, RTSP_INTERLEAVED_HEADER_SIZE);
+            for (uint8_t i = 0; i < e.packet.iov_cnt; ++i) {
+                buffers_.emplace_back(e.packet.iov[i].iov_base, e.packet.iov[i].iov_len);
+            }
+        } else {
+            buffers_.emplace_back(e.raw.data(), e.raw.size());
+        }
+    }
+    boost::asio::async_write(socket_, buffers_,
+        [self = shared_from_this()](const boost::system::error_code& ec, std::size_t) {
+            self->on_write(ec);
+        });
+}
+
+void RtspInterleavedTransport::on_write(const boost::system::error_code& ec) {
+    ErrorHandler on_error;
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        if (!ec) {
+            for (const Entry& e : writing_) {
+                if (e.media) {
+                    ++stats_.sent_packets;
+                    stats_.sent_bytes += e.packet.size;
+                }
+            }
+        }
+        writing_.clear();
+        if (ec) {
+            // 主动Close导致的取消不回调
+            if (!closed_) {
+                on_error = error_handler_;
+            }
+            closed_ = true;
+            pending_.clear();
+            pending_bytes_ = 0;
+            write_scheduled_ = false;
+        } else if (pending_.empty()) {
+            write_scheduled_ = false;
+            return;
+        }
+    }
+    if (ec) {
+        if (on_error) {
+            on_error(ec);
+        }
+        return;
+    }
+    start_write();
+}
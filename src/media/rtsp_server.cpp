@@ -0,0 +1,1287 @@
+#include "rtsp_server.h"
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include "rtcp.h"
+#include "rtsp.h"
+#include "stringhelper.h"
+
+namespace {
+    /// @brief 静态负载类型（RFC 3551）
+    constexpr uint8_t kPayloadTypePcmu = 0;
+    constexpr uint8_t kPayloadTypePcma = 8;
+    constexpr uint8_t kPayloadTypeDynamic = 96;
+    /// @brief 会话超时只需秒级精度
+    constexpr int64_t kTimerTickMs = 100;
+
+    uint32_t random_u32() {
+        thread_local std::mt19937 rng{std::random_device{}()};
+        return rng();
+    }
+
+    /// @brief 去掉"rtsp://host[:port]"和查询串，返回不带首尾'/'的路径
+    std::string url_path(const std::string& url) {
+        std::string_view v(url);
+        std::size_t scheme = v.find("://");
+        if (scheme != std::string_view::npos) {
+            v.remove_prefix(scheme + 3);
+            std::size_t slash = v.find('/');
+            v = slash == std::string_view::npos ? std::string_view() : v.substr(slash);
+        }
+        std::size_t query = v.find('?');
+        if (query != std::string_view::npos) {
+            v = v.substr(0, query);
+        }
+        while (!v.empty() && v.front() == '/') {
+            v.remove_prefix(1);
+        }
+        while (!v.empty() && v.back() == '/') {
+            v.remove_suffix(1);
+        }
+        return std::string(v);
+    }
+
+    /// @brief 解析"a-b"形式的端口/通道对，只有一个数时b=a+1
+    bool parse_pair(std::string_view v, int& a, int& b) {
+        std::size_t dash = v.find('-');
+        std::string_view first = v.substr(0, dash);
+        auto [p1, ec1] = std::from_chars(first.data(), first.data() + first.size(), a);
+        if (ec1 != std::errc()) {
+            return false;
+        }
+        b = a + 1;
+        if (dash != std::string_view::npos) {
+            std::string_view second = v.substr(dash + 1);
+            auto [p2, ec2] = std::from_chars(second.data(), second.data() + second.size(), b);
+            if (ec2 != std::errc()) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    /// @brief 访问单元是否带recovery point SEI（H.264/H.265的SEI payloadType 6），可作为起播点
+    bool has_recovery_point(SdpCodec codec, const uint8_t* data, std::size_t size) {
+        std::vector<NalUnitView> nalus;
+        NaluHelper::SplitAnnexB(data, size, nalus);
+        for (const NalUnitView& nal : nalus) {
+            std::size_t header = 0;
+            if (codec == SdpCodec::H264 && nal.size > 1 && (nal.data[0] & 0x1F) == 6) {
+                header = 1;
+            } else if (codec == SdpCodec::H265 && nal.size > 2 && H265RtpPacketizer::NalType(nal.data) == 39) {
+                header = 2;
+            } else {
+                continue;
+            }
+            // 只看第一条SEI消息，recovery point通常单独成条或排在最前
+            int payload_type = 0;
+            std::size_t i = header;
+            while (i < nal.size && nal.data[i] == 0xFF) {
+                payload_type += 255;
+                ++i;
+            }
+            if (i < nal.size && payload_type + nal.data[i] == 6) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    /// @brief 关闭订阅者的平滑发送队列，返回后节拍器线程不再为其发送
+    void close_paced(const RtspSubscriber& sub) {
+        for (const auto& sink : sub.sinks) {
+            if (sink.paced) {
+                sink.paced->Close();
+            }
+        }
+    }
+}
+
+// ---------------------------------------------------------------- RtspMediaSource
+
+RtspMediaSource::RtspMediaSource(const Config& cfg)
+    : cfg_(cfg), subscribers_(std::make_shared<const SubscriberList>()) {
+    if (cfg_.video_codec == SdpCodec::H264 || cfg_.video_codec == SdpCodec::H265) {
+        video_track_ = static_cast<int>(track_count_);
+        Track& t = tracks_[track_count_++];
+        t.sdp.codec = cfg_.video_codec;
+        t.sdp.video = true;
+        t.sdp.payload_type = kPayloadTypeDynamic;
+        t.sdp.clock_rate = 90000;
+        t.sdp.control = "trackID=" + std::to_string(video_track_);
+
+        RtpPacketizer::Config pcfg;
+        pcfg.payload_type = kPayloadTypeDynamic;
+        pcfg.ssrc = random_u32();
+        pcfg.initial_seq = static_cast<uint16_t>(random_u32());
+        pcfg.mtu = cfg_.mtu;
+        if (cfg_.video_codec == SdpCodec::H264) {
+            t.packetizer = std::make_unique<H264RtpPacketizer>(pcfg);
+        } else {
+            t.packetizer = std::make_unique<H265RtpPacketizer>(pcfg);
+        }
+        t.ssrc = pcfg.ssrc;
+        if (!cfg_.video_extradata.empty()) {
+            Sdp::ExtractParameterSets(cfg_.video_extradata.data(), cfg_.video_extradata.size(), t.sdp);
+            have_parameter_sets_ = Sdp::HasParameterSets(t.sdp);
+        }
+    }
+    if (cfg_.audio_codec == SdpCodec::PCMA || cfg_.audio_codec == SdpCodec::PCMU) {
+        audio_track_ = static_cast<int>(track_count_);
+        Track& t = tracks_[track_count_++];
+        t.sdp.codec = cfg_.audio_codec;
+        t.sdp.video = false;
+        t.sdp.payload_type = cfg_.audio_codec == SdpCodec::PCMA ? kPayloadTypePcma : kPayloadTypePcmu;
+        t.sdp.clock_rate = cfg_.audio_sample_rate;
+        t.sdp.control = "trackID=" + std::to_string(audio_track_);
+        t.ssrc = random_u32();
+        t.seq = static_cast<uint16_t>(random_u32());
+    }
+    // 纯音频源每帧都可独立解码，不需要缓存
+    if (cfg_.enable_gop_cache && video_track_ >= 0) {
+        gop_cache_ = std::make_unique<GopCache<CachedFrame>>(cfg_.gop_cache);
+    }
+}
+
+RtspMediaSource::~RtspMediaSource() {
+    for (const auto& sub : *subscribers_.load(std::memory_order_acquire)) {
+        close_paced(*sub);
+    }
+}
+
+bool RtspMediaSource::PushVideo(const uint8_t* data, std::size_t size, uint32_t timestamp, std::shared_ptr<const void> keepalive) {
+    if (video_track_ < 0 || !data || size == 0) {
+        return false;
+    }
+    Track& t = tracks_[video_track_];
+    std::lock_guard<std::mutex> lock(t.mtx);
+    t.batch.clear();
+    if (t.packetizer->PacketizeAnnexB(data, size, timestamp, t.batch) == 0) {
+        return false;
+    }
+    t.last_timestamp = timestamp;
+    if (!have_parameter_sets_ && (t.batch.packets[0].flags & RtpPacketView::kKeyframe)) {
+        // 编码器没有给extradata（或给得不全），从带内参数集补齐SDP，齐了才不再检查
+        std::lock_guard<std::mutex> sdp_lock(mtx_);
+        Sdp::ExtractParameterSets(data, size, t.sdp);
+        have_parameter_sets_ = Sdp::HasParameterSets(t.sdp);
+    }
+    std::shared_ptr<const CachedFrame> frame;
+    if (gop_cache_) {
+        uint8_t flags = 0;
+        if (t.batch.packets[0].flags & RtpPacketView::kKeyframe) {
+            flags = GopCache<CachedFrame>::kKeyframe;
+        } else if (cfg_.gop_cache.trim_to_start_point && has_recovery_point(t.sdp.codec, data, size)) {
+            flags = GopCache<CachedFrame>::kStartPoint;
+        }
+        frame = cache_frame(static_cast<std::size_t>(video_track_), t, data, size, keepalive, flags);
+    }
+    fan_out(static_cast<std::size_t>(video_track_), t, data, size, keepalive, std::move(frame));
+    return true;
+}
+
+bool RtspMediaSource::PushAudio(const uint8_t* data, std::size_t size, uint32_t timestamp, std::shared_ptr<const void> keepalive) {
+    if (audio_track_ < 0 || !data || size == 0) {
+        return false;
+    }
+    Track& t = tracks_[audio_track_];
+    std::lock_guard<std::mutex> lock(t.mtx);
+    t.batch.clear();
+    packetize_audio(t, data, size, timestamp);
+    t.last_timestamp = timestamp;
+    std::shared_ptr<const CachedFrame> frame;
+    if (gop_cache_) {
+        // 音频不作为起播点，视频关键帧之前的音频不缓存
+        frame = cache_frame(static_cast<std::size_t>(audio_track_), t, data, size, keepalive, 0);
+    }
+    fan_out(static_cast<std::size_t>(audio_track_), t, data, size, keepalive, std::move(frame));
+    return true;
+}
+
+void RtspMediaSource::packetize_audio(Track& t, const uint8_t* data, std::size_t size, uint32_t timestamp) {
+    // G.711每个采样1字节，切包后时间戳按字节数推进
+    const std::size_t max_payload = cfg_.mtu - RTP_FIXED_HEADER_SIZE;
+    for (std::size_t off = 0; off < size; off += max_payload) {
+        std::size_t len = std::min(max_payload, size - off);
+        RtpPacketView& p = t.batch.packets.emplace_back();
+        p.iov_cnt = 0;
+        p.size = 0;
+        p.seq = t.seq++;
+        p.timestamp = timestamp + static_cast<uint32_t>(off);
+        // 音频每帧独立可解，按关键帧处理，不会让interleaved队列进入等关键帧状态
+        p.flags = RtpPacketView::kKeyframe | (off == 0 ? RtpPacketView::kFrameStart : 0);
+        WriteRtpHeader(p.slab, t.sdp.payload_type, false, p.seq, p.timestamp, t.ssrc);
+        p.push_slab(0, RTP_FIXED_HEADER_SIZE);
+        p.push_data(data + off, len);
+    }
+}
+
+std::shared_ptr<RtspMediaSource::CachedFrame> RtspMediaSource::acquire_frame(Track& t) {
+    if (t.free_frames == 0) {
+        // 从队首数出已被GOP缓存和发送队列放掉的帧，顺便释放其负载引用，编码器缓冲不被池拖住
+        for (auto& f : t.frame_pool) {
+            if (f.use_count() != 1) {
+                break;
+            }
+            std::atomic_thread_fence(std::memory_order_acquire);
+            f->keepalive.reset();
+            ++t.free_frames;
+        }
+    }
+    std::shared_ptr<CachedFrame> frame;
+    if (t.free_frames > 0) {
+        frame = std::move(t.frame_pool.front());
+        t.frame_pool.pop_front();
+        --t.free_frames;
+    } else {
+        frame = std::make_shared<CachedFrame>();
+        if (!t.frame_pool.empty() && t.frame_pool.size() >= cfg_.gop_cache.max_frames) {
+            // 最老的帧仍被占用（如慢观看者的发送队列），不再跟踪，由最后的持有者释放
+            t.frame_pool.pop_front();
+        }
+    }
+    t.frame_pool.push_back(frame);
+    return frame;
+}
+
+std::shared_ptr<RtspMediaSource::CachedFrame> RtspMediaSource::hold_frame(Track& t, const uint8_t* data, std::size_t size,
+                                                                          const std::shared_ptr<const void>& keepalive) {
+    // 复用的帧沿用batch和data的容量
+    std::shared_ptr<CachedFrame> frame = acquire_frame(t);
+    frame->batch = t.batch;
+    if (keepalive) {
+        frame->keepalive = keepalive;
+        frame->data.clear();
+    } else {
+        // 负载只在本次调用内有效，拷贝一份并把指向原缓冲区的iovec改指到副本
+        frame->data.assign(data, data + size);
+        for (RtpPacketView& p : frame->batch.packets) {
+            for (std::size_t i = 0; i < p.iov_cnt; ++i) {
+                const uint8_t* base = static_cast<const uint8_t*>(p.iov[i].iov_base);
+                if (base >= data && base < data + size) {
+                    p.iov[i].iov_base = frame->data.data() + (base - data);
+                }
+            }
+        }
+    }
+    return frame;
+}
+
+std::shared_ptr<const RtspMediaSource::CachedFrame> RtspMediaSource::cache_frame(std::size_t index, Track& t, const uint8_t* data,
+                                                                                 std::size_t size, const std::shared_ptr<const void>& keepalive,
+                                                                                 uint8_t flags) {
+    std::shared_ptr<const CachedFrame> frame = hold_frame(t, data, size, keepalive);
+    gop_cache_->Push(static_cast<uint8_t>(index), flags, frame->batch.bytes(), frame);
+    return frame;
+}
+
+int RtspMediaSource::paced_send(std::size_t index, const ASIO::UdpEndpoint& to, const RtpPacketView* packets, std::size_t count) {
+    Track& t = tracks_[index];
+    std::lock_guard<std::mutex> lock(t.send_mtx);
+    return t.sender ? t.sender->Send(to, packets, count) : -1;
+}
+
+std::size_t RtspMediaSource::send_to(RtspSubscriber& sub, RtspSubscriber::Sink& sink, Track& t, const RtpPacketBatch& batch,
+                                     const std::shared_ptr<const void>& keepalive, uint64_t& udp_dropped) {
+    if (sink.interleaved) {
+        auto result = sub.transport->SendRtp(sink.channel, batch, keepalive);
+        if (result == RtspInterleavedTransport::SendResult::Queued) {
+            return batch.size();
+        }
+        if (result == RtspInterleavedTransport::SendResult::Dropped) {
+            tcp_dropped_frames_.fetch_add(1, std::memory_order_relaxed);
+        }
+        return 0;
+    }
+    if (sink.paced) {
+        if (sink.paced->Enqueue(batch, keepalive)) {
+            return batch.size();
+        }
+        udp_dropped += batch.size();
+        return 0;
+    }
+    if (!t.sender) {
+        return 0;
+    }
+    std::size_t sent = static_cast<std::size_t>(std::max(0, t.sender->Send(sink.rtp_to, batch)));
+    udp_dropped += batch.size() - sent;
+    return sent;
+}
+
+void RtspMediaSource::fan_out(std::size_t index, Track& t, const uint8_t* data, std::size_t size,
+                              const std::shared_ptr<const void>& keepalive, std::shared_ptr<const CachedFrame> frame) {
+    const RtpPacketBatch& batch = t.batch;
+    const uint8_t flags = batch.packets[0].flags;
+    frames_.fetch_add(1, std::memory_order_relaxed);
+    packets_.fetch_add(batch.size(), std::memory_order_relaxed);
+
+    // 一次原子load拿到快照，之后遍历期间订阅者增删不影响本帧
+    std::shared_ptr<const SubscriberList> list = subscribers_.load(std::memory_order_acquire);
+    uint64_t fanout = 0;
+    uint64_t udp_dropped = 0;
+    // 平滑发送在本次调用返回后才进行，track.batch会被下一帧覆盖，入队的包取自缓存帧；
+    // 推流方给了keepalive时包头随入队拷贝，负载由keepalive持有
+    const RtpPacketBatch* paced_batch = frame ? &frame->batch : &batch;
+    std::shared_ptr<const void> paced_keepalive = frame ? frame : keepalive;
+    bool udp = false;
+    for (const std::shared_ptr<RtspSubscriber>& sub : *list) {
+        RtspSubscriber::Sink& sink = sub->sinks[index];
+        if (!sink.enabled) {
+            continue;
+        }
+        if (sink.wait_keyframe.load(std::memory_order_relaxed)) {
+            if (!(flags & RtpPacketView::kKeyframe)) {
+                continue;
+            }
+            sink.wait_keyframe.store(false, std::memory_order_relaxed);
+        }
+        udp = udp || !sink.interleaved;
+        if (!sink.paced) {
+            fanout += send_to(*sub, sink, t, batch, keepalive, udp_dropped);
+            continue;
+        }
+        if (!paced_keepalive) {
+            frame = hold_frame(t, data, size, nullptr);
+            paced_batch = &frame->batch;
+            paced_keepalive = frame;
+        }
+        fanout += send_to(*sub, sink, t, *paced_batch, paced_keepalive, udp_dropped);
+    }
+    if (udp && t.rtx) {
+        // 重传可能在很多帧之后，和平滑发送一样缓存帧的副本
+        if (!paced_keepalive) {
+            frame = hold_frame(t, data, size, nullptr);
+            paced_batch = &frame->batch;
+            paced_keepalive = frame;
+        }
+        t.rtx->Store(*paced_batch, paced_keepalive, net::AsioTimerWheel::now_ms());
+    }
+    fanout_packets_.fetch_add(fanout, std::memory_order_relaxed);
+    if (udp_dropped) {
+        udp_dropped_.fetch_add(udp_dropped, std::memory_order_relaxed);
+    }
+}
+
+std::string RtspMediaSource::Describe(const std::string& origin_ip) const {
+    std::vector<SdpTrack> tracks;
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        for (std::size_t i = 0; i < track_count_; ++i) {
+            tracks.push_back(tracks_[i].sdp);
+        }
+    }
+    return Sdp::Generate(cfg_.session_name, origin_ip, tracks);
+}
+
+std::string RtspMediaSource::track_control(std::size_t track) const {
+    return track < track_count_ ? tracks_[track].sdp.control : std::string();
+}
+
+uint32_t RtspMediaSource::track_ssrc(std::size_t track) const {
+    return track < track_count_ ? tracks_[track].ssrc : 0;
+}
+
+void RtspMediaSource::track_position(std::size_t track, uint16_t& seq, uint32_t& rtptime) const {
+    if (track >= track_count_) {
+        seq = 0;
+        rtptime = 0;
+        return;
+    }
+    const Track& t = tracks_[track];
+    std::lock_guard<std::mutex> lock(t.mtx);
+    seq = t.packetizer ? t.packetizer->next_seq() : t.seq;
+    rtptime = t.last_timestamp;
+}
+
+bool RtspMediaSource::AttachUdp(std::size_t track, std::unique_ptr<net::UdpBatchSocket> rtp, std::unique_ptr<net::UdpBatchSocket> rtcp) {
+    if (track >= track_count_ || !rtp || !rtcp) {
+        return false;
+    }
+    Track& t = tracks_[track];
+    std::lock_guard<std::mutex> lock(t.mtx);
+    if (t.sender) {
+        return true;
+    }
+    t.rtp_socket = std::move(rtp);
+    t.rtcp_socket = std::move(rtcp);
+    {
+        std::lock_guard<std::mutex> send_lock(t.send_mtx);
+        t.sender = std::make_unique<RtpUdpSender>(*t.rtp_socket);
+    }
+    if (cfg_.enable_rtx) {
+        t.rtx = std::make_unique<RtpRtxCache>(cfg_.rtx);
+    }
+    // 观看者的接收报告按来源地址交给各自的会话，用于保活和RTCP统计
+    t.rtcp_socket->StartReceive([weak = weak_from_this(), track](const net::UdpDatagram* dgrams, size_t count) {
+        if (auto self = weak.lock()) {
+            self->on_viewer_rtcp(track, dgrams, count);
+        }
+    });
+    return true;
+}
+
+void RtspMediaSource::on_viewer_rtcp(std::size_t index, const net::UdpDatagram* dgrams, std::size_t count) {
+    auto list = subscribers_.load(std::memory_order_acquire);
+    for (std::size_t i = 0; i < count; ++i) {
+        // 不认识的来源（未PLAY或已TEARDOWN的观看者、扫描流量）直接丢弃
+        for (const auto& sub : *list) {
+            const RtspSubscriber::Sink& sink = sub->sinks[index];
+            if (sink.enabled && !sink.interleaved && sink.rtcp_from == dgrams[i].from && sub->rtcp_handler) {
+                viewer_rtcp_.fetch_add(1, std::memory_order_relaxed);
+                sub->rtcp_handler(index, dgrams[i].data, dgrams[i].size);
+                break;
+            }
+        }
+    }
+}
+
+std::size_t RtspMediaSource::Retransmit(std::size_t track, const ASIO::UdpEndpoint& to, const uint16_t* seqs, std::size_t count) {
+    if (track >= track_count_) {
+        return 0;
+    }
+    Track& t = tracks_[track];
+    std::lock_guard<std::mutex> lock(t.mtx);
+    if (!t.rtx) {
+        return 0;
+    }
+    t.rtx_out.clear();
+    if (t.rtx->OnNack(seqs, count, net::AsioTimerWheel::now_ms(), t.rtx_out) == 0) {
+        return 0;
+    }
+    // 与节拍器线程共用sender，按原序号、原SSRC直接发出，不进平滑队列排在实时包之后
+    std::size_t sent = 0;
+    {
+        std::lock_guard<std::mutex> send_lock(t.send_mtx);
+        for (const RtpRtxCache::RtxPacket& p : t.rtx_out) {
+            if (!t.sender || t.sender->Send(to, &p.packet, 1) <= 0) {
+                break;
+            }
+            ++sent;
+        }
+    }
+    t.rtx_out.clear();
+    retransmitted_.fetch_add(sent, std::memory_order_relaxed);
+    return sent;
+}
+
+bool RtspMediaSource::has_udp(std::size_t track) const {
+    if (track >= track_count_) {
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(tracks_[track].mtx);
+    return tracks_[track].sender != nullptr;
+}
+
+uint16_t RtspMediaSource::udp_port(std::size_t track) const {
+    if (track >= track_count_) {
+        return 0;
+    }
+    std::lock_guard<std::mutex> lock(tracks_[track].mtx);
+    return tracks_[track].rtp_socket ? tracks_[track].rtp_socket->local_endpoint().port() : 0;
+}
+
+void RtspMediaSource::AddSubscriber(std::shared_ptr<RtspSubscriber> subscriber, const JoinHandler& on_join) {
+    // 持有所有轨道的推流锁：回放与挂入索引之间不会插入实时帧，回放的最后一个包与之后的实时包序号连续
+    std::array<std::unique_lock<std::mutex>, RTSP_MAX_TRACKS> track_locks;
+    for (std::size_t i = 0; i < track_count_; ++i) {
+        track_locks[i] = std::unique_lock<std::mutex>(tracks_[i].mtx);
+    }
+    std::vector<GopCache<CachedFrame>::Entry> replay;
+    if (gop_cache_) {
+        replay = gop_cache_->Snapshot();
+    }
+
+    KeyframeRequestHandler request;
+    bool added = false;
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        auto next = std::make_shared<SubscriberList>(*subscribers_.load(std::memory_order_acquire));
+        if (std::find(next->begin(), next->end(), subscriber) == next->end()) {
+            if (cfg_.request_keyframe_on_join && video_track_ >= 0 && subscriber->sinks[video_track_].enabled && replay.empty()) {
+                request = keyframe_handler_;
+            }
+            if (cfg_.pacer) {
+                // 队列容量额外留出回放的包数，回放整段入队，由节拍器线程在推流锁外发出
+                std::array<std::size_t, RTSP_MAX_TRACKS> replay_packets{};
+                for (const auto& e : replay) {
+                    replay_packets[e.track] += e.frame->batch.size();
+                }
+                for (std::size_t i = 0; i < track_count_; ++i) {
+                    RtspSubscriber::Sink& sink = subscriber->sinks[i];
+                    if (!sink.enabled || sink.interleaved) {
+                        continue;
+                    }
+                    auto send = [this, i, to = sink.rtp_to](const RtpPacketView* packets, std::size_t count) {
+                        return paced_send(i, to, packets, count);
+                    };
+                    sink.paced = cfg_.pacer->AddStream(std::move(send), cfg_.pacer->config().queue_capacity + replay_packets[i]);
+                }
+            }
+            next->push_back(subscriber);
+            subscribers_.store(std::move(next), std::memory_order_release);
+            added = true;
+        }
+    }
+    if (!added) {
+        replay.clear();
+    }
+
+    TrackPositions positions;
+    std::array<bool, RTSP_MAX_TRACKS> replayed{};
+    for (const auto& e : replay) {
+        if (!replayed[e.track]) {
+            replayed[e.track] = true;
+            positions[e.track].seq = e.frame->batch.packets[0].seq;
+            positions[e.track].rtptime = e.frame->batch.packets[0].timestamp;
+        }
+    }
+    for (std::size_t i = 0; i < track_count_; ++i) {
+        if (!replayed[i]) {
+            const Track& t = tracks_[i];
+            positions[i].seq = t.packetizer ? t.packetizer->next_seq() : t.seq;
+            positions[i].rtptime = t.last_timestamp;
+        }
+    }
+    if (on_join) {
+        on_join(positions);
+    }
+
+    uint64_t fanout = 0;
+    uint64_t udp_dropped = 0;
+    uint64_t frames = 0;
+    for (const auto& e : replay) {
+        RtspSubscriber::Sink& sink = subscriber->sinks[e.track];
+        if (!sink.enabled) {
+            continue;
+        }
+        sink.wait_keyframe.store(false, std::memory_order_relaxed);
+        Track& t = tracks_[e.track];
+        fanout += send_to(*subscriber, sink, t, e.frame->batch, e.frame, udp_dropped);
+        if (!sink.interleaved && t.rtx) {
+            t.rtx->Store(e.frame->batch, e.frame, net::AsioTimerWheel::now_ms());
+        }
+        ++frames;
+    }
+    fanout_packets_.fetch_add(fanout, std::memory_order_relaxed);
+    udp_dropped_.fetch_add(udp_dropped, std::memory_order_relaxed);
+    replayed_frames_.fetch_add(frames, std::memory_order_relaxed);
+
+    for (std::size_t i = 0; i < track_count_; ++i) {
+        track_locks[i].unlock();
+    }
+    if (request) {
+        request();
+    }
+}
+
+void RtspMediaSource::RemoveSubscriber(const RtspSubscriber* subscriber) {
+    std::shared_ptr<RtspSubscriber> removed;
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        auto current = subscribers_.load(std::memory_order_acquire);
+        auto next = std::make_shared<SubscriberList>();
+        next->reserve(current->size());
+        for (const auto& sub : *current) {
+            if (sub.get() != subscriber) {
+                next->push_back(sub);
+            } else {
+                removed = sub;
+            }
+        }
+        if (!removed) {
+            return;
+        }
+        subscribers_.store(std::move(next), std::memory_order_release);
+    }
+    // 仍持有旧快照的推流线程再入队会被拒绝
+    close_paced(*removed);
+}
+
+std::shared_ptr<const RtspMediaSource::SubscriberList> RtspMediaSource::subscribers() const {
+    return subscribers_.load(std::memory_order_acquire);
+}
+
+void RtspMediaSource::SetKeyframeRequestHandler(KeyframeRequestHandler handler) {
+    std::lock_guard<std::mutex> lock(mtx_);
+    keyframe_handler_ = std::move(handler);
+}
+
+void RtspMediaSource::RequestKeyframe() {
+    KeyframeRequestHandler request;
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        request = keyframe_handler_;
+    }
+    if (request) {
+        request();
+    }
+}
+
+void RtspMediaSource::Close() {
+    std::shared_ptr<const SubscriberList> list;
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        list = subscribers_.exchange(std::make_shared<const SubscriberList>(), std::memory_order_acq_rel);
+    }
+    for (const auto& sub : *list) {
+        close_paced(*sub);
+        if (sub->transport) {
+            sub->transport->Close();
+        }
+    }
+    // UDP socket在io线程关闭并析构，取消的接收回调不再访问socket对象
+    for (std::size_t i = 0; i < track_count_; ++i) {
+        Track& t = tracks_[i];
+        std::unique_ptr<net::UdpBatchSocket> rtp;
+        std::unique_ptr<net::UdpBatchSocket> rtcp;
+        {
+            std::lock_guard<std::mutex> lock(t.mtx);
+            {
+                std::lock_guard<std::mutex> send_lock(t.send_mtx);
+                t.sender.reset();
+            }
+            t.rtx.reset();
+            rtp = std::move(t.rtp_socket);
+            rtcp = std::move(t.rtcp_socket);
+        }
+        if (rtp && rtcp) {
+            auto executor = rtcp->socket().get_executor();
+            boost::asio::post(executor, [rtp = std::move(rtp), rtcp = std::move(rtcp)]() {
+                rtp->Close();
+                rtcp->Close();
+            });
+        }
+    }
+}
+
+RtspMediaSource::Stats RtspMediaSource::stats() const {
+    Stats s;
+    s.frames = frames_.load(std::memory_order_relaxed);
+    s.packets = packets_.load(std::memory_order_relaxed);
+    s.fanout_packets = fanout_packets_.load(std::memory_order_relaxed);
+    s.udp_dropped = udp_dropped_.load(std::memory_order_relaxed);
+    s.tcp_dropped_frames = tcp_dropped_frames_.load(std::memory_order_relaxed);
+    s.subscribers = subscribers_.load(std::memory_order_acquire)->size();
+    s.replayed_frames = replayed_frames_.load(std::memory_order_relaxed);
+    s.viewer_rtcp = viewer_rtcp_.load(std::memory_order_relaxed);
+    s.retransmitted = retransmitted_.load(std::memory_order_relaxed);
+    if (gop_cache_) {
+        auto cache = gop_cache_->stats();
+        s.gop_cache_frames = cache.frames;
+        s.gop_cache_bytes = cache.bytes;
+    }
+    return s;
+}
+
+// ---------------------------------------------------------------- RtspServerSession
+
+/// @brief 单个RTSP连接：解析请求 -> 应答，PLAY后把订阅者挂到源上
+/// @details 所有回调在连接的strand上执行；应答经interleaved发送端写出，与媒体包保持顺序
+class RtspServerSession : public std::enable_shared_from_this<RtspServerSession> {
+public:
+    RtspServerSession(ASIO::TcpSocket socket, std::shared_ptr<RtspServer> server)
+        : socket_(std::move(socket)), server_(std::move(server)) {
+        const auto& cfg = server_->config();
+        transport_ = std::make_shared<RtspInterleavedTransport>(socket_, cfg.interleaved);
+        buf_.resize(std::max<std::size_t>(cfg.max_request_size, RTSP_INTERLEAVED_HEADER_SIZE + 65535));
+    }
+
+    void Start() {
+        last_active_ = std::chrono::steady_clock::now();
+        transport_->SetErrorHandler([weak = weak_from_this()](const boost::system::error_code&) {
+            if (auto self = weak.lock()) {
+                self->Close();
+            }
+        });
+        do_read();
+        arm_timer(std::max(1, server_->config().session_timeout_s) * 1000);
+    }
+
+    /// @brief 可在任意线程调用
+    void Close() {
+        boost::asio::post(socket_.get_executor(), [self = shared_from_this()]() {
+            self->close();
+        });
+    }
+
+private:
+    void do_read() {
+        socket_.async_read_some(boost::asio::buffer(buf_.data() + used_, buf_.size() - used_),
+            [self = shared_from_this()](const boost::system::error_code& ec, std::size_t n) {
+                if (ec) {
+                    self->close();
+                    return;
+                }
+                self->used_ += n;
+                if (self->process()) {
+                    self->do_read();
+                } else {
+                    self->close();
+                }
+            });
+    }
+
+    /// @return false时关闭连接
+    bool process() {
+        std::size_t off = 0;
+        bool ok = true;
+        while (off < used_) {
+            const char* data = buf_.data() + off;
+            std::size_t avail = used_ - off;
+            if (data[0] == '$') {
+                // 观看者经interleaved通道发来的RTCP：保活，并交给该轨道的RTCP会话
+                uint8_t channel = 0;
+                const uint8_t* payload = nullptr;
+                std::size_t payload_size = 0;
+                std::size_t n = RtspInterleavedTransport::ParseFrame(reinterpret_cast<const uint8_t*>(data), avail,
+                                                                     channel, payload, payload_size);
+                if (n == 0) {
+                    break;
+                }
+                last_active_ = std::chrono::steady_clock::now();
+                if (subscriber_) {
+                    for (std::size_t i = 0; i < subscriber_->sinks.size(); ++i) {
+                        const auto& sink = subscriber_->sinks[i];
+                        if (sink.enabled && sink.interleaved && channel == sink.channel + 1) {
+                            on_rtcp(i, payload, payload_size);
+                            break;
+                        }
+                    }
+                }
+                off += n;
+                continue;
+            }
+            RtspMessage req;
+            long n = RtspMessage::Parse(data, avail, req);
+            if (n == 0) {
+                if (avail >= server_->config().max_request_size) {
+                    reply(-1, 413, "Request Entity Too Large");
+                    ok = false;
+                }
+                break;
+            }
+            if (n < 0 || !req.request) {
+                reply(-1, 400, "Bad Request");
+                ok = false;
+                break;
+            }
+            off += static_cast<std::size_t>(n);
+            last_active_ = std::chrono::steady_clock::now();
+            handle(req);
+        }
+        if (off > 0) {
+            std::memmove(buf_.data(), buf_.data() + off, used_ - off);
+            used_ -= off;
+        }
+        return ok && !closed_;
+    }
+
+    void handle(const RtspMessage& req) {
+        int cseq = req.CSeq();
+        if (cseq < 0) {
+            reply(cseq, 400, "Bad Request");
+            return;
+        }
+        if (const std::string* sess = req.Header("Session")) {
+            std::string id = sess->substr(0, sess->find(';'));
+            if (id != session_id_) {
+                reply(cseq, 454, "Session Not Found");
+                return;
+            }
+        }
+        if (req.method == "OPTIONS") {
+            reply(cseq, 200, "OK", "Public: OPTIONS, DESCRIBE, SETUP, PLAY, TEARDOWN, GET_PARAMETER\r\n");
+        } else if (req.method == "DESCRIBE") {
+            on_describe(req, cseq);
+        } else if (req.method == "SETUP") {
+            on_setup(req, cseq);
+        } else if (req.method == "PLAY") {
+            on_play(req, cseq);
+        } else if (req.method == "TEARDOWN") {
+            teardown();
+            reply(cseq, 200, "OK");
+        } else if (req.method == "GET_PARAMETER" || req.method == "SET_PARAMETER") {
+            reply(cseq, 200, "OK", session_header());
+        } else {
+            reply(cseq, 501, "Not Implemented");
+        }
+    }
+
+    void on_describe(const RtspMessage& req, int cseq) {
+        auto source = server_->FindSource(url_path(req.url));
+        if (!source) {
+            reply(cseq, 404, "Not Found");
+            return;
+        }
+        boost::system::error_code ec;
+        auto local = socket_.local_endpoint(ec);
+        std::string sdp = source->Describe(ec ? "0.0.0.0" : local.address().to_string());
+        std::string base = req.url;
+        if (base.empty() || base.back() != '/') {
+            base += '/';
+        }
+        reply(cseq, 200, "OK", "Content-Base: " + base + "\r\nContent-Type: application/sdp\r\n", sdp);
+    }
+
+    void on_setup(const RtspMessage& req, int cseq) {
+        if (playing_) {
+            reply(cseq, 455, "Method Not Valid in This State");
+            return;
+        }
+        // URL为 <源路径>/<a=control>，单轨道源也接受直接用源路径
+        std::string path = url_path(req.url);
+        std::shared_ptr<RtspMediaSource> source;
+        std::size_t track = 0;
+        std::size_t slash = path.rfind('/');
+        if (slash != std::string::npos) {
+            source = server_->FindSource(path.substr(0, slash));
+            if (source) {
+                std::string control = path.substr(slash + 1);
+                for (track = 0; track < source->track_count(); ++track) {
+                    if (source->track_control(track) == control) {
+                        break;
+                    }
+                }
+                if (track == source->track_count()) {
+                    reply(cseq, 404, "Not Found");
+                    return;
+                }
+            }
+        }
+        if (!source) {
+            source = server_->FindSource(path);
+            track = 0;
+            if (!source || source->track_count() != 1) {
+                reply(cseq, 404, "Not Found");
+                return;
+            }
+        }
+        if (source_ && source_ != source) {
+            reply(cseq, 459, "Aggregate Operation Not Allowed");
+            return;
+        }
+
+        const std::string* transport = req.Header("Transport");
+        if (!transport) {
+            reply(cseq, 461, "Unsupported Transport");
+            return;
+        }
+        // 客户端可能列出多个候选，取第一个能支持的
+        std::string_view all(*transport);
+        bool tcp = false;
+        bool found = false;
+        int a = -1;
+        int b = -1;
+        while (!all.empty() && !found) {
+            std::size_t comma = all.find(',');
+            std::string_view spec = all.substr(0, comma);
+            all = comma == std::string_view::npos ? std::string_view() : all.substr(comma + 1);
+            bool multicast = false;
+            bool is_tcp = false;
+            bool is_rtp = false;
+            int x = -1;
+            int y = -1;
+            while (!spec.empty()) {
+                std::size_t semi = spec.find(';');
+                std::string_view param = StringHelper::trim(spec.substr(0, semi));
+                spec = semi == std::string_view::npos ? std::string_view() : spec.substr(semi + 1);
+                if (param == "RTP/AVP" || param == "RTP/AVP/UDP") {
+                    is_rtp = true;
+                } else if (param == "RTP/AVP/TCP") {
+                    is_rtp = true;
+                    is_tcp = true;
+                } else if (param == "multicast") {
+                    multicast = true;
+                } else if (param.substr(0, 12) == "interleaved=") {
+                    parse_pair(param.substr(12), x, y);
+                } else if (param.substr(0, 12) == "client_port=") {
+                    parse_pair(param.substr(12), x, y);
+                }
+            }
+            if (!is_rtp || multicast) {
+                continue;
+            }
+            if (is_tcp) {
+                if (x < 0) {
+                    x = static_cast<int>(2 * track);
+                    y = x + 1;
+                }
+                if (x > 255 || y > 255) {
+                    continue;
+                }
+            } else if (x <= 0 || x > 65535 || y > 65535) {
+                continue;
+            }
+            tcp = is_tcp;
+            a = x;
+            b = y;
+            found = true;
+        }
+        if (!found) {
+            reply(cseq, 461, "Unsupported Transport");
+            return;
+        }
+
+        if (!tcp && !server_->EnsureUdp(*source, track)) {
+            reply(cseq, 500, "Internal Server Error");
+            return;
+        }
+        if (!subscriber_) {
+            subscriber_ = std::make_shared<RtspSubscriber>();
+            subscriber_->transport = transport_;
+            subscriber_->owner = shared_from_this();
+            // 源在io线程按来源地址转来UDP观看者的RTCP，拷贝后切回本连接的strand处理
+            subscriber_->rtcp_handler = [weak = weak_from_this()](std::size_t track, const uint8_t* data, std::size_t size) {
+                if (auto self = weak.lock()) {
+                    boost::asio::post(self->socket_.get_executor(),
+                        [self, track, report = std::vector<uint8_t>(data, data + size)]() {
+                            self->on_rtcp(track, report.data(), report.size());
+                        });
+                }
+            };
+        }
+        source_ = source;
+        if (session_id_.empty()) {
+            char id[17];
+            std::snprintf(id, sizeof(id), "%08X%08X", random_u32(), random_u32());
+            session_id_ = id;
+        }
+
+        RtspSubscriber::Sink& sink = subscriber_->sinks[track];
+        sink.enabled = true;
+        sink.interleaved = tcp;
+        RtcpSession::Config rtcp_cfg;
+        rtcp_cfg.ssrc = source->track_ssrc(track);
+        rtcp_[track] = std::make_unique<RtcpSession>(rtcp_cfg);
+        if (!tcp) {
+            // 只在本连接的strand上经on_rtcp回调，rtcp_随会话释放
+            rtcp_[track]->SetNackHandler([this, track](const uint16_t* seqs, std::size_t count) {
+                if (source_ && subscriber_) {
+                    source_->Retransmit(track, subscriber_->sinks[track].rtp_to, seqs, count);
+                }
+            });
+        }
+        char ssrc[9];
+        std::snprintf(ssrc, sizeof(ssrc), "%08X", source->track_ssrc(track));
+        std::string reply_transport;
+        if (tcp) {
+            sink.channel = static_cast<uint8_t>(a);
+            reply_transport = "RTP/AVP/TCP;unicast;interleaved=" + std::to_string(a) + "-" + std::to_string(b);
+        } else {
+            boost::system::error_code ec;
+            auto remote = socket_.remote_endpoint(ec);
+            if (ec) {
+                reply(cseq, 500, "Internal Server Error");
+                return;
+            }
+            // 只发往信令连接的对端地址，忽略destination参数，避免被用作反射放大
+            sink.rtp_to = ASIO::UdpEndpoint(remote.address(), static_cast<uint16_t>(a));
+            sink.rtcp_from = ASIO::UdpEndpoint(remote.address(), static_cast<uint16_t>(b > 0 ? b : a + 1));
+            uint16_t port = source->udp_port(track);
+            reply_transport = "RTP/AVP;unicast;client_port=" + std::to_string(a) + "-" + std::to_string(b)
+                            + ";server_port=" + std::to_string(port) + "-" + std::to_string(port + 1);
+        }
+        reply_transport += std::string(";ssrc=") + ssrc;
+        reply(cseq, 200, "OK", "Transport: " + reply_transport + "\r\n" + session_header());
+    }
+
+    void on_play(const RtspMessage& req, int cseq) {
+        if (!subscriber_ || !source_) {
+            reply(cseq, 455, "Method Not Valid in This State");
+            return;
+        }
+        std::string base = req.url;
+        if (!base.empty() && base.back() == '/') {
+            base.pop_back();
+        }
+        // 单轨道源的SETUP可能直接用源路径，PLAY同样可能带着轨道路径
+        auto reply_play = [&](const RtspMediaSource::TrackPositions& positions) {
+            std::string rtp_info;
+            for (std::size_t i = 0; i < source_->track_count(); ++i) {
+                if (!subscriber_->sinks[i].enabled) {
+                    continue;
+                }
+                if (!rtp_info.empty()) {
+                    rtp_info += ",";
+                }
+                rtp_info += "url=" + base + "/" + source_->track_control(i) + ";seq=" + std::to_string(positions[i].seq)
+                          + ";rtptime=" + std::to_string(positions[i].rtptime);
+            }
+            reply(cseq, 200, "OK", "Range: npt=now-\r\nRTP-Info: " + rtp_info + "\r\n" + session_header());
+        };
+        if (playing_) {
+            RtspMediaSource::TrackPositions positions;
+            for (std::size_t i = 0; i < source_->track_count(); ++i) {
+                source_->track_position(i, positions[i].seq, positions[i].rtptime);
+            }
+            reply_play(positions);
+            return;
+        }
+        transport_->SetKeyframeRequestHandler([weak = std::weak_ptr<RtspMediaSource>(source_)](uint8_t) {
+            if (auto source = weak.lock()) {
+                source->RequestKeyframe();
+            }
+        });
+        // 应答在GOP缓存回放之前入队，RTP-Info的序号是回放的第一个包
+        source_->AddSubscriber(subscriber_, reply_play);
+        playing_ = true;
+    }
+
+    std::string session_header() const {
+        if (session_id_.empty()) {
+            return std::string();
+        }
+        return "Session: " + session_id_ + ";timeout=" + std::to_string(server_->config().session_timeout_s) + "\r\n";
+    }
+
+    void reply(int cseq, int status, const char* reason, const std::string& headers = std::string(),
+               const std::string& body = std::string()) {
+        std::string text = "RTSP/1.0 " + std::to_string(status) + " " + reason + "\r\n";
+        if (cseq >= 0) {
+            text += "CSeq: " + std::to_string(cseq) + "\r\n";
+        }
+        text += headers;
+        if (!body.empty()) {
+            text += "Content-Length: " + std::to_string(body.size()) + "\r\n";
+        }
+        text += "\r\n";
+        text += body;
+        transport_->SendControl(std::move(text));
+    }
+
+    /// @brief 从源上摘除并清空会话状态，连接保留
+    void teardown() {
+        if (source_ && subscriber_) {
+            source_->RemoveSubscriber(subscriber_.get());
+        }
+        subscriber_.reset();
+        source_.reset();
+        session_id_.clear();
+        playing_ = false;
+        for (auto& rtcp : rtcp_) {
+            rtcp.reset();
+        }
+    }
+
+    /// @brief 观看者的RTCP（UDP经源转来，或interleaved通道）：保活，并交给该轨道的RTCP会话
+    void on_rtcp(std::size_t track, const uint8_t* data, std::size_t size) {
+        if (closed_) {
+            return;
+        }
+        last_active_ = std::chrono::steady_clock::now();
+        if (track < rtcp_.size() && rtcp_[track]) {
+            rtcp_[track]->OnRtcpReceived(data, size, net::AsioTimerWheel::now_ms());
+        }
+    }
+
+    /// @brief 在时间轮上挂一个到期检查；收到请求时只更新last_active_，到期时再按剩余时间重挂，
+    /// 保活请求不产生任何定时器操作
+    void arm_timer(int64_t delay_ms) {
+        timer_id_ = server_->timers().Schedule(delay_ms, [weak = weak_from_this()]() {
+            if (auto self = weak.lock()) {
+                boost::asio::post(self->socket_.get_executor(), [self]() {
+                    self->on_timer();
+                });
+            }
+        });
+    }
+
+    void on_timer() {
+        if (closed_) {
+            return;
+        }
+        const auto timeout = std::chrono::seconds(std::max(1, server_->config().session_timeout_s));
+        // interleaved播放时媒体在同一连接上，连接本身即保活；其余情况要求周期性的RTSP请求或RTCP
+        bool tcp_playing = false;
+        if (playing_) {
+            for (const auto& sink : subscriber_->sinks) {
+                tcp_playing = tcp_playing || (sink.enabled && sink.interleaved);
+            }
+        }
+        auto idle = std::chrono::steady_clock::now() - last_active_;
+        if (!tcp_playing && idle >= timeout) {
+            close();
+            return;
+        }
+        auto remaining = tcp_playing ? timeout : timeout - idle;
+        arm_timer(std::chrono::duration_cast<std::chrono::milliseconds>(remaining).count() + 1);
+    }
+
+    void close() {
+        if (closed_) {
+            return;
+        }
+        closed_ = true;
+        teardown();
+        server_->timers().Cancel(timer_id_);
+        transport_->SetErrorHandler(nullptr);
+        transport_->Close();
+    }
+
+    ASIO::TcpSocket socket_;
+    std::shared_ptr<RtspServer> server_;
+    net::AsioTimerWheel::TimerId timer_id_ = 0;
+    std::shared_ptr<RtspInterleavedTransport> transport_;
+    std::vector<char> buf_;
+    std::size_t used_ = 0;
+
+    std::string session_id_;
+    std::shared_ptr<RtspMediaSource> source_;
+    /// @brief SETUP时建立，PLAY时挂到源上
+    std::shared_ptr<RtspSubscriber> subscriber_;
+    bool playing_ = false;
+    bool closed_ = false;
+    std::chrono::steady_clock::time_point last_active_;
+    /// @brief 每个SETUP过的轨道一个RTCP会话，接收观看者的RR/NACK
+    std::array<std::unique_ptr<RtcpSession>, RTSP_MAX_TRACKS> rtcp_;
+};
+
+// ---------------------------------------------------------------- RtspServer
+
+RtspServer::RtspServer(ASIO::IoContext& io, const Config& cfg)
+    : io_(io), cfg_(cfg), acceptor_(io, ASIO::TcpEndpoint(boost::asio::ip::tcp::v4(), cfg.port)),
+      timers_(std::make_shared<net::AsioTimerWheel>(io, TimerWheel::Config{kTimerTickMs})),
+      next_port_(static_cast<uint16_t>(cfg.rtp_port_min & ~1u)) {
+    if (cfg_.pace_udp) {
+        pacer_ = std::make_shared<RtpPacer>(cfg_.pacer);
+    }
+}
+
+RtspServer::~RtspServer() {
+    boost::system::error_code ec;
+    acceptor_.close(ec);
+}
+
+void RtspServer::Start() {
+    if (pacer_) {
+        pacer_->Start();
+    }
+    do_accept();
+}
+
+void RtspServer::Stop() {
+    boost::system::error_code ec;
+    acceptor_.close(ec);
+    std::vector<std::weak_ptr<RtspServerSession>> sessions;
+    std::vector<std::shared_ptr<RtspMediaSource>> sources;
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        sessions.swap(sessions_);
+        for (auto& kv : sources_) {
+            sources.push_back(kv.second);
+        }
+    }
+    for (auto& weak : sessions) {
+        if (auto session = weak.lock()) {
+            session->Close();
+        }
+    }
+    // 源仍保持注册，只释放其UDP端口，否则挂着的接收会让io_context无法退出
+    for (auto& source : sources) {
+        source->Close();
+    }
+    if (pacer_) {
+        pacer_->Stop();
+    }
+    timers_->Stop();
+}
+
+void RtspServer::do_accept() {
+    acceptor_.async_accept(boost::asio::make_strand(io_),
+        [self = shared_from_this()](const boost::system::error_code& ec, ASIO::TcpSocket socket) {
+            if (!self->acceptor_.is_open()) {
+                return;
+            }
+            if (!ec) {
+                boost::system::error_code opt_ec;
+                socket.set_option(boost::asio::ip::tcp::no_delay(true), opt_ec);
+                auto session = std::make_shared<RtspServerSession>(std::move(socket), self);
+                {
+                    std::lock_guard<std::mutex> lock(self->mtx_);
+                    std::erase_if(self->sessions_, [](const auto& w) { return w.expired(); });
+                    self->sessions_.push_back(session);
+                }
+                session->Start();
+            }
+            self->do_accept();
+        });
+}
+
+std::shared_ptr<RtspMediaSource> RtspServer::AddSource(const std::string& path, const RtspMediaSource::Config& cfg) {
+    std::string key = url_path("/" + path);
+    std::lock_guard<std::mutex> lock(mtx_);
+    if (sources_.count(key)) {
+        return nullptr;
+    }
+    RtspMediaSource::Config source_cfg = cfg;
+    if (!source_cfg.pacer) {
+        source_cfg.pacer = pacer_;
+    }
+    auto source = std::make_shared<RtspMediaSource>(source_cfg);
+    sources_.emplace(key, source);
+    return source;
+}
+
+void RtspServer::RemoveSource(const std::string& path) {
+    std::shared_ptr<RtspMediaSource> source;
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        auto it = sources_.find(url_path("/" + path));
+        if (it == sources_.end()) {
+            return;
+        }
+        source = std::move(it->second);
+        sources_.erase(it);
+    }
+    source->Close();
+}
+
+std::shared_ptr<RtspMediaSource> RtspServer::FindSource(const std::string& path) const {
+    std::lock_guard<std::mutex> lock(mtx_);
+    auto it = sources_.find(path);
+    return it == sources_.end() ? nullptr : it->second;
+}
+
+bool RtspServer::EnsureUdp(RtspMediaSource& source, std::size_t track) {
+    if (source.has_udp(track)) {
+        return true;
+    }
+    std::lock_guard<std::mutex> lock(mtx_);
+    if (source.has_udp(track)) {
+        return true;
+    }
+    // 只发不收的RTP socket不需要大接收slab
+    net::UdpBatchSocket::Config rtp_cfg;
+    rtp_cfg.batch = 64;
+    rtp_cfg.datagram_size = 256;
+    net::UdpBatchSocket::Config rtcp_cfg;
+    rtcp_cfg.batch = 8;
+    rtcp_cfg.datagram_size = 1500;
+    rtcp_cfg.enable_gso = false;
+
+    const uint16_t first = static_cast<uint16_t>(cfg_.rtp_port_min & ~1u);
+    const std::size_t pairs = cfg_.rtp_port_max > first ? (cfg_.rtp_port_max - first) / 2 : 0;
+    for (std::size_t i = 0; i < pairs; ++i) {
+        uint16_t port = next_port_;
+        next_port_ = static_cast<uint16_t>(port + 2);
+        if (next_port_ + 1 >= cfg_.rtp_port_max || next_port_ < first) {
+            next_port_ = first;
+        }
+        try {
+            auto rtp = std::make_unique<net::UdpBatchSocket>(io_, ASIO::UdpEndpoint(boost::asio::ip::udp::v4(), port), rtp_cfg);
+            auto rtcp = std::make_unique<net::UdpBatchSocket>(io_, ASIO::UdpEndpoint(boost::asio::ip::udp::v4(), port + 1), rtcp_cfg);
+            return source.AttachUdp(track, std::move(rtp), std::move(rtcp));
+        } catch (const boost::system::system_error&) {
+            // 端口被占用，试下一对
+        }
+    }
+    return false;
+}
+
+uint16_t RtspServer::port() const {
+    boost::system::error_code ec;
+    return acceptor_.local_endpoint(ec).port();
+}
@@ -0,0 +1,287 @@
+#include "sdp.h"
+#include <charconv>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <strings.h>
+#include "rtp_packetizer.h"
+
+namespace {
+    const char kBase64Table[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+    int base64_value(char c) noexcept {
+        if (c >= 'A' && c <= 'Z') return c - 'A';
+        if (c >= 'a' && c <= 'z') return c - 'a' + 26;
+        if (c >= '0' && c <= '9') return c - '0' + 52;
+        if (c == '+') return 62;
+        if (c == '/') return 63;
+        return -1;
+    }
+
+    SdpCodec codec_from_name(std::string_view name) noexcept {
+        auto is = [name](const char* s) {
+            return name.size() == std::strlen(s) && ::strncasecmp(name.data(), s, name.size()) == 0;
+        };
+        if (is("H264")) return SdpCodec::H264;
+        if (is("H265") || is("HEVC")) return SdpCodec::H265;
+        if (is("PCMA")) return SdpCodec::PCMA;
+        if (is("PCMU")) return SdpCodec::PCMU;
+        return SdpCodec::Unknown;
+    }
+
+    /// @brief 取出"<pt> <rest>"中的负载类型，不匹配当前轨道时返回false
+    bool strip_payload_type(std::string_view& v, uint8_t pt) {
+        std::size_t sp = v.find(' ');
+        if (sp == std::string_view::npos) {
+            return false;
+        }
+        int value = -1;
+        std::from_chars(v.data(), v.data() + sp, value);
+        v.remove_prefix(sp + 1);
+        return value == pt;
+    }
+
+    void parse_fmtp(std::string_view v, SdpTrack& track) {
+        while (!v.empty()) {
+            std::size_t semi = v.find(';');
+            std::string_view param = v.substr(0, semi);
+            v = semi == std::string_view::npos ? std::string_view() : v.substr(semi + 1);
+            while (!param.empty() && param.front() == ' ') {
+                param.remove_prefix(1);
+            }
+            std::size_t eq = param.find('=');
+            if (eq == std::string_view::npos) {
+                continue;
+            }
+            std::string_view key = param.substr(0, eq);
+            std::string_view value = param.substr(eq + 1);
+            if (key == "sprop-parameter-sets") {
+                std::size_t comma = value.find(',');
+                Sdp::Base64Decode(value.substr(0, comma), track.sps);
+                if (comma != std::string_view::npos) {
+                    Sdp::Base64Decode(value.substr(comma + 1), track.pps);
+                }
+            } else if (key == "sprop-vps") {
+                Sdp::Base64Decode(value, track.vps);
+            } else if (key == "sprop-sps") {
+                Sdp::Base64Decode(value, track.sps);
+            } else if (key == "sprop-pps") {
+                Sdp::Base64Decode(value, track.pps);
+            }
+        }
+    }
+}
+
+namespace Sdp {
+
+const char* CodecName(SdpCodec codec) noexcept {
+    switch (codec) {
+    case SdpCodec::H264: return "H264";
+    case SdpCodec::H265: return "H265";
+    case SdpCodec::PCMA: return "PCMA";
+    case SdpCodec::PCMU: return "PCMU";
+    default: return "";
+    }
+}
+
+std::string Base64Encode(const void* data, std::size_t size) {
+    const uint8_t* p = static_cast<const uint8_t*>(data);
+    std::string out;
+    out.reserve((size + 2) / 3 * 4);
+    std::size_t i = 0;
+    for (; i + 3 <= size; i += 3) {
+        uint32_t v = (static_cast<uint32_t>(p[i]) << 16) | (static_cast<uint32_t>(p[i + 1]) << 8) | p[i + 2];
+        out.push_back(kBase64Table[(v >> 18) & 0x3F]);
+        out.push_back(kBase64Table[(v >> 12) & 0x3F]);
+        out.push_back(kBase64Table[(v >> 6) & 0x3F]);
+        out.push_back(kBase64Table[v & 0x3F]);
+    }
+    if (i < size) {
+        uint32_t v = static_cast<uint32_t>(p[i]) << 16;
+        if (i + 1 < size) {
+            v |= static_cast<uint32_t>(p[i + 1]) << 8;
+        }
+        out.push_back(kBase64Table[(v >> 18) & 0x3F]);
+        out.push_back(kBase64Table[(v >> 12) & 0x3F]);
+        out.push_back(i + 1 < size ? kBase64Table[(v >> 6) & 0x3F] : '=');
+        out.push_back('=');
+    }
+    return out;
+}
+
+bool Base64Decode(std::string_view in, std::string& out) {
+    out.clear();
+    while (!in.empty() && in.back() == '=') {
+        in.remove_suffix(1);
+    }
+    uint32_t acc = 0;
+    int bits = 0;
+    for (char c : in) {
+        int v = base64_value(c);
+        if (v < 0) {
+            return false;
+        }
+        acc = (acc << 6) | static_cast<uint32_t>(v);
+        bits += 6;
+        if (bits >= 8) {
+            bits -= 8;
+            out.push_back(static_cast<char>((acc >> bits) & 0xFF));
+        }
+    }
+    return true;
+}
+
+bool ExtractParameterSets(const uint8_t* data, std::size_t size, SdpTrack& track) {
+    std::vector<NalUnitView> nalus;
+    NaluHelper::SplitAnnexB(data, size, nalus);
+    bool found = false;
+    for (const NalUnitView& nal : nalus) {
+        if (nal.size == 0) {
+            continue;
+        }
+        std::string* dst = nullptr;
+        if (track.codec == SdpCodec::H264) {
+            uint8_t type = nal.data[0] & 0x1F;
+            dst = type == 7 ? &track.sps : type == 8 ? &track.pps : nullptr;
+        } else if (track.codec == SdpCodec::H265) {
+            uint8_t type = H265RtpPacketizer::NalType(nal.data);
+            dst = type == 32 ? &track.vps : type == 33 ? &track.sps : type == 34 ? &track.pps : nullptr;
+        }
+        if (dst) {
+            dst->assign(reinterpret_cast<const char*>(nal.data), nal.size);
+            found = true;
+        }
+    }
+    return found;
+}
+
+bool HasParameterSets(const SdpTrack& track) noexcept {
+    if (track.sps.empty() || track.pps.empty()) {
+        return false;
+    }
+    return track.codec != SdpCodec::H265 || !track.vps.empty();
+}
+
+std::string Fmtp(const SdpTrack& track) {
+    std::string fmtp;
+    if (track.codec == SdpCodec::H264) {
+        fmtp = "packetization-mode=1";
+        if (track.sps.size() >= 4) {
+            char profile[8];
+            std::snprintf(profile, sizeof(profile), "%02X%02X%02X", static_cast<uint8_t>(track.sps[1]),
+                          static_cast<uint8_t>(track.sps[2]), static_cast<uint8_t>(track.sps[3]));
+            fmtp += ";profile-level-id=";
+            fmtp += profile;
+        }
+        if (!track.sps.empty() && !track.pps.empty()) {
+            fmtp += ";sprop-parameter-sets=" + Base64Encode(track.sps.data(), track.sps.size())
+                  + "," + Base64Encode(track.pps.data(), track.pps.size());
+        }
+    } else if (track.codec == SdpCodec::H265) {
+        if (!track.vps.empty() && !track.sps.empty() && !track.pps.empty()) {
+            fmtp = "sprop-vps=" + Base64Encode(track.vps.data(), track.vps.size())
+                 + ";sprop-sps=" + Base64Encode(track.sps.data(), track.sps.size())
+                 + ";sprop-pps=" + Base64Encode(track.pps.data(), track.pps.size());
+        }
+    }
+    return fmtp;
+}
+
+std::string Generate(const std::string& session_name, const std::string& origin_ip, const std::vector<SdpTrack>& tracks) {
+    auto sess_id = std::chrono::duration_cast<std::chrono::seconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+    std::string sdp;
+    sdp.reserve(512);
+    sdp += "v=0\r\n";
+    sdp += "o=- " + std::to_string(sess_id) + " 1 IN IP4 " + origin_ip + "\r\n";
+    sdp += "s=" + (session_name.empty() ? std::string("-") : session_name) + "\r\n";
+    sdp += "c=IN IP4 0.0.0.0\r\n";
+    sdp += "t=0 0\r\n";
+    sdp += "a=range:npt=now-\r\n";
+    sdp += "a=control:*\r\n";
+    for (const SdpTrack& t : tracks) {
+        std::string pt = std::to_string(t.payload_type);
+        sdp += std::string("m=") + (t.video ? "video" : "audio") + " 0 RTP/AVP " + pt + "\r\n";
+        sdp += "a=rtpmap:" + pt + " " + CodecName(t.codec) + "/" + std::to_string(t.clock_rate);
+        if (!t.video && t.channels > 1) {
+            sdp += "/" + std::to_string(t.channels);
+        }
+        sdp += "\r\n";
+        std::string fmtp = Fmtp(t);
+        if (!fmtp.empty()) {
+            sdp += "a=fmtp:" + pt + " " + fmtp + "\r\n";
+        }
+        sdp += "a=control:" + t.control + "\r\n";
+    }
+    return sdp;
+}
+
+bool Parse(std::string_view sdp, std::vector<SdpTrack>& tracks) {
+    tracks.clear();
+    while (!sdp.empty()) {
+        std::size_t eol = sdp.find('\n');
+        std::string_view line = sdp.substr(0, eol);
+        sdp = eol == std::string_view::npos ? std::string_view() : sdp.substr(eol + 1);
+        if (!line.empty() && line.back() == '\r') {
+            line.remove_suffix(1);
+        }
+        if (line.size() < 2 || line[1] != '=') {
+            continue;
+        }
+        std::string_view value = line.substr(2);
+        if (line[0] == 'm') {
+            // m=<media> <port> <proto> <fmt> ...
+            SdpTrack& t = tracks.emplace_back();
+            t.video = value.substr(0, 5) == "video";
+            // m=行可能列出多个格式，这里取第一个
+            int pt = 0;
+            std::size_t proto_end = value.find(' ');
+            for (int i = 0; i < 2 && proto_end != std::string_view::npos; ++i) {
+                proto_end = value.find(' ', proto_end + 1);
+            }
+            if (proto_end != std::string_view::npos) {
+                std::from_chars(value.data() + proto_end + 1, value.data() + value.size(), pt);
+            }
+            t.payload_type = static_cast<uint8_t>(pt);
+            t.clock_rate = t.video ? 90000 : 8000;
+            // 静态负载类型可以不带rtpmap
+            if (!t.video && pt == 0) {
+                t.codec = SdpCodec::PCMU;
+            } else if (!t.video && pt == 8) {
+                t.codec = SdpCodec::PCMA;
+            }
+            continue;
+        }
+        if (line[0] != 'a' || tracks.empty()) {
+            continue;
+        }
+        SdpTrack& t = tracks.back();
+        if (value.substr(0, 7) == "rtpmap:") {
+            value.remove_prefix(7);
+            if (!strip_payload_type(value, t.payload_type)) {
+                continue;
+            }
+            // <encoding>/<clock>[/<channels>]
+            std::size_t slash = value.find('/');
+            t.codec = codec_from_name(value.substr(0, slash));
+            if (slash != std::string_view::npos) {
+                std::string_view rest = value.substr(slash + 1);
+                std::size_t slash2 = rest.find('/');
+                std::from_chars(rest.data(), rest.data() + (slash2 == std::string_view::npos ? rest.size() : slash2), t.clock_rate);
+                if (slash2 != std::string_view::npos) {
+                    std::from_chars(rest.data() + slash2 + 1, rest.data() + rest.size(), t.channels);
+                }
+            }
+        } else if (value.substr(0, 5) == "fmtp:") {
+            value.remove_prefix(5);
+            if (strip_payload_type(value, t.payload_type)) {
+                parse_fmtp(value, t);
+            }
+        } else if (value.substr(0, 8) == "control:") {
+            t.control = std::string(value.substr(8));
+        }
+    }
+    return !tracks.empty();
+}
+
+}
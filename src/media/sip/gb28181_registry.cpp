@@ -0,0 +1,490 @@
+#include "sip/gb28181_registry.h"
+#include <algorithm>
+#include <cstdio>
+#include <ctime>
+
+namespace {
+
+/// @brief GB28181设备编码是20位数字，留些余量给非标设备
+constexpr std::size_t kMaxDeviceId = 48;
+
+std::size_t thread_slot() {
+    static std::atomic<std::size_t> next{0};
+    thread_local std::size_t slot = next.fetch_add(1, std::memory_order_relaxed);
+    return slot;
+}
+
+bool parse_uint(StringView s, uint32_t& out) {
+    while (!s.empty() && (s.front() == ' ' || s.front() == '\t')) {
+        s.remove_prefix(1);
+    }
+    if (s.empty()) {
+        return false;
+    }
+    uint64_t v = 0;
+    std::size_t i = 0;
+    for (; i < s.size() && s[i] >= '0' && s[i] <= '9'; ++i) {
+        v = v * 10 + static_cast<uint64_t>(s[i] - '0');
+        if (v > 0xFFFFFFFFull) {
+            return false;
+        }
+    }
+    if (i == 0) {
+        return false;
+    }
+    out = static_cast<uint32_t>(v);
+    return true;
+}
+
+/// @brief GB/T 28181 9.10.2校时用的Date格式，同一秒内各线程复用上次的结果
+StringView date_now() {
+    thread_local std::time_t cached_sec = 0;
+    thread_local char cached[64] = {0};
+    std::time_t now = std::time(nullptr);
+    if (now != cached_sec) {
+        std::tm tm{};
+        localtime_r(&now, &tm);
+        std::snprintf(cached, sizeof(cached), "%04d-%02d-%02dT%02d:%02d:%02d.000",
+                      tm.tm_year + 1900, tm.tm_mon + 1, tm.tm_mday, tm.tm_hour, tm.tm_min, tm.tm_sec);
+        cached_sec = now;
+    }
+    return StringView(cached);
+}
+
+}
+
+struct GbDeviceRegistry::Device {
+    std::string id;
+    SipTransport::Peer peer;
+    int64_t registered_ms = 0;
+    int64_t expires_at_ms = 0;
+    int64_t last_keepalive_ms = 0;
+    net::AsioTimerWheel::TimerId timer = 0;
+};
+
+struct GbDeviceRegistry::Shard {
+    mutable std::mutex mtx;
+    Table table;
+};
+
+/// @brief 一条心跳，定长以便批次缓冲复用时不分配
+struct GbDeviceRegistry::Keepalive {
+    char id[kMaxDeviceId];
+    uint8_t length = 0;
+    uint32_t shard = 0;
+    int64_t at_ms = 0;
+    SipTransport::Peer peer;
+
+    StringView device_id() const noexcept { return StringView(id, length); }
+};
+
+struct GbDeviceRegistry::Reactor {
+    std::mutex mtx;
+    std::vector<Keepalive> pending;
+    /// @brief 串行化合并，合并在锁外进行，期间新的心跳继续记到pending
+    std::mutex flush_mtx;
+    std::vector<Keepalive> work;
+};
+
+GbDeviceRegistry::GbDeviceRegistry(std::shared_ptr<SipTransactionLayer> layer,
+                                   std::shared_ptr<net::AsioTimerWheel> timers)
+    : GbDeviceRegistry(std::move(layer), std::move(timers), Config{}) {
+
+}
+
+GbDeviceRegistry::GbDeviceRegistry(std::shared_ptr<SipTransactionLayer> layer,
+                                   std::shared_ptr<net::AsioTimerWheel> timers, const Config& cfg)
+    : layer_(std::move(layer)), timers_(std::move(timers)), cfg_(cfg) {
+    std::size_t n = 1;
+    while (n < cfg_.shards) {
+        n <<= 1;
+    }
+    shards_.reserve(n);
+    for (std::size_t i = 0; i < n; ++i) {
+        shards_.push_back(std::make_unique<Shard>());
+        if (cfg_.expected_devices) {
+            shards_.back()->table.reserve(cfg_.expected_devices / n + 1);
+        }
+    }
+    shard_mask_ = n - 1;
+
+    n = 1;
+    while (n < cfg_.reactors) {
+        n <<= 1;
+    }
+    reactors_.reserve(n);
+    for (std::size_t i = 0; i < n; ++i) {
+        reactors_.push_back(std::make_unique<Reactor>());
+        reactors_.back()->pending.reserve(cfg_.batch_size);
+        reactors_.back()->work.reserve(cfg_.batch_size);
+    }
+    reactor_mask_ = n - 1;
+    tag_ = SipTransactionLayer::NewBranch().substr(7, 10);
+}
+
+GbDeviceRegistry::~GbDeviceRegistry() {
+    Stop();
+}
+
+void GbDeviceRegistry::Start() {
+    std::lock_guard<std::mutex> lock(flush_timer_mtx_);
+    if (stopped_.load() || flush_timer_) {
+        return;
+    }
+    flush_timer_ = timers_->Schedule(cfg_.flush_interval_ms, [weak = weak_from_this()]() {
+        if (auto self = weak.lock()) {
+            self->on_flush_timer();
+        }
+    });
+}
+
+void GbDeviceRegistry::Stop() {
+    if (stopped_.exchange(true)) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(flush_timer_mtx_);
+        timers_->Cancel(flush_timer_);
+        flush_timer_ = 0;
+    }
+    for (auto& shard : shards_) {
+        std::lock_guard<std::mutex> lock(shard->mtx);
+        for (auto& kv : shard->table) {
+            disarm(*kv.second);
+        }
+        devices_.fetch_sub(shard->table.size(), std::memory_order_relaxed);
+        shard->table.clear();
+    }
+}
+
+void GbDeviceRegistry::on_flush_timer() {
+    Flush();
+    std::lock_guard<std::mutex> lock(flush_timer_mtx_);
+    if (stopped_.load()) {
+        return;
+    }
+    flush_timer_ = timers_->Schedule(cfg_.flush_interval_ms, [weak = weak_from_this()]() {
+        if (auto self = weak.lock()) {
+            self->on_flush_timer();
+        }
+    });
+}
+
+GbDeviceRegistry::Stats GbDeviceRegistry::stats() const {
+    Stats s;
+    s.registered = registered_.load(std::memory_order_relaxed);
+    s.refreshed = refreshed_.load(std::memory_order_relaxed);
+    s.unregistered = unregistered_.load(std::memory_order_relaxed);
+    s.expired = expired_.load(std::memory_order_relaxed);
+    s.offline = offline_.load(std::memory_order_relaxed);
+    s.keepalives = keepalives_.load(std::memory_order_relaxed);
+    s.unknown_keepalives = unknown_keepalives_.load(std::memory_order_relaxed);
+    s.batches = batches_.load(std::memory_order_relaxed);
+    return s;
+}
+
+StringView GbDeviceRegistry::DeviceId(const SipMessageView& msg) noexcept {
+    StringView from = msg.header(SipHeaderId::From);
+    std::size_t pos = from.find("sip:");
+    if (pos == StringView::npos) {
+        return StringView();
+    }
+    from.remove_prefix(pos + 4);
+    std::size_t end = from.find_first_of("@;>: ");
+    return from.substr(0, end);
+}
+
+bool GbDeviceRegistry::IsKeepalive(const SipMessageView& msg) noexcept {
+    StringView body = msg.body();
+    std::size_t pos = body.find("<CmdType>");
+    if (pos == StringView::npos) {
+        return false;
+    }
+    body.remove_prefix(pos + 9);
+    while (!body.empty() && (body.front() == ' ' || body.front() == '\t' || body.front() == '\r' || body.front() == '\n')) {
+        body.remove_prefix(1);
+    }
+    return body.substr(0, 9) == "Keepalive";
+}
+
+bool GbDeviceRegistry::HandleRequest(const SipMessageView& request) {
+    if (request.method() == "REGISTER") {
+        on_register(request);
+        return true;
+    }
+    if (request.method() == "MESSAGE" && IsKeepalive(request)) {
+        on_keepalive(request);
+        return true;
+    }
+    return false;
+}
+
+std::size_t GbDeviceRegistry::shard_index(StringView device_id) const noexcept {
+    return IdHash()(device_id) & shard_mask_;
+}
+
+bool GbDeviceRegistry::Find(StringView device_id, DeviceInfo& out) const {
+    const Shard& shard = *shards_[shard_index(device_id)];
+    std::lock_guard<std::mutex> lock(shard.mtx);
+    auto it = shard.table.find(device_id);
+    if (it == shard.table.end()) {
+        return false;
+    }
+    const Device& d = *it->second;
+    out.id = d.id;
+    out.peer = d.peer;
+    out.registered_ms = d.registered_ms;
+    out.expires_at_ms = d.expires_at_ms;
+    out.last_keepalive_ms = d.last_keepalive_ms;
+    return true;
+}
+
+bool GbDeviceRegistry::Contains(StringView device_id) const {
+    const Shard& shard = *shards_[shard_index(device_id)];
+    std::lock_guard<std::mutex> lock(shard.mtx);
+    return shard.table.find(device_id) != shard.table.end();
+}
+
+void GbDeviceRegistry::on_register(const SipMessageView& request) {
+    StringView id = DeviceId(request);
+    if (id.empty() || id.size() > kMaxDeviceId) {
+        layer_->Respond(request, 400, "Bad Request");
+        return;
+    }
+    uint32_t expires = cfg_.default_expires;
+    if (!parse_uint(request.header(SipHeaderId::Expires), expires)) {
+        StringView contact = request.header(SipHeaderId::Contact);
+        if (!parse_uint(SipMessageView::Param(SipMessageView::NextListValue(contact), "expires"), expires)) {
+            expires = cfg_.default_expires;
+        }
+    }
+    char number[16];
+    if (expires != 0 && expires < cfg_.min_expires) {
+        int n = std::snprintf(number, sizeof(number), "%u", cfg_.min_expires);
+        SipHeaderField min_expires;
+        min_expires.name = "Min-Expires";
+        min_expires.value = StringView(number, static_cast<std::size_t>(n));
+        SipResponseOptions opts;
+        opts.to_tag = tag_;
+        opts.extra_headers = &min_expires;
+        opts.extra_count = 1;
+        layer_->Respond(request, 423, "Interval Too Brief", opts);
+        return;
+    }
+    expires = std::min(expires, cfg_.max_expires);
+
+    const int64_t now = net::AsioTimerWheel::now_ms();
+    const std::size_t index = shard_index(id);
+    Shard& shard = *shards_[index];
+    bool added = false;
+    bool removed = false;
+    std::string removed_id;
+    {
+        std::lock_guard<std::mutex> lock(shard.mtx);
+        auto it = shard.table.find(id);
+        if (expires == 0) {
+            if (it != shard.table.end()) {
+                disarm(*it->second);
+                removed_id = std::move(it->second->id);
+                shard.table.erase(it);
+                devices_.fetch_sub(1, std::memory_order_relaxed);
+                removed = true;
+            }
+        } else {
+            std::shared_ptr<Device> device;
+            if (it != shard.table.end()) {
+                device = it->second;
+                refreshed_.fetch_add(1, std::memory_order_relaxed);
+            } else {
+                device = std::make_shared<Device>();
+                device->id.assign(id.data(), id.size());
+                device->registered_ms = now;
+                shard.table.emplace(device->id, device);
+                devices_.fetch_add(1, std::memory_order_relaxed);
+                added = true;
+            }
+            device->peer = request.peer();
+            device->expires_at_ms = now + static_cast<int64_t>(expires) * 1000;
+            // 注册本身也说明设备在线
+            device->last_keepalive_ms = now;
+            arm(index, device, now);
+        }
+    }
+
+    int n = std::snprintf(number, sizeof(number), "%u", expires);
+    SipHeaderField extra[2];
+    extra[0].name = "Expires";
+    extra[0].value = StringView(number, static_cast<std::size_t>(n));
+    extra[1].name = "Date";
+    extra[1].value = date_now();
+    SipResponseOptions opts;
+    opts.to_tag = tag_;
+    opts.extra_headers = extra;
+    opts.extra_count = 2;
+    layer_->Respond(request, 200, "OK", opts);
+
+    if (added) {
+        registered_.fetch_add(1, std::memory_order_relaxed);
+        notify(Event::Registered, std::string(id));
+    } else if (removed) {
+        unregistered_.fetch_add(1, std::memory_order_relaxed);
+        notify(Event::Unregistered, removed_id);
+    }
+}
+
+void GbDeviceRegistry::on_keepalive(const SipMessageView& request) {
+    StringView id = DeviceId(request);
+    if (id.empty() || id.size() > kMaxDeviceId) {
+        layer_->Respond(request, 400, "Bad Request");
+        return;
+    }
+    // 未注册设备不能回200，否则它认为心跳正常、不会重新注册；查找只占分片锁一下，更新仍走批次
+    if (!Contains(id)) {
+        layer_->Respond(request, 403, "Forbidden");
+        keepalives_.fetch_add(1, std::memory_order_relaxed);
+        unknown_keepalives_.fetch_add(1, std::memory_order_relaxed);
+        notify(Event::UnknownKeepalive, std::string(id));
+        return;
+    }
+    layer_->Respond(request, 200, "OK");
+
+    Reactor& reactor = *reactors_[thread_slot() & reactor_mask_];
+    bool full = false;
+    {
+        std::lock_guard<std::mutex> lock(reactor.mtx);
+        reactor.pending.emplace_back();
+        Keepalive& k = reactor.pending.back();
+        std::copy(id.begin(), id.end(), k.id);
+        k.length = static_cast<uint8_t>(id.size());
+        k.shard = static_cast<uint32_t>(shard_index(id));
+        k.at_ms = net::AsioTimerWheel::now_ms();
+        k.peer = request.peer();
+        full = reactor.pending.size() >= cfg_.batch_size;
+    }
+    if (full) {
+        flush(reactor);
+    }
+}
+
+void GbDeviceRegistry::Flush() {
+    for (auto& reactor : reactors_) {
+        flush(*reactor);
+    }
+}
+
+void GbDeviceRegistry::flush(Reactor& reactor) {
+    std::lock_guard<std::mutex> flush_lock(reactor.flush_mtx);
+    {
+        std::lock_guard<std::mutex> lock(reactor.mtx);
+        if (reactor.pending.empty()) {
+            return;
+        }
+        reactor.pending.swap(reactor.work);
+    }
+    apply(reactor.work);
+    reactor.work.clear();
+}
+
+void GbDeviceRegistry::apply(std::vector<Keepalive>& batch) {
+    // 按分片排序，同一分片的心跳一次加锁处理完；同一分片内保持到达顺序
+    std::stable_sort(batch.begin(), batch.end(),
+                     [](const Keepalive& a, const Keepalive& b) { return a.shard < b.shard; });
+    std::vector<std::string> unknown;
+    std::size_t i = 0;
+    while (i < batch.size()) {
+        Shard& shard = *shards_[batch[i].shard];
+        std::lock_guard<std::mutex> lock(shard.mtx);
+        const uint32_t index = batch[i].shard;
+        for (; i < batch.size() && batch[i].shard == index; ++i) {
+            const Keepalive& k = batch[i];
+            auto it = shard.table.find(k.device_id());
+            if (it == shard.table.end()) {
+                unknown.emplace_back(k.device_id());
+                continue;
+            }
+            Device& device = *it->second;
+            if (k.at_ms >= device.last_keepalive_ms) {
+                device.last_keepalive_ms = k.at_ms;
+                device.peer = k.peer;
+            }
+        }
+    }
+    batches_.fetch_add(1, std::memory_order_relaxed);
+    keepalives_.fetch_add(batch.size(), std::memory_order_relaxed);
+    unknown_keepalives_.fetch_add(unknown.size(), std::memory_order_relaxed);
+    for (const auto& id : unknown) {
+        notify(Event::UnknownKeepalive, id);
+    }
+}
+
+void GbDeviceRegistry::arm(std::size_t shard, const std::shared_ptr<Device>& device, int64_t now_ms) {
+    int64_t deadline = device->expires_at_ms;
+    if (cfg_.keepalive_interval && cfg_.keepalive_timeout_count) {
+        deadline = std::min(deadline, device->last_keepalive_ms +
+            static_cast<int64_t>(cfg_.keepalive_interval) * cfg_.keepalive_timeout_count * 1000);
+    }
+    const int64_t delay = std::max<int64_t>(deadline - now_ms, 0);
+    if (device->timer && timers_->Reschedule(device->timer, delay)) {
+        return;
+    }
+    device->timer = timers_->Schedule(delay,
+        [weak = weak_from_this(), shard, target = std::weak_ptr<Device>(device)]() {
+            if (auto self = weak.lock()) {
+                self->on_timer(shard, target);
+            }
+        });
+}
+
+void GbDeviceRegistry::disarm(Device& device) {
+    if (device.timer) {
+        timers_->Cancel(device.timer);
+        device.timer = 0;
+    }
+}
+
+void GbDeviceRegistry::on_timer(std::size_t index, const std::weak_ptr<Device>& target) {
+    std::shared_ptr<Device> device = target.lock();
+    if (!device || stopped_.load(std::memory_order_relaxed)) {
+        return;
+    }
+    Shard& shard = *shards_[index];
+    Event event;
+    std::string id;
+    for (bool merged = false;; merged = true) {
+        std::unique_lock<std::mutex> lock(shard.mtx);
+        auto it = shard.table.find(StringView(device->id));
+        if (it == shard.table.end() || it->second != device) {
+            return;
+        }
+        const int64_t now = net::AsioTimerWheel::now_ms();
+        const int64_t keepalive_deadline = device->last_keepalive_ms +
+            static_cast<int64_t>(cfg_.keepalive_interval) * cfg_.keepalive_timeout_count * 1000;
+        if (now >= device->expires_at_ms) {
+            event = Event::Expired;
+        } else if (cfg_.keepalive_interval && cfg_.keepalive_timeout_count && now >= keepalive_deadline) {
+            // 心跳可能还在批次里没合并，合并后再判一次；空批次的flush只是各reactor加锁看一眼
+            if (!merged) {
+                lock.unlock();
+                Flush();
+                continue;
+            }
+            event = Event::Offline;
+        } else {
+            arm(index, device, now);
+            return;
+        }
+        disarm(*device);
+        id = std::move(device->id);
+        shard.table.erase(it);
+        devices_.fetch_sub(1, std::memory_order_relaxed);
+        break;
+    }
+    (event == Event::Expired ? expired_ : offline_).fetch_add(1, std::memory_order_relaxed);
+    notify(event, id);
+}
+
+void GbDeviceRegistry::notify(Event event, const std::string& device_id) {
+    if (event_handler_) {
+        event_handler_(event, device_id);
+    }
+}
@@ -0,0 +1,60 @@
+#include "sip/sip_buffer_pool.h"
+
+SipBufferPool::State::~State() {
+    for (std::string* s : idle) {
+        delete s;
+    }
+}
+
+void SipBufferPool::Recycler::operator()(std::string* buffer) const {
+    if (!buffer) {
+        return;
+    }
+    if (state_) {
+        std::lock_guard<std::mutex> lock(state_->mtx);
+        if (state_->idle.size() < state_->cfg.max_idle && buffer->capacity() <= state_->cfg.max_capacity) {
+            buffer->clear();
+            state_->idle.push_back(buffer);
+            return;
+        }
+        ++state_->stats.dropped;
+    }
+    delete buffer;
+}
+
+SipBufferPool::SipBufferPool() : SipBufferPool(Config{}) {
+
+}
+
+SipBufferPool::SipBufferPool(const Config& cfg) : state_(std::make_shared<State>()) {
+    state_->cfg = cfg;
+    state_->idle.reserve(cfg.max_idle);
+}
+
+SipBufferPool::Buffer SipBufferPool::Acquire() {
+    std::string* buffer = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(state_->mtx);
+        ++state_->stats.acquired;
+        if (!state_->idle.empty()) {
+            buffer = state_->idle.back();
+            state_->idle.pop_back();
+            ++state_->stats.reused;
+        }
+    }
+    if (!buffer) {
+        buffer = new std::string();
+        buffer->reserve(state_->cfg.initial_capacity);
+    }
+    return Buffer(buffer, Recycler(state_));
+}
+
+SipBufferPool::Stats SipBufferPool::stats() const {
+    std::lock_guard<std::mutex> lock(state_->mtx);
+    return state_->stats;
+}
+
+std::size_t SipBufferPool::idle() const {
+    std::lock_guard<std::mutex> lock(state_->mtx);
+    return state_->idle.size();
+}
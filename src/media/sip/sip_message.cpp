@@ -0,0 +1,710 @@
+#include "sip/sip_message.h"
+#include <cstring>
+#include <stdexcept>
+// INVITE sip:34020000001320000001@3402000000 SIP/2.0
+// Via: SIP/2.0/TCP 192.168.1.10:5060;branch=z9hG4bK-123456
+// From: <sip:34020000002000000001@3402000000>;tag=1234
+// To: <sip:34020000001320000001@3402000000>
+// Call-ID: 987654321@192.168.1.10
+// CSeq: 1 INVITE
+// Content-Length: 129
+
+// v=0
+// o=34020000002000000001 0 0 IN IP4 192.168.1.10
+// s=Play
+// c=IN IP4 192.168.1.10
+// t=0 0
+// m=video 30000 RTP/AVP 96
+// a=rtpmap:96 PS/90000
+
+/// @brief SIP响应报文
+// SIP/2.0 100 Trying
+// Via: SIP/2.0/UDP pc33.atlanta.com;branch=z9hG4bK776asdhds
+// From: Alice <sip:alice@atlanta.com>;tag=1928301774
+// To: Bob <sip:bob@biloxi.com>
+// Call-ID: a84b4c76e66710@pc33.atlanta.com
+// CSeq: 314159 INVITE
+// Content-Length: 0
+
+SipMessage SipMessage::Parse(const std::string& data) {
+    SipMessageView view;
+    if (SipMessageView::Parse(data.data(), data.size(), view) != SipMessageView::ParseResult::Ok) {
+        throw std::runtime_error("SipMessage::Parse: Invalid SIP message");
+    }
+    return view.ToMessage();
+}
+
+void SipMessage::build_headers() const {
+    std::shared_ptr<const SipMessageView> parsed = std::move(parsed_);
+    for (const SipHeaderField& h : parsed->headers()) {
+        const bool known = h.id != SipHeaderId::Other;
+        StringView key = known ? SipMessageView::HeaderName(h.id) : h.name;
+        auto [it, inserted] = headers_.try_emplace(std::string(key.data(), key.size()), h.value.data(), h.value.size());
+        if (inserted) {
+            continue;
+        }
+        if (SipMessageView::IsListHeader(h.id)) {
+            it->second.append(", ").append(h.value.data(), h.value.size());
+        } else {
+            it->second.assign(h.value.data(), h.value.size());
+        }
+    }
+}
+
+namespace {
+
+inline std::size_t decimal_digits(uint64_t v) noexcept {
+    std::size_t n = 1;
+    while (v >= 10) {
+        v /= 10;
+        ++n;
+    }
+    return n;
+}
+
+/// @brief 只统计长度，和WriteSink走同一段生成代码，保证预先算出的大小准确
+struct SizeSink {
+    std::size_t n = 0;
+    void put(StringView s) noexcept { n += s.size(); }
+    void put(char) noexcept { ++n; }
+    void put_uint(uint64_t v) noexcept { n += decimal_digits(v); }
+};
+
+struct WriteSink {
+    char* p;
+    void put(StringView s) noexcept {
+        if (!s.empty()) {
+            std::memcpy(p, s.data(), s.size());
+            p += s.size();
+        }
+    }
+    void put(char c) noexcept { *p++ = c; }
+    void put_uint(uint64_t v) noexcept {
+        std::size_t n = decimal_digits(v);
+        for (std::size_t i = n; i-- > 0;) {
+            p[i] = static_cast<char>('0' + v % 10);
+            v /= 10;
+        }
+        p += n;
+    }
+};
+
+template <typename Sink>
+void put_header(Sink& out, StringView name, StringView value) {
+    out.put(name);
+    out.put(StringView(": ", 2));
+    out.put(value);
+    out.put(StringView("\r\n", 2));
+}
+
+template <typename Sink>
+void put_body(Sink& out, StringView body) {
+    out.put(StringView("Content-Length: ", 16));
+    out.put_uint(body.size());
+    out.put(StringView("\r\n\r\n", 4));
+    out.put(body);
+}
+
+}
+
+template <typename Sink>
+static void emit_message(const SipMessage& msg, Sink& out) {
+    if (!msg.method().empty()) {
+        out.put(msg.method());
+        out.put(' ');
+        out.put(msg.uri());
+        out.put(' ');
+        out.put(msg.version());
+    } else {
+        out.put(msg.version());
+        out.put(' ');
+        out.put_uint(static_cast<uint64_t>(msg.status_code() < 0 ? 0 : msg.status_code()));
+        out.put(' ');
+        out.put(msg.reason());
+    }
+    out.put(StringView("\r\n", 2));
+    for (auto& [k, v] : msg.headers()) {
+        // Content-Length按实际消息体生成，忽略调用方（或解析来源）带的旧值
+        if (SipMessageView::HeaderId(k) == SipHeaderId::ContentLength) {
+            continue;
+        }
+        put_header(out, k, v);
+    }
+    put_body(out, msg.body());
+}
+
+std::string SipMessage::ToString() const {
+    std::string out;
+    SerializeInto(out);
+    return out;
+}
+
+std::size_t SipMessage::SerializedSize() const {
+    SizeSink sink;
+    emit_message(*this, sink);
+    return sink.n;
+}
+
+std::size_t SipMessage::SerializeInto(char* dst, std::size_t capacity) const {
+    const std::size_t size = SerializedSize();
+    if (size > capacity) {
+        return 0;
+    }
+    WriteSink sink{dst};
+    emit_message(*this, sink);
+    return size;
+}
+
+std::size_t SipMessage::SerializeInto(std::string& buffer) const {
+    const std::size_t size = SerializedSize();
+    buffer.resize(size);
+    WriteSink sink{&buffer[0]};
+    emit_message(*this, sink);
+    return size;
+}
+
+/************************************SipMessageView***********************************/
+namespace {
+
+struct KnownHeader {
+    const char* name;
+    /// @brief RFC 3261 7.3.3 / RFC 3265 的紧凑形式，0表示没有
+    char compact;
+    bool list;
+};
+
+// 下标与SipHeaderId一致
+const KnownHeader kKnownHeaders[] = {
+    {"", 0, false},
+    {"Via", 'v', true},
+    {"From", 'f', false},
+    {"To", 't', false},
+    {"Call-ID", 'i', false},
+    {"CSeq", 0, false},
+    {"Contact", 'm', true},
+    {"Max-Forwards", 0, false},
+    {"Expires", 0, false},
+    {"Content-Length", 'l', false},
+    {"Content-Type", 'c', false},
+    {"Content-Encoding", 'e', true},
+    {"Supported", 'k', true},
+    {"Subject", 's', false},
+    {"Event", 'o', false},
+    {"Allow-Events", 'u', true},
+    {"Allow", 0, true},
+    {"Route", 0, true},
+    {"Record-Route", 0, true},
+    {"Authorization", 0, false},
+    {"WWW-Authenticate", 0, false},
+    {"Proxy-Authorization", 0, false},
+    {"Proxy-Authenticate", 0, false},
+    {"User-Agent", 0, false},
+    {"Date", 0, false},
+    {"Subscription-State", 0, false},
+};
+static_assert(sizeof(kKnownHeaders) / sizeof(kKnownHeaders[0]) == static_cast<std::size_t>(SipHeaderId::Count),
+              "kKnownHeaders must match SipHeaderId");
+
+inline char lower(char c) noexcept {
+    return (c >= 'A' && c <= 'Z') ? static_cast<char>(c | 0x20) : c;
+}
+
+bool iequals(StringView a, StringView b) noexcept {
+    if (a.size() != b.size()) {
+        return false;
+    }
+    for (std::size_t i = 0; i < a.size(); ++i) {
+        if (lower(a[i]) != lower(b[i])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+inline bool is_ws(char c) noexcept {
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+StringView trim(const char* begin, const char* end) noexcept {
+    while (begin < end && is_ws(*begin)) {
+        ++begin;
+    }
+    while (end > begin && is_ws(end[-1])) {
+        --end;
+    }
+    return StringView(begin, static_cast<std::size_t>(end - begin));
+}
+
+/// @brief 常用头的开放寻址哈希表，槽位存SipHeaderId
+struct HeaderTable {
+    static constexpr std::size_t kSlots = 64;
+    uint8_t ids[kSlots] = {};
+    uint32_t hashes[kSlots] = {};
+    /// @brief 紧凑形式按小写字母直接索引
+    uint8_t compact[26] = {};
+
+    HeaderTable() {
+        for (std::size_t id = 1; id < static_cast<std::size_t>(SipHeaderId::Count); ++id) {
+            const KnownHeader& k = kKnownHeaders[id];
+            uint32_t h = SipMessageView::HeaderHash(k.name);
+            std::size_t i = h & (kSlots - 1);
+            while (ids[i] != 0) {
+                i = (i + 1) & (kSlots - 1);
+            }
+            ids[i] = static_cast<uint8_t>(id);
+            hashes[i] = h;
+            if (k.compact) {
+                compact[k.compact - 'a'] = static_cast<uint8_t>(id);
+            }
+        }
+    }
+
+    SipHeaderId lookup(StringView name, uint32_t hash) const noexcept {
+        if (name.size() == 1) {
+            char c = lower(name[0]);
+            return (c >= 'a' && c <= 'z') ? static_cast<SipHeaderId>(compact[c - 'a']) : SipHeaderId::Other;
+        }
+        for (std::size_t i = hash & (kSlots - 1); ids[i] != 0; i = (i + 1) & (kSlots - 1)) {
+            if (hashes[i] == hash && iequals(name, kKnownHeaders[ids[i]].name)) {
+                return static_cast<SipHeaderId>(ids[i]);
+            }
+        }
+        return SipHeaderId::Other;
+    }
+};
+
+const HeaderTable& header_table() {
+    static const HeaderTable table;
+    return table;
+}
+
+/// @brief 十进制非负整数，非法或溢出返回false
+bool parse_uint(StringView s, uint64_t max, uint64_t& out) noexcept {
+    if (s.empty()) {
+        return false;
+    }
+    uint64_t v = 0;
+    for (char c : s) {
+        if (c < '0' || c > '9') {
+            return false;
+        }
+        v = v * 10 + static_cast<uint64_t>(c - '0');
+        if (v > max) {
+            return false;
+        }
+    }
+    out = v;
+    return true;
+}
+
+/// @brief 取出[p, end)中的下一行（不含行尾），p移到下一行开头；没有换行时返回false
+inline bool next_line(const char*& p, const char* end, const char*& line_end) noexcept {
+    const char* nl = static_cast<const char*>(std::memchr(p, '\n', static_cast<std::size_t>(end - p)));
+    if (!nl) {
+        return false;
+    }
+    line_end = (nl > p && nl[-1] == '\r') ? nl - 1 : nl;
+    p = nl + 1;
+    return true;
+}
+
+}
+
+uint32_t SipMessageView::HeaderHash(StringView name) noexcept {
+    uint32_t h = 2166136261u;
+    for (char c : name) {
+        h ^= static_cast<uint8_t>(lower(c));
+        h *= 16777619u;
+    }
+    return h;
+}
+
+SipHeaderId SipMessageView::HeaderId(StringView name) noexcept {
+    return header_table().lookup(name, HeaderHash(name));
+}
+
+StringView SipMessageView::HeaderName(SipHeaderId id) noexcept {
+    std::size_t i = static_cast<std::size_t>(id);
+    return i < static_cast<std::size_t>(SipHeaderId::Count) ? StringView(kKnownHeaders[i].name) : StringView();
+}
+
+bool SipMessageView::IsListHeader(SipHeaderId id) noexcept {
+    std::size_t i = static_cast<std::size_t>(id);
+    return i < static_cast<std::size_t>(SipHeaderId::Count) && kKnownHeaders[i].list;
+}
+
+void SipMessageView::reset() noexcept {
+    raw_ = StringView();
+    method_ = StringView();
+    uri_ = StringView();
+    version_ = StringView();
+    status_code_ = 0;
+    reason_ = StringView();
+    headers_.clear();
+    body_ = StringView();
+    peer_ = Peer();
+    storage_.reset();
+}
+
+SipMessageView::ParseResult SipMessageView::Parse(const char* data, std::size_t size, SipMessageView& out,
+                                                  std::size_t* consumed, bool stream) {
+    out.reset();
+    const char* const end = data + size;
+    const char* p = data;
+    // RFC 3261 7.5: 起始行之前的CRLF忽略（TCP保活）
+    while (p < end && (*p == '\r' || *p == '\n')) {
+        ++p;
+    }
+    if (p == end) {
+        return stream ? ParseResult::Incomplete : ParseResult::Error;
+    }
+    const char* const start = p;
+    const ParseResult short_data = stream ? ParseResult::Incomplete : ParseResult::Error;
+
+    // ---- 起始行 ----
+    const char* line_end;
+    const char* line = p;
+    if (!next_line(p, end, line_end)) {
+        return short_data;
+    }
+    const char* sp1 = static_cast<const char*>(std::memchr(line, ' ', static_cast<std::size_t>(line_end - line)));
+    if (!sp1) {
+        return ParseResult::Error;
+    }
+    const char* sp2 = static_cast<const char*>(std::memchr(sp1 + 1, ' ', static_cast<std::size_t>(line_end - sp1 - 1)));
+    if (!sp2) {
+        return ParseResult::Error;
+    }
+    StringView first(line, static_cast<std::size_t>(sp1 - line));
+    if (first.size() >= 4 && std::memcmp(first.data(), "SIP/", 4) == 0) {
+        // SIP/2.0 200 OK
+        uint64_t code = 0;
+        if (!parse_uint(StringView(sp1 + 1, static_cast<std::size_t>(sp2 - sp1 - 1)), 699, code) || code < 100) {
+            return ParseResult::Error;
+        }
+        out.version_ = first;
+        out.status_code_ = static_cast<int>(code);
+        out.reason_ = trim(sp2 + 1, line_end);
+    } else {
+        // INVITE sip:xxx@yyy SIP/2.0
+        out.method_ = first;
+        out.uri_ = StringView(sp1 + 1, static_cast<std::size_t>(sp2 - sp1 - 1));
+        out.version_ = trim(sp2 + 1, line_end);
+        if (first.empty() || out.uri_.empty() || out.version_.size() < 4 ||
+            std::memcmp(out.version_.data(), "SIP/", 4) != 0) {
+            return ParseResult::Error;
+        }
+    }
+
+    // ---- 头字段 ----
+    const HeaderTable& table = header_table();
+    bool has_length = false;
+    uint64_t content_length = 0;
+    bool terminated = false;
+    while (p < end) {
+        line = p;
+        if (!next_line(p, end, line_end)) {
+            if (stream) {
+                return ParseResult::Incomplete;
+            }
+            // 数据报最后一行可以没有换行
+            line_end = end;
+            p = end;
+        }
+        if (line_end == line) {
+            terminated = true;
+            break;
+        }
+        if (*line == ' ' || *line == '\t') {
+            // 折行，并入上一个头字段
+            if (out.headers_.empty()) {
+                return ParseResult::Error;
+            }
+            SipHeaderField& prev = out.headers_.back();
+            StringView cont = trim(line, line_end);
+            if (!cont.empty()) {
+                const char* vbegin = prev.value.empty() ? cont.data() : prev.value.data();
+                prev.value = StringView(vbegin, static_cast<std::size_t>(cont.data() + cont.size() - vbegin));
+            }
+            continue;
+        }
+        const char* colon = static_cast<const char*>(std::memchr(line, ':', static_cast<std::size_t>(line_end - line)));
+        if (!colon) {
+            return ParseResult::Error;
+        }
+        SipHeaderField h;
+        h.name = trim(line, colon);
+        if (h.name.empty()) {
+            return ParseResult::Error;
+        }
+        h.value = trim(colon + 1, line_end);
+        h.hash = HeaderHash(h.name);
+        h.id = table.lookup(h.name, h.hash);
+        if (h.id == SipHeaderId::ContentLength) {
+            if (!parse_uint(h.value, 0xFFFFFFFFu, content_length)) {
+                return ParseResult::Error;
+            }
+            has_length = true;
+        }
+        if (out.headers_.size() >= kMaxHeaders) {
+            return ParseResult::Error;
+        }
+        out.headers_.push_back(h);
+    }
+    if (!terminated && stream) {
+        return ParseResult::Incomplete;
+    }
+
+    // ---- 消息体 ----
+    // RFC 3261 18.3: 流式必须靠Content-Length分帧；数据报以Content-Length为准，多余字节丢弃，不足则整条丢弃
+    const std::size_t avail = static_cast<std::size_t>(end - p);
+    std::size_t body_size;
+    if (has_length) {
+        if (content_length > avail) {
+            return short_data;
+        }
+        body_size = static_cast<std::size_t>(content_length);
+    } else {
+        body_size = stream ? 0 : avail;
+    }
+    out.body_ = StringView(p, body_size);
+    p += body_size;
+    out.raw_ = StringView(start, static_cast<std::size_t>(p - start));
+    if (consumed) {
+        *consumed = static_cast<std::size_t>(p - data);
+    }
+    return ParseResult::Ok;
+}
+
+SipMessageView::ParseResult SipMessageView::Parse(std::shared_ptr<const std::string> buffer, SipMessageView& out) {
+    if (!buffer) {
+        out.reset();
+        return ParseResult::Error;
+    }
+    ParseResult r = Parse(buffer->data(), buffer->size(), out);
+    if (r == ParseResult::Ok) {
+        out.storage_ = std::move(buffer);
+    }
+    return r;
+}
+
+void SipMessageView::rebase(const char* from, const char* to) noexcept {
+    auto move = [from, to](StringView& sv) {
+        if (!sv.empty()) {
+            sv = StringView(to + (sv.data() - from), sv.size());
+        }
+    };
+    move(raw_);
+    move(method_);
+    move(uri_);
+    move(version_);
+    move(reason_);
+    move(body_);
+    for (SipHeaderField& h : headers_) {
+        move(h.name);
+        move(h.value);
+    }
+}
+
+void SipMessageView::Retain() {
+    if (storage_ || raw_.empty()) {
+        return;
+    }
+    auto copy = std::make_shared<const std::string>(raw_.data(), raw_.size());
+    rebase(raw_.data(), copy->data());
+    storage_ = std::move(copy);
+}
+
+StringView SipMessageView::header(SipHeaderId id) const noexcept {
+    for (const SipHeaderField& h : headers_) {
+        if (h.id == id) {
+            return h.value;
+        }
+    }
+    return StringView();
+}
+
+StringView SipMessageView::header(StringView name) const noexcept {
+    const uint32_t hash = HeaderHash(name);
+    SipHeaderId id = header_table().lookup(name, hash);
+    if (id != SipHeaderId::Other) {
+        return header(id);
+    }
+    for (const SipHeaderField& h : headers_) {
+        if (h.id == SipHeaderId::Other && h.hash == hash && iequals(h.name, name)) {
+            return h.value;
+        }
+    }
+    return StringView();
+}
+
+bool SipMessageView::has_header(SipHeaderId id) const noexcept {
+    for (const SipHeaderField& h : headers_) {
+        if (h.id == id) {
+            return true;
+        }
+    }
+    return false;
+}
+
+std::size_t SipMessageView::CountValues(SipHeaderId id) const {
+    std::size_t n = 0;
+    ForEachValue(id, [&n](StringView) { ++n; });
+    return n;
+}
+
+StringView SipMessageView::NextListValue(StringView& rest) noexcept {
+    const char* p = rest.data();
+    const char* const end = p + rest.size();
+    bool quoted = false;
+    int angle = 0;
+    const char* q = p;
+    for (; q < end; ++q) {
+        char c = *q;
+        if (quoted) {
+            if (c == '\\' && q + 1 < end) {
+                ++q;
+            } else if (c == '"') {
+                quoted = false;
+            }
+        } else if (c == '"') {
+            quoted = true;
+        } else if (c == '<') {
+            ++angle;
+        } else if (c == '>') {
+            if (angle > 0) {
+                --angle;
+            }
+        } else if (c == ',' && angle == 0) {
+            break;
+        }
+    }
+    StringView value = trim(p, q);
+    rest = q < end ? StringView(q + 1, static_cast<std::size_t>(end - q - 1)) : StringView();
+    return value;
+}
+
+StringView SipMessageView::Param(StringView value, StringView name) noexcept {
+    const char* p = value.data();
+    const char* const end = p + value.size();
+    // name-addr形式的参数在'>'之后，尖括号内是URI参数
+    const char* gt = static_cast<const char*>(std::memchr(p, '>', value.size()));
+    if (gt) {
+        p = gt + 1;
+    }
+    while (p < end) {
+        const char* semi = static_cast<const char*>(std::memchr(p, ';', static_cast<std::size_t>(end - p)));
+        if (!semi) {
+            break;
+        }
+        p = semi + 1;
+        const char* next = static_cast<const char*>(std::memchr(p, ';', static_cast<std::size_t>(end - p)));
+        const char* seg_end = next ? next : end;
+        const char* eq = static_cast<const char*>(std::memchr(p, '=', static_cast<std::size_t>(seg_end - p)));
+        StringView key = trim(p, eq ? eq : seg_end);
+        if (iequals(key, name)) {
+            if (!eq) {
+                return StringView();
+            }
+            StringView v = trim(eq + 1, seg_end);
+            if (v.size() >= 2 && v[0] == '"' && v[v.size() - 1] == '"') {
+                v = v.substr(1, v.size() - 2);
+            }
+            return v;
+        }
+        p = seg_end;
+    }
+    return StringView();
+}
+
+bool SipMessageView::cseq(uint32_t& seq, StringView& method) const noexcept {
+    StringView v = header(SipHeaderId::CSeq);
+    std::size_t sp = v.find(' ');
+    if (sp == StringView::npos) {
+        return false;
+    }
+    uint64_t n = 0;
+    if (!parse_uint(v.substr(0, sp), 0xFFFFFFFFu, n)) {
+        return false;
+    }
+    StringView m = trim(v.data() + sp, v.data() + v.size());
+    if (m.empty()) {
+        return false;
+    }
+    seq = static_cast<uint32_t>(n);
+    method = m;
+    return true;
+}
+
+StringView SipMessageView::top_via_branch() const noexcept {
+    StringView rest = header(SipHeaderId::Via);
+    return Param(NextListValue(rest), "branch");
+}
+
+SipMessage SipMessageView::ToMessage() const {
+    SipMessage msg;
+    msg.set_method(std::string(method_));
+    msg.set_uri(std::string(uri_));
+    msg.set_version(std::string(version_));
+    msg.set_status_code(status_code_);
+    msg.set_reason(std::string(reason_));
+    msg.set_body(std::string(body_));
+    if (!headers_.empty()) {
+        auto held = std::make_shared<SipMessageView>(*this);
+        held->Retain();
+        msg.parsed_ = std::move(held);
+    }
+    if (*peer_.protocol || peer_.port != 0) {
+        msg.set_remote(SipMessage::RemoteInfo(peer_.protocol, peer_.address.to_string(), peer_.port));
+    }
+    return msg;
+}
+
+template <typename Sink>
+static void emit_response(const SipMessageView& req, int status_code, StringView reason,
+                          const SipResponseOptions& opts, Sink& out) {
+    out.put(StringView("SIP/2.0 ", 8));
+    out.put_uint(static_cast<uint64_t>(status_code < 0 ? 0 : status_code));
+    out.put(' ');
+    out.put(reason);
+    out.put(StringView("\r\n", 2));
+    // RFC 3261 8.2.6.2: Via按原顺序全部带回，From/Call-ID/CSeq原样，To必要时补tag
+    for (const SipHeaderField& h : req.headers()) {
+        switch (h.id) {
+        case SipHeaderId::Via:
+        case SipHeaderId::From:
+        case SipHeaderId::CallId:
+        case SipHeaderId::CSeq:
+            put_header(out, SipMessageView::HeaderName(h.id), h.value);
+            break;
+        case SipHeaderId::To:
+            out.put(StringView("To: ", 4));
+            out.put(h.value);
+            if (!opts.to_tag.empty() && SipMessageView::Param(h.value, "tag").empty()) {
+                out.put(StringView(";tag=", 5));
+                out.put(opts.to_tag);
+            }
+            out.put(StringView("\r\n", 2));
+            break;
+        default:
+            break;
+        }
+    }
+    for (std::size_t i = 0; i < opts.extra_count; ++i) {
+        put_header(out, opts.extra_headers[i].name, opts.extra_headers[i].value);
+    }
+    if (!opts.content_type.empty()) {
+        put_header(out, StringView("Content-Type", 12), opts.content_type);
+    }
+    put_body(out, opts.body);
+}
+
+std::size_t SipMessageView::SerializeResponse(int status_code, StringView reason, std::string& buffer,
+                                              const SipResponseOptions& opts) const {
+    SizeSink size;
+    emit_response(*this, status_code, reason, opts, size);
+    buffer.resize(size.n);
+    WriteSink sink{&buffer[0]};
+    emit_response(*this, status_code, reason, opts, sink);
+    return size.n;
+}
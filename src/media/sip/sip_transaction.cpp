@@ -0,0 +1,649 @@
+#include "sip/sip_transaction.h"
+#include <algorithm>
+#include <random>
+
+namespace {
+
+enum class TxnKind : uint8_t {
+    ServerInvite,
+    ServerNonInvite,
+    ClientInvite,
+    ClientNonInvite
+};
+
+enum class TxnState : uint8_t {
+    Idle,
+    /// @brief 客户端INVITE：已发请求，未收到应答
+    Calling,
+    /// @brief 非INVITE：已收/发请求，未有应答
+    Trying,
+    Proceeding,
+    Completed,
+    /// @brief 服务端INVITE：收到非2xx最终应答的ACK
+    Confirmed,
+    /// @brief RFC 6026：INVITE的2xx之后吸收重传
+    Accepted
+};
+
+constexpr StringView kMagicCookie = "z9hG4bK";
+
+void append_uint(std::string& out, uint64_t v) {
+    char tmp[20];
+    std::size_t n = 0;
+    do {
+        tmp[n++] = static_cast<char>('0' + v % 10);
+        v /= 10;
+    } while (v);
+    while (n) {
+        out.push_back(tmp[--n]);
+    }
+}
+
+void append(std::string& out, StringView s) {
+    out.append(s.data(), s.size());
+}
+
+/// @brief 事务key：side为'S'/'C'；RFC 3261 branch为"branch 方法"，旧式为"~Call-ID CSeq From-tag 方法"
+bool make_key(std::string& out, char side, const SipMessageView& msg, StringView method) {
+    out.clear();
+    out.push_back(side);
+    StringView vias = msg.header(SipHeaderId::Via);
+    StringView branch = SipMessageView::Param(SipMessageView::NextListValue(vias), "branch");
+    if (branch.size() > kMagicCookie.size() && branch.substr(0, kMagicCookie.size()) == kMagicCookie) {
+        append(out, branch);
+        out.push_back(' ');
+        append(out, method);
+        return true;
+    }
+    uint32_t seq = 0;
+    StringView cseq_method;
+    StringView call_id = msg.call_id();
+    if (call_id.empty() || !msg.cseq(seq, cseq_method)) {
+        return false;
+    }
+    out.push_back('~');
+    append(out, call_id);
+    out.push_back(' ');
+    append_uint(out, seq);
+    out.push_back(' ');
+    append(out, msg.from_tag());
+    out.push_back(' ');
+    append(out, method);
+    return true;
+}
+
+/// @brief 每个线程复用的key缓冲，查找时不分配
+std::string& key_scratch() {
+    thread_local std::string scratch;
+    return scratch;
+}
+
+bool is_reliable(const char* protocol) {
+    return protocol && protocol[0] == 'T';
+}
+
+/// @brief 按请求生成非2xx最终应答的ACK（RFC 3261 17.1.1.3）
+void build_ack(std::string& out, const SipMessageView& request, const SipMessageView& response) {
+    out.clear();
+    out.append("ACK ");
+    append(out, request.uri());
+    out.append(" SIP/2.0\r\nVia: ");
+    StringView vias = request.header(SipHeaderId::Via);
+    append(out, SipMessageView::NextListValue(vias));
+    out.append("\r\n");
+    request.ForEachValue(SipHeaderId::Route, [&out](StringView route) {
+        out.append("Route: ");
+        append(out, route);
+        out.append("\r\n");
+    });
+    out.append("From: ");
+    append(out, request.header(SipHeaderId::From));
+    out.append("\r\nTo: ");
+    append(out, response.header(SipHeaderId::To));
+    out.append("\r\nCall-ID: ");
+    append(out, request.call_id());
+    uint32_t seq = 0;
+    StringView method;
+    request.cseq(seq, method);
+    out.append("\r\nCSeq: ");
+    append_uint(out, seq);
+    out.append(" ACK\r\nMax-Forwards: 70\r\nContent-Length: 0\r\n\r\n");
+}
+
+}
+
+struct SipTransactionLayer::Transaction {
+    /// @brief 指向表节点里的key，节点在表之间搬动时地址不变
+    const std::string* key = nullptr;
+    std::size_t shard = 0;
+    /// @brief 复用时递增，过期的定时器回调据此识别
+    uint32_t generation = 1;
+    TxnKind kind = TxnKind::ServerNonInvite;
+    TxnState state = TxnState::Idle;
+    bool reliable = false;
+    SipTransport::Peer peer;
+    /// @brief 客户端：请求报文；服务端：最近一次应答
+    std::string wire;
+    /// @brief 客户端INVITE非2xx最终应答的ACK
+    std::string ack;
+    int64_t interval_ms = 0;
+    net::AsioTimerWheel::TimerId timers[2] = {0, 0};
+    ResponseHandler on_response;
+
+    bool client() const noexcept { return kind == TxnKind::ClientInvite || kind == TxnKind::ClientNonInvite; }
+};
+
+struct SipTransactionLayer::Shard {
+    std::size_t index = 0;
+    std::mutex mtx;
+    Table table;
+    /// @brief 摘下的节点（key + 事务对象），再次登记时不分配
+    std::vector<Table::node_type> pool;
+};
+
+struct SipTransactionLayer::Actions {
+    SipTransport::Peer peers[2];
+    SipTransport::Buffer sends[2];
+    std::size_t send_count = 0;
+    ResponseHandler notify;
+    bool notify_timeout = false;
+};
+
+SipTransactionLayer::SipTransactionLayer(SipTransport::Ptr transport, std::shared_ptr<net::AsioTimerWheel> timers)
+    : SipTransactionLayer(std::move(transport), std::move(timers), Config{}) {
+
+}
+
+SipTransactionLayer::SipTransactionLayer(SipTransport::Ptr transport, std::shared_ptr<net::AsioTimerWheel> timers,
+                                         const Config& cfg)
+    : transport_(std::move(transport)), timers_(std::move(timers)), cfg_(cfg) {
+    std::size_t n = 1;
+    while (n < cfg_.shards) {
+        n <<= 1;
+    }
+    shards_.reserve(n);
+    for (std::size_t i = 0; i < n; ++i) {
+        shards_.push_back(std::make_unique<Shard>());
+        shards_.back()->index = i;
+    }
+    shard_mask_ = n - 1;
+}
+
+SipTransactionLayer::~SipTransactionLayer() {
+    Stop();
+}
+
+void SipTransactionLayer::Start() {
+    transport_->SetMsgHandler([weak = weak_from_this()](const SipMessageView& msg) {
+        if (auto self = weak.lock()) {
+            self->on_message(msg);
+        }
+    });
+}
+
+void SipTransactionLayer::Stop() {
+    if (stopped_.exchange(true)) {
+        return;
+    }
+    for (auto& shard : shards_) {
+        std::lock_guard<std::mutex> lock(shard->mtx);
+        // 不能直接clear：Cancel拦不住时间轮已取下待执行的回调，它们还拿着事务指针
+        while (!shard->table.empty()) {
+            release(shard->table.begin()->second.get());
+        }
+    }
+}
+
+SipTransactionLayer::Stats SipTransactionLayer::stats() const {
+    Stats s;
+    s.server_created = server_created_.load(std::memory_order_relaxed);
+    s.client_created = client_created_.load(std::memory_order_relaxed);
+    s.absorbed = absorbed_.load(std::memory_order_relaxed);
+    s.retransmitted = retransmitted_.load(std::memory_order_relaxed);
+    s.timeouts = timeouts_.load(std::memory_order_relaxed);
+    s.rejected = rejected_.load(std::memory_order_relaxed);
+    s.stray_responses = stray_responses_.load(std::memory_order_relaxed);
+    return s;
+}
+
+std::string SipTransactionLayer::NewBranch() {
+    thread_local std::mt19937_64 rng(std::random_device{}());
+    static const char kHex[] = "0123456789abcdef";
+    std::string branch(kMagicCookie);
+    uint64_t v = rng();
+    for (int i = 0; i < 16; ++i) {
+        branch.push_back(kHex[v & 0xF]);
+        v >>= 4;
+    }
+    return branch;
+}
+
+SipTransactionLayer::Shard& SipTransactionLayer::shard_for(std::string_view key) noexcept {
+    return *shards_[KeyHash()(key) & shard_mask_];
+}
+
+SipTransactionLayer::Transaction* SipTransactionLayer::acquire(Shard& shard, std::string_view key) {
+    Table::iterator it;
+    if (!shard.pool.empty()) {
+        Table::node_type node = std::move(shard.pool.back());
+        shard.pool.pop_back();
+        node.key().assign(key.data(), key.size());
+        it = shard.table.insert(std::move(node)).position;
+    } else {
+        it = shard.table.emplace(std::string(key), std::make_unique<Transaction>()).first;
+    }
+    Transaction* txn = it->second.get();
+    txn->key = &it->first;
+    txn->shard = shard.index;
+    active_.fetch_add(1, std::memory_order_relaxed);
+    return txn;
+}
+
+void SipTransactionLayer::release(Transaction* txn) {
+    Shard& shard = *shards_[txn->shard];
+    cancel(txn, TimerKind::Retransmit);
+    cancel(txn, TimerKind::Timeout);
+    auto it = shard.table.find(std::string_view(*txn->key));
+    if (it == shard.table.end()) {
+        return;
+    }
+    Table::node_type node = shard.table.extract(it);
+    // 字符串只清空不释放，容量留给下一个事务
+    ++txn->generation;
+    txn->state = TxnState::Idle;
+    txn->wire.clear();
+    txn->ack.clear();
+    txn->on_response = nullptr;
+    txn->key = nullptr;
+    shard.pool.push_back(std::move(node));
+    active_.fetch_sub(1, std::memory_order_relaxed);
+}
+
+void SipTransactionLayer::schedule(Transaction* txn, TimerKind kind, int64_t delay_ms) {
+    cancel(txn, kind);
+    const uint32_t generation = txn->generation;
+    const std::size_t shard = txn->shard;
+    txn->timers[static_cast<int>(kind)] = timers_->Schedule(delay_ms,
+        [weak = weak_from_this(), shard, txn, generation, kind]() {
+            if (auto self = weak.lock()) {
+                self->on_timer(shard, txn, generation, kind);
+            }
+        });
+}
+
+void SipTransactionLayer::cancel(Transaction* txn, TimerKind kind) {
+    auto& id = txn->timers[static_cast<int>(kind)];
+    if (id) {
+        timers_->Cancel(id);
+        id = 0;
+    }
+}
+
+void SipTransactionLayer::finish_after(Transaction* txn, int64_t delay_ms) {
+    cancel(txn, TimerKind::Retransmit);
+    if (txn->reliable || delay_ms <= 0) {
+        release(txn);
+        return;
+    }
+    schedule(txn, TimerKind::Timeout, delay_ms);
+}
+
+void SipTransactionLayer::run(Actions& actions) {
+    for (std::size_t i = 0; i < actions.send_count; ++i) {
+        transport_->SendBuffer(actions.peers[i], std::move(actions.sends[i]));
+    }
+    if (actions.notify && actions.notify_timeout) {
+        actions.notify(nullptr);
+    }
+}
+
+/// @brief 持锁时把要发送的内容拷进池化缓冲，锁外再交给传输层
+static void queue_send(SipTransport& transport, const SipTransport::Peer& peer, std::string_view data,
+                       SipTransport::Peer* peers, SipTransport::Buffer* sends, std::size_t& count) {
+    SipTransport::Buffer buffer = transport.buffer_pool().Acquire();
+    buffer->assign(data.data(), data.size());
+    peers[count] = peer;
+    sends[count] = std::move(buffer);
+    ++count;
+}
+
+void SipTransactionLayer::on_message(const SipMessageView& msg) {
+    if (stopped_.load(std::memory_order_relaxed)) {
+        return;
+    }
+    if (msg.is_request()) {
+        on_request(msg);
+    } else {
+        on_response(msg);
+    }
+}
+
+void SipTransactionLayer::on_request(const SipMessageView& msg) {
+    const bool is_ack = msg.method() == "ACK";
+    const bool is_invite = msg.method() == "INVITE";
+    std::string& key = key_scratch();
+    if (!make_key(key, 'S', msg, is_ack ? StringView("INVITE") : msg.method())) {
+        return;
+    }
+    Actions actions;
+    bool deliver = false;
+    bool reject = false;
+    {
+        Shard& shard = shard_for(key);
+        std::lock_guard<std::mutex> lock(shard.mtx);
+        auto it = shard.table.find(std::string_view(key));
+        if (it != shard.table.end()) {
+            Transaction* txn = it->second.get();
+            if (is_ack) {
+                // 非2xx最终应答的ACK由事务吸收（RFC 3261 17.2.1）
+                if (txn->kind == TxnKind::ServerInvite && txn->state == TxnState::Completed) {
+                    txn->state = TxnState::Confirmed;
+                    cancel(txn, TimerKind::Retransmit);
+                    finish_after(txn, cfg_.t4_ms);
+                } else if (txn->state == TxnState::Accepted) {
+                    // 2xx的ACK通常用新branch，万一同branch也交给TU
+                    deliver = true;
+                }
+            } else if (!txn->wire.empty() && (txn->state == TxnState::Proceeding || txn->state == TxnState::Completed)) {
+                // 重传请求：重发最近一次应答
+                queue_send(*transport_, txn->peer, txn->wire, actions.peers, actions.sends, actions.send_count);
+                retransmitted_.fetch_add(1, std::memory_order_relaxed);
+            }
+            if (!deliver) {
+                absorbed_.fetch_add(1, std::memory_order_relaxed);
+            }
+        } else if (is_ack) {
+            deliver = true;
+        } else if (active_.load(std::memory_order_relaxed) >= cfg_.max_transactions) {
+            reject = true;
+        } else {
+            Transaction* txn = acquire(shard, key);
+            txn->kind = is_invite ? TxnKind::ServerInvite : TxnKind::ServerNonInvite;
+            txn->state = is_invite ? TxnState::Proceeding : TxnState::Trying;
+            txn->peer = msg.peer();
+            txn->reliable = is_reliable(msg.peer().protocol);
+            schedule(txn, TimerKind::Timeout, cfg_.server_guard_ms);
+            if (is_invite && cfg_.auto_trying) {
+                msg.SerializeResponse(100, "Trying", txn->wire);
+                queue_send(*transport_, txn->peer, txn->wire, actions.peers, actions.sends, actions.send_count);
+            }
+            server_created_.fetch_add(1, std::memory_order_relaxed);
+            deliver = true;
+        }
+    }
+    run(actions);
+    if (reject) {
+        rejected_.fetch_add(1, std::memory_order_relaxed);
+        transport_->SendResponse(msg, 503, "Service Unavailable");
+        return;
+    }
+    if (deliver && request_handler_) {
+        request_handler_(msg);
+    }
+}
+
+bool SipTransactionLayer::Respond(const SipMessageView& request, int status_code, StringView reason,
+                                  const SipResponseOptions& opts) {
+    std::string& key = key_scratch();
+    const bool keyed = request.method() != "ACK" && make_key(key, 'S', request, request.method());
+    Actions actions;
+    bool stateless = !keyed;
+    if (keyed) {
+        Shard& shard = shard_for(key);
+        std::lock_guard<std::mutex> lock(shard.mtx);
+        auto it = shard.table.find(std::string_view(key));
+        if (it == shard.table.end()) {
+            stateless = true;
+        } else {
+            Transaction* txn = it->second.get();
+            if (txn->state != TxnState::Trying && txn->state != TxnState::Proceeding) {
+                return false;
+            }
+            request.SerializeResponse(status_code, reason, txn->wire, opts);
+            queue_send(*transport_, txn->peer, txn->wire, actions.peers, actions.sends, actions.send_count);
+            if (status_code < 200) {
+                txn->state = TxnState::Proceeding;
+            } else if (txn->kind == TxnKind::ServerInvite) {
+                cancel(txn, TimerKind::Timeout);
+                if (status_code < 300) {
+                    // RFC 6026 Timer L：吸收INVITE重传，2xx的重传由TU负责
+                    txn->state = TxnState::Accepted;
+                    schedule(txn, TimerKind::Timeout, 64 * cfg_.t1_ms);
+                } else {
+                    // Timer G重传应答直到收到ACK，Timer H等ACK
+                    txn->state = TxnState::Completed;
+                    if (!txn->reliable) {
+                        txn->interval_ms = cfg_.t1_ms;
+                        schedule(txn, TimerKind::Retransmit, txn->interval_ms);
+                    }
+                    schedule(txn, TimerKind::Timeout, 64 * cfg_.t1_ms);
+                }
+            } else {
+                // Timer J
+                txn->state = TxnState::Completed;
+                cancel(txn, TimerKind::Timeout);
+                finish_after(txn, 64 * cfg_.t1_ms);
+            }
+        }
+    }
+    if (stateless) {
+        return transport_->SendResponse(request, status_code, reason, opts);
+    }
+    run(actions);
+    return true;
+}
+
+bool SipTransactionLayer::SendRequest(SipMessage request, ResponseHandler on_response) {
+    if (stopped_.load(std::memory_order_relaxed)) {
+        return false;
+    }
+    if (request.method() == "ACK") {
+        // 2xx的ACK不属于INVITE事务（RFC 3261 17.1.1.3），直接发送
+        transport_->Send(request);
+        return true;
+    }
+    auto via = request.headers().find("Via");
+    if (via == request.headers().end() || request.method().empty()) {
+        return false;
+    }
+    StringView vias = via->second;
+    StringView top = SipMessageView::NextListValue(vias);
+    if (SipMessageView::Param(top, "branch").empty()) {
+        std::string value(top);
+        value.append(";branch=").append(NewBranch());
+        if (!vias.empty()) {
+            value.append(", ").append(vias.data(), vias.size());
+        }
+        request.set_header("Via", value);
+    }
+    const auto& remote = request.remote();
+    boost::system::error_code ec;
+    auto address = boost::asio::ip::make_address(remote.ip, ec);
+    if (ec || remote.port == 0) {
+        return false;
+    }
+
+    Actions actions;
+    {
+        // 先序列化，再用自己的解析器取key，保证和应答匹配时的取法一致
+        std::string wire;
+        request.SerializeInto(wire);
+        SipMessageView parsed;
+        if (SipMessageView::Parse(wire.data(), wire.size(), parsed) != SipMessageView::ParseResult::Ok) {
+            return false;
+        }
+        std::string& key = key_scratch();
+        if (!make_key(key, 'C', parsed, parsed.method())) {
+            return false;
+        }
+        Shard& shard = shard_for(key);
+        std::lock_guard<std::mutex> lock(shard.mtx);
+        if (shard.table.find(std::string_view(key)) != shard.table.end() ||
+            active_.load(std::memory_order_relaxed) >= cfg_.max_transactions) {
+            return false;
+        }
+        Transaction* txn = acquire(shard, key);
+        const bool invite = request.method() == "INVITE";
+        txn->kind = invite ? TxnKind::ClientInvite : TxnKind::ClientNonInvite;
+        txn->state = invite ? TxnState::Calling : TxnState::Trying;
+        txn->peer = SipTransport::Peer{remote.protocol == "TCP" ? "TCP" : "UDP", address, remote.port};
+        txn->reliable = is_reliable(txn->peer.protocol);
+        txn->wire.swap(wire);
+        txn->on_response = std::move(on_response);
+        // Timer A/E重传，Timer B/F超时
+        if (!txn->reliable) {
+            txn->interval_ms = cfg_.t1_ms;
+            schedule(txn, TimerKind::Retransmit, txn->interval_ms);
+        }
+        schedule(txn, TimerKind::Timeout, 64 * cfg_.t1_ms);
+        queue_send(*transport_, txn->peer, txn->wire, actions.peers, actions.sends, actions.send_count);
+        client_created_.fetch_add(1, std::memory_order_relaxed);
+    }
+    run(actions);
+    return true;
+}
+
+void SipTransactionLayer::on_response(const SipMessageView& msg) {
+    uint32_t seq = 0;
+    StringView method;
+    std::string& key = key_scratch();
+    if (!msg.cseq(seq, method) || !make_key(key, 'C', msg, method)) {
+        return;
+    }
+    const int code = msg.status_code();
+    Actions actions;
+    ResponseHandler handler;
+    bool stray = false;
+    {
+        Shard& shard = shard_for(key);
+        std::lock_guard<std::mutex> lock(shard.mtx);
+        auto it = shard.table.find(std::string_view(key));
+        if (it == shard.table.end()) {
+            stray = true;
+        } else {
+            Transaction* txn = it->second.get();
+            const bool invite = txn->kind == TxnKind::ClientInvite;
+            switch (txn->state) {
+            case TxnState::Calling:
+            case TxnState::Trying:
+            case TxnState::Proceeding:
+                if (code < 200) {
+                    txn->state = TxnState::Proceeding;
+                    if (invite) {
+                        // 收到临时应答后INVITE不再重传
+                        cancel(txn, TimerKind::Retransmit);
+                    }
+                    handler = txn->on_response;
+                } else if (invite && code < 300) {
+                    // RFC 6026 Timer M：2xx重传继续交给TU去ACK
+                    txn->state = TxnState::Accepted;
+                    cancel(txn, TimerKind::Retransmit);
+                    schedule(txn, TimerKind::Timeout, 64 * cfg_.t1_ms);
+                    handler = txn->on_response;
+                } else if (invite) {
+                    // 非2xx：事务自己发ACK，Timer D内吸收应答重传
+                    SipMessageView request;
+                    if (SipMessageView::Parse(txn->wire.data(), txn->wire.size(), request) == SipMessageView::ParseResult::Ok) {
+                        build_ack(txn->ack, request, msg);
+                        queue_send(*transport_, txn->peer, txn->ack, actions.peers, actions.sends, actions.send_count);
+                    }
+                    txn->state = TxnState::Completed;
+                    handler = std::move(txn->on_response);
+                    cancel(txn, TimerKind::Timeout);
+                    finish_after(txn, std::max<int64_t>(64 * cfg_.t1_ms, 32000));
+                } else {
+                    // Timer K
+                    txn->state = TxnState::Completed;
+                    handler = std::move(txn->on_response);
+                    cancel(txn, TimerKind::Timeout);
+                    finish_after(txn, cfg_.t4_ms);
+                }
+                break;
+            case TxnState::Accepted:
+                if (code >= 200 && code < 300) {
+                    handler = txn->on_response;
+                } else {
+                    absorbed_.fetch_add(1, std::memory_order_relaxed);
+                }
+                break;
+            case TxnState::Completed:
+                if (invite && !txn->ack.empty()) {
+                    queue_send(*transport_, txn->peer, txn->ack, actions.peers, actions.sends, actions.send_count);
+                    retransmitted_.fetch_add(1, std::memory_order_relaxed);
+                }
+                absorbed_.fetch_add(1, std::memory_order_relaxed);
+                break;
+            default:
+                break;
+            }
+        }
+    }
+    run(actions);
+    if (stray) {
+        stray_responses_.fetch_add(1, std::memory_order_relaxed);
+        if (stray_handler_) {
+            stray_handler_(msg);
+        }
+        return;
+    }
+    if (handler) {
+        handler(&msg);
+    }
+}
+
+void SipTransactionLayer::on_timer(std::size_t shard_index, Transaction* txn, uint32_t generation, TimerKind kind) {
+    if (stopped_.load(std::memory_order_relaxed)) {
+        return;
+    }
+    Actions actions;
+    {
+        Shard& shard = *shards_[shard_index];
+        std::lock_guard<std::mutex> lock(shard.mtx);
+        // 事务对象只在本分片的表和复用池之间流转，持锁后读取是安全的
+        if (stopped_.load(std::memory_order_relaxed) || txn->generation != generation || txn->state == TxnState::Idle) {
+            return;
+        }
+        txn->timers[static_cast<int>(kind)] = 0;
+        if (kind == TimerKind::Retransmit) {
+            bool resend = false;
+            switch (txn->kind) {
+            case TxnKind::ClientInvite:
+                // Timer A：每次翻倍，直到Timer B
+                resend = txn->state == TxnState::Calling;
+                txn->interval_ms *= 2;
+                break;
+            case TxnKind::ClientNonInvite:
+                // Timer E：翻倍封顶T2，Proceeding后固定T2
+                resend = txn->state == TxnState::Trying || txn->state == TxnState::Proceeding;
+                txn->interval_ms = txn->state == TxnState::Proceeding ? cfg_.t2_ms
+                                                                      : std::min(txn->interval_ms * 2, cfg_.t2_ms);
+                break;
+            case TxnKind::ServerInvite:
+                // Timer G：重传非2xx最终应答，翻倍封顶T2
+                resend = txn->state == TxnState::Completed;
+                txn->interval_ms = std::min(txn->interval_ms * 2, cfg_.t2_ms);
+                break;
+            default:
+                break;
+            }
+            if (resend) {
+                queue_send(*transport_, txn->peer, txn->wire, actions.peers, actions.sends, actions.send_count);
+                retransmitted_.fetch_add(1, std::memory_order_relaxed);
+                schedule(txn, TimerKind::Retransmit, txn->interval_ms);
+            }
+        } else {
+            // Timer B/F：客户端事务超时要通知TU；H：ACK一直没来；其余是等待期结束
+            const bool waiting = txn->state == TxnState::Calling || txn->state == TxnState::Trying ||
+                                 txn->state == TxnState::Proceeding;
+            if (waiting || (txn->kind == TxnKind::ServerInvite && txn->state == TxnState::Completed)) {
+                timeouts_.fetch_add(1, std::memory_order_relaxed);
+            }
+            if (txn->client() && waiting) {
+                actions.notify = std::move(txn->on_response);
+                actions.notify_timeout = true;
+            }
+            release(txn);
+        }
+    }
+    run(actions);
+}
@@ -1,121 +1,551 @@
-#include "sip_transport.h"
-#include "stringhelper.h"
-// INVITE sip:34020000001320000001@3402000000 SIP/2.0
-// Via: SIP/2.0/TCP 192.168.1.10:5060;branch=z9hG4bK-123456
-// From: <sip:34020000002000000001@3402000000>;tag=1234
-// To: <sip:34020000001320000001@3402000000>
-// Call-ID: 987654321@192.168.1.10
-// CSeq: 1 INVITE
-// Content-Length: 129
-
-// v=0
-// o=34020000002000000001 0 0 IN IP4 192.168.1.10
-// s=Play
-// c=IN IP4 192.168.1.10
-// t=0 0
-// m=video 30000 RTP/AVP 96
-// a=rtpmap:96 PS/90000
-
-/// @brief SIP响应报文
-// SIP/2.0 100 Trying
-// Via: SIP/2.0/UDP pc33.atlanta.com;branch=z9hG4bK776asdhds
-// From: Alice <sip:alice@atlanta.com>;tag=1928301774
-// To: Bob <sip:bob@biloxi.com>
-// Call-ID: a84b4c76e66710@pc33.atlanta.com
-// CSeq: 314159 INVITE
-// Content-Length: 0
-
-SipMessage SipMessage::Parse(const std::string& data) {
-    SipMessage msg;
-    std::istringstream iss(data);
-    std::string line;
-
-    //解析首行
-    // INVITE sip:34020000001320000001@3402000000 SIP/2.0
-    if(!std::getline(iss, line)) {
-        throw std::runtime_error("SipMessage::Parse: SIP message is empty!");
-    }
-
-    line = StringHelper::trim(line);
-    if(line.empty()) {
-        throw std::runtime_error("SipMessage::Parse: SIP message first line is empty!");
-    }
-
-    if(line.find("SIP/") == 0) {
-        // 响应报文 SIP/2.0 100 Trying
-        size_t sp1 = line.find(' ');
-        size_t sp2 = line.find(' ', sp1 + 1);
-        if(sp1 == std::string::npos || sp2 == std::string::npos) {
-            throw std::runtime_error("SipMessage::Parse: Invalid SIP response start line");
-        }
-        msg.version_ = line.substr(0, sp1);
+#include "sip/sip_transport.h"
+#include <algorithm>
+#include <cstring>
+#include <deque>
+#include <stdexcept>
+
+/************************************SipTransport***********************************/
+SipTransport::~SipTransport() {
+    stop_taps();
+}
+
+void SipTransport::SetTapHandler(MessageHandler handler) {
+    std::lock_guard<std::mutex> lock(tap_mtx_);
+    tap_handlers_.push_back(std::move(handler));
+    if (!tap_queue_) {
+        tap_queue_ = std::make_unique<BoundMPMCQueue<SipMessageView>>(kTapQueueCapacity);
+        // 一个进程里可能有多个传输层，按创建顺序编号区分
+        static std::atomic<uint64_t> next_instance{0};
+        tap_metrics_ = MetricsRegistry::getInstance().RegisterQueue("sip_tap", *tap_queue_,
+            {{"instance", std::to_string(next_instance.fetch_add(1, std::memory_order_relaxed))}});
+        tap_thread_ = std::thread([this]() { tap_loop(); });
+        tap_active_.store(true, std::memory_order_release);
+    }
+}
+
+void SipTransport::stop_taps() {
+    {
+        std::lock_guard<std::mutex> lock(tap_mtx_);
+        if (!tap_queue_) {
+            return;
+        }
+        tap_active_.store(false, std::memory_order_release);
+        // 队列本身留到析构，收包线程可能还在post_tap里
+        tap_queue_->stop();
+    }
+    if (tap_thread_.joinable()) {
+        tap_thread_.join();
+    }
+}
+
+void SipTransport::post_tap(const SipMessageView& msg) {
+    // 收包线程上只拷贝一次报文，监听在tap线程上执行
+    SipMessageView copy = msg;
+    copy.Retain();
+    // 不等待：队列满说明监听跟不上，丢掉这条
+    if (!tap_queue_->try_enqueue(std::move(copy))) {
+        tap_dropped_.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+void SipTransport::tap_loop() {
+    SipMessageView msg;
+    while (true) {
         try {
-            msg.status_code_ = std::stoi(line.substr(sp1 + 1, sp2 - sp1 - 1));
-        } catch (const std::exception& e) {
-            throw std::runtime_error("SipMessage::Parse: Invalid SIP response start line");
+            if (!tap_queue_->dequeue_for(msg, std::chrono::milliseconds(100))) {
+                if (!tap_active_.load(std::memory_order_acquire)) {
+                    return;
+                }
+                continue;
+            }
+        } catch (const std::exception&) {
+            return;
         }
-        msg.reason_ = StringHelper::trim(line.substr(sp2 + 1));
+        std::lock_guard<std::mutex> lock(tap_mtx_);
+        for (auto& h : tap_handlers_) {
+            if (h) {
+                try {
+                    h(msg);
+                } catch (const std::exception&) {
+                    // 监听出错不影响其他监听
+                }
+            }
+        }
+    }
+}
+
+void SipTransport::Send(const SipMessage& msg) {
+    const auto& remote = msg.remote();
+    boost::system::error_code ec;
+    auto addr = boost::asio::ip::make_address(remote.ip, ec);
+    if (ec || remote.port == 0) {
+        return;
     }
+    Buffer buffer = pool_.Acquire();
+    msg.SerializeInto(*buffer);
+    // Peer::protocol只指向字面量，跨异步发送保存也安全
+    const char* protocol = remote.protocol == "TCP" ? "TCP" : "UDP";
+    SendBuffer(Peer{protocol, addr, remote.port}, std::move(buffer));
+}
+
+bool SipTransport::SendResponse(const SipMessageView& request, int status_code, StringView reason,
+                                const SipResponseOptions& opts) {
+    Buffer buffer = pool_.Acquire();
+    request.SerializeResponse(status_code, reason, *buffer, opts);
+    return SendBuffer(request.peer(), std::move(buffer));
+}
 
+/************************************UdpSipTransport***********************************/
+net::UdpBatchSocket::Config UdpSipTransport::socketConfig() {
+    net::UdpBatchSocket::Config cfg;
+    cfg.batch = 32;
+    // RFC 3261 18.1.1: 超过MTU的请求应走TCP，这里留足余量接收IP分片重组后的大包
+    cfg.datagram_size = 8192;
+    cfg.enable_gso = false;
+    return cfg;
+}
 
-    bool first_line = true;
-    bool in_body = false;
+UdpSipTransport::UdpSipTransport(ASIO::IoContext& ctx, const std::string& listen_ip, uint16_t port) {
+    Config cfg;
+    cfg.listen_ip = listen_ip;
+    cfg.port = port;
+    open_sockets({ctx.get_executor()}, cfg);
+}
 
-    while (std::getline(iss, line)) {
-        if (!line.empty() && line.back() == '\r') line.pop_back();
+UdpSipTransport::UdpSipTransport(ASIO::IoContext& ctx, const Config& cfg) {
+    std::size_t n = cfg.sockets ? cfg.sockets : std::max(1u, std::thread::hardware_concurrency());
+    std::vector<boost::asio::any_io_executor> executors;
+    for (std::size_t i = 0; i < n; ++i) {
+        executors.emplace_back(boost::asio::make_strand(ctx));
+    }
+    open_sockets(executors, cfg);
+}
 
-        if (first_line) {
-            first_line = false;
-            std::istringstream ls(line);
-            std::string first_word;
-            ls >> first_word;
+UdpSipTransport::UdpSipTransport(const std::vector<ASIO::IoContext*>& reactors, const Config& cfg) {
+    if (reactors.empty()) {
+        throw std::invalid_argument("UdpSipTransport: no reactor");
+    }
+    std::size_t n = cfg.sockets ? cfg.sockets : reactors.size();
+    std::vector<boost::asio::any_io_executor> executors;
+    for (std::size_t i = 0; i < n; ++i) {
+        executors.emplace_back(reactors[i % reactors.size()]->get_executor());
+    }
+    open_sockets(executors, cfg);
+}
 
-            if (first_word.rfind("SIP/", 0) == 0) {
-                msg.version_ = first_word;
-                ls >> msg.status_code_;
-                std::getline(ls, msg.reason_);
-                if (!msg.reason_.empty() && msg.reason_[0] == ' ')
-                    msg.reason_.erase(0, 1);
-            } else {
-                msg.method_ = first_word;
-                ls >> msg.uri_ >> msg.version_;
-            }
+UdpSipTransport::~UdpSipTransport() {
+    stop_taps();
+}
+
+void UdpSipTransport::open_sockets(const std::vector<boost::asio::any_io_executor>& executors, const Config& cfg) {
+    net::UdpBatchSocket::Config sock_cfg = socketConfig();
+    sock_cfg.reuse_port = executors.size() > 1;
+    sock_cfg.recv_buffer = cfg.recv_buffer;
+    ASIO::UdpEndpoint local(boost::asio::ip::make_address(cfg.listen_ip), cfg.port);
+    for (const auto& executor : executors) {
+        sockets_.push_back(std::make_unique<net::UdpBatchSocket>(executor, local, sock_cfg));
+        if (local.port() == 0) {
+            local.port(sockets_.front()->local_endpoint().port());
+        }
+    }
+}
+
+void UdpSipTransport::Start() {
+    for (auto& socket : sockets_) {
+        socket->StartReceive([this](const net::UdpDatagram* dgrams, size_t count) {
+            onDatagrams(dgrams, count);
+        });
+    }
+}
+
+void UdpSipTransport::Stop() {
+    for (auto& socket : sockets_) {
+        socket->Close();
+    }
+}
+
+bool UdpSipTransport::SendBuffer(const Peer& to, Buffer buffer) {
+    if (!buffer || to.port == 0) {
+        return false;
+    }
+    // 按目的地址固定用一个socket发送，和接收侧的分流一样保持同一对端的顺序
+    std::size_t index = 0;
+    if (sockets_.size() > 1) {
+        std::size_t h = to.address.is_v4() ? to.address.to_v4().to_uint()
+                                           : std::hash<std::string>()(to.address.to_string());
+        index = (h * 31 + to.port) % sockets_.size();
+    }
+    // 同步发送，返回后缓冲随句柄析构归还
+    return sockets_[index]->SendTo(ASIO::UdpEndpoint(to.address, to.port), buffer->data(), buffer->size());
+}
+
+void UdpSipTransport::onDatagrams(const net::UdpDatagram* dgrams, size_t count) {
+    // 视图直接指向收包缓冲，整批复用同一个对象，常见消息解析时不分配内存
+    SipMessageView msg;
+    for (size_t i = 0; i < count; ++i) {
+        const auto& d = dgrams[i];
+        // 保活用的CRLF和截断报文直接丢弃
+        if (d.truncated || d.size < 4) {
             continue;
         }
+        if (SipMessageView::Parse(reinterpret_cast<const char*>(d.data), d.size, msg) != SipMessageView::ParseResult::Ok) {
+            continue;
+        }
+        msg.set_peer(SipMessageView::Peer{"UDP", d.from.address(), d.from.port()});
+        try {
+            dispatch_message(msg);
+        } catch (const std::exception&) {
+            // 非法报文不影响同批其他消息
+        }
+    }
+}
+
+/************************************TcpSipTransport***********************************/
+namespace {
+    constexpr int64_t kTimerTickMs = 100;
+}
+
+/// @brief 单条SIP TCP连接：读缓冲就地切分消息，写队列批量写出
+/// @details 所有状态只在连接的strand上访问；Send/Close可在任意线程调用
+class TcpSipConnection : public std::enable_shared_from_this<TcpSipConnection> {
+public:
+    using Buffer = SipTransport::Buffer;
+
+    TcpSipConnection(ASIO::TcpSocket socket, std::shared_ptr<TcpSipTransport> transport,
+                     const ASIO::TcpEndpoint& remote, bool connected)
+        : socket_(std::move(socket)), transport_(std::move(transport)), remote_(remote),
+          peer_{"TCP", remote.address(), remote.port()}, connected_(connected) {
+        buf_.resize(std::max<std::size_t>(transport_->config().read_buffer_size, 512));
+    }
+
+    /// @brief 已连接（accept得到）的连接开始收发
+    void Start() {
+        boost::asio::post(socket_.get_executor(), [self = shared_from_this()]() {
+            self->touch();
+            self->arm_timer(self->idle_timeout_ms());
+            self->do_read();
+        });
+    }
+
+    /// @brief 主动连接，连上之前Send的消息排队
+    void Connect() {
+        boost::asio::post(socket_.get_executor(), [self = shared_from_this()]() {
+            self->touch();
+            self->arm_timer(std::max<int64_t>(1, self->transport_->config().connect_timeout_ms));
+            self->socket_.async_connect(self->remote_, [self](const boost::system::error_code& ec) {
+                if (self->closed_) {
+                    return;
+                }
+                if (ec) {
+                    self->close();
+                    return;
+                }
+                boost::system::error_code opt_ec;
+                self->socket_.set_option(boost::asio::ip::tcp::no_delay(true), opt_ec);
+                self->connected_ = true;
+                self->touch();
+                self->do_read();
+                self->do_write();
+            });
+        });
+    }
+
+    void Send(Buffer buffer) {
+        boost::asio::post(socket_.get_executor(), [self = shared_from_this(), buffer = std::move(buffer)]() mutable {
+            self->enqueue(std::move(buffer));
+        });
+    }
+
+    void Close() {
+        boost::asio::post(socket_.get_executor(), [self = shared_from_this()]() {
+            self->close();
+        });
+    }
+
+private:
+    int64_t idle_timeout_ms() const {
+        return std::max<int64_t>(1, transport_->config().idle_timeout_ms);
+    }
+
+    void touch() {
+        last_active_ms_ = net::AsioTimerWheel::now_ms();
+    }
+
+    void do_read() {
+        if (closed_) {
+            return;
+        }
+        socket_.async_read_some(boost::asio::buffer(buf_.data() + used_, buf_.size() - used_),
+            [self = shared_from_this()](const boost::system::error_code& ec, std::size_t n) {
+                if (ec || self->closed_) {
+                    self->close();
+                    return;
+                }
+                self->used_ += n;
+                self->touch();
+                if (self->process()) {
+                    self->do_read();
+                } else {
+                    self->close();
+                }
+            });
+    }
 
-        if (!in_body) {
-            if (line.empty()) {
-                in_body = true;
+    /// @return false时关闭连接
+    bool process() {
+        std::size_t off = 0;
+        while (off < used_ && !closed_) {
+            const char* data = buf_.data() + off;
+            std::size_t avail = used_ - off;
+            if (data[0] == '\r' || data[0] == '\n') {
+                // RFC 5626 4.4.1: 双CRLF保活回单个CRLF；消息之间零散的CRLF直接跳过
+                static const char kPing[] = "\r\n\r\n";
+                if (avail >= 4 && std::memcmp(data, kPing, 4) == 0) {
+                    pong();
+                    off += 4;
+                } else if (avail < 4 && std::memcmp(data, kPing, avail) == 0) {
+                    break;
+                } else {
+                    ++off;
+                }
                 continue;
             }
-            auto pos = line.find(':');
-            if (pos != std::string::npos) {
-                std::string key = line.substr(0, pos);
-                std::string value = line.substr(pos + 1);
-                if (!value.empty() && value[0] == ' ')
-                    value.erase(0, 1);
-                msg.headers_[key] = value;
+            std::size_t consumed = 0;
+            auto r = SipMessageView::Parse(data, avail, msg_, &consumed, true);
+            if (r == SipMessageView::ParseResult::Incomplete) {
+                break;
             }
-        } else {
-            msg.body_ += line + "\n";
+            if (r == SipMessageView::ParseResult::Error) {
+                return false;
+            }
+            off += consumed;
+            msg_.set_peer(peer_);
+            try {
+                transport_->on_message(msg_);
+            } catch (const std::exception&) {
+                // 上层处理异常不影响连接上后续的消息
+            }
+        }
+        if (off > 0) {
+            // 只有不完整的尾部需要挪动
+            std::memmove(buf_.data(), buf_.data() + off, used_ - off);
+            used_ -= off;
+        }
+        if (used_ == buf_.size()) {
+            const std::size_t max = transport_->config().max_message_size;
+            if (buf_.size() >= max) {
+                return false;
+            }
+            buf_.resize(std::min(buf_.size() * 2, max));
+        }
+        return !closed_;
+    }
+
+    void pong() {
+        Buffer buffer = transport_->buffer_pool().Acquire();
+        buffer->assign("\r\n", 2);
+        enqueue(std::move(buffer));
+    }
+
+    void enqueue(Buffer buffer) {
+        if (closed_ || !buffer || buffer->empty()) {
+            return;
+        }
+        pending_.push_back(std::move(buffer));
+        if (pending_.size() > transport_->config().max_write_queue) {
+            close();
+            return;
+        }
+        do_write();
+    }
+
+    void do_write() {
+        if (closed_ || !connected_ || !writing_.empty() || pending_.empty()) {
+            return;
+        }
+        // 排队的消息一次gather写出
+        iov_.clear();
+        while (!pending_.empty()) {
+            writing_.push_back(std::move(pending_.front()));
+            pending_.pop_front();
+            iov_.emplace_back(writing_.back()->data(), writing_.back()->size());
+        }
+        boost::asio::async_write(socket_, iov_,
+            [self = shared_from_this()](const boost::system::error_code& ec, std::size_t) {
+                // 写完才能归还缓冲，关闭时也要等到这里
+                self->writing_.clear();
+                if (ec || self->closed_) {
+                    self->close();
+                    return;
+                }
+                self->touch();
+                self->do_write();
+            });
+    }
+
+    void arm_timer(int64_t delay_ms) {
+        timer_id_ = transport_->timers().Schedule(delay_ms, [weak = weak_from_this()]() {
+            if (auto self = weak.lock()) {
+                boost::asio::post(self->socket_.get_executor(), [self]() {
+                    self->on_timer();
+                });
+            }
+        });
+    }
+
+    void on_timer() {
+        if (closed_) {
+            return;
         }
+        const int64_t timeout = connected_ ? idle_timeout_ms() : transport_->config().connect_timeout_ms;
+        const int64_t idle = net::AsioTimerWheel::now_ms() - last_active_ms_;
+        if (idle >= timeout) {
+            close();
+            return;
+        }
+        // 期间有收发就按剩余时间重挂，不在每次收发时改动时间轮
+        arm_timer(timeout - idle + 1);
+    }
+
+    void close() {
+        if (closed_) {
+            return;
+        }
+        closed_ = true;
+        transport_->timers().Cancel(timer_id_);
+        pending_.clear();
+        boost::system::error_code ec;
+        socket_.shutdown(boost::asio::ip::tcp::socket::shutdown_both, ec);
+        socket_.close(ec);
+        transport_->remove(remote_, this);
+    }
+
+    ASIO::TcpSocket socket_;
+    std::shared_ptr<TcpSipTransport> transport_;
+    ASIO::TcpEndpoint remote_;
+    SipMessageView::Peer peer_;
+    bool connected_;
+    bool closed_ = false;
+    int64_t last_active_ms_ = 0;
+    net::AsioTimerWheel::TimerId timer_id_ = 0;
+
+    std::vector<char> buf_;
+    std::size_t used_ = 0;
+    /// @brief 复用的解析结果，视图指向buf_
+    SipMessageView msg_;
+
+    std::deque<Buffer> pending_;
+    std::vector<Buffer> writing_;
+    std::vector<boost::asio::const_buffer> iov_;
+};
+
+TcpSipTransport::TcpSipTransport(ASIO::IoContext& io, const Config& cfg, std::shared_ptr<net::AsioTimerWheel> timers)
+    : io_(io), cfg_(cfg),
+      acceptor_(io, ASIO::TcpEndpoint(boost::asio::ip::make_address(cfg.listen_ip), cfg.port)),
+      timers_(timers ? timers : std::make_shared<net::AsioTimerWheel>(io, TimerWheel::Config{kTimerTickMs})),
+      own_timers_(!timers) {
+
+}
+
+TcpSipTransport::~TcpSipTransport() {
+    stop_taps();
+    boost::system::error_code ec;
+    acceptor_.close(ec);
+}
+
+void TcpSipTransport::Start() {
+    do_accept();
+}
+
+void TcpSipTransport::Stop() {
+    boost::system::error_code ec;
+    acceptor_.close(ec);
+    std::map<ASIO::TcpEndpoint, std::shared_ptr<TcpSipConnection>> connections;
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        stopped_ = true;
+        connections.swap(connections_);
     }
-    return msg;
+    for (auto& kv : connections) {
+        kv.second->Close();
+    }
+    if (own_timers_) {
+        timers_->Stop();
+    }
+}
+
+void TcpSipTransport::do_accept() {
+    acceptor_.async_accept(boost::asio::make_strand(io_),
+        [self = shared_from_this()](const boost::system::error_code& ec, ASIO::TcpSocket socket) {
+            if (!self->acceptor_.is_open()) {
+                return;
+            }
+            if (!ec) {
+                boost::system::error_code opt_ec;
+                socket.set_option(boost::asio::ip::tcp::no_delay(true), opt_ec);
+                ASIO::TcpEndpoint remote = socket.remote_endpoint(opt_ec);
+                if (!opt_ec) {
+                    auto conn = std::make_shared<TcpSipConnection>(std::move(socket), self, remote, true);
+                    bool accepted = false;
+                    {
+                        std::lock_guard<std::mutex> lock(self->mtx_);
+                        if (!self->stopped_) {
+                            self->connections_[remote] = conn;
+                            accepted = true;
+                        }
+                    }
+                    if (accepted) {
+                        conn->Start();
+                    }
+                }
+            }
+            self->do_accept();
+        });
 }
 
-std::string SipMessage::ToString() const {
-    std::ostringstream oss;
-    if (!method_.empty()) {
-        oss << method_ << " " << uri_ << " " << version_ << "\r\n";
-    } else {
-        oss << version_ << " " << status_code_ << " " << reason_ << "\r\n";
+bool TcpSipTransport::SendBuffer(const Peer& to, Buffer buffer) {
+    if (!buffer || to.port == 0) {
+        return false;
+    }
+    ASIO::TcpEndpoint remote(to.address, to.port);
+    std::shared_ptr<TcpSipConnection> conn;
+    bool connect = false;
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        if (stopped_) {
+            return false;
+        }
+        auto it = connections_.find(remote);
+        if (it != connections_.end()) {
+            conn = it->second;
+        } else {
+            conn = std::make_shared<TcpSipConnection>(ASIO::TcpSocket(boost::asio::make_strand(io_)),
+                                                      shared_from_this(), remote, false);
+            connections_.emplace(remote, conn);
+            connect = true;
+        }
     }
+    if (connect) {
+        conn->Connect();
+    }
+    conn->Send(std::move(buffer));
+    return true;
+}
 
-    for (auto& [k, v] : headers_) {
-        oss << k << ": " << v << "\r\n";
+void TcpSipTransport::remove(const ASIO::TcpEndpoint& remote, const TcpSipConnection* conn) {
+    std::lock_guard<std::mutex> lock(mtx_);
+    auto it = connections_.find(remote);
+    if (it != connections_.end() && it->second.get() == conn) {
+        connections_.erase(it);
     }
-    oss << "Content-Length: " << body_.size() << "\r\n";
-    oss << "\r\n";
-    oss << body_;
-    return oss.str();
+}
+
+ASIO::TcpEndpoint TcpSipTransport::local_endpoint() const {
+    boost::system::error_code ec;
+    return acceptor_.local_endpoint(ec);
+}
+
+std::size_t TcpSipTransport::connection_count() const {
+    std::lock_guard<std::mutex> lock(mtx_);
+    return connections_.size();
 }
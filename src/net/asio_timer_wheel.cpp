@@ -0,0 +1,129 @@
+#include "asio_timer_wheel.h"
+#include <chrono>
+
+namespace net {
+
+AsioTimerWheel::AsioTimerWheel(ASIO::IoContext& io) : AsioTimerWheel(io, TimerWheel::Config{}) {
+
+}
+
+AsioTimerWheel::AsioTimerWheel(ASIO::IoContext& io, const TimerWheel::Config& cfg)
+    : strand_(boost::asio::make_strand(io)), timer_(strand_), wheel_(cfg, now_ms()) {
+
+}
+
+int64_t AsioTimerWheel::now_ms() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void AsioTimerWheel::kick_locked(bool& start) {
+    if (armed_ || stopped_) {
+        return;
+    }
+    // 空闲期间轮没有推进，先对齐到当前时间，否则新定时器会按旧的tick提前到期
+    wheel_.Advance(now_ms(), expired_);
+    armed_ = true;
+    start = true;
+}
+
+AsioTimerWheel::TimerId AsioTimerWheel::Schedule(int64_t delay_ms, Callback cb) {
+    bool start = false;
+    TimerId id;
+    int64_t at_ms;
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        if (stopped_) {
+            return 0;
+        }
+        kick_locked(start);
+        id = wheel_.Schedule(delay_ms, std::move(cb));
+        at_ms = wheel_.next_tick_ms();
+    }
+    if (start) {
+        boost::asio::post(strand_, [self = shared_from_this(), at_ms]() {
+            self->arm(at_ms);
+        });
+    }
+    return id;
+}
+
+bool AsioTimerWheel::Cancel(TimerId id) {
+    std::lock_guard<std::mutex> lock(mtx_);
+    return wheel_.Cancel(id);
+}
+
+bool AsioTimerWheel::Reschedule(TimerId id, int64_t delay_ms) {
+    std::lock_guard<std::mutex> lock(mtx_);
+    return wheel_.Reschedule(id, delay_ms);
+}
+
+void AsioTimerWheel::Stop() {
+    TimerWheel::Config cfg;
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        stopped_ = true;
+        cfg.tick_ms = wheel_.tick_ms();
+    }
+    boost::asio::post(strand_, [self = shared_from_this(), cfg]() {
+        self->timer_.cancel();
+        // 回调在锁外析构，回调持有的对象析构时可能再调用Cancel
+        TimerWheel dropped(cfg, 0);
+        {
+            std::lock_guard<std::mutex> lock(self->mtx_);
+            std::swap(self->wheel_, dropped);
+        }
+    });
+}
+
+std::size_t AsioTimerWheel::size() const {
+    std::lock_guard<std::mutex> lock(mtx_);
+    return wheel_.size();
+}
+
+void AsioTimerWheel::arm(int64_t at_ms) {
+    timer_.expires_at(std::chrono::steady_clock::time_point(std::chrono::milliseconds(at_ms)));
+    timer_.async_wait([self = shared_from_this()](const boost::system::error_code& ec) {
+        if (ec) {
+            return;
+        }
+        self->on_tick();
+    });
+}
+
+void AsioTimerWheel::on_tick() {
+    std::vector<Callback> batch;
+    int64_t next_ms = 0;
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        if (stopped_) {
+            armed_ = false;
+            return;
+        }
+        batch.swap(expired_);
+        wheel_.Advance(now_ms(), batch);
+        // 轮空了就停表，下一次Schedule重新启动
+        armed_ = !wheel_.empty();
+        next_ms = wheel_.next_tick_ms();
+    }
+    for (Callback& cb : batch) {
+        if (cb) {
+            cb();
+        }
+    }
+    batch.clear();
+    bool rearm = false;
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        if (expired_.capacity() < batch.capacity()) {
+            expired_.swap(batch);
+        }
+        // 回调中新加的定时器可能已经让armed_变为true并post了arm，这里只在仍由本次驱动负责时继续
+        rearm = armed_ && !stopped_;
+    }
+    if (rearm) {
+        arm(next_ms);
+    }
+}
+
+}
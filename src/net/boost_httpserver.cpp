@@ -1,4 +1,6 @@
 #include "boost_httpserver.h"
+#include "httpconnection.h"
+#include "metrics.h"
 #include <boost/beast.hpp>
 BoostHttpServer::BoostHttpServer(boost::asio::io_context& io, uint16_t port) : HttpServerBase(port), io_(io), 
     acceptor_(io, tcp::endpoint(tcp::v4(), port)), socket_(io) {
@@ -12,6 +14,10 @@ BoostHttpServer::~BoostHttpServer() {
 void BoostHttpServer::start() {
     auto self = shared_from_this();
     acceptor_.async_accept(socket_, [self](boost::beast::error_code ec) {
+        if (!self->acceptor_.is_open()) {
+            // 已stop
+            return;
+        }
         try{
             if (ec) {
                 // 出错则放弃该连接
@@ -20,7 +26,7 @@ void BoostHttpServer::start() {
             }
 
             // 成功接受连接，创建HttpConnection处理请求
-            // std::make_shared<HttpConnection>(std::move(self->socket_), self->handler_)->start();
+            std::make_shared<HttpConnection>(std::move(self->socket_), self)->start();
             //继续监听
             self->start();
         }
@@ -36,3 +42,18 @@ void BoostHttpServer::stop() {
     acceptor_.close(ec); // 关闭监听器，停止接受新连接
     socket_.close(ec);   // 关闭当前socket连接
 }
+
+void BoostHttpServer::EnableMetrics(const std::string& path) {
+    AddRoute(path, [](const HttpRequest& req, HttpResponse& resp) {
+        auto& registry = MetricsRegistry::getInstance();
+        bool json = req.query.find("format=json") != std::string::npos
+                 || req.accept.find("application/json") != std::string::npos;
+        if (json) {
+            resp.content_type = "application/json";
+            resp.body = registry.RenderJson();
+        } else {
+            resp.content_type = "text/plain; version=0.0.4; charset=utf-8";
+            resp.body = registry.RenderPrometheus();
+        }
+    });
+}
@@ -0,0 +1,78 @@
+#include "httpconnection.h"
+#include <chrono>
+
+namespace http = boost::beast::http;
+
+HttpConnection::HttpConnection(boost::asio::ip::tcp::socket socket, std::shared_ptr<const HttpServerBase> server)
+    : stream_(std::move(socket)), server_(std::move(server)) {
+
+}
+
+void HttpConnection::start() {
+    do_read();
+}
+
+void HttpConnection::do_read() {
+    req_ = {};
+    // 防止慢客户端长期占用连接
+    stream_.expires_after(std::chrono::seconds(30));
+    auto self = shared_from_this();
+    http::async_read(stream_, buffer_, req_, [self](boost::beast::error_code ec, std::size_t) {
+        self->on_read(ec);
+    });
+}
+
+void HttpConnection::on_read(boost::beast::error_code ec) {
+    if (ec) {
+        close();
+        return;
+    }
+
+    HttpRequest req;
+    req.method = std::string(req_.method_string());
+    req.uri = std::string(req_.target());
+    auto qpos = req.uri.find('?');
+    req.path = req.uri.substr(0, qpos);
+    if (qpos != std::string::npos) {
+        req.query = req.uri.substr(qpos + 1);
+    }
+    auto accept = req_.find(http::field::accept);
+    if (accept != req_.end()) {
+        req.accept = std::string(accept->value());
+    }
+    req.body = std::move(req_.body());
+
+    HttpResponse resp;
+    try {
+        server_->Dispatch(req, resp);
+    } catch (const std::exception& e) {
+        resp.status_code = 500;
+        resp.body = e.what();
+    }
+
+    resp_ = {};
+    resp_.version(req_.version());
+    resp_.result(static_cast<http::status>(resp.status_code));
+    resp_.set(http::field::server, "media");
+    resp_.set(http::field::content_type, resp.content_type);
+    resp_.keep_alive(req_.keep_alive());
+    resp_.body() = std::move(resp.body);
+    resp_.prepare_payload();
+    do_write();
+}
+
+void HttpConnection::do_write() {
+    auto self = shared_from_this();
+    http::async_write(stream_, resp_, [self](boost::beast::error_code ec, std::size_t) {
+        if (ec || !self->resp_.keep_alive()) {
+            self->close();
+            return;
+        }
+        self->do_read();
+    });
+}
+
+void HttpConnection::close() {
+    boost::beast::error_code ec;
+    stream_.socket().shutdown(boost::asio::ip::tcp::socket::shutdown_send, ec);
+}
@@ -0,0 +1,312 @@
+#include "udp_batch_socket.h"
+#include <cerrno>
+#include <cstring>
+#include <netinet/in.h>
+#include <netinet/udp.h>
+
+#ifndef SOL_UDP
+#define SOL_UDP 17
+#endif
+#ifndef UDP_SEGMENT
+#define UDP_SEGMENT 103
+#endif
+
+namespace net {
+
+namespace {
+    /// @brief 单个GSO超级包最多的分段数（UDP_MAX_SEGMENTS）
+    constexpr size_t kMaxGsoSegments = 64;
+    /// @brief 单个GSO超级包的负载上限，留出IP/UDP头
+    constexpr size_t kMaxGsoBytes = 65000;
+    /// @brief 每条消息平均可用的iovec数
+    constexpr size_t kIovPerMessage = 32;
+
+    size_t datagram_size(const UdpOutDatagram& d) {
+        size_t len = 0;
+        for (size_t i = 0; i < d.iov_cnt; ++i) {
+            len += d.iov[i].iov_len;
+        }
+        return len;
+    }
+}
+
+UdpBatchSocket::UdpBatchSocket(ASIO::IoContext& ctx, const ASIO::UdpEndpoint& local)
+    : UdpBatchSocket(ctx, local, Config{}) {
+
+}
+
+UdpBatchSocket::UdpBatchSocket(ASIO::IoContext& ctx, const ASIO::UdpEndpoint& local, const Config& cfg)
+    : UdpBatchSocket(ctx.get_executor(), local, cfg) {
+
+}
+
+UdpBatchSocket::UdpBatchSocket(const boost::asio::any_io_executor& executor, const ASIO::UdpEndpoint& local, const Config& cfg)
+    : cfg_(cfg), socket_(executor) {
+    if (cfg_.batch == 0) {
+        cfg_.batch = 1;
+    }
+    socket_.open(local.protocol());
+    int fd = socket_.native_handle();
+    if (cfg_.reuse_port) {
+        socket_.set_option(boost::asio::socket_base::reuse_address(true));
+        int one = 1;
+        ::setsockopt(fd, SOL_SOCKET, SO_REUSEPORT, &one, sizeof(one));
+    }
+    if (cfg_.recv_buffer > 0) {
+        socket_.set_option(boost::asio::socket_base::receive_buffer_size(cfg_.recv_buffer));
+    }
+    if (cfg_.send_buffer > 0) {
+        socket_.set_option(boost::asio::socket_base::send_buffer_size(cfg_.send_buffer));
+    }
+    socket_.bind(local);
+    socket_.non_blocking(true);
+
+    if (cfg_.enable_gso) {
+        // 能读到该选项说明内核支持UDP GSO（4.18+）
+        int seg = 0;
+        socklen_t len = sizeof(seg);
+        gso_ = ::getsockopt(fd, SOL_UDP, UDP_SEGMENT, &seg, &len) == 0;
+    }
+
+    // 接收slab：每个数据报一个固定槽位
+    slab_.resize(cfg_.batch * cfg_.datagram_size);
+    recv_msgs_.resize(cfg_.batch);
+    recv_iov_.resize(cfg_.batch);
+    recv_addrs_.resize(cfg_.batch);
+    datagrams_.resize(cfg_.batch);
+    for (size_t i = 0; i < cfg_.batch; ++i) {
+        recv_iov_[i].iov_base = slab_.data() + i * cfg_.datagram_size;
+        recv_iov_[i].iov_len = cfg_.datagram_size;
+        std::memset(&recv_msgs_[i], 0, sizeof(mmsghdr));
+        recv_msgs_[i].msg_hdr.msg_iov = &recv_iov_[i];
+        recv_msgs_[i].msg_hdr.msg_iovlen = 1;
+        recv_msgs_[i].msg_hdr.msg_name = &recv_addrs_[i];
+    }
+
+    send_msgs_.resize(cfg_.batch);
+    send_iov_.resize(cfg_.batch * kIovPerMessage);
+    send_cmsg_.resize(cfg_.batch * CMSG_SPACE(sizeof(uint16_t)));
+    send_counts_.resize(cfg_.batch);
+}
+
+UdpBatchSocket::~UdpBatchSocket() {
+    Close();
+}
+
+void UdpBatchSocket::StartReceive(BatchHandler handler) {
+    StartReceive(std::move(handler), boost::asio::any_io_executor());
+}
+
+void UdpBatchSocket::StartReceive(BatchHandler handler, const boost::asio::any_io_executor& executor) {
+    handler_ = std::move(handler);
+    handler_executor_ = executor;
+    receive_generation_.fetch_add(1, std::memory_order_acq_rel);
+    receiving_ = true;
+    arm();
+}
+
+void UdpBatchSocket::StopReceive() {
+    receiving_ = false;
+    receive_generation_.fetch_add(1, std::memory_order_acq_rel);
+    handler_ = nullptr;
+    boost::system::error_code ec;
+    socket_.cancel(ec);
+}
+
+void UdpBatchSocket::StopReceive(std::function<void()> on_stopped) {
+    StopReceive();
+    if (wait_state_->pending == 0) {
+        boost::asio::post(handler_executor_ ? handler_executor_ : socket_.get_executor(), std::move(on_stopped));
+        return;
+    }
+    // 被cancel的等待以operation_aborted完成，最后一个完成时调用
+    wait_state_->on_stopped = std::move(on_stopped);
+}
+
+void UdpBatchSocket::arm() {
+    // 调用方需保证对象在io_context停止或Close之后才析构，或用StopReceive(on_stopped)等等待全部完成
+    const uint64_t generation = receive_generation_.load(std::memory_order_acquire);
+    ++wait_state_->pending;
+    auto on_wait = [this, state = wait_state_, generation](const boost::system::error_code& ec) {
+        if (--state->pending == 0 && state->on_stopped) {
+            // 回调里可能析构本socket，之后不能再访问成员
+            auto on_stopped = std::move(state->on_stopped);
+            state->on_stopped = nullptr;
+            on_stopped();
+            return;
+        }
+        if (ec) {
+            return;
+        }
+        on_readable(generation);
+    };
+    if (handler_executor_) {
+        socket_.async_wait(ASIO::UdpSocket::wait_read, boost::asio::bind_executor(handler_executor_, std::move(on_wait)));
+    } else {
+        socket_.async_wait(ASIO::UdpSocket::wait_read, std::move(on_wait));
+    }
+}
+
+void UdpBatchSocket::on_readable(uint64_t generation) {
+    // StopReceive之后（可能已交给别的会话）才完成的等待
+    if (generation != receive_generation_.load(std::memory_order_acquire)) {
+        return;
+    }
+    for (size_t round = 0; round < cfg_.max_batches_per_wakeup; ++round) {
+        int n = ReceiveBatch();
+        if (n <= 0) {
+            break;
+        }
+        if (handler_) {
+            handler_(datagrams_.data(), static_cast<size_t>(n));
+        }
+        if (static_cast<size_t>(n) < cfg_.batch) {
+            break;
+        }
+    }
+    if (receiving_ && socket_.is_open() && generation == receive_generation_.load(std::memory_order_acquire)) {
+        arm();
+    }
+}
+
+int UdpBatchSocket::ReceiveBatch() {
+    for (size_t i = 0; i < cfg_.batch; ++i) {
+        recv_msgs_[i].msg_hdr.msg_namelen = sizeof(sockaddr_storage);
+        recv_msgs_[i].msg_hdr.msg_flags = 0;
+    }
+    int n = ::recvmmsg(socket_.native_handle(), recv_msgs_.data(), static_cast<unsigned>(cfg_.batch), MSG_DONTWAIT, nullptr);
+    if (n < 0) {
+        return (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) ? 0 : -1;
+    }
+    for (int i = 0; i < n; ++i) {
+        UdpDatagram& d = datagrams_[i];
+        const msghdr& hdr = recv_msgs_[i].msg_hdr;
+        d.data = static_cast<const uint8_t*>(recv_iov_[i].iov_base);
+        d.size = recv_msgs_[i].msg_len;
+        d.truncated = (hdr.msg_flags & MSG_TRUNC) != 0;
+        std::memcpy(d.from.data(), &recv_addrs_[i], hdr.msg_namelen);
+        d.from.resize(hdr.msg_namelen);
+    }
+    return n;
+}
+
+size_t UdpBatchSocket::build_message(const ASIO::UdpEndpoint& to, const UdpOutDatagram* dgrams, size_t count, size_t msg_index) {
+    mmsghdr& m = send_msgs_[msg_index];
+    std::memset(&m, 0, sizeof(m));
+    m.msg_hdr.msg_name = const_cast<sockaddr*>(to.data());
+    m.msg_hdr.msg_namelen = static_cast<socklen_t>(to.size());
+
+    const size_t iov_start = send_iov_used_;
+    const size_t seg = datagram_size(dgrams[0]);
+    size_t n = 0;
+    size_t bytes = 0;
+    while (n < count) {
+        const UdpOutDatagram& d = dgrams[n];
+        size_t len = n == 0 ? seg : datagram_size(d);
+        if (n > 0) {
+            // GSO要求除最后一个外等长，且最后一个不能更长
+            if (!gso_ || len > seg || len == 0 || n >= kMaxGsoSegments || bytes + len > kMaxGsoBytes) {
+                break;
+            }
+        }
+        if (send_iov_used_ + d.iov_cnt > send_iov_.size()) {
+            break;
+        }
+        std::memcpy(&send_iov_[send_iov_used_], d.iov, d.iov_cnt * sizeof(iovec));
+        send_iov_used_ += d.iov_cnt;
+        bytes += len;
+        ++n;
+        if (len < seg) {
+            break;
+        }
+    }
+
+    m.msg_hdr.msg_iov = &send_iov_[iov_start];
+    m.msg_hdr.msg_iovlen = send_iov_used_ - iov_start;
+    if (n > 1) {
+        uint8_t* ctrl = send_cmsg_.data() + msg_index * CMSG_SPACE(sizeof(uint16_t));
+        std::memset(ctrl, 0, CMSG_SPACE(sizeof(uint16_t)));
+        m.msg_hdr.msg_control = ctrl;
+        m.msg_hdr.msg_controllen = CMSG_SPACE(sizeof(uint16_t));
+        cmsghdr* cm = CMSG_FIRSTHDR(&m.msg_hdr);
+        cm->cmsg_level = SOL_UDP;
+        cm->cmsg_type = UDP_SEGMENT;
+        cm->cmsg_len = CMSG_LEN(sizeof(uint16_t));
+        uint16_t gso_size = static_cast<uint16_t>(seg);
+        std::memcpy(CMSG_DATA(cm), &gso_size, sizeof(gso_size));
+    }
+    send_counts_[msg_index] = n;
+    return n;
+}
+
+int UdpBatchSocket::send_messages(size_t msg_count) {
+    size_t sent = 0;
+    while (sent < msg_count) {
+        int r = ::sendmmsg(socket_.native_handle(), send_msgs_.data() + sent, static_cast<unsigned>(msg_count - sent), MSG_DONTWAIT);
+        if (r < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            break;
+        }
+        sent += static_cast<size_t>(r);
+    }
+    return static_cast<int>(sent);
+}
+
+int UdpBatchSocket::SendBatch(const ASIO::UdpEndpoint& to, const UdpOutDatagram* dgrams, size_t count) {
+    size_t done = 0;
+    while (done < count) {
+        // 单个数据报的iovec超过预分配容量（非常规用法），扩容后再组包
+        if (dgrams[done].iov_cnt > send_iov_.size()) {
+            send_iov_.resize(dgrams[done].iov_cnt);
+        }
+        send_iov_used_ = 0;
+        size_t msg_count = 0;
+        size_t pos = done;
+        while (pos < count && msg_count < cfg_.batch) {
+            if (send_iov_used_ + dgrams[pos].iov_cnt > send_iov_.size()) {
+                break;
+            }
+            pos += build_message(to, dgrams + pos, count - pos, msg_count);
+            ++msg_count;
+        }
+
+        int sent_msgs = send_messages(msg_count);
+        int err = errno;
+        for (int i = 0; i < sent_msgs; ++i) {
+            done += send_counts_[i];
+        }
+        if (static_cast<size_t>(sent_msgs) == msg_count) {
+            continue;
+        }
+        if (err == EAGAIN || err == EWOULDBLOCK || err == ENOBUFS) {
+            break;
+        }
+        // 网卡不支持校验和卸载等情况下GSO报错，关闭后用普通sendmmsg重发剩余部分
+        if (gso_ && (err == EIO || err == EINVAL || err == ENOPROTOOPT) && send_counts_[sent_msgs] > 1) {
+            gso_ = false;
+            continue;
+        }
+        return done > 0 ? static_cast<int>(done) : -1;
+    }
+    return static_cast<int>(done);
+}
+
+bool UdpBatchSocket::SendTo(const ASIO::UdpEndpoint& to, const void* data, size_t size) {
+    boost::system::error_code ec;
+    socket_.send_to(boost::asio::buffer(data, size), to, 0, ec);
+    return !ec;
+}
+
+void UdpBatchSocket::Close() {
+    boost::system::error_code ec;
+    socket_.close(ec);
+}
+
+ASIO::UdpEndpoint UdpBatchSocket::local_endpoint() const {
+    boost::system::error_code ec;
+    return socket_.local_endpoint(ec);
+}
+
+}
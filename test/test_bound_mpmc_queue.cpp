@@ -0,0 +1,416 @@
+#include <iostream>
+#include <memory>
+#include <atomic>
+#include <chrono>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+#include "bound_mpmc_queue.h"
+
+static int failures = 0;
+#define CHECK(cond) do { if (!(cond)) { std::cerr << "CHECK failed: " #cond " at line " << __LINE__ << std::endl; ++failures; } } while (0)
+
+template <typename Pred>
+static bool wait_until(Pred pred, int ms = 3000) {
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(ms);
+    while (!pred()) {
+        if (std::chrono::steady_clock::now() > deadline) {
+            return false;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    }
+    return true;
+}
+
+/// @brief 拷贝到指定值时抛异常，用来制造批量入队中途失败
+struct Fragile {
+    static int throw_on;
+    int v = 0;
+    Fragile() = default;
+    explicit Fragile(int x) : v(x) {}
+    Fragile(const Fragile& o) : v(o.v) {
+        if (v == throw_on) {
+            throw std::runtime_error("copy failed");
+        }
+    }
+    Fragile(Fragile&&) noexcept = default;
+    Fragile& operator=(const Fragile&) = default;
+    Fragile& operator=(Fragile&&) noexcept = default;
+};
+int Fragile::throw_on = -1;
+
+/// @brief 批量接口保持FIFO，空间不足时部分入队，跨越环尾时正确回绕
+static void test_bulk_fifo() {
+    BoundMPMCQueue<std::string> q(8);
+    std::vector<std::string> in{"a", "b", "c", "d", "e"};
+    CHECK(q.try_enqueue_bulk(in.begin(), in.end()) == 5);
+    CHECK(q.try_enqueue(std::string("f")));
+    // 只剩2个位置
+    CHECK(q.try_enqueue_bulk(in.begin(), in.end()) == 2);
+    CHECK(q.try_enqueue_bulk(in.begin(), in.end()) == 0);
+    CHECK(q.size_approx() == 8);
+
+    std::vector<std::string> out;
+    CHECK(q.try_dequeue_bulk(std::back_inserter(out), 3) == 3);
+    CHECK((out == std::vector<std::string>{"a", "b", "c"}));
+    std::string one;
+    CHECK(q.try_dequeue(one) && one == "d");
+    out.clear();
+    CHECK(q.try_dequeue_bulk(std::back_inserter(out), 100) == 4);
+    CHECK((out == std::vector<std::string>{"e", "f", "a", "b"}));
+    CHECK(q.try_dequeue_bulk(std::back_inserter(out), 100) == 0);
+
+    // 反复跨越环尾
+    for (int round = 0; round < 100; ++round) {
+        std::vector<std::string> batch{std::to_string(round), "x", "y"};
+        CHECK(q.try_enqueue_bulk(std::make_move_iterator(batch.begin()), std::make_move_iterator(batch.end())) == 3);
+        std::string got[3];
+        CHECK(q.try_dequeue_bulk(got, 3) == 3);
+        CHECK(got[0] == std::to_string(round) && got[1] == "x" && got[2] == "y");
+    }
+}
+
+/// @brief 批量入队中途构造失败：已写入的元素可取出，剩余预留位置被跳过，队列继续可用
+static void test_bulk_exception() {
+    BoundMPMCQueue<Fragile> q(8);
+    std::vector<Fragile> in{Fragile(1), Fragile(2), Fragile(3), Fragile(4)};
+    Fragile::throw_on = 3;
+    bool thrown = false;
+    try {
+        q.try_enqueue_bulk(in.begin(), in.end());
+    } catch (const std::runtime_error&) {
+        thrown = true;
+    }
+    Fragile::throw_on = -1;
+    CHECK(thrown);
+    CHECK(q.try_enqueue(Fragile(5)));
+
+    Fragile single;
+    CHECK(q.try_dequeue(single) && single.v == 1);
+    std::vector<Fragile> out;
+    CHECK(q.try_dequeue_bulk(std::back_inserter(out), 8) == 2);
+    CHECK(out.size() == 2 && out[0].v == 2 && out[1].v == 5);
+    CHECK(!q.try_dequeue(single));
+}
+
+/// @brief 多生产者多消费者混用单个和批量接口，每个元素恰好出队一次，同一生产者的元素按序
+static void test_concurrent() {
+    constexpr int kProducers = 4;
+    constexpr int kConsumers = 4;
+    constexpr uint64_t kPerProducer = 50000;
+    BoundMPMCQueue<uint64_t> q(256);
+    std::atomic<uint64_t> consumed{0};
+    std::atomic<uint64_t> sum{0};
+    std::atomic<int> disorder{0};
+    std::vector<std::thread> threads;
+    for (int p = 0; p < kProducers; ++p) {
+        threads.emplace_back([&, p]() {
+            uint64_t i = 0;
+            std::vector<uint64_t> batch;
+            while (i < kPerProducer) {
+                if (p % 2 == 0) {
+                    if (q.try_enqueue((uint64_t(p) << 32) | i)) {
+                        ++i;
+                    } else {
+                        std::this_thread::yield();
+                    }
+                    continue;
+                }
+                batch.clear();
+                for (uint64_t k = i; k < kPerProducer && batch.size() < 16; ++k) {
+                    batch.push_back((uint64_t(p) << 32) | k);
+                }
+                std::size_t n = q.try_enqueue_bulk(batch.begin(), batch.end());
+                i += n;
+                if (n == 0) {
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+    for (int c = 0; c < kConsumers; ++c) {
+        threads.emplace_back([&, c]() {
+            std::vector<int64_t> last(kProducers, -1);
+            auto take = [&](uint64_t v) {
+                int p = static_cast<int>(v >> 32);
+                int64_t seq = static_cast<int64_t>(v & 0xFFFFFFFF);
+                if (seq <= last[p]) {
+                    ++disorder;
+                }
+                last[p] = seq;
+                sum += seq;
+                ++consumed;
+            };
+            uint64_t batch[32];
+            while (consumed.load(std::memory_order_relaxed) < kProducers * kPerProducer) {
+                std::size_t n = 0;
+                if (c % 2 == 0) {
+                    n = q.try_dequeue(batch[0]) ? 1 : 0;
+                } else {
+                    n = q.try_dequeue_bulk(batch, 32);
+                }
+                for (std::size_t i = 0; i < n; ++i) {
+                    take(batch[i]);
+                }
+                if (n == 0) {
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+    for (auto& th : threads) {
+        th.join();
+    }
+    CHECK(consumed == kProducers * kPerProducer);
+    CHECK(sum == kProducers * (kPerProducer * (kPerProducer - 1) / 2));
+    CHECK(disorder == 0);
+    CHECK(q.size_approx() == 0);
+}
+
+/// @brief 阻塞等待：被try_*接口唤醒、超时返回、stop唤醒所有等待者
+static void test_blocking() {
+    BoundMPMCQueue<int> q(4);
+    std::atomic<int> got{-1};
+    std::thread consumer([&]() {
+        int v = 0;
+        q.dequeue_blocking(v);
+        got = v;
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    CHECK(q.try_enqueue(7));
+    consumer.join();
+    CHECK(got == 7);
+
+    int v = 0;
+    auto start = std::chrono::steady_clock::now();
+    CHECK(!q.dequeue_for(v, std::chrono::milliseconds(30)));
+    CHECK(std::chrono::steady_clock::now() - start >= std::chrono::milliseconds(30));
+
+    // 队列满时阻塞入队，被批量出队唤醒
+    for (int i = 0; i < 4; ++i) {
+        CHECK(q.try_enqueue(i));
+    }
+    std::atomic<bool> pushed{false};
+    std::thread producer([&]() {
+        q.enqueue_blocking(100);
+        pushed = true;
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    CHECK(!pushed);
+    int out[2];
+    CHECK(q.try_dequeue_bulk(out, 2) == 2 && out[0] == 0 && out[1] == 1);
+    producer.join();
+    CHECK(pushed);
+    CHECK(q.enqueue_for(101, std::chrono::milliseconds(10)));
+    CHECK(!q.enqueue_for(102, std::chrono::milliseconds(10)));
+    // 零超时退化为一次try
+    CHECK(!q.enqueue_for(103, std::chrono::milliseconds(0)));
+    CHECK(q.dequeue_for(v, std::chrono::milliseconds(0)) && v == 2);
+    CHECK(q.enqueue_for(104, std::chrono::milliseconds(0)));
+
+    // stop唤醒所有阻塞等待者
+    BoundMPMCQueue<int> empty(4);
+    std::atomic<int> woken{0};
+    std::vector<std::thread> waiters;
+    for (int i = 0; i < 3; ++i) {
+        waiters.emplace_back([&]() {
+            int x = 0;
+            try {
+                empty.dequeue_blocking(x);
+            } catch (const std::runtime_error&) {
+                ++woken;
+            }
+        });
+    }
+    waiters.emplace_back([&]() {
+        int x = 0;
+        if (!empty.dequeue_for(x, std::chrono::seconds(10))) {
+            ++woken;
+        }
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    empty.stop();
+    for (auto& th : waiters) {
+        th.join();
+    }
+    CHECK(woken == 4);
+
+    // 析构先唤醒挂起在阻塞接口里的线程，等它们退出后才释放队列
+    auto doomed = std::make_unique<BoundMPMCQueue<int>>(2);
+    auto full = std::make_unique<BoundMPMCQueue<int>>(2);
+    CHECK(full->try_enqueue(1) && full->try_enqueue(2));
+    std::atomic<int> thrown{0};
+    BoundMPMCQueue<int>* doomed_raw = doomed.get();
+    BoundMPMCQueue<int>* full_raw = full.get();
+    std::thread parked_consumer([&thrown, doomed_raw]() {
+        int x = 0;
+        try {
+            doomed_raw->dequeue_blocking(x);
+        } catch (const std::runtime_error&) {
+            ++thrown;
+        }
+    });
+    std::thread parked_producer([&thrown, full_raw]() {
+        try {
+            full_raw->enqueue_blocking(3);
+        } catch (const std::runtime_error&) {
+            ++thrown;
+        }
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    doomed.reset();
+    full.reset();
+    parked_consumer.join();
+    parked_producer.join();
+    CHECK(thrown == 2);
+}
+
+/// @brief 一次批量出队腾出多个位置时，所有挂起的生产者都被唤醒；批量入队同理唤醒多个消费者
+static void test_bulk_wakes_many() {
+    constexpr int kWaiters = 3;
+    BoundMPMCQueue<int> q(4);
+    for (int i = 0; i < 4; ++i) {
+        CHECK(q.try_enqueue(i));
+    }
+    std::atomic<int> pushed{0};
+    std::vector<std::thread> producers;
+    for (int i = 0; i < kWaiters; ++i) {
+        producers.emplace_back([&q, &pushed, i]() {
+            try {
+                q.enqueue_blocking(100 + i);
+                ++pushed;
+            } catch (const std::runtime_error&) {
+            }
+        });
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    CHECK(pushed == 0);
+    int out[4];
+    CHECK(q.try_dequeue_bulk(out, 4) == 4);
+    CHECK(wait_until([&] { return pushed == kWaiters; }, 1000));
+
+    int drained[4];
+    CHECK(q.try_dequeue_bulk(drained, 4) == kWaiters);
+    std::atomic<int> popped{0};
+    std::vector<std::thread> consumers;
+    for (int i = 0; i < kWaiters; ++i) {
+        consumers.emplace_back([&q, &popped]() {
+            int v = 0;
+            try {
+                q.dequeue_blocking(v);
+                ++popped;
+            } catch (const std::runtime_error&) {
+            }
+        });
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    CHECK(popped == 0);
+    int batch[kWaiters] = {1, 2, 3};
+    CHECK(q.try_enqueue_bulk(batch, batch + kWaiters) == kWaiters);
+    CHECK(wait_until([&] { return popped == kWaiters; }, 1000));
+
+    // 失败时不让挂着的线程拖住测试
+    q.stop();
+    for (auto& th : producers) {
+        th.join();
+    }
+    for (auto& th : consumers) {
+        th.join();
+    }
+}
+
+/// @brief 两个线程经两条队列乒乓，测单程交接延迟，只打印供参考
+static double bench_handoff() {
+    constexpr int kRounds = 2000;
+    BoundMPMCQueue<int> ping(64);
+    BoundMPMCQueue<int> pong(64);
+    std::thread echo([&]() {
+        int v = 0;
+        for (int i = 0; i < kRounds; ++i) {
+            ping.dequeue_blocking(v);
+            pong.enqueue_blocking(v);
+        }
+    });
+    auto start = std::chrono::steady_clock::now();
+    int v = 0;
+    for (int i = 0; i < kRounds; ++i) {
+        ping.enqueue_blocking(i);
+        pong.dequeue_blocking(v);
+    }
+    double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    echo.join();
+    return ns / kRounds / 2;
+}
+
+/// @brief 4P/4C吞吐：单个接口与一次32个的批量接口，只打印供参考
+static double bench(bool bulk) {
+    constexpr int kProducers = 4;
+    constexpr int kConsumers = 4;
+    constexpr uint64_t kPerProducer = 50000;
+    constexpr std::size_t kBatch = 32;
+    BoundMPMCQueue<uint64_t> q(4096);
+    std::atomic<uint64_t> consumed{0};
+    std::vector<std::thread> threads;
+    auto start = std::chrono::steady_clock::now();
+    for (int p = 0; p < kProducers; ++p) {
+        threads.emplace_back([&]() {
+            uint64_t batch[kBatch];
+            for (uint64_t i = 0; i < kPerProducer;) {
+                if (!bulk) {
+                    if (q.try_enqueue(i)) {
+                        ++i;
+                    } else {
+                        std::this_thread::yield();
+                    }
+                    continue;
+                }
+                std::size_t n = std::min<uint64_t>(kBatch, kPerProducer - i);
+                for (std::size_t k = 0; k < n; ++k) {
+                    batch[k] = i + k;
+                }
+                std::size_t done = q.try_enqueue_bulk(batch, batch + n);
+                i += done;
+                if (done == 0) {
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+    for (int c = 0; c < kConsumers; ++c) {
+        threads.emplace_back([&]() {
+            uint64_t batch[kBatch];
+            while (consumed.load(std::memory_order_relaxed) < kProducers * kPerProducer) {
+                std::size_t n = bulk ? q.try_dequeue_bulk(batch, kBatch) : (q.try_dequeue(batch[0]) ? 1 : 0);
+                if (n) {
+                    consumed.fetch_add(n, std::memory_order_relaxed);
+                } else {
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+    for (auto& th : threads) {
+        th.join();
+    }
+    double sec = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return kProducers * kPerProducer / sec / 1e6;
+}
+
+int main() {
+    test_bulk_fifo();
+    test_bulk_exception();
+    test_concurrent();
+    test_blocking();
+    test_bulk_wakes_many();
+    std::cout << "handoff latency: " << bench_handoff() << " ns" << std::endl;
+    double single = bench(false);
+    double bulk = bench(true);
+    std::cout << "4P/4C throughput: single " << single << " Mops/s, bulk(32) " << bulk << " Mops/s" << std::endl;
+    if (failures) {
+        std::cerr << failures << " check(s) failed" << std::endl;
+        return 1;
+    }
+    std::cout << "test_bound_mpmc_queue passed" << std::endl;
+    return 0;
+}
@@ -0,0 +1,318 @@
+#include <iostream>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "sip/gb28181_registry.h"
+
+static int failures = 0;
+#define CHECK(cond) do { if (!(cond)) { std::cerr << "CHECK failed: " #cond " at line " << __LINE__ << std::endl; ++failures; } } while (0)
+
+/// @brief 记录发出的应答，inject模拟从网络收到消息
+class FakeTransport : public SipTransport {
+public:
+    void Start() override {}
+    void Stop() override {}
+
+    bool SendBuffer(const Peer&, Buffer buffer) override {
+        std::lock_guard<std::mutex> lock(mtx_);
+        if (record_) {
+            sent_.push_back(*buffer);
+        }
+        return true;
+    }
+
+    void inject(const std::string& data) {
+        SipMessageView view;
+        if (SipMessageView::Parse(data.data(), data.size(), view) != SipMessageView::ParseResult::Ok) {
+            std::cerr << "bad test message" << std::endl;
+            ++failures;
+            return;
+        }
+        view.set_peer({"UDP", boost::asio::ip::make_address("127.0.0.1"), 5060});
+        dispatch_message(view);
+    }
+
+    std::string last() {
+        std::lock_guard<std::mutex> lock(mtx_);
+        return sent_.empty() ? std::string() : sent_.back();
+    }
+
+    void set_record(bool record) { record_ = record; }
+
+private:
+    std::mutex mtx_;
+    std::vector<std::string> sent_;
+    bool record_ = true;
+};
+
+static std::atomic<int> branch_seq{0};
+
+static std::string make_register(const std::string& id, const std::string& expires) {
+    std::string branch = std::to_string(++branch_seq);
+    return "REGISTER sip:34020000002000000001@3402000000 SIP/2.0\r\n"
+        "Via: SIP/2.0/UDP 127.0.0.1:5060;branch=z9hG4bKreg" + branch + "\r\n"
+        "From: <sip:" + id + "@3402000000>;tag=1\r\n"
+        "To: <sip:" + id + "@3402000000>\r\n"
+        "Call-ID: reg-" + id + "\r\n"
+        "CSeq: 1 REGISTER\r\n"
+        "Contact: <sip:" + id + "@127.0.0.1:5060>\r\n"
+        "Max-Forwards: 70\r\n" +
+        (expires.empty() ? std::string() : "Expires: " + expires + "\r\n") +
+        "Content-Length: 0\r\n\r\n";
+}
+
+static std::string make_keepalive(const std::string& id) {
+    std::string branch = std::to_string(++branch_seq);
+    std::string body = "<?xml version=\"1.0\" encoding=\"GB2312\"?>\r\n<Notify>\r\n<CmdType>Keepalive</CmdType>\r\n"
+        "<SN>" + branch + "</SN>\r\n<DeviceID>" + id + "</DeviceID>\r\n<Status>OK</Status>\r\n</Notify>\r\n";
+    return "MESSAGE sip:34020000002000000001@3402000000 SIP/2.0\r\n"
+        "Via: SIP/2.0/UDP 127.0.0.1:5060;branch=z9hG4bKka" + branch + "\r\n"
+        "From: <sip:" + id + "@3402000000>;tag=2\r\n"
+        "To: <sip:34020000002000000001@3402000000>\r\n"
+        "Call-ID: ka-" + branch + "\r\n"
+        "CSeq: 20 MESSAGE\r\n"
+        "Content-Type: Application/MANSCDP+xml\r\n"
+        "Content-Length: " + std::to_string(body.size()) + "\r\n\r\n" + body;
+}
+
+static std::string device(int i) {
+    std::string n = std::to_string(i);
+    return "3402000000132" + std::string(7 - n.size(), '0') + n;
+}
+
+template <typename Pred>
+static bool wait_until(Pred pred, int ms = 3000) {
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(ms);
+    while (!pred()) {
+        if (std::chrono::steady_clock::now() > deadline) {
+            return false;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    }
+    return true;
+}
+
+struct Fixture {
+    ASIO::IoContext io;
+    boost::asio::executor_work_guard<ASIO::IoContext::executor_type> work{io.get_executor()};
+    std::thread th;
+    std::shared_ptr<net::AsioTimerWheel> timers;
+    std::shared_ptr<FakeTransport> transport = std::make_shared<FakeTransport>();
+    std::shared_ptr<SipTransactionLayer> layer;
+    std::shared_ptr<GbDeviceRegistry> registry;
+    std::mutex mtx;
+    std::vector<std::pair<GbDeviceRegistry::Event, std::string>> events;
+
+    explicit Fixture(const GbDeviceRegistry::Config& cfg) {
+        timers = std::make_shared<net::AsioTimerWheel>(io, TimerWheel::Config{10});
+        layer = std::make_shared<SipTransactionLayer>(transport, timers);
+        registry = std::make_shared<GbDeviceRegistry>(layer, timers, cfg);
+        layer->SetRequestHandler([this](const SipMessageView& req) {
+            if (!registry->HandleRequest(req)) {
+                layer->Respond(req, 405, "Method Not Allowed");
+            }
+        });
+        registry->SetEventHandler([this](GbDeviceRegistry::Event e, const std::string& id) {
+            std::lock_guard<std::mutex> lock(mtx);
+            events.emplace_back(e, id);
+        });
+        layer->Start();
+        registry->Start();
+        th = std::thread([this]() { io.run(); });
+    }
+
+    ~Fixture() {
+        registry->Stop();
+        layer->Stop();
+        timers->Stop();
+        work.reset();
+        th.join();
+    }
+
+    std::size_t count(GbDeviceRegistry::Event e) {
+        std::lock_guard<std::mutex> lock(mtx);
+        std::size_t n = 0;
+        for (auto& ev : events) {
+            n += ev.first == e;
+        }
+        return n;
+    }
+};
+
+/// @brief 注册、刷新、注销，有效期过短回423
+static void test_register() {
+    Fixture f(GbDeviceRegistry::Config{});
+    const std::string id = device(1);
+    f.transport->inject(make_register(id, "3600"));
+    std::string rsp = f.transport->last();
+    CHECK(rsp.compare(0, 15, "SIP/2.0 200 OK\r") == 0);
+    CHECK(rsp.find("Expires: 3600\r\n") != std::string::npos);
+    CHECK(rsp.find("Date: ") != std::string::npos);
+    CHECK(rsp.find(";tag=") != std::string::npos);
+    CHECK(f.registry->Contains(id));
+    CHECK(f.registry->size() == 1);
+    CHECK(f.count(GbDeviceRegistry::Event::Registered) == 1);
+
+    GbDeviceRegistry::DeviceInfo info;
+    CHECK(f.registry->Find(id, info));
+    CHECK(info.id == id);
+    CHECK(info.peer.port == 5060);
+    CHECK(info.expires_at_ms - info.registered_ms == 3600 * 1000);
+
+    // 刷新不产生事件，没带Expires用默认值
+    f.transport->inject(make_register(id, ""));
+    CHECK(f.registry->stats().refreshed == 1);
+    CHECK(f.count(GbDeviceRegistry::Event::Registered) == 1);
+    CHECK(f.transport->last().find("Expires: 3600\r\n") != std::string::npos);
+
+    f.transport->inject(make_register(id, "10"));
+    CHECK(f.transport->last().compare(0, 11, "SIP/2.0 423") == 0);
+    CHECK(f.transport->last().find("Min-Expires: 60\r\n") != std::string::npos);
+
+    f.transport->inject(make_register(id, "0"));
+    CHECK(f.transport->last().compare(0, 11, "SIP/2.0 200") == 0);
+    CHECK(!f.registry->Contains(id));
+    CHECK(f.count(GbDeviceRegistry::Event::Unregistered) == 1);
+    CHECK(f.registry->size() == 0);
+}
+
+/// @brief 多个reactor并发心跳，批量合并到分片；未注册设备的心跳回403并上报事件
+static void test_keepalive_batch() {
+    GbDeviceRegistry::Config cfg;
+    cfg.batch_size = 64;
+    cfg.flush_interval_ms = 1000;
+    Fixture f(cfg);
+    constexpr int kDevices = 200;
+    constexpr int kThreads = 8;
+    constexpr int kPerThread = 1000;
+    for (int i = 0; i < kDevices; ++i) {
+        f.transport->inject(make_register(device(i), "3600"));
+    }
+    CHECK(f.registry->size() == kDevices);
+    GbDeviceRegistry::DeviceInfo before;
+    f.registry->Find(device(7), before);
+
+    std::vector<std::vector<std::string>> msgs(kThreads);
+    for (int t = 0; t < kThreads; ++t) {
+        for (int i = 0; i < kPerThread; ++i) {
+            msgs[t].push_back(make_keepalive(device((t * kPerThread + i) % kDevices)));
+        }
+    }
+    f.transport->set_record(false);
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    std::vector<std::thread> threads;
+    auto start = std::chrono::steady_clock::now();
+    for (int t = 0; t < kThreads; ++t) {
+        threads.emplace_back([&, t]() {
+            for (auto& m : msgs[t]) {
+                f.transport->inject(m);
+            }
+        });
+    }
+    for (auto& th : threads) {
+        th.join();
+    }
+    double us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+    std::cout << "keepalive: " << us / (kThreads * kPerThread) << " us/message across " << kThreads << " threads" << std::endl;
+    f.registry->Flush();
+    auto stats = f.registry->stats();
+    CHECK(stats.keepalives == static_cast<uint64_t>(kThreads * kPerThread));
+    CHECK(stats.batches < stats.keepalives / 8);
+    CHECK(stats.unknown_keepalives == 0);
+    GbDeviceRegistry::DeviceInfo after;
+    CHECK(f.registry->Find(device(7), after));
+    CHECK(after.last_keepalive_ms > before.last_keepalive_ms);
+
+    f.transport->set_record(true);
+    f.transport->inject(make_keepalive(device(7)));
+    CHECK(f.transport->last().compare(0, 11, "SIP/2.0 200") == 0);
+    // 未注册设备的心跳不回200，设备据此重新注册
+    f.transport->inject(make_keepalive(device(9999)));
+    CHECK(f.transport->last().compare(0, 11, "SIP/2.0 403") == 0);
+    CHECK(f.count(GbDeviceRegistry::Event::UnknownKeepalive) == 1);
+    CHECK(f.registry->stats().unknown_keepalives == 1);
+    CHECK(!f.registry->Contains(device(9999)));
+}
+
+/// @brief 注册有效期在时间轮上到期
+static void test_expiry() {
+    GbDeviceRegistry::Config cfg;
+    cfg.min_expires = 1;
+    cfg.keepalive_interval = 0;
+    Fixture f(cfg);
+    f.transport->inject(make_register(device(1), "1"));
+    f.transport->inject(make_register(device(2), "3600"));
+    auto start = std::chrono::steady_clock::now();
+    CHECK(wait_until([&]() { return f.count(GbDeviceRegistry::Event::Expired) == 1; }));
+    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+    CHECK(elapsed >= 950);
+    CHECK(!f.registry->Contains(device(1)));
+    CHECK(f.registry->Contains(device(2)));
+}
+
+/// @brief 心跳顺延离线判定，停止心跳后判离线
+static void test_offline() {
+    GbDeviceRegistry::Config cfg;
+    cfg.keepalive_interval = 1;
+    cfg.keepalive_timeout_count = 1;
+    cfg.flush_interval_ms = 20;
+    Fixture f(cfg);
+    auto start = std::chrono::steady_clock::now();
+    f.transport->inject(make_register(device(1), "3600"));
+    std::this_thread::sleep_for(std::chrono::milliseconds(600));
+    f.transport->inject(make_keepalive(device(1)));
+    std::this_thread::sleep_for(std::chrono::milliseconds(600));
+    CHECK(f.registry->Contains(device(1)));
+    CHECK(wait_until([&]() { return f.count(GbDeviceRegistry::Event::Offline) == 1; }));
+    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+    CHECK(elapsed >= 1550);
+    CHECK(!f.registry->Contains(device(1)));
+    CHECK(f.registry->stats().offline == 1);
+}
+
+/// @brief 网络恢复后的注册风暴
+static void bench_register_burst() {
+    constexpr int kDevices = 40000;
+    constexpr int kThreads = 8;
+    GbDeviceRegistry::Config cfg;
+    cfg.expected_devices = kDevices;
+    Fixture f(cfg);
+    f.transport->set_record(false);
+    std::vector<std::vector<std::string>> msgs(kThreads);
+    for (int i = 0; i < kDevices; ++i) {
+        msgs[i % kThreads].push_back(make_register(device(i), "3600"));
+    }
+    std::vector<std::thread> threads;
+    auto start = std::chrono::steady_clock::now();
+    for (int t = 0; t < kThreads; ++t) {
+        threads.emplace_back([&, t]() {
+            for (auto& m : msgs[t]) {
+                f.transport->inject(m);
+            }
+        });
+    }
+    for (auto& th : threads) {
+        th.join();
+    }
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    std::cout << "register burst: " << kDevices << " devices in " << ms << " ms across " << kThreads << " threads" << std::endl;
+    CHECK(f.registry->size() == static_cast<std::size_t>(kDevices));
+    CHECK(f.count(GbDeviceRegistry::Event::Registered) == static_cast<std::size_t>(kDevices));
+}
+
+int main() {
+    test_register();
+    test_keepalive_batch();
+    test_expiry();
+    test_offline();
+    bench_register_burst();
+    if (failures) {
+        std::cerr << failures << " check(s) failed" << std::endl;
+        return 1;
+    }
+    std::cout << "test_gb28181_registry passed" << std::endl;
+    return 0;
+}
@@ -0,0 +1,216 @@
+#include <iostream>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "media/gop_cache.h"
+#include "media/rtsp_client.h"
+#include "media/rtsp_server.h"
+
+static int failures = 0;
+#define CHECK(cond) do { if (!(cond)) { std::cerr << "CHECK failed: " #cond " at line " << __LINE__ << std::endl; ++failures; } } while (0)
+
+template <typename Pred>
+static bool wait_until(Pred pred, int ms = 3000) {
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(ms);
+    while (!pred()) {
+        if (std::chrono::steady_clock::now() > deadline) {
+            return false;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    }
+    return true;
+}
+
+using IntCache = GopCache<int>;
+
+static std::vector<int> contents(const IntCache& cache) {
+    std::vector<int> out;
+    for (const auto& e : cache.Snapshot()) {
+        out.push_back(*e.frame);
+    }
+    return out;
+}
+
+static void test_reset_on_keyframe() {
+    IntCache cache;
+    // 第一个关键帧之前的帧不缓存
+    CHECK(!cache.Push(0, 0, 10, std::make_shared<int>(1)));
+    CHECK(!cache.Push(1, 0, 10, std::make_shared<int>(2)));
+    CHECK(cache.empty());
+    CHECK(cache.Push(0, IntCache::kKeyframe, 100, std::make_shared<int>(3)));
+    CHECK(cache.Push(1, 0, 10, std::make_shared<int>(4)));
+    CHECK(cache.Push(0, 0, 20, std::make_shared<int>(5)));
+    CHECK((contents(cache) == std::vector<int>{3, 4, 5}));
+    CHECK(cache.stats().bytes == 130);
+    CHECK(cache.Push(0, IntCache::kKeyframe, 100, std::make_shared<int>(6)));
+    CHECK((contents(cache) == std::vector<int>{6}));
+    CHECK(cache.stats().resets == 1);
+    // 起播点默认不重置
+    CHECK(cache.Push(0, IntCache::kStartPoint, 50, std::make_shared<int>(7)));
+    CHECK((contents(cache) == std::vector<int>{6, 7}));
+    cache.Clear();
+    CHECK(!cache.Push(0, 0, 10, std::make_shared<int>(8)));
+}
+
+static void test_bounds() {
+    GopCacheConfig cfg;
+    cfg.max_bytes = 1000;
+    cfg.max_frames = 100;
+    IntCache cache(cfg);
+    CHECK(cache.Push(0, IntCache::kKeyframe, 400, std::make_shared<int>(1)));
+    CHECK(cache.Push(0, 0, 100, std::make_shared<int>(2)));
+    CHECK(cache.Push(0, IntCache::kStartPoint, 300, std::make_shared<int>(3)));
+    CHECK(cache.Push(0, 0, 100, std::make_shared<int>(4)));
+    // 超出上限时裁到下一个起播点
+    CHECK(cache.Push(0, 0, 200, std::make_shared<int>(5)));
+    CHECK((contents(cache) == std::vector<int>{3, 4, 5}));
+    CHECK(cache.stats().bytes == 600);
+    // 没有可裁的起播点时整体清空，等下一个关键帧
+    CHECK(!cache.Push(0, 0, 500, std::make_shared<int>(6)));
+    CHECK(cache.empty() && cache.stats().overflows == 1);
+    CHECK(!cache.Push(0, 0, 10, std::make_shared<int>(7)));
+    CHECK(cache.Push(0, IntCache::kKeyframe, 10, std::make_shared<int>(8)));
+
+    cfg.max_frames = 3;
+    cfg.trim_to_start_point = true;
+    IntCache frames(cfg);
+    CHECK(frames.Push(0, IntCache::kKeyframe, 1, std::make_shared<int>(1)));
+    CHECK(frames.Push(0, 0, 1, std::make_shared<int>(2)));
+    CHECK(frames.Push(0, IntCache::kStartPoint, 1, std::make_shared<int>(3)));
+    CHECK((contents(frames) == std::vector<int>{3}));
+    CHECK(frames.Push(0, 0, 1, std::make_shared<int>(4)));
+    CHECK(frames.Push(0, 0, 1, std::make_shared<int>(5)));
+    CHECK(!frames.Push(0, 0, 1, std::make_shared<int>(6)));
+}
+
+static std::vector<uint8_t> make_frame(std::size_t size, uint8_t seed) {
+    std::vector<uint8_t> au{0, 0, 0, 1, static_cast<uint8_t>(seed & 1 ? 0x65 : 0x41)};
+    for (std::size_t i = 0; i < size; ++i) {
+        au.push_back(static_cast<uint8_t>((i + seed) % 251 + 2));
+    }
+    return au;
+}
+
+/// @brief 缓存帧在被GOP缓存放掉后复用，复用前释放负载引用，推流方的缓冲不被拖住
+static void test_frame_reuse() {
+    RtspMediaSource::Config scfg;
+    scfg.video_extradata = {0, 0, 0, 1, 0x67, 0x42, 0xE0, 0x1F, 0xAA, 0, 0, 0, 1, 0x68, 0xCE, 0x3C, 0x80};
+    RtspMediaSource source(scfg);
+    std::vector<std::weak_ptr<std::vector<uint8_t>>> held;
+    auto push = [&](uint8_t seed, uint32_t ts) {
+        auto au = std::make_shared<std::vector<uint8_t>>(make_frame(1500, seed));
+        held.push_back(au);
+        CHECK(source.PushVideo(au->data(), au->size(), ts, au));
+    };
+    push(1, 3000);
+    push(2, 6000);
+    push(3, 9000);
+    CHECK(source.stats().gop_cache_frames == 1);
+    // 第一个GOP已被新关键帧挤出，下一次推流取帧时回收
+    CHECK(!held[0].expired() && !held[1].expired());
+    push(4, 12000);
+    CHECK(held[0].expired() && held[1].expired());
+    CHECK(!held[2].expired() && !held[3].expired());
+    CHECK(source.stats().gop_cache_frames == 2);
+}
+
+/// @brief 观看者在GOP中途加入：先收到缓存的关键帧和P帧，随后的实时帧无缝衔接，不请求关键帧
+static void test_rtsp_replay(bool tcp) {
+    ASIO::IoContext io;
+    RtspServer::Config cfg;
+    cfg.port = 0;
+    cfg.rtp_port_min = 43000;
+    cfg.rtp_port_max = 43100;
+    auto server = std::make_shared<RtspServer>(io, cfg);
+    server->Start();
+    RtspMediaSource::Config scfg;
+    scfg.video_extradata = {0, 0, 0, 1, 0x67, 0x42, 0xE0, 0x1F, 0xAA, 0, 0, 0, 1, 0x68, 0xCE, 0x3C, 0x80};
+    auto source = server->AddSource("live/cam1", scfg);
+    int keyframe_requests = 0;
+    source->SetKeyframeRequestHandler([&]() { ++keyframe_requests; });
+
+    // 推流方不提供keepalive，缓存需自行拷贝负载
+    std::vector<std::vector<uint8_t>> pushed = {make_frame(4000, 1), make_frame(1500, 2), make_frame(1500, 4)};
+    for (std::size_t i = 0; i < pushed.size(); ++i) {
+        std::vector<uint8_t> tmp = pushed[i];
+        CHECK(source->PushVideo(tmp.data(), tmp.size(), 3000 * static_cast<uint32_t>(i + 1)));
+        std::fill(tmp.begin(), tmp.end(), 0);
+    }
+    CHECK(source->stats().gop_cache_frames == 3);
+
+    auto work = boost::asio::make_work_guard(io);
+    std::thread th([&]() { io.run(); });
+
+    RtspClient::Config ccfg;
+    ccfg.tcp = tcp;
+    ccfg.jitter.min_delay_ms = 5;
+    ccfg.jitter.max_delay_ms = 50;
+    auto client = std::make_shared<RtspClient>(io, ccfg);
+    std::mutex mtx;
+    std::condition_variable cv;
+    std::vector<std::pair<uint32_t, std::vector<uint8_t>>> frames;
+    client->SetFrameHandler([&](const SdpTrack&, AccessUnitView& au) {
+        std::vector<uint8_t> data;
+        for (const iovec& seg : au.segments) {
+            data.insert(data.end(), static_cast<uint8_t*>(seg.iov_base), static_cast<uint8_t*>(seg.iov_base) + seg.iov_len);
+        }
+        std::lock_guard<std::mutex> lock(mtx);
+        frames.emplace_back(au.timestamp, std::move(data));
+        cv.notify_all();
+    });
+    CHECK(client->Start("rtsp://127.0.0.1:" + std::to_string(server->port()) + "/live/cam1"));
+
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    {
+        std::unique_lock<std::mutex> lock(mtx);
+        cv.wait_until(lock, deadline, [&]() { return frames.size() >= 3; });
+        CHECK(frames.size() == 3);
+    }
+    auto live = make_frame(1500, 6);
+    CHECK(source->PushVideo(live.data(), live.size(), 12000));
+    pushed.push_back(live);
+    {
+        std::unique_lock<std::mutex> lock(mtx);
+        cv.wait_until(lock, deadline, [&]() { return frames.size() >= 4; });
+        CHECK(frames.size() == 4);
+        for (std::size_t i = 0; i < frames.size() && i < pushed.size(); ++i) {
+            CHECK(frames[i].first == 3000 * (i + 1) && frames[i].second == pushed[i]);
+        }
+    }
+    CHECK(client->stats().corrupted_frames == 0);
+    CHECK(keyframe_requests == 0);
+    CHECK(source->stats().replayed_frames == 3);
+    // UDP观看者的回放和实时包都经节拍器发出
+    auto subs = source->subscribers();
+    CHECK(subs->size() == 1);
+    if (!subs->empty()) {
+        const auto& paced = subs->front()->sinks[0].paced;
+        CHECK((paced != nullptr) == !tcp);
+        if (paced) {
+            auto ps = paced->stats();
+            CHECK(ps.enqueued == source->stats().packets && ps.sent == ps.enqueued);
+        }
+    }
+
+    client->Stop();
+    server->Stop();
+    work.reset();
+    th.join();
+}
+
+int main() {
+    test_reset_on_keyframe();
+    test_bounds();
+    test_frame_reuse();
+    test_rtsp_replay(true);
+    test_rtsp_replay(false);
+    if (failures) {
+        std::cerr << failures << " check(s) failed" << std::endl;
+        return 1;
+    }
+    std::cout << "test_gop_cache passed" << std::endl;
+    return 0;
+}
@@ -0,0 +1,165 @@
+#include <iostream>
+#include <atomic>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include "metrics.h"
+#include "bound_mpmc_queue.h"
+#include "mpmc_queue.h"
+#include "log/log_queue.h"
+#include "sip/sip_transport.h"
+
+static int failures = 0;
+#define CHECK(cond) do { if (!(cond)) { std::cerr << "CHECK failed: " #cond " at line " << __LINE__ << std::endl; ++failures; } } while (0)
+
+/// @brief 注册、输出、注销；Prometheus文本格式：同名指标只输出一次HELP/TYPE，标签值转义
+static void test_register_render() {
+    auto& registry = MetricsRegistry::getInstance();
+    const std::size_t base = registry.size();
+
+    std::atomic<uint64_t> frames{42};
+    MetricsHandle counter = registry.RegisterCounter("test_frames_total", "Frames handled",
+        {{"stream", "cam\"1\""}}, &frames);
+    MetricsHandle gauge = registry.RegisterGauge("test_depth", "Queue depth", {}, [] { return 1.5; });
+    MetricsHandle collector = registry.RegisterCollector([](MetricsWriter& w) {
+        w.Add("test_frames_total", MetricType::Counter, "Frames handled", {{"stream", "cam2"}}, 7);
+        w.Add("test_devices", MetricType::Gauge, "", {{"pool", "a\\b\nc"}}, 1e6);
+    });
+    CHECK(registry.size() == base + 3);
+
+    std::string text = registry.RenderPrometheus();
+    CHECK(text.find("# HELP test_frames_total Frames handled\n"
+                    "# TYPE test_frames_total counter\n"
+                    "test_frames_total{stream=\"cam\\\"1\\\"\"} 42\n"
+                    "test_frames_total{stream=\"cam2\"} 7\n") != std::string::npos);
+    CHECK(text.find("# HELP test_depth Queue depth\n# TYPE test_depth gauge\ntest_depth 1.5\n") != std::string::npos);
+    // 没有help时不输出HELP行；大整数不用科学计数法
+    CHECK(text.find("# HELP test_devices") == std::string::npos);
+    CHECK(text.find("# TYPE test_devices gauge\ntest_devices{pool=\"a\\\\b\\nc\"} 1000000\n") != std::string::npos);
+
+    std::string json = registry.RenderJson();
+    CHECK(json.find("\"name\":\"test_depth\"") != std::string::npos);
+    CHECK(json.find("\"type\":\"counter\"") != std::string::npos);
+
+    // 句柄移动后原句柄失效，只注销一次
+    MetricsHandle moved = std::move(gauge);
+    CHECK(!gauge.valid() && moved.valid());
+    moved.reset();
+    counter.reset();
+    CHECK(registry.size() == base + 1);
+    text = registry.RenderPrometheus();
+    CHECK(text.find("test_depth") == std::string::npos);
+    CHECK(text.find("test_frames_total{stream=\"cam2\"} 7\n") != std::string::npos);
+    CHECK(text.find("cam\\\"1") == std::string::npos);
+    collector.reset();
+    CHECK(registry.size() == base);
+}
+
+/// @brief 回调里注销自身或其他条目不死锁，被注销的条目本次抓取不再读取
+static void test_unregister_from_callback() {
+    auto& registry = MetricsRegistry::getInstance();
+    MetricsHandle self;
+    MetricsHandle other;
+    int other_calls = 0;
+    self = registry.RegisterGauge("test_a_self", "", {}, [&] {
+        self.reset();
+        other.reset();
+        return 1.0;
+    });
+    other = registry.RegisterGauge("test_b_other", "", {}, [&] {
+        ++other_calls;
+        return 2.0;
+    });
+    std::string text = registry.RenderPrometheus();
+    CHECK(text.find("test_a_self 1\n") != std::string::npos);
+    CHECK(other_calls == 0);
+    CHECK(text.find("test_b_other") == std::string::npos);
+    CHECK(!self.valid() && !other.valid());
+}
+
+/// @brief 持续抓取时注销能及时返回，返回后计数器可以安全销毁
+static void test_unregister_during_scrape() {
+    auto& registry = MetricsRegistry::getInstance();
+    std::atomic<bool> stop{false};
+    std::vector<std::thread> scrapers;
+    for (int i = 0; i < 2; ++i) {
+        scrapers.emplace_back([&]() {
+            while (!stop.load(std::memory_order_relaxed)) {
+                registry.RenderPrometheus();
+            }
+        });
+    }
+    for (int i = 0; i < 2000; ++i) {
+        auto counter = std::make_unique<std::atomic<uint64_t>>(i);
+        auto value = std::make_shared<int>(i);
+        MetricsHandle c = registry.RegisterCounter("test_churn_total", "", {}, counter.get());
+        MetricsHandle g = registry.RegisterGauge("test_churn", "", {}, [raw = value.get()] { return *raw; });
+        c.reset();
+        g.reset();
+        counter.reset();
+        value.reset();
+    }
+    stop = true;
+    for (auto& th : scrapers) {
+        th.join();
+    }
+    CHECK(registry.RenderPrometheus().find("test_churn") == std::string::npos);
+}
+
+/// @brief 队列深度/容量指标：通用队列、日志队列和SIP tap队列
+static void test_queue_gauges() {
+    auto& registry = MetricsRegistry::getInstance();
+    BoundMPMCQueue<int> bounded(8);
+    MPMCQueue<int> unbounded;
+    for (int i = 0; i < 3; ++i) {
+        bounded.try_enqueue(i);
+        unbounded.enqueue(i);
+    }
+    unbounded.enqueue(3);
+    auto bounded_metrics = registry.RegisterQueue("test_bounded", bounded);
+    auto unbounded_metrics = registry.RegisterQueue("test_unbounded", unbounded);
+    CHECK(bounded_metrics.size() == 2 && unbounded_metrics.size() == 1);
+
+    // 与BoostAsyncLogger注册日志队列的方式一致
+    LogQueue<int> log_queue;
+    log_queue.push(1);
+    auto log_metrics = registry.RegisterQueue("log", log_queue);
+
+    ASIO::IoContext io;
+    UdpSipTransport::Config cfg;
+    cfg.listen_ip = "127.0.0.1";
+    cfg.port = 0;
+    auto transport = std::make_shared<UdpSipTransport>(io, cfg);
+    transport->SetTapHandler([](const SipMessageView&) {});
+
+    std::string text = registry.RenderPrometheus();
+    CHECK(text.find("media_queue_depth{queue=\"test_bounded\"} 3\n") != std::string::npos);
+    CHECK(text.find("media_queue_capacity{queue=\"test_bounded\"} 8\n") != std::string::npos);
+    CHECK(text.find("media_queue_depth{queue=\"test_unbounded\"} 4\n") != std::string::npos);
+    CHECK(text.find("media_queue_capacity{queue=\"test_unbounded\"}") == std::string::npos);
+    CHECK(text.find("media_queue_depth{queue=\"log\"} 1\n") != std::string::npos);
+    CHECK(text.find("media_queue_capacity{queue=\"log\"} 64\n") != std::string::npos);
+    CHECK(text.find("media_queue_depth{queue=\"sip_tap\",instance=\"0\"} 0\n") != std::string::npos);
+    CHECK(text.find("media_queue_capacity{queue=\"sip_tap\",instance=\"0\"} 1024\n") != std::string::npos);
+
+    // 队列的持有者析构后指标随之注销
+    transport.reset();
+    log_metrics.clear();
+    text = registry.RenderPrometheus();
+    CHECK(text.find("queue=\"sip_tap\"") == std::string::npos);
+    CHECK(text.find("queue=\"log\"") == std::string::npos);
+}
+
+int main() {
+    test_register_render();
+    test_unregister_from_callback();
+    test_unregister_during_scrape();
+    test_queue_gauges();
+    if (failures) {
+        std::cerr << failures << " check(s) failed" << std::endl;
+        return 1;
+    }
+    std::cout << "test_metrics passed" << std::endl;
+    return 0;
+}
@@ -0,0 +1,152 @@
+#include <iostream>
+#include <vector>
+#include <cstring>
+#include "media/mpeg_ps.h"
+
+static int failures = 0;
+#define CHECK(cond) do { if (!(cond)) { std::cerr << "CHECK failed: " #cond " at line " << __LINE__ << std::endl; ++failures; } } while (0)
+
+static void append_nal(std::vector<uint8_t>& au, uint8_t header, std::size_t size, uint8_t seed) {
+    au.insert(au.end(), {0, 0, 0, 1, header});
+    for (std::size_t i = 0; i < size; ++i) {
+        au.push_back(static_cast<uint8_t>((i * 7 + seed) % 251 + 2));
+    }
+}
+
+/// @brief 去掉RTP头拼接负载，模拟接收端按marker重组一帧
+static std::vector<uint8_t> reassemble(const RtpPacketBatch& batch, std::size_t first, std::size_t mtu) {
+    std::vector<uint8_t> ps;
+    for (std::size_t i = first; i < batch.size(); ++i) {
+        const RtpPacketView& p = batch.packets[i];
+        CHECK(p.size <= mtu);
+        CHECK(p.marker() == (i + 1 == batch.size()));
+        std::vector<uint8_t> buf(p.size);
+        p.Flatten(buf.data(), buf.size());
+        ps.insert(ps.end(), buf.begin() + RTP_FIXED_HEADER_SIZE, buf.end());
+    }
+    return ps;
+}
+
+static std::vector<uint8_t> flatten(const PsFrame& f) {
+    std::vector<uint8_t> out(f.size);
+    f.Flatten(out.data(), out.size());
+    return out;
+}
+
+/// @brief 打包 -> 按RTP重组 -> 解复用，基本流逐字节一致；大帧拆成多个PES
+static void test_video_roundtrip() {
+    RtpPacketizer::Config cfg;
+    cfg.mtu = 1400;
+    cfg.ssrc = 0x11;
+    PsRtpPacketizer packetizer(cfg, PsCodec::H265, PsCodec::G711A);
+    PsDemuxer demuxer;
+
+    std::vector<uint8_t> idr;
+    append_nal(idr, 0x40, 20, 1);      // VPS
+    append_nal(idr, 0x42, 40, 2);      // SPS
+    append_nal(idr, 0x44, 8, 3);       // PPS
+    append_nal(idr, 0x26, 150000, 4);  // IDR_W_RADL，超过单个PES上限
+
+    RtpPacketBatch batch;
+    // H.265 NAL头的第二字节取自append_nal生成的负载首字节
+    packetizer.PacketizeAnnexB(idr.data(), idr.size(), 90000, batch);
+    CHECK(batch.size() > 100);
+    CHECK(batch.packets[0].flags & RtpPacketView::kKeyframe);
+    CHECK(batch.packets[0].flags & RtpPacketView::kFrameStart);
+    for (std::size_t i = 1; i < batch.size(); ++i) {
+        CHECK(static_cast<uint16_t>(batch.packets[i].seq - batch.packets[i - 1].seq) == 1);
+    }
+
+    auto ps = reassemble(batch, 0, cfg.mtu);
+    CHECK(demuxer.Input(ps.data(), ps.size()));
+    auto frames = demuxer.frames();
+    CHECK(frames.size() == 1);
+    if (frames.size() == 1) {
+        CHECK(frames[0].codec == PsCodec::H265);
+        CHECK(frames[0].stream_id == PsRtpPacketizer::kVideoStreamId);
+        CHECK(frames[0].pts == 90000);
+        CHECK(frames[0].keyframe);
+        CHECK(!frames[0].truncated);
+        CHECK(frames[0].segments.size() == 3);
+        CHECK(flatten(frames[0]) == idr);
+    }
+    CHECK(demuxer.skipped_bytes() == 0);
+
+    // P帧不带PSM，沿用之前的映射
+    std::vector<uint8_t> p;
+    append_nal(p, 0x02, 3000, 5);      // TRAIL_R
+    batch.clear();
+    packetizer.PacketizeAnnexB(p.data(), p.size(), 93600, batch);
+    CHECK(!(batch.packets[0].flags & RtpPacketView::kKeyframe));
+    ps = reassemble(batch, 0, cfg.mtu);
+    CHECK(ps.size() < 3000 + 64);
+    CHECK(demuxer.Input(ps.data(), ps.size()));
+    frames = demuxer.frames();
+    CHECK(frames.size() == 1 && frames[0].codec == PsCodec::H265 && !frames[0].keyframe);
+    CHECK(frames.size() == 1 && frames[0].pts == 93600 && flatten(frames[0]) == p);
+
+    // 音频帧与视频帧在同一段数据里
+    std::vector<uint8_t> pcm(320, 0xD5);
+    batch.clear();
+    packetizer.PacketizeAudio(pcm.data(), pcm.size(), 93600, batch);
+    std::size_t audio_pkts = batch.size();
+    CHECK(audio_pkts == 1);
+    auto both = reassemble(batch, 0, cfg.mtu);
+    both.insert(both.end(), ps.begin(), ps.end());
+    CHECK(demuxer.Input(both.data(), both.size()));
+    frames = demuxer.frames();
+    CHECK(frames.size() == 2);
+    if (frames.size() == 2) {
+        CHECK(frames[0].codec == PsCodec::G711A && flatten(frames[0]) == pcm);
+        CHECK(frames[1].codec == PsCodec::H265 && flatten(frames[1]) == p);
+    }
+
+    // 截断的尾部：已有部分仍产出，并标记截断
+    CHECK(demuxer.Input(ps.data(), ps.size() - 100));
+    frames = demuxer.frames();
+    CHECK(frames.size() == 1 && frames[0].truncated && frames[0].size == p.size() - 100);
+
+    std::vector<uint8_t> garbage(100, 0x55);
+    CHECK(!demuxer.Input(garbage.data(), garbage.size()));
+    CHECK(demuxer.frames().empty());
+}
+
+/// @brief 手工构造的PS（带PTS+DTS、padding、前置垃圾字节）
+static void test_demux_handmade() {
+    std::vector<uint8_t> ps(5, 0xAA);   // 需要重新同步的垃圾
+    uint8_t buf[64];
+    std::size_t n = Ps::WritePackHeader(buf, 3600, 1000);
+    ps.insert(ps.end(), buf, buf + n);
+    // padding流
+    ps.insert(ps.end(), {0x00, 0x00, 0x01, 0xBE, 0x00, 0x02, 0xFF, 0xFF});
+    const uint8_t es[] = {0x00, 0x00, 0x00, 0x01, 0x65, 0x88, 0x84};
+    n = Ps::WritePesHeader(buf, 0xE0, sizeof(es), 7200, 3600);
+    CHECK(n == PS_PES_HEADER_MAX_SIZE);
+    ps.insert(ps.end(), buf, buf + n);
+    ps.insert(ps.end(), es, es + sizeof(es));
+    ps.insert(ps.end(), {0x00, 0x00, 0x01, PS_END_CODE});
+
+    PsDemuxer demuxer;
+    CHECK(demuxer.Input(ps.data(), ps.size()));
+    auto frames = demuxer.frames();
+    CHECK(frames.size() == 1);
+    if (frames.size() == 1) {
+        CHECK(frames[0].pts == 7200 && frames[0].dts == 3600);
+        // 未收到PSM，编码未知
+        CHECK(frames[0].codec == PsCodec::Unknown);
+        CHECK(frames[0].size == sizeof(es));
+        CHECK(frames[0].segments[0].iov_base == ps.data() + ps.size() - 4 - sizeof(es));
+    }
+    CHECK(demuxer.skipped_bytes() == 5);
+}
+
+int main() {
+    test_video_roundtrip();
+    test_demux_handmade();
+    if (failures) {
+        std::cerr << failures << " check(s) failed" << std::endl;
+        return 1;
+    }
+    std::cout << "test_mpeg_ps passed" << std::endl;
+    return 0;
+}
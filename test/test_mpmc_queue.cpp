@@ -0,0 +1,228 @@
+#include <iostream>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include "mpmc_queue.h"
+
+static int failures = 0;
+#define CHECK(cond) do { if (!(cond)) { std::cerr << "CHECK failed: " #cond " at line " << __LINE__ << std::endl; ++failures; } } while (0)
+
+/// @brief 统计存活对象数，检查出队/回收后值都被析构
+struct Tracked {
+    static std::atomic<int> live;
+    uint64_t v = 0;
+    Tracked() { ++live; }
+    explicit Tracked(uint64_t x) : v(x) { ++live; }
+    Tracked(const Tracked& o) : v(o.v) { ++live; }
+    Tracked(Tracked&& o) noexcept : v(o.v) { ++live; }
+    Tracked& operator=(const Tracked& o) = default;
+    Tracked& operator=(Tracked&& o) noexcept = default;
+    ~Tracked() { --live; }
+};
+std::atomic<int> Tracked::live{0};
+
+/// @brief 单线程下单个/批量出入队保持FIFO
+static void test_fifo() {
+    MPMCQueue<std::string> q;
+    std::string out;
+    CHECK(!q.try_dequeue(out));
+    q.enqueue("a");
+    std::vector<std::string> batch{"b", "c", "d", "e"};
+    CHECK(q.enqueue_bulk(std::make_move_iterator(batch.begin()), std::make_move_iterator(batch.end())) == 4);
+    q.enqueue(std::string("f"));
+    CHECK(q.size() == 6);
+
+    CHECK(q.try_dequeue(out) && out == "a");
+    std::vector<std::string> got;
+    CHECK(q.try_dequeue_bulk(std::back_inserter(got), 3) == 3);
+    CHECK((got == std::vector<std::string>{"b", "c", "d"}));
+    got.clear();
+    CHECK(q.try_dequeue_bulk(std::back_inserter(got), 10) == 2);
+    CHECK((got == std::vector<std::string>{"e", "f"}));
+    CHECK(q.try_dequeue_bulk(std::back_inserter(got), 10) == 0);
+    CHECK(q.size() == 0);
+
+    // 节点经EBR回收后复用，反复出入队结果不变
+    for (int round = 0; round < 1000; ++round) {
+        std::vector<std::string> in{std::to_string(round), "x", "y"};
+        q.enqueue_bulk(in.begin(), in.end());
+        std::string a;
+        CHECK(q.try_dequeue(a) && a == std::to_string(round));
+        std::string rest[2];
+        CHECK(q.try_dequeue_bulk(rest, 2) == 2 && rest[0] == "x" && rest[1] == "y");
+    }
+}
+
+/// @brief 多生产者多消费者混用单个和批量接口，每个元素恰好出队一次，且同一生产者的元素按序
+static void test_concurrent() {
+    constexpr int kProducers = 8;
+    constexpr int kConsumers = 8;
+    constexpr uint64_t kPerProducer = 20000;
+    {
+        MPMCQueue<Tracked> q;
+        std::atomic<uint64_t> consumed{0};
+        std::atomic<uint64_t> sum{0};
+        std::atomic<int> disorder{0};
+        std::vector<std::thread> threads;
+        for (int p = 0; p < kProducers; ++p) {
+            threads.emplace_back([&, p]() {
+                uint64_t i = 0;
+                while (i < kPerProducer) {
+                    if (p % 2 == 0) {
+                        q.enqueue(Tracked((uint64_t(p) << 32) | i));
+                        ++i;
+                    } else {
+                        std::vector<Tracked> batch;
+                        for (uint64_t k = 0; k < 16 && i < kPerProducer; ++k, ++i) {
+                            batch.emplace_back((uint64_t(p) << 32) | i);
+                        }
+                        q.enqueue_bulk(batch.begin(), batch.end());
+                    }
+                }
+            });
+        }
+        for (int c = 0; c < kConsumers; ++c) {
+            threads.emplace_back([&, c]() {
+                std::vector<int64_t> last(kProducers, -1);
+                auto take = [&](const Tracked& t) {
+                    int p = static_cast<int>(t.v >> 32);
+                    int64_t seq = static_cast<int64_t>(t.v & 0xFFFFFFFF);
+                    if (seq <= last[p]) {
+                        ++disorder;
+                    }
+                    last[p] = seq;
+                    sum += seq;
+                    ++consumed;
+                };
+                std::vector<Tracked> batch;
+                while (consumed.load(std::memory_order_relaxed) < kProducers * kPerProducer) {
+                    if (c % 2 == 0) {
+                        Tracked t;
+                        if (q.try_dequeue(t)) {
+                            take(t);
+                        } else {
+                            std::this_thread::yield();
+                        }
+                    } else {
+                        batch.clear();
+                        if (q.try_dequeue_bulk(std::back_inserter(batch), 32) == 0) {
+                            std::this_thread::yield();
+                        }
+                        for (auto& t : batch) {
+                            take(t);
+                        }
+                    }
+                }
+            });
+        }
+        for (auto& th : threads) {
+            th.join();
+        }
+        CHECK(consumed == kProducers * kPerProducer);
+        CHECK(sum == kProducers * (kPerProducer * (kPerProducer - 1) / 2));
+        CHECK(disorder == 0);
+        CHECK(q.size() == 0);
+    }
+    CHECK(Tracked::live == 0);
+}
+
+/// @brief 同一线程先后使用多个队列（各自的EBR回收器）
+static void test_many_queues() {
+    for (int i = 0; i < 4; ++i) {
+        auto q = std::make_unique<MPMCQueue<int>>();
+        auto other = std::make_unique<MPMCQueue<int>>();
+        for (int k = 0; k < 500; ++k) {
+            q->enqueue(k);
+            other->enqueue(k);
+            int v = 0;
+            CHECK(q->try_dequeue(v) && v == k);
+            CHECK(other->try_dequeue(v) && v == k);
+        }
+    }
+}
+
+/// @brief 已退出线程退休的对象由之后推进epoch的线程代为回收，不必等回收器析构
+static void test_exited_thread_retired() {
+    static std::atomic<int> reclaimed{0};
+    constexpr int kRetired = 100;
+    EpochReclaimer gc;
+    gc.set_probe_stride(1);
+    int dummy[kRetired];
+    std::thread worker([&]() {
+        for (int i = 0; i < kRetired; ++i) {
+            gc.retire(&dummy[i], [](void*) { ++reclaimed; });
+        }
+    });
+    worker.join();
+    CHECK(reclaimed < kRetired);
+    for (int i = 0; i < 8 && reclaimed < kRetired; ++i) {
+        gc.quiescent_point();
+    }
+    CHECK(reclaimed == kRetired);
+}
+
+/// @brief 8P/8C吞吐：单个接口与一次32个的批量接口，只打印供参考
+static double bench(bool bulk) {
+    constexpr int kProducers = 8;
+    constexpr int kConsumers = 8;
+    constexpr uint64_t kPerProducer = 20000;
+    constexpr std::size_t kBatch = 32;
+    MPMCQueue<uint64_t> q;
+    std::atomic<uint64_t> consumed{0};
+    std::vector<std::thread> threads;
+    auto start = std::chrono::steady_clock::now();
+    for (int p = 0; p < kProducers; ++p) {
+        threads.emplace_back([&]() {
+            if (!bulk) {
+                for (uint64_t i = 0; i < kPerProducer; ++i) {
+                    q.enqueue(i);
+                }
+                return;
+            }
+            uint64_t batch[kBatch];
+            for (uint64_t i = 0; i < kPerProducer; i += kBatch) {
+                for (std::size_t k = 0; k < kBatch; ++k) {
+                    batch[k] = i + k;
+                }
+                q.enqueue_bulk(batch, batch + kBatch);
+            }
+        });
+    }
+    for (int c = 0; c < kConsumers; ++c) {
+        threads.emplace_back([&]() {
+            uint64_t batch[kBatch];
+            while (consumed.load(std::memory_order_relaxed) < kProducers * kPerProducer) {
+                std::size_t n = bulk ? q.try_dequeue_bulk(batch, kBatch) : (q.try_dequeue(batch[0]) ? 1 : 0);
+                if (n) {
+                    consumed.fetch_add(n, std::memory_order_relaxed);
+                } else {
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+    for (auto& th : threads) {
+        th.join();
+    }
+    double sec = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return kProducers * kPerProducer / sec / 1e6;
+}
+
+int main() {
+    test_fifo();
+    test_concurrent();
+    test_many_queues();
+    test_exited_thread_retired();
+    double single = bench(false);
+    double bulk = bench(true);
+    std::cout << "8P/8C throughput: single " << single << " Mops/s, bulk(32) " << bulk << " Mops/s" << std::endl;
+    if (failures) {
+        std::cerr << failures << " check(s) failed" << std::endl;
+        return 1;
+    }
+    std::cout << "test_mpmc_queue passed" << std::endl;
+    return 0;
+}
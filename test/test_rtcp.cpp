@@ -0,0 +1,251 @@
+#include <iostream>
+#include <set>
+#include <vector>
+#include "media/rtcp.h"
+
+static int failures = 0;
+#define CHECK(cond) do { if (!(cond)) { std::cerr << "CHECK failed: " #cond " at line " << __LINE__ << std::endl; ++failures; } } while (0)
+
+static std::vector<uint8_t> rtp(uint16_t seq, uint32_t ts, uint32_t ssrc) {
+    std::vector<uint8_t> pkt(20, 0xAB);
+    WriteRtpHeader(pkt.data(), 96, false, seq, ts, ssrc);
+    return pkt;
+}
+
+/// @brief 接收统计：回绕、丢包、乱序
+static void test_receive_stats() {
+    RtpReceiveStats stats(0xAAAA, 90000);
+    int64_t now = 0;
+    uint32_t ts = 0;
+    // 65530..65535, 0..9，其中丢掉2、3，5与6乱序
+    std::vector<uint16_t> seqs;
+    for (uint32_t s = 65530; s < 65536 + 10; ++s) {
+        uint16_t seq = static_cast<uint16_t>(s);
+        if (seq == 2 || seq == 3) {
+            continue;
+        }
+        seqs.push_back(seq);
+    }
+    std::swap(seqs[seqs.size() - 5], seqs[seqs.size() - 4]);
+    for (uint16_t seq : seqs) {
+        stats.Update(seq, ts, now);
+        ts += 3000;
+        now += 33;
+    }
+    CHECK(stats.ext_highest_seq() == 65536 + 9);
+    CHECK(stats.lost() == 2);
+
+    RtcpReportBlock block;
+    stats.FillReportBlock(block, now);
+    CHECK(block.cumulative_lost == 2);
+    // 第一个包处于试用期不计入，期望15个
+    CHECK(block.fraction_lost == (2 << 8) / 15);
+    CHECK(block.ext_highest_seq == 65536 + 9);
+    CHECK(!stats.active());
+}
+
+class Collector : public RtcpHandler {
+public:
+    void OnSenderReport(uint32_t ssrc, const RtcpSenderInfo& info, const RtcpReportBlock* blocks, std::size_t count) override {
+        sr_ssrc = ssrc;
+        sr_info = info;
+        sr_blocks = count;
+        if (count) {
+            first = blocks[0];
+        }
+    }
+    void OnBye(const uint32_t* ssrcs, std::size_t count) override {
+        bye = count ? ssrcs[0] : 0;
+    }
+    uint32_t sr_ssrc = 0;
+    RtcpSenderInfo sr_info;
+    std::size_t sr_blocks = 0;
+    RtcpReportBlock first;
+    uint32_t bye = 0;
+};
+
+/// @brief 写SR+BYE复合包再解析
+static void test_compound_roundtrip() {
+    uint8_t buf[256];
+    RtcpSenderInfo info;
+    info.ntp = {100, 200};
+    info.rtp_ts = 12345;
+    info.packet_count = 10;
+    info.octet_count = 10000;
+    RtcpReportBlock block;
+    block.ssrc = 0x55;
+    block.fraction_lost = 12;
+    block.cumulative_lost = -3;
+    block.ext_highest_seq = 70000;
+    block.jitter = 42;
+    std::size_t n = Rtcp::WriteSenderReport(std::span<uint8_t>(buf, sizeof(buf)), 0x77, info, &block, 1);
+    CHECK(n == 52);
+    n += Rtcp::WriteBye(std::span<uint8_t>(buf + n, sizeof(buf) - n), 0x77);
+    CHECK(Rtcp::WriteSenderReport(std::span<uint8_t>(buf, 20), 0x77, info, &block, 1) == 0);
+
+    Collector c;
+    CHECK(Rtcp::ParseCompound(buf, n, c));
+    CHECK(c.sr_ssrc == 0x77);
+    CHECK(c.sr_info.ntp.sec == 100 && c.sr_info.octet_count == 10000);
+    CHECK(c.sr_blocks == 1);
+    CHECK(c.first.cumulative_lost == -3 && c.first.fraction_lost == 12 && c.first.ext_highest_seq == 70000);
+    CHECK(c.bye == 0x77);
+
+    // 长度字段越界
+    buf[3] = 40;
+    CHECK(!Rtcp::ParseCompound(buf, n, c));
+}
+
+/// @brief 两个会话互发：接收端RR带回发送端的丢包与LSR
+static void test_session() {
+    RtcpSession::Config scfg;
+    scfg.ssrc = 0x1111;
+    RtcpSession sender(scfg);
+    RtcpSession::Config rcfg;
+    rcfg.ssrc = 0x2222;
+    RtcpSession receiver(rcfg);
+
+    int64_t now = 0;
+    for (uint16_t seq = 0; seq < 100; ++seq) {
+        auto pkt = rtp(seq, seq * 3000u, 0x1111);
+        sender.OnRtpSent(pkt.size() - 12, seq * 3000u, now);
+        if (seq % 10 != 5) {
+            RtpHeaderView hdr;
+            CHECK(hdr.Parse(pkt.data(), pkt.size()));
+            receiver.OnRtpReceived(hdr, now);
+        }
+        now += 33;
+    }
+    CHECK(!sender.ReportDue(now));
+
+    uint8_t buf[512];
+    std::size_t n = sender.BuildReport(std::span<uint8_t>(buf, sizeof(buf)), now);
+    CHECK(n == 28);
+    CHECK(buf[1] == RTCP_PACKET_TYPE_SR);
+    CHECK(receiver.OnRtcpReceived(buf, n, now));
+
+    n = receiver.BuildReport(std::span<uint8_t>(buf, sizeof(buf)), now + 10);
+    CHECK(n == 32);
+    CHECK(buf[1] == RTCP_PACKET_TYPE_RR);
+    CHECK(sender.OnRtcpReceived(buf, n, now + 20));
+    auto& remote = sender.remote_report();
+    CHECK(remote.valid);
+    CHECK(remote.cumulative_lost == 10);
+    CHECK(remote.rtt_ms >= 0);
+    CHECK(sender.ReportDue(now + 60000));
+}
+
+/// @brief SDES：多chunk、替换、删除、打包解析往返
+static void test_sdes() {
+    RTCPSdes sdes;
+    CHECK(sdes.AddItem(0x1, RTCP_SdesItemType::RTCP_SDES_CNAME, "cam1@10.0.0.1"));
+    CHECK(sdes.AddItem(0x2, RTCP_SdesItemType::RTCP_SDES_CNAME, "cam2@10.0.0.2"));
+    CHECK(sdes.AddItem(0x2, RTCP_SdesItemType::RTCP_SDES_TOOL, "media"));
+    CHECK(sdes.AddItem(0x2, RTCP_SdesItemType::RTCP_SDES_CNAME, "cam2"));
+    CHECK(sdes.GetItem(0x2, RTCP_SdesItemType::RTCP_SDES_CNAME) == "cam2");
+    CHECK(sdes.GetItem(0x2, RTCP_SdesItemType::RTCP_SDES_TOOL) == "media");
+    sdes.RemoveItem(0x2, RTCP_SdesItemType::RTCP_SDES_TOOL);
+    CHECK(sdes.GetItem(0x2, RTCP_SdesItemType::RTCP_SDES_TOOL).empty());
+
+    uint8_t buf[128];
+    std::size_t n = sdes.PackInto(std::span<uint8_t>(buf, sizeof(buf)));
+    CHECK(n > 0 && n % 4 == 0);
+    CHECK(sdes.PackInto(std::span<uint8_t>(buf, 8)) == 0);
+    CHECK(sdes.Pack() == std::vector<uint8_t>(buf, buf + n));
+
+    RTCPSdes parsed;
+    parsed.Parse(buf, n);
+    CHECK(parsed.chunk_count() == 2);
+    CHECK(parsed.GetItem(0x1, RTCP_SdesItemType::RTCP_SDES_CNAME) == "cam1@10.0.0.1");
+    CHECK(parsed.GetItem(0x2, RTCP_SdesItemType::RTCP_SDES_CNAME) == "cam2");
+
+    // 每种item都取255字节的最大长度，仍能保存并往返
+    RTCPSdes full;
+    const std::string longest(255, 'x');
+    CHECK(!full.AddItem(0x3, RTCP_SdesItemType::RTCP_SDES_CNAME, longest + "x"));
+    for (int type = 1; type <= 8; ++type) {
+        CHECK(full.AddItem(0x3, static_cast<RTCP_SdesItemType>(type), longest));
+    }
+    std::vector<uint8_t> packed = full.Pack();
+    CHECK(!packed.empty());
+    RTCPSdes full_parsed;
+    full_parsed.Parse(packed.data(), packed.size());
+    CHECK(full_parsed.GetItem(0x3, RTCP_SdesItemType::RTCP_SDES_CNAME) == longest);
+    CHECK(full_parsed.GetItem(0x3, RTCP_SdesItemType::RTCP_SDES_PRIV) == longest);
+}
+
+/// @brief 带CNAME的会话生成RR+SDES复合包
+static void test_session_compound() {
+    struct Types : RtcpHandler {
+        void OnReceiverReport(uint32_t, const RtcpReportBlock*, std::size_t) override { ++rr; }
+        void OnPacket(uint8_t pt, const uint8_t* data, std::size_t size) override {
+            if (pt == RTCP_PACKET_TYPE_SDES) {
+                sdes.Parse(data, size);
+            }
+        }
+        int rr = 0;
+        RTCPSdes sdes;
+    } types;
+
+    RtcpSession::Config cfg;
+    cfg.ssrc = 0x3333;
+    cfg.cname = "nvr@host";
+    RtcpSession session(cfg);
+    uint8_t buf[256];
+    std::size_t n = session.BuildReport(std::span<uint8_t>(buf, sizeof(buf)), 0);
+    CHECK(n > 8);
+    CHECK(Rtcp::ParseCompound(buf, n, types));
+    CHECK(types.rr == 1);
+    CHECK(types.sdes.GetItem(0x3333, RTCP_SdesItemType::RTCP_SDES_CNAME) == "nvr@host");
+}
+
+/// @brief 活跃源多于一个报告的块数上限时轮转，每个源都能轮到
+static void test_report_rotation() {
+    struct Blocks : RtcpHandler {
+        void OnReceiverReport(uint32_t, const RtcpReportBlock* blocks, std::size_t count) override {
+            for (std::size_t i = 0; i < count; ++i) {
+                ssrcs.insert(blocks[i].ssrc);
+            }
+            last_count = count;
+        }
+        std::set<uint32_t> ssrcs;
+        std::size_t last_count = 0;
+    } seen;
+
+    RtcpSession::Config cfg;
+    cfg.ssrc = 0x4444;
+    RtcpSession session(cfg);
+    constexpr uint32_t kSources = 40;
+    uint8_t buf[1500];
+    for (int round = 0; round < 2; ++round) {
+        // 每轮所有源都有两个连续的新包（首轮借此通过试用期），都处于活跃状态
+        for (uint32_t s = 0; s < kSources; ++s) {
+            for (int k = 0; k < 2; ++k) {
+                auto pkt = rtp(static_cast<uint16_t>(round * 2 + k), round * 3000u, 0x10000 + s);
+                RtpHeaderView hdr;
+                CHECK(hdr.Parse(pkt.data(), pkt.size()));
+                session.OnRtpReceived(hdr, round * 100);
+            }
+        }
+        std::size_t n = session.BuildReport(std::span<uint8_t>(buf, sizeof(buf)), round * 100 + 50);
+        CHECK(n > 0);
+        CHECK(Rtcp::ParseCompound(buf, n, seen));
+        CHECK(seen.last_count == RTCP_MAX_REPORT_BLOCKS);
+    }
+    CHECK(seen.ssrcs.size() == kSources);
+}
+
+int main() {
+    test_receive_stats();
+    test_compound_roundtrip();
+    test_session();
+    test_sdes();
+    test_session_compound();
+    test_report_rotation();
+    if (failures) {
+        std::cerr << failures << " check(s) failed" << std::endl;
+        return 1;
+    }
+    std::cout << "test_rtcp passed" << std::endl;
+    return 0;
+}
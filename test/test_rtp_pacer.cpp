@@ -0,0 +1,139 @@
+#include <iostream>
+#include <vector>
+#include <memory>
+#include "media/rtp_packetizer.h"
+#include "media/rtp_pacer.h"
+
+static int failures = 0;
+#define CHECK(cond) do { if (!(cond)) { std::cerr << "CHECK failed: " #cond " at line " << __LINE__ << std::endl; ++failures; } } while (0)
+
+static std::vector<uint8_t> make_frame(bool idr, std::size_t size) {
+    std::vector<uint8_t> au = {0, 0, 0, 1, static_cast<uint8_t>(idr ? 0x65 : 0x01)};
+    au.resize(au.size() + size, 0x5A);
+    return au;
+}
+
+/// @brief 关键帧约100个包，应在窗口内均匀发出而不是一次发完
+static void test_spread_over_window() {
+    RtpPacer::Config cfg;
+    cfg.window_ms = 20;
+    cfg.tick_us = 500;
+    RtpPacer pacer(cfg);
+
+    std::vector<std::pair<int64_t, std::size_t>> sends;
+    int64_t now = 1000000;
+    auto stream = pacer.AddStream([&](const RtpPacketView*, std::size_t count) {
+        sends.emplace_back(now, count);
+        return static_cast<int>(count);
+    });
+
+    H264RtpPacketizer::Config pcfg;
+    pcfg.mtu = 1200;
+    H264RtpPacketizer packetizer(pcfg);
+    auto frame = std::make_shared<std::vector<uint8_t>>(make_frame(true, 120000));
+    RtpPacketBatch batch;
+    packetizer.PacketizeAnnexB(frame->data(), frame->size(), 0, batch);
+    const std::size_t total = batch.size();
+    CHECK(total > 90);
+
+    std::weak_ptr<std::vector<uint8_t>> weak = frame;
+    CHECK(stream->Enqueue(batch, frame));
+    frame.reset();
+    CHECK(!weak.expired());
+    CHECK(pacer.active_streams() == 1);
+
+    std::size_t sent_by_half = 0;
+    for (; now < 1000000 + 40000; now += cfg.tick_us) {
+        pacer.Poll(now);
+        if (now < 1000000 + 10000) {
+            sent_by_half = stream->stats().sent;
+        }
+    }
+    CHECK(stream->stats().sent == total);
+    CHECK(stream->stats().queued_packets == 0);
+    CHECK(weak.expired());
+    CHECK(pacer.active_streams() == 0);
+    // 前半个窗口只发出约一半，最大单次突发不超过桶深
+    CHECK(sent_by_half > total / 3 && sent_by_half < total * 2 / 3 + 6);
+    std::size_t max_burst = 0;
+    for (auto& s : sends) {
+        max_burst = std::max(max_burst, s.second);
+    }
+    CHECK(max_burst <= 12);
+    CHECK(sends.back().first - sends.front().first >= 15000);
+    CHECK(sends.back().first - sends.front().first <= 22000);
+}
+
+/// @brief 队列满时丢弃不被参考的新帧，或从队头按整帧丢弃旧包
+static void test_bounded_queue() {
+    RtpPacer pacer;
+    auto stream = pacer.AddStream([](const RtpPacketView*, std::size_t count) {
+        return static_cast<int>(count);
+    }, 16);
+
+    H264RtpPacketizer::Config pcfg;
+    pcfg.mtu = 1200;
+    H264RtpPacketizer packetizer(pcfg);
+    auto idr = make_frame(true, 10000);
+    auto p = make_frame(false, 5000);
+    RtpPacketBatch big, small;
+    packetizer.PacketizeAnnexB(idr.data(), idr.size(), 0, big);
+    packetizer.PacketizeAnnexB(p.data(), p.size(), 3000, small);
+    CHECK(big.size() == 9 && small.size() == 5);
+    CHECK(small.packets[0].flags & RtpPacketView::kDisposable);
+
+    CHECK(stream->Enqueue(big));
+    CHECK(stream->Enqueue(small));
+    // 剩余2个槽位，不被参考的帧直接丢弃
+    CHECK(!stream->Enqueue(small));
+    CHECK(stream->stats().dropped == 5);
+    // 关键帧挤掉队头的整帧
+    CHECK(stream->Enqueue(big));
+    CHECK(stream->stats().queued_packets == 14);
+    CHECK(stream->stats().dropped == 14);
+
+    stream->Close();
+    CHECK(stream->stats().queued_packets == 0);
+    CHECK(!stream->Enqueue(small));
+}
+
+/// @brief 发送线程驱动多个流
+static void test_thread() {
+    RtpPacer::Config cfg;
+    cfg.window_ms = 5;
+    RtpPacer pacer(cfg);
+    pacer.Start();
+
+    std::vector<std::shared_ptr<PacedRtpStream>> streams;
+    for (int i = 0; i < 100; ++i) {
+        streams.push_back(pacer.AddStream([](const RtpPacketView*, std::size_t count) {
+            return static_cast<int>(count);
+        }));
+    }
+    H264RtpPacketizer packetizer(H264RtpPacketizer::Config{});
+    auto frame = make_frame(true, 20000);
+    RtpPacketBatch batch;
+    packetizer.PacketizeAnnexB(frame.data(), frame.size(), 0, batch);
+    for (auto& s : streams) {
+        CHECK(s->Enqueue(batch));
+    }
+    for (int i = 0; i < 200 && pacer.active_streams() > 0; ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    pacer.Stop();
+    for (auto& s : streams) {
+        CHECK(s->stats().sent == batch.size());
+    }
+}
+
+int main() {
+    test_spread_over_window();
+    test_bounded_queue();
+    test_thread();
+    if (failures) {
+        std::cerr << failures << " check(s) failed" << std::endl;
+        return 1;
+    }
+    std::cout << "test_rtp_pacer passed" << std::endl;
+    return 0;
+}
@@ -0,0 +1,180 @@
+#include <iostream>
+#include <vector>
+#include <cstring>
+#include "media/rtp_packetizer.h"
+#include "media/rtp_depacketizer.h"
+
+static int failures = 0;
+#define CHECK(cond) do { if (!(cond)) { std::cerr << "CHECK failed: " #cond " at line " << __LINE__ << std::endl; ++failures; } } while (0)
+
+/// @brief 构造Annex-B访问单元：SPS、PPS、一个大IDR
+static std::vector<uint8_t> make_access_unit(std::size_t idr_size) {
+    std::vector<uint8_t> au;
+    const uint8_t sps[] = {0, 0, 0, 1, 0x67, 0x42, 0x00, 0x1f, 0xe9};
+    const uint8_t pps[] = {0, 0, 0, 1, 0x68, 0xce, 0x3c, 0x80};
+    au.insert(au.end(), sps, sps + sizeof(sps));
+    au.insert(au.end(), pps, pps + sizeof(pps));
+    au.insert(au.end(), {0, 0, 1, 0x65});
+    for (std::size_t i = 1; i < idr_size; ++i) {
+        au.push_back(static_cast<uint8_t>(i % 251 + 2));
+    }
+    return au;
+}
+
+static void test_h264_fu_a_and_stap_a() {
+    auto au = make_access_unit(5000);
+    H264RtpPacketizer::Config cfg;
+    cfg.ssrc = 0x11223344;
+    cfg.initial_seq = 65534;
+    cfg.mtu = 1200;
+    H264RtpPacketizer packetizer(cfg);
+    RtpPacketBatch batch;
+    std::size_t n = packetizer.PacketizeAnnexB(au.data(), au.size(), 9000, batch);
+
+    // STAP-A(SPS+PPS) + FU-A若干
+    CHECK(n == batch.size());
+    CHECK(n >= 6);
+    CHECK((batch.packets[0].slab[12] & 0x1F) == H264RtpPacketizer::kStapA);
+    CHECK(batch.packets[0].flags & RtpPacketView::kFrameStart);
+    CHECK(batch.packets.back().marker());
+    CHECK(batch.packets[1].seq == 65535);
+    CHECK(batch.packets[2].seq == 0);
+
+    // 负载指向原缓冲区，不拷贝
+    const uint8_t* fu_payload = static_cast<const uint8_t*>(batch.packets[1].iov[1].iov_base);
+    CHECK(fu_payload >= au.data() && fu_payload < au.data() + au.size());
+
+    // 重组FU-A，得到原IDR
+    std::vector<uint8_t> idr;
+    for (std::size_t i = 1; i < batch.size(); ++i) {
+        auto& p = batch.packets[i];
+        CHECK(p.size <= cfg.mtu);
+        CHECK(p.flags & RtpPacketView::kKeyframe);
+        uint8_t fu_header = p.slab[13];
+        if (fu_header & 0x80) {
+            idr.push_back((p.slab[12] & 0xE0) | (fu_header & 0x1F));
+        }
+        const uint8_t* d = static_cast<const uint8_t*>(p.iov[1].iov_base);
+        idr.insert(idr.end(), d, d + p.iov[1].iov_len);
+    }
+    CHECK(idr.size() == 5000);
+    CHECK(std::memcmp(idr.data(), au.data() + 20, idr.size()) == 0);
+
+    // 拷贝后slab内的iovec指向新对象
+    RtpPacketView copy = batch.packets[0];
+    CHECK(copy.iov[0].iov_base == copy.slab);
+    uint8_t flat[1500];
+    CHECK(copy.Flatten(flat, sizeof(flat)) == copy.size);
+    CHECK(flat[0] == 0x80 && flat[8] == 0x11 && flat[11] == 0x44);
+}
+
+/// @brief H.265往返：VPS/SPS/PPS聚合为AP，IDR拆分为FU，解包后与原码流一致
+static void test_h265_roundtrip() {
+    std::vector<uint8_t> au;
+    const uint8_t vps[] = {0, 0, 0, 1, 0x40, 0x01, 0x0c, 0x01, 0xff};
+    const uint8_t sps[] = {0, 0, 0, 1, 0x42, 0x01, 0x01, 0x01, 0x60};
+    const uint8_t pps[] = {0, 0, 0, 1, 0x44, 0x01, 0xc1, 0x72};
+    au.insert(au.end(), vps, vps + sizeof(vps));
+    au.insert(au.end(), sps, sps + sizeof(sps));
+    au.insert(au.end(), pps, pps + sizeof(pps));
+    au.insert(au.end(), {0, 0, 0, 1, 0x26, 0x01}); // IDR_W_RADL
+    for (std::size_t i = 0; i < 4000; ++i) {
+        au.push_back(static_cast<uint8_t>(i % 251 + 2));
+    }
+
+    H265RtpPacketizer::Config cfg;
+    cfg.payload_type = 98;
+    cfg.mtu = 1000;
+    H265RtpPacketizer packetizer(cfg);
+    RtpPacketBatch batch;
+    std::size_t n = packetizer.PacketizeAnnexB(au.data(), au.size(), 3600, batch);
+    CHECK(n >= 6);
+    CHECK(H265RtpPacketizer::NalType(batch.packets[0].slab + 12) == H265RtpPacketizer::kAp);
+    CHECK(H265RtpPacketizer::NalType(batch.packets[1].slab + 12) == H265RtpPacketizer::kFu);
+    CHECK(batch.packets[1].slab[14] == (0x80 | 19));
+    CHECK(batch.packets.back().slab[14] == (0x40 | 19));
+    CHECK(batch.packets.back().marker());
+
+    H265RtpDepacketizer depacketizer;
+    std::vector<std::vector<uint8_t>> wire(batch.size());
+    for (std::size_t i = 0; i < batch.size(); ++i) {
+        auto& p = batch.packets[i];
+        CHECK(p.size <= cfg.mtu);
+        CHECK(p.flags & RtpPacketView::kKeyframe);
+        wire[i].resize(p.size);
+        p.Flatten(wire[i].data(), wire[i].size());
+        CHECK(depacketizer.Push(wire[i].data() + 12, wire[i].size() - 12, p.timestamp, p.marker()));
+    }
+    CHECK(depacketizer.ready());
+    auto& out = depacketizer.access_unit();
+    CHECK(out.keyframe);
+    CHECK(!out.corrupted);
+    CHECK(out.size == au.size());
+    std::vector<uint8_t> flat(out.size);
+    CHECK(out.Flatten(flat.data(), flat.size()) == au.size());
+    CHECK(flat == au);
+
+    // 丢掉中间一个FU分片，帧被标记为损坏
+    depacketizer.Reset();
+    for (std::size_t i = 0; i < wire.size(); ++i) {
+        if (i == 2) {
+            depacketizer.MarkLoss();
+            continue;
+        }
+        depacketizer.Push(wire[i].data() + 12, wire[i].size() - 12, 3600, batch.packets[i].marker());
+    }
+    CHECK(depacketizer.ready());
+    CHECK(depacketizer.access_unit().corrupted);
+}
+
+/// @brief 多slice的IDR：每个slice都走FU-A，重建的NALU头超出内联arena后溢出到堆上，帧保持完整
+static void test_many_slice_idr() {
+    constexpr int kSlices = 150;
+    std::vector<uint8_t> au = make_access_unit(0);
+    au.resize(au.size() - 4); // 去掉空IDR
+    for (int s = 0; s < kSlices; ++s) {
+        au.insert(au.end(), {0, 0, 0, 1, 0x65});
+        for (std::size_t i = 0; i < 1500; ++i) {
+            au.push_back(static_cast<uint8_t>((i + s) % 251 + 2));
+        }
+    }
+    H264RtpPacketizer::Config cfg;
+    cfg.mtu = 1200;
+    H264RtpPacketizer packetizer(cfg);
+    RtpPacketBatch batch;
+    packetizer.PacketizeAnnexB(au.data(), au.size(), 9000, batch);
+    std::vector<std::vector<uint8_t>> wire(batch.size());
+    for (std::size_t i = 0; i < batch.size(); ++i) {
+        wire[i].resize(batch.packets[i].size);
+        batch.packets[i].Flatten(wire[i].data(), wire[i].size());
+    }
+
+    // 两帧：第二帧复用第一帧分配的溢出块
+    H264RtpDepacketizer depacketizer;
+    for (int round = 0; round < 2; ++round) {
+        for (std::size_t i = 0; i < wire.size(); ++i) {
+            CHECK(depacketizer.Push(wire[i].data() + 12, wire[i].size() - 12, 9000 + round * 3600,
+                                    batch.packets[i].marker()));
+        }
+        CHECK(depacketizer.ready());
+        auto& out = depacketizer.access_unit();
+        CHECK(out.keyframe);
+        CHECK(!out.corrupted);
+        std::vector<uint8_t> flat(out.size);
+        CHECK(out.Flatten(flat.data(), flat.size()) == au.size());
+        CHECK(flat == au);
+        depacketizer.Reset();
+    }
+}
+
+int main() {
+    test_h264_fu_a_and_stap_a();
+    test_h265_roundtrip();
+    test_many_slice_idr();
+    if (failures) {
+        std::cerr << failures << " check(s) failed" << std::endl;
+        return 1;
+    }
+    std::cout << "test_rtp_packetizer passed" << std::endl;
+    return 0;
+}
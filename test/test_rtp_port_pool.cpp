@@ -0,0 +1,168 @@
+#include <iostream>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+#include "rtp_port_pool.h"
+
+static int failures = 0;
+#define CHECK(cond) do { if (!(cond)) { std::cerr << "CHECK failed: " #cond " at line " << __LINE__ << std::endl; ++failures; } } while (0)
+
+template <typename Pred>
+static bool wait_until(Pred pred, int ms = 3000) {
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(ms);
+    while (!pred()) {
+        if (std::chrono::steady_clock::now() > deadline) {
+            return false;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    }
+    return true;
+}
+
+static RtpPortPool::Config pool_config(uint16_t min, uint16_t max) {
+    RtpPortPool::Config cfg;
+    cfg.ip = "127.0.0.1";
+    cfg.port_min = min;
+    cfg.port_max = max;
+    cfg.quarantine_ms = 200;
+    return cfg;
+}
+
+/// @brief 成对分配、耗尽、归还后隔离期满才再次借出
+static void test_acquire_release() {
+    ASIO::IoContext io;
+    // 占住一个端口，池应跳过这一对
+    ASIO::UdpSocket busy(io, ASIO::UdpEndpoint(boost::asio::ip::make_address("127.0.0.1"), 44005));
+    auto pool = std::make_shared<RtpPortPool>(io, pool_config(44001, 44020));
+    CHECK(pool->capacity() == 9);
+
+    std::vector<RtpPortPool::Lease> leases;
+    std::set<uint16_t> ports;
+    while (auto lease = pool->Acquire()) {
+        CHECK(lease.port() % 2 == 0);
+        CHECK(lease.port() != 44004);
+        CHECK(lease.rtp().local_endpoint().port() == lease.port());
+        CHECK(lease.rtcp() && lease.rtcp()->local_endpoint().port() == lease.port() + 1);
+        ports.insert(lease.port());
+        leases.push_back(std::move(lease));
+    }
+    CHECK(leases.size() == 9 && ports.size() == 9);
+    CHECK(*ports.begin() == 44000);
+    auto stats = pool->stats();
+    CHECK(stats.leased == 9 && stats.free == 0 && stats.exhausted == 1);
+
+    uint16_t returned = leases.back().port();
+    leases.pop_back();
+    CHECK(pool->stats().quarantined == 1);
+    CHECK(!pool->Acquire());
+    std::this_thread::sleep_for(std::chrono::milliseconds(250));
+    auto again = pool->Acquire();
+    CHECK(again && again.port() == returned);
+
+    // 移动后原Lease为空，只归还一次
+    RtpPortPool::Lease moved = std::move(again);
+    CHECK(!again && moved);
+    moved.Release();
+    CHECK(!moved);
+    CHECK(pool->stats().quarantined == 1);
+}
+
+/// @brief 隔离期间到达的旧会话数据报不会交给下一个借用者
+static void test_stale_packets() {
+    ASIO::IoContext io;
+    auto work = boost::asio::make_work_guard(io);
+    std::thread th([&]() { io.run(); });
+    auto strand = boost::asio::make_strand(io);
+
+    auto pool = std::make_shared<RtpPortPool>(io, pool_config(44100, 44102));
+    CHECK(pool->capacity() == 1);
+    net::UdpBatchSocket peer(io, ASIO::UdpEndpoint(boost::asio::ip::make_address("127.0.0.1"), 0));
+
+    std::mutex mtx;
+    std::vector<std::string> got;
+    auto handler = [&](const net::UdpDatagram* dgrams, size_t count) {
+        std::lock_guard<std::mutex> lock(mtx);
+        for (size_t i = 0; i < count; ++i) {
+            got.emplace_back(reinterpret_cast<const char*>(dgrams[i].data), dgrams[i].size);
+        }
+    };
+
+    auto lease = pool->Acquire();
+    ASIO::UdpEndpoint target(boost::asio::ip::make_address("127.0.0.1"), lease.port());
+    boost::asio::post(strand, [&]() { lease.rtp().StartReceive(handler, strand); });
+    peer.SendTo(target, "first", 5);
+    CHECK(wait_until([&]() { std::lock_guard<std::mutex> lock(mtx); return got.size() == 1; }));
+
+    std::atomic<bool> released{false};
+    boost::asio::post(strand, [&]() { lease.Release(); released = true; });
+    CHECK(wait_until([&]() { return released.load(); }));
+    for (int i = 0; i < 5; ++i) {
+        peer.SendTo(target, "stale", 5);
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(250));
+
+    auto next = pool->Acquire();
+    CHECK(next && next.port() == target.port());
+    boost::asio::post(strand, [&]() { next.rtp().StartReceive(handler, strand); });
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    peer.SendTo(target, "fresh", 5);
+    CHECK(wait_until([&]() { std::lock_guard<std::mutex> lock(mtx); return got.size() == 2; }));
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        CHECK((got == std::vector<std::string>{"first", "fresh"}));
+    }
+
+    released = false;
+    boost::asio::post(strand, [&]() { next.Release(); released = true; });
+    CHECK(wait_until([&]() { return released.load(); }));
+    peer.Close();
+    work.reset();
+    th.join();
+}
+
+/// @brief 借出/归还与现场打开绑定一对socket的耗时对比
+static void bench_acquire() {
+    ASIO::IoContext io;
+    constexpr int kRounds = 2000;
+    auto cfg = pool_config(44200, 44264);
+    cfg.quarantine_ms = 0;
+    auto pool = std::make_shared<RtpPortPool>(io, cfg);
+
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < kRounds; ++i) {
+        auto lease = pool->Acquire();
+        CHECK(lease);
+    }
+    double pooled = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count() / kRounds;
+
+    net::UdpBatchSocket::Config ucfg;
+    ucfg.batch = cfg.batch;
+    ucfg.datagram_size = cfg.datagram_size;
+    ucfg.recv_buffer = cfg.recv_buffer;
+    ucfg.enable_gso = false;
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < kRounds; ++i) {
+        uint16_t port = static_cast<uint16_t>(44300 + (i % 32) * 2);
+        net::UdpBatchSocket rtp(io, ASIO::UdpEndpoint(boost::asio::ip::make_address("127.0.0.1"), port), ucfg);
+        net::UdpBatchSocket rtcp(io, ASIO::UdpEndpoint(boost::asio::ip::make_address("127.0.0.1"), port + 1), ucfg);
+    }
+    double bound = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count() / kRounds;
+    std::cout << "rtp port pair: pool acquire/release " << pooled << " us, open+bind " << bound << " us" << std::endl;
+}
+
+int main() {
+    test_acquire_release();
+    test_stale_packets();
+    bench_acquire();
+    if (failures) {
+        std::cerr << failures << " check(s) failed" << std::endl;
+        return 1;
+    }
+    std::cout << "test_rtp_port_pool passed" << std::endl;
+    return 0;
+}
@@ -0,0 +1,128 @@
+#include <iostream>
+#include <vector>
+#include <memory>
+#include "media/rtcp.h"
+#include "media/rtp_rtx_cache.h"
+
+static int failures = 0;
+#define CHECK(cond) do { if (!(cond)) { std::cerr << "CHECK failed: " #cond " at line " << __LINE__ << std::endl; ++failures; } } while (0)
+
+static std::vector<uint8_t> flatten(const RtpPacketView& p) {
+    std::vector<uint8_t> buf(p.size);
+    p.Flatten(buf.data(), buf.size());
+    return buf;
+}
+
+/// @brief NACK经RTCP会话解析后交给缓存，重传内容与原包一致
+static void test_nack_roundtrip() {
+    H264RtpPacketizer::Config pcfg;
+    pcfg.ssrc = 0xABCD;
+    pcfg.initial_seq = 65500;   // 跨越序号回绕
+    pcfg.mtu = 1200;
+    H264RtpPacketizer packetizer(pcfg);
+    auto frame = std::make_shared<std::vector<uint8_t>>(std::vector<uint8_t>{0, 0, 0, 1, 0x65});
+    frame->resize(60000, 0x33);
+    RtpPacketBatch batch;
+    packetizer.PacketizeAnnexB(frame->data(), frame->size(), 0, batch);
+    CHECK(batch.size() > 50);
+
+    RtpRtxCache cache;
+    cache.Store(batch, frame, 1000);
+    std::weak_ptr<std::vector<uint8_t>> weak = frame;
+    frame.reset();
+    CHECK(!weak.expired());
+
+    RtcpSession::Config scfg;
+    scfg.ssrc = 0xABCD;
+    RtcpSession session(scfg);
+    std::vector<RtpRtxCache::RtxPacket> out;
+    int64_t now = 1050;
+    session.SetNackHandler([&](const uint16_t* seqs, std::size_t count) {
+        cache.OnNack(seqs, count, now, out);
+    });
+
+    // 一个PID/BLP覆盖回绕前后的序号，另一个单独的序号
+    const uint16_t lost[] = {65520, 65534, 65535, 0, 3};
+    uint8_t buf[256];
+    std::size_t n = Rtcp::WriteNack(buf, 0x1111, 0xABCD, lost, 5);
+    CHECK(n == RTCP_HEADER_SIZE + 8 + 2 * 4);
+    CHECK(session.OnRtcpReceived(buf, n, now));
+    CHECK(out.size() == 5);
+    for (std::size_t i = 0; i < out.size() && i < 5; ++i) {
+        CHECK(out[i].packet.seq == lost[i]);
+        std::size_t index = static_cast<uint16_t>(lost[i] - 65500);
+        CHECK(flatten(out[i].packet) == flatten(batch.packets[index]));
+        CHECK(out[i].keepalive != nullptr);
+    }
+
+    // 一个RTT内重复请求不重传
+    out.clear();
+    CHECK(session.OnRtcpReceived(buf, n, now + 5));
+    CHECK(out.empty());
+    CHECK(cache.stats().duplicate == 5);
+
+    // 其他SSRC的NACK不回调
+    n = Rtcp::WriteNack(buf, 0x1111, 0x9999, lost, 5);
+    CHECK(session.OnRtcpReceived(buf, n, now + 100));
+    CHECK(out.empty());
+
+    // 过期
+    out.clear();
+    CHECK(cache.OnNack(lost, 1, 1000 + 2000, out) == 0);
+    CHECK(cache.stats().expired == 1);
+
+    cache.Clear();
+    out.clear();
+    CHECK(weak.expired());
+}
+
+/// @brief 重传码率受令牌桶限制，覆盖后的槽位不再命中
+static void test_rate_limit() {
+    RtpRtxCache::Config cfg;
+    cfg.capacity = 64;
+    cfg.min_bitrate_bps = 8 * 12000;    // 12000字节/秒，令牌桶深度取下限3000字节
+    cfg.max_ratio = 0;
+    RtpRtxCache cache(cfg);
+
+    RtpPacketView pkt;
+    static uint8_t payload[1000];
+    for (uint16_t seq = 0; seq < 100; ++seq) {
+        pkt.iov_cnt = 0;
+        pkt.size = 0;
+        pkt.seq = seq;
+        WriteRtpHeader(pkt.slab, 96, false, seq, 0, 1);
+        pkt.push_slab(0, RTP_FIXED_HEADER_SIZE);
+        pkt.push_data(payload, sizeof(payload));
+        cache.Store(pkt, nullptr, seq);
+    }
+
+    std::vector<RtpRtxCache::RtxPacket> out;
+    std::vector<uint16_t> seqs;
+    for (uint16_t seq = 50; seq < 60; ++seq) {
+        seqs.push_back(seq);
+    }
+    // 3000字节的桶只够2个1012字节的包
+    CHECK(cache.OnNack(seqs.data(), seqs.size(), 200, out) == 2);
+    CHECK(cache.stats().throttled == 8);
+    // 100ms后补充1200字节，加上余下的976字节够再发2个
+    out.clear();
+    CHECK(cache.OnNack(seqs.data() + 2, seqs.size() - 2, 300, out) == 2);
+    CHECK(out.size() == 2 && out[0].packet.seq == 52 && out[1].packet.seq == 53);
+
+    // 序号10的槽位已被74覆盖
+    uint16_t old_seq = 10;
+    out.clear();
+    CHECK(cache.OnNack(&old_seq, 1, 1000, out) == 0);
+    CHECK(cache.stats().missing == 1);
+}
+
+int main() {
+    test_nack_roundtrip();
+    test_rate_limit();
+    if (failures) {
+        std::cerr << failures << " check(s) failed" << std::endl;
+        return 1;
+    }
+    std::cout << "test_rtp_rtx_cache passed" << std::endl;
+    return 0;
+}
@@ -0,0 +1,133 @@
+#include <iostream>
+#include <vector>
+#include <cstring>
+#include "media/rtp_packetizer.h"
+#include "media/rtsp_interleaved.h"
+
+static int failures = 0;
+#define CHECK(cond) do { if (!(cond)) { std::cerr << "CHECK failed: " #cond " at line " << __LINE__ << std::endl; ++failures; } } while (0)
+
+static std::vector<uint8_t> make_frame(uint8_t nal_header, std::size_t size, uint8_t seed) {
+    std::vector<uint8_t> au = {0, 0, 0, 1, nal_header};
+    for (std::size_t i = 0; i < size; ++i) {
+        au.push_back(static_cast<uint8_t>((i + seed) % 251 + 2));
+    }
+    return au;
+}
+
+static std::vector<std::vector<uint8_t>> flatten(const RtpPacketBatch& batch) {
+    std::vector<std::vector<uint8_t>> out;
+    for (auto& p : batch.packets) {
+        std::vector<uint8_t> buf(p.size);
+        p.Flatten(buf.data(), buf.size());
+        out.push_back(std::move(buf));
+    }
+    return out;
+}
+
+/// @brief 积压时的丢弃顺序，以及写出的字节流与打包结果逐字节一致
+static void test_backpressure_and_framing() {
+    using Result = RtspInterleavedTransport::SendResult;
+    ASIO::IoContext ctx;
+    boost::asio::ip::tcp::acceptor acceptor(ctx, ASIO::TcpEndpoint(boost::asio::ip::address_v4::loopback(), 0));
+    ASIO::TcpSocket client(ctx);
+    client.connect(acceptor.local_endpoint());
+    ASIO::TcpSocket server(ctx);
+    acceptor.accept(server);
+
+    RtspInterleavedTransport::Config cfg;
+    cfg.max_queued_bytes = 64 * 1024;
+    cfg.low_watermark = 16 * 1024;
+    auto transport = std::make_shared<RtspInterleavedTransport>(server, cfg);
+    int keyframe_requests = 0;
+    transport->SetKeyframeRequestHandler([&](uint8_t channel) {
+        CHECK(channel == 0);
+        ++keyframe_requests;
+    });
+
+    H264RtpPacketizer packetizer(H264RtpPacketizer::Config{});
+    auto idr = make_frame(0x65, 40000, 1);
+    auto b = make_frame(0x01, 10000, 2);     // nal_ref_idc=0，不被参考
+    auto p = make_frame(0x41, 10000, 3);
+    auto p_big = make_frame(0x41, 20000, 4);
+    RtpPacketBatch idr_batch, b_batch, p_batch, p_big_batch;
+    packetizer.PacketizeAnnexB(idr.data(), idr.size(), 0, idr_batch);
+    packetizer.PacketizeAnnexB(b.data(), b.size(), 3000, b_batch);
+    packetizer.PacketizeAnnexB(p.data(), p.size(), 6000, p_batch);
+    packetizer.PacketizeAnnexB(p_big.data(), p_big.size(), 9000, p_big_batch);
+
+    // io_context尚未运行，数据全部留在待发队列
+    const std::string reply = "RTSP/1.0 200 OK\r\nCSeq: 5\r\n\r\n";
+    CHECK(transport->SendControl(reply) == Result::Queued);
+    CHECK(transport->SendRtp(0, idr_batch) == Result::Queued);
+    CHECK(transport->SendRtp(0, b_batch) == Result::Queued);
+    CHECK(transport->SendRtp(0, b_batch) == Result::Queued);
+    // 已满：新到的不被参考帧直接丢弃
+    CHECK(transport->SendRtp(0, b_batch) == Result::Dropped);
+    // 参考帧挤掉队列里的两个不被参考帧
+    CHECK(transport->SendRtp(0, p_batch) == Result::Queued);
+    CHECK(transport->stats().dropped_frames == 3);
+    // 放不下的参考帧：丢弃并进入等关键帧状态
+    CHECK(transport->SendRtp(0, p_big_batch) == Result::Dropped);
+    CHECK(keyframe_requests == 1);
+    CHECK(transport->SendRtp(0, p_batch) == Result::Dropped);
+    CHECK(keyframe_requests == 1);
+    // 关键帧清掉积压后入队
+    CHECK(transport->SendRtp(0, idr_batch) == Result::Queued);
+    const uint8_t rtcp[8] = {0x80, 201, 0, 1, 0, 0, 0, 7};
+    CHECK(transport->SendRtcp(1, rtcp, sizeof(rtcp)) == Result::Queued);
+    CHECK(!transport->writable());
+
+    ctx.run();
+    auto stats = transport->stats();
+    CHECK(stats.queued_bytes == 0);
+    CHECK(stats.sent_packets == idr_batch.size());
+
+    auto expected_rtp = flatten(idr_batch);
+    std::size_t total = reply.size() + RTSP_INTERLEAVED_HEADER_SIZE + sizeof(rtcp);
+    for (auto& pkt : expected_rtp) {
+        total += RTSP_INTERLEAVED_HEADER_SIZE + pkt.size();
+    }
+    std::vector<uint8_t> wire(total);
+    boost::asio::read(client, boost::asio::buffer(wire));
+
+    CHECK(std::memcmp(wire.data(), reply.data(), reply.size()) == 0);
+    std::size_t pos = reply.size();
+    std::size_t index = 0;
+    while (pos < wire.size()) {
+        uint8_t channel = 0xFF;
+        const uint8_t* payload = nullptr;
+        std::size_t payload_size = 0;
+        std::size_t n = RtspInterleavedTransport::ParseFrame(wire.data() + pos, wire.size() - pos, channel, payload, payload_size);
+        CHECK(n > 0);
+        if (n == 0) {
+            break;
+        }
+        if (index < expected_rtp.size()) {
+            CHECK(channel == 0);
+            CHECK(payload_size == expected_rtp[index].size());
+            CHECK(std::memcmp(payload, expected_rtp[index].data(), payload_size) == 0);
+        } else {
+            CHECK(channel == 1);
+            CHECK(payload_size == sizeof(rtcp) && std::memcmp(payload, rtcp, sizeof(rtcp)) == 0);
+        }
+        ++index;
+        pos += n;
+    }
+    CHECK(index == expected_rtp.size() + 1);
+
+    uint8_t ch;
+    const uint8_t* payload;
+    std::size_t payload_size;
+    CHECK(RtspInterleavedTransport::ParseFrame(wire.data() + reply.size(), 10, ch, payload, payload_size) == 0);
+}
+
+int main() {
+    test_backpressure_and_framing();
+    if (failures) {
+        std::cerr << failures << " check(s) failed" << std::endl;
+        return 1;
+    }
+    std::cout << "test_rtsp_interleaved passed" << std::endl;
+    return 0;
+}
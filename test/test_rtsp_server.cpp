@@ -0,0 +1,382 @@
+#include <iostream>
+#include <chrono>
+#include <vector>
+#include <string>
+#include <thread>
+#include "media/rtcp.h"
+#include "media/rtsp.h"
+#include "media/rtsp_server.h"
+
+static int failures = 0;
+#define CHECK(cond) do { if (!(cond)) { std::cerr << "CHECK failed: " #cond " at line " << __LINE__ << std::endl; ++failures; } } while (0)
+
+static std::vector<uint8_t> make_frame(std::initializer_list<uint8_t> prefix, std::size_t size, uint8_t seed) {
+    std::vector<uint8_t> au(prefix);
+    au.insert(au.end(), {0, 0, 0, 1, static_cast<uint8_t>(seed & 1 ? 0x65 : 0x41)});
+    for (std::size_t i = 0; i < size; ++i) {
+        au.push_back(static_cast<uint8_t>((i + seed) % 251 + 2));
+    }
+    return au;
+}
+
+/// @brief 阻塞式的最小RTSP客户端
+struct Client {
+    ASIO::IoContext ctx;
+    ASIO::TcpSocket socket{ctx};
+    std::string buf;
+    int cseq = 0;
+    std::string session;
+
+    explicit Client(uint16_t port) {
+        socket.connect(ASIO::TcpEndpoint(boost::asio::ip::address_v4::loopback(), port));
+    }
+
+    RtspMessage request(const std::string& method, const std::string& url, const std::string& headers = "") {
+        std::string text = method + " " + url + " RTSP/1.0\r\nCSeq: " + std::to_string(++cseq) + "\r\n" + headers;
+        if (!session.empty()) {
+            text += "Session: " + session + "\r\n";
+        }
+        text += "\r\n";
+        boost::asio::write(socket, boost::asio::buffer(text));
+        RtspMessage msg;
+        while (true) {
+            // 跳过应答前可能出现的interleaved媒体帧
+            if (!buf.empty() && buf[0] == '$') {
+                uint8_t ch;
+                const uint8_t* payload;
+                std::size_t n;
+                std::size_t len = RtspInterleavedTransport::ParseFrame(reinterpret_cast<const uint8_t*>(buf.data()), buf.size(), ch, payload, n);
+                if (len) {
+                    buf.erase(0, len);
+                    continue;
+                }
+            } else if (long n = RtspMessage::Parse(buf.data(), buf.size(), msg); n > 0) {
+                buf.erase(0, n);
+                break;
+            }
+            read_some();
+        }
+        if (const std::string* s = msg.Header("Session")) {
+            session = s->substr(0, s->find(';'));
+        }
+        return msg;
+    }
+
+    /// @brief 读一个interleaved帧
+    std::vector<uint8_t> read_frame(uint8_t& channel) {
+        while (true) {
+            const uint8_t* payload;
+            std::size_t n;
+            std::size_t len = buf.empty() ? 0 : RtspInterleavedTransport::ParseFrame(reinterpret_cast<const uint8_t*>(buf.data()), buf.size(), channel, payload, n);
+            if (len) {
+                std::vector<uint8_t> out(payload, payload + n);
+                buf.erase(0, len);
+                return out;
+            }
+            read_some();
+        }
+    }
+
+    void read_some() {
+        char tmp[8192];
+        std::size_t n = socket.read_some(boost::asio::buffer(tmp));
+        buf.append(tmp, n);
+    }
+};
+
+static void test_sdp() {
+    SdpTrack t;
+    t.codec = SdpCodec::H264;
+    const uint8_t extradata[] = {0, 0, 0, 1, 0x67, 0x42, 0xE0, 0x1F, 0xAA, 0, 0, 0, 1, 0x68, 0xCE, 0x3C, 0x80};
+    CHECK(Sdp::ExtractParameterSets(extradata, sizeof(extradata), t));
+    CHECK(Sdp::Fmtp(t) == "packetization-mode=1;profile-level-id=42E01F;sprop-parameter-sets=Z0LgH6o=,aM48gA==");
+    std::string decoded;
+    CHECK(Sdp::Base64Decode("Z0LgH6o=", decoded) && decoded == t.sps);
+    CHECK(Sdp::HasParameterSets(t));
+    t.codec = SdpCodec::H265;
+    CHECK(!Sdp::HasParameterSets(t));
+
+    // extradata只有SPS时，从关键帧带内的PPS补齐
+    RtspMediaSource::Config scfg;
+    scfg.video_extradata.assign(extradata, extradata + 9);
+    auto source = std::make_shared<RtspMediaSource>(scfg);
+    CHECK(source->Describe("127.0.0.1").find("sprop-parameter-sets") == std::string::npos);
+    auto key = make_frame({0, 0, 0, 1, 0x68, 0xCE, 0x3C, 0x80}, 100, 1);
+    CHECK(source->PushVideo(key.data(), key.size(), 3000));
+    CHECK(source->Describe("127.0.0.1").find("sprop-parameter-sets=Z0LgH6o=,aM48gA==") != std::string::npos);
+}
+
+/// @brief 一个源、一个interleaved观看者和一个UDP观看者：收到的包逐字节相同，都从关键帧开始
+static void test_fan_out() {
+    ASIO::IoContext io;
+    RtspServer::Config cfg;
+    cfg.port = 0;
+    cfg.rtp_port_min = 41000;
+    cfg.rtp_port_max = 41100;
+    auto server = std::make_shared<RtspServer>(io, cfg);
+    server->Start();
+
+    RtspMediaSource::Config scfg;
+    scfg.video_extradata = {0, 0, 0, 1, 0x67, 0x42, 0xE0, 0x1F, 0xAA, 0, 0, 0, 1, 0x68, 0xCE, 0x3C, 0x80};
+    auto source = server->AddSource("live/cam1", scfg);
+    CHECK(source != nullptr);
+    CHECK(server->AddSource("/live/cam1/", scfg) == nullptr);
+    int keyframe_requests = 0;
+    source->SetKeyframeRequestHandler([&]() { ++keyframe_requests; });
+
+    auto work = boost::asio::make_work_guard(io);
+    std::thread th([&]() { io.run(); });
+    const std::string url = "rtsp://127.0.0.1:" + std::to_string(server->port()) + "/live/cam1";
+
+    Client tcp(server->port());
+    RtspMessage r = tcp.request("OPTIONS", url);
+    CHECK(r.status == 200 && r.CSeq() == 1 && r.Header("Public"));
+    r = tcp.request("DESCRIBE", url, "Accept: application/sdp\r\n");
+    CHECK(r.status == 200);
+    CHECK(r.body.find("m=video 0 RTP/AVP 96\r\n") != std::string::npos);
+    CHECK(r.body.find("sprop-parameter-sets=Z0LgH6o=,aM48gA==") != std::string::npos);
+    CHECK(r.body.find("a=control:trackID=0") != std::string::npos);
+    CHECK(tcp.request("DESCRIBE", url + "x").status == 404);
+    r = tcp.request("SETUP", url + "/trackID=0", "Transport: RTP/AVP/TCP;unicast;interleaved=0-1\r\n");
+    CHECK(r.status == 200 && !tcp.session.empty());
+    CHECK(r.Header("Transport") && r.Header("Transport")->find("interleaved=0-1") != std::string::npos);
+    r = tcp.request("PLAY", url + "/");
+    CHECK(r.status == 200 && r.Header("RTP-Info"));
+
+    // UDP观看者
+    ASIO::UdpSocket udp(io, ASIO::UdpEndpoint(boost::asio::ip::address_v4::loopback(), 0));
+    uint16_t client_port = udp.local_endpoint().port();
+    Client viewer(server->port());
+    r = viewer.request("SETUP", url + "/trackID=0", "Transport: RTP/AVP;unicast;client_port=" + std::to_string(client_port)
+                       + "-" + std::to_string(client_port + 1) + "\r\n");
+    CHECK(r.status == 200 && r.Header("Transport") && r.Header("Transport")->find("server_port=41000-41001") != std::string::npos);
+    CHECK(viewer.request("PLAY", url).status == 200);
+    CHECK(source->stats().subscribers == 2);
+    CHECK(keyframe_requests == 2);
+
+    // P帧被跳过，关键帧开始转发
+    auto p = make_frame({}, 3000, 2);
+    CHECK(source->PushVideo(p.data(), p.size(), 1000));
+    auto idr = make_frame({}, 5000, 1);
+    CHECK(source->PushVideo(idr.data(), idr.size(), 4000));
+    CHECK(source->stats().frames == 2);
+
+    std::vector<std::vector<uint8_t>> tcp_packets;
+    std::vector<std::vector<uint8_t>> udp_packets;
+    while (true) {
+        uint8_t ch = 0xFF;
+        auto pkt = tcp.read_frame(ch);
+        CHECK(ch == 0);
+        tcp_packets.push_back(pkt);
+        RtpHeaderView hv;
+        CHECK(hv.Parse(pkt.data(), pkt.size()) && hv.timestamp == 4000);
+        if (hv.marker) {
+            break;
+        }
+    }
+    for (std::size_t i = 0; i < tcp_packets.size(); ++i) {
+        std::vector<uint8_t> dgram(2048);
+        std::size_t n = udp.receive(boost::asio::buffer(dgram));
+        dgram.resize(n);
+        udp_packets.push_back(dgram);
+    }
+    CHECK(!tcp_packets.empty() && tcp_packets == udp_packets);
+    CHECK(source->stats().fanout_packets == 2 * tcp_packets.size());
+
+    // TEARDOWN后不再发给该观看者
+    CHECK(viewer.request("TEARDOWN", url).status == 200);
+    CHECK(source->stats().subscribers == 1);
+
+    server->RemoveSource("live/cam1");
+    CHECK(source->stats().subscribers == 0);
+    server->Stop();
+    work.reset();
+    th.join();
+}
+
+/// @brief 没有保活的连接在会话超时后被关闭
+static void test_session_timeout() {
+    ASIO::IoContext io;
+    RtspServer::Config cfg;
+    cfg.port = 0;
+    cfg.session_timeout_s = 1;
+    auto server = std::make_shared<RtspServer>(io, cfg);
+    server->Start();
+    auto work = boost::asio::make_work_guard(io);
+    std::thread th([&]() { io.run(); });
+
+    Client idle(server->port());
+    Client active(server->port());
+    auto start = std::chrono::steady_clock::now();
+    CHECK(idle.request("OPTIONS", "rtsp://127.0.0.1/x").status == 200);
+    // 持续有请求的连接不超时
+    for (int i = 0; i < 6; ++i) {
+        CHECK(active.request("OPTIONS", "rtsp://127.0.0.1/x").status == 200);
+        std::this_thread::sleep_for(std::chrono::milliseconds(250));
+    }
+    boost::system::error_code ec;
+    char tmp[16];
+    idle.socket.read_some(boost::asio::buffer(tmp), ec);
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    CHECK(ec == boost::asio::error::eof);
+    CHECK(elapsed >= std::chrono::milliseconds(1000) && elapsed < std::chrono::milliseconds(2500));
+    CHECK(active.request("OPTIONS", "rtsp://127.0.0.1/x").status == 200);
+
+    server->Stop();
+    work.reset();
+    th.join();
+}
+
+/// @brief 在回环上绑一对相邻端口（RTP, RTCP）
+static uint16_t bind_pair(ASIO::UdpSocket& rtp, ASIO::UdpSocket& rtcp) {
+    auto loopback = boost::asio::ip::address_v4::loopback();
+    while (true) {
+        rtp = ASIO::UdpSocket(rtp.get_executor(), ASIO::UdpEndpoint(loopback, 0));
+        uint16_t port = rtp.local_endpoint().port();
+        boost::system::error_code ec;
+        rtcp = ASIO::UdpSocket(rtcp.get_executor());
+        rtcp.open(boost::asio::ip::udp::v4(), ec);
+        rtcp.bind(ASIO::UdpEndpoint(loopback, static_cast<uint16_t>(port + 1)), ec);
+        if (!ec) {
+            return port;
+        }
+    }
+}
+
+/// @brief UDP观看者只靠RTCP接收报告保活：发RR的会话不超时，不发的被关闭
+static void test_udp_rtcp_keepalive() {
+    ASIO::IoContext io;
+    RtspServer::Config cfg;
+    cfg.port = 0;
+    cfg.session_timeout_s = 1;
+    cfg.rtp_port_min = 41200;
+    cfg.rtp_port_max = 41300;
+    auto server = std::make_shared<RtspServer>(io, cfg);
+    server->Start();
+    RtspMediaSource::Config scfg;
+    scfg.video_extradata = {0, 0, 0, 1, 0x67, 0x42, 0xE0, 0x1F, 0xAA, 0, 0, 0, 1, 0x68, 0xCE, 0x3C, 0x80};
+    auto source = server->AddSource("live/cam2", scfg);
+    auto work = boost::asio::make_work_guard(io);
+    std::thread th([&]() { io.run(); });
+    const std::string url = "rtsp://127.0.0.1:" + std::to_string(server->port()) + "/live/cam2";
+
+    ASIO::IoContext client_io;
+    ASIO::UdpSocket rtp_a(client_io), rtcp_a(client_io), rtp_b(client_io), rtcp_b(client_io);
+    uint16_t port_a = bind_pair(rtp_a, rtcp_a);
+    uint16_t port_b = bind_pair(rtp_b, rtcp_b);
+    Client reporting(server->port());
+    Client silent(server->port());
+    uint16_t server_port = 0;
+    for (auto [client, port] : {std::make_pair(&reporting, port_a), std::make_pair(&silent, port_b)}) {
+        RtspMessage r = client->request("SETUP", url + "/trackID=0", "Transport: RTP/AVP;unicast;client_port="
+                                        + std::to_string(port) + "-" + std::to_string(port + 1) + "\r\n");
+        CHECK(r.status == 200 && r.Header("Transport"));
+        if (r.Header("Transport")) {
+            auto pos = r.Header("Transport")->find("server_port=");
+            server_port = static_cast<uint16_t>(std::stoi(r.Header("Transport")->substr(pos + 12)));
+        }
+        CHECK(client->request("PLAY", url).status == 200);
+    }
+
+    // 每250ms从RTCP端口发一个RR，持续超过会话超时
+    uint8_t rr[64];
+    std::size_t rr_size = Rtcp::WriteReceiverReport(rr, 0x5151, nullptr, 0);
+    ASIO::UdpEndpoint server_rtcp(boost::asio::ip::address_v4::loopback(), static_cast<uint16_t>(server_port + 1));
+    for (int i = 0; i < 7; ++i) {
+        rtcp_a.send_to(boost::asio::buffer(rr, rr_size), server_rtcp);
+        // 其他端口发来的报告不算数
+        rtp_b.send_to(boost::asio::buffer(rr, rr_size), server_rtcp);
+        std::this_thread::sleep_for(std::chrono::milliseconds(250));
+    }
+    boost::system::error_code ec;
+    char tmp[16];
+    silent.socket.read_some(boost::asio::buffer(tmp), ec);
+    CHECK(ec == boost::asio::error::eof);
+    CHECK(reporting.request("OPTIONS", url).status == 200);
+    CHECK(source->stats().viewer_rtcp == 7);
+
+    server->Stop();
+    work.reset();
+    th.join();
+}
+
+/// @brief UDP观看者发NACK：缓存中的包按原样重发，不认识的序号忽略
+static void test_nack_retransmit() {
+    ASIO::IoContext io;
+    RtspServer::Config cfg;
+    cfg.port = 0;
+    cfg.rtp_port_min = 41400;
+    cfg.rtp_port_max = 41500;
+    auto server = std::make_shared<RtspServer>(io, cfg);
+    server->Start();
+    RtspMediaSource::Config scfg;
+    scfg.video_extradata = {0, 0, 0, 1, 0x67, 0x42, 0xE0, 0x1F, 0xAA, 0, 0, 0, 1, 0x68, 0xCE, 0x3C, 0x80};
+    auto source = server->AddSource("live/cam3", scfg);
+    auto work = boost::asio::make_work_guard(io);
+    std::thread th([&]() { io.run(); });
+    const std::string url = "rtsp://127.0.0.1:" + std::to_string(server->port()) + "/live/cam3";
+
+    ASIO::IoContext client_io;
+    ASIO::UdpSocket rtp(client_io), rtcp(client_io);
+    uint16_t port = bind_pair(rtp, rtcp);
+    Client viewer(server->port());
+    RtspMessage r = viewer.request("SETUP", url + "/trackID=0", "Transport: RTP/AVP;unicast;client_port="
+                                   + std::to_string(port) + "-" + std::to_string(port + 1) + "\r\n");
+    CHECK(r.status == 200 && r.Header("Transport"));
+    uint16_t server_port = 0;
+    if (r.Header("Transport")) {
+        auto pos = r.Header("Transport")->find("server_port=");
+        server_port = static_cast<uint16_t>(std::stoi(r.Header("Transport")->substr(pos + 12)));
+    }
+    CHECK(viewer.request("PLAY", url).status == 200);
+
+    auto idr = make_frame({}, 5000, 1);
+    CHECK(source->PushVideo(idr.data(), idr.size(), 9000));
+    std::vector<std::vector<uint8_t>> packets;
+    while (true) {
+        std::vector<uint8_t> dgram(2048);
+        dgram.resize(rtp.receive(boost::asio::buffer(dgram)));
+        RtpHeaderView hv;
+        CHECK(hv.Parse(dgram.data(), dgram.size()));
+        packets.push_back(dgram);
+        if (hv.marker) {
+            break;
+        }
+    }
+    CHECK(packets.size() >= 3);
+
+    RtpHeaderView lost;
+    CHECK(lost.Parse(packets[1].data(), packets[1].size()));
+    uint16_t seqs[] = {static_cast<uint16_t>(lost.seq - 100), lost.seq};
+    uint8_t nack[64];
+    std::size_t nack_size = Rtcp::WriteNack(nack, 0x5151, lost.ssrc, seqs, 2);
+    CHECK(nack_size > 0);
+    rtcp.send_to(boost::asio::buffer(nack, nack_size),
+                 ASIO::UdpEndpoint(boost::asio::ip::address_v4::loopback(), static_cast<uint16_t>(server_port + 1)));
+    std::vector<uint8_t> resent(2048);
+    resent.resize(rtp.receive(boost::asio::buffer(resent)));
+    CHECK(resent == packets[1]);
+    for (int i = 0; i < 100 && source->stats().retransmitted == 0; ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    CHECK(source->stats().retransmitted == 1);
+    CHECK(rtp.available() == 0);
+
+    server->Stop();
+    work.reset();
+    th.join();
+}
+
+int main() {
+    test_sdp();
+    test_fan_out();
+    test_session_timeout();
+    test_udp_rtcp_keepalive();
+    test_nack_retransmit();
+    if (failures) {
+        std::cerr << failures << " check(s) failed" << std::endl;
+        return 1;
+    }
+    std::cout << "test_rtsp_server passed" << std::endl;
+    return 0;
+}
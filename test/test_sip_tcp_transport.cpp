@@ -0,0 +1,257 @@
+#include <iostream>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "sip/sip_transport.h"
+
+static int failures = 0;
+#define CHECK(cond) do { if (!(cond)) { std::cerr << "CHECK failed: " #cond " at line " << __LINE__ << std::endl; ++failures; } } while (0)
+
+static std::string make_request(const std::string& method, const std::string& call_id, const std::string& body = "") {
+    std::string s = method + " sip:34020000002000000001@3402000000 SIP/2.0\r\n"
+        "Via: SIP/2.0/TCP 127.0.0.1:5060;branch=z9hG4bK" + call_id + "\r\n"
+        "From: <sip:34020000001320000001@3402000000>;tag=1\r\n"
+        "To: <sip:34020000002000000001@3402000000>\r\n"
+        "Call-ID: " + call_id + "\r\n"
+        "CSeq: 1 " + method + "\r\n"
+        "Content-Type: Application/MANSCDP+xml\r\n"
+        "Content-Length: " + std::to_string(body.size()) + "\r\n\r\n" + body;
+    return s;
+}
+
+template <typename Pred>
+static bool wait_until(Pred pred, int ms = 3000) {
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(ms);
+    while (!pred()) {
+        if (std::chrono::steady_clock::now() > deadline) {
+            return false;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    }
+    return true;
+}
+
+static TcpSipTransport::Config server_config() {
+    TcpSipTransport::Config cfg;
+    cfg.listen_ip = "127.0.0.1";
+    cfg.port = 0;
+    cfg.read_buffer_size = 1024;
+    cfg.max_message_size = 256 * 1024;
+    return cfg;
+}
+
+/// @brief 粘包、拆包、超过初始读缓冲的大消息体、双CRLF保活，应答走同一条连接
+static void test_stream_framing() {
+    ASIO::IoContext io;
+    auto work = boost::asio::make_work_guard(io);
+    std::thread th([&]() { io.run(); });
+
+    auto server = std::make_shared<TcpSipTransport>(io, server_config());
+    std::mutex mtx;
+    std::vector<std::string> call_ids;
+    std::size_t big_body = 0;
+    server->SetMsgHandler([&](const SipMessageView& msg) {
+        CHECK(std::string(msg.peer().protocol) == "TCP");
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            call_ids.emplace_back(msg.call_id());
+            if (msg.call_id() == "big") {
+                big_body = msg.body().size();
+                CHECK(msg.body().front() == '<' && msg.body().back() == '>');
+            }
+        }
+        SipResponseOptions opts;
+        opts.to_tag = "srv";
+        server->SendResponse(msg, 200, "OK", opts);
+    });
+    server->Start();
+
+    ASIO::TcpSocket client(io);
+    client.connect(server->local_endpoint());
+    std::string two = make_request("MESSAGE", "a") + make_request("REGISTER", "b");
+    boost::asio::write(client, boost::asio::buffer(two));
+    std::string split = make_request("MESSAGE", "c", "<Notify>hello</Notify>");
+    for (std::size_t off = 0; off < split.size(); off += 37) {
+        boost::asio::write(client, boost::asio::buffer(split.data() + off, std::min<std::size_t>(37, split.size() - off)));
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    std::string xml = "<Catalog>" + std::string(100 * 1024, 'x') + "</Catalog>";
+    std::string big = make_request("NOTIFY", "big", xml);
+    boost::asio::write(client, boost::asio::buffer(big));
+    boost::asio::write(client, boost::asio::buffer("\r\n\r\n", 4));
+
+    CHECK(wait_until([&]() { std::lock_guard<std::mutex> lock(mtx); return call_ids.size() == 4; }));
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        CHECK((call_ids == std::vector<std::string>{"a", "b", "c", "big"}));
+        CHECK(big_body == xml.size());
+    }
+    CHECK(server->connection_count() == 1);
+
+    // 4个应答 + 保活回的CRLF，按同一个流式解析器切分
+    std::string rx;
+    std::vector<std::string> responses;
+    bool pong = false;
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(3);
+    while ((responses.size() < 4 || !pong) && std::chrono::steady_clock::now() < deadline) {
+        char tmp[4096];
+        boost::system::error_code ec;
+        std::size_t n = client.read_some(boost::asio::buffer(tmp), ec);
+        if (ec) {
+            break;
+        }
+        rx.append(tmp, n);
+        while (!rx.empty()) {
+            if (rx.compare(0, 2, "\r\n") == 0) {
+                pong = true;
+                rx.erase(0, 2);
+                continue;
+            }
+            SipMessageView r;
+            std::size_t consumed = 0;
+            if (SipMessageView::Parse(rx.data(), rx.size(), r, &consumed, true) != SipMessageView::ParseResult::Ok) {
+                break;
+            }
+            CHECK(r.status_code() == 200);
+            CHECK(r.to_tag() == "srv");
+            responses.emplace_back(r.call_id());
+            rx.erase(0, consumed);
+        }
+    }
+    CHECK(responses.size() == 4);
+    CHECK(pong);
+
+    // 非法报文断开连接
+    boost::asio::write(client, boost::asio::buffer(std::string("garbage line\r\n\r\n")));
+    CHECK(wait_until([&]() { return server->connection_count() == 0; }));
+
+    server->Stop();
+    work.reset();
+    th.join();
+}
+
+/// @brief 主动连接：发往同一对端复用一条连接，对端的应答从这条连接回来；共用外部时间轮
+static void test_connection_reuse() {
+    ASIO::IoContext io;
+    auto work = boost::asio::make_work_guard(io);
+    std::thread th([&]() { io.run(); });
+
+    auto timers = std::make_shared<net::AsioTimerWheel>(io, TimerWheel::Config{10});
+    auto server = std::make_shared<TcpSipTransport>(io, server_config(), timers);
+    auto client = std::make_shared<TcpSipTransport>(io, server_config(), timers);
+    std::atomic<int> requests{0};
+    std::atomic<int> responses{0};
+    server->SetMsgHandler([&](const SipMessageView& msg) {
+        if (msg.is_request()) {
+            ++requests;
+            server->SendResponse(msg, 200, "OK");
+        }
+    });
+    client->SetMsgHandler([&](const SipMessageView& msg) {
+        if (!msg.is_request() && msg.status_code() == 200) {
+            ++responses;
+        }
+    });
+    server->Start();
+    client->Start();
+
+    SipMessage req;
+    req.set_method("MESSAGE");
+    req.set_uri("sip:34020000002000000001@3402000000");
+    req.set_version("SIP/2.0");
+    req.set_header("Via", "SIP/2.0/TCP 127.0.0.1;branch=z9hG4bKreuse");
+    req.set_header("From", "<sip:a@b>;tag=1");
+    req.set_header("To", "<sip:c@d>");
+    req.set_header("Call-ID", "reuse");
+    req.set_header("CSeq", "1 MESSAGE");
+    req.set_body("<Notify/>");
+    req.set_remote(SipMessage::RemoteInfo("TCP", "127.0.0.1", server->local_endpoint().port()));
+    // 连上之前发出的也按序排队
+    for (int i = 0; i < 5; ++i) {
+        client->Send(req);
+    }
+    CHECK(wait_until([&]() { return responses == 5; }));
+    CHECK(requests == 5);
+    CHECK(client->connection_count() == 1);
+    CHECK(server->connection_count() == 1);
+    for (int i = 0; i < 5; ++i) {
+        client->Send(req);
+    }
+    CHECK(wait_until([&]() { return responses == 10; }));
+    CHECK(client->connection_count() == 1);
+    CHECK(server->connection_count() == 1);
+
+    // 连不上的对端：排队的消息丢弃，连接在超时或失败后注销
+    ASIO::TcpEndpoint dead;
+    {
+        boost::asio::ip::tcp::acceptor probe(io, ASIO::TcpEndpoint(boost::asio::ip::make_address("127.0.0.1"), 0));
+        dead = probe.local_endpoint();
+    }
+    SipMessageView::Peer peer{"TCP", dead.address(), dead.port()};
+    auto buffer = client->buffer_pool().Acquire();
+    req.SerializeInto(*buffer);
+    CHECK(client->SendBuffer(peer, std::move(buffer)));
+    CHECK(wait_until([&]() { return client->connection_count() == 1; }));
+
+    client->Stop();
+    server->Stop();
+    CHECK(!client->SendBuffer(peer, client->buffer_pool().Acquire()));
+    timers->Stop();
+    work.reset();
+    th.join();
+}
+
+/// @brief 空闲超时在时间轮上关闭连接，有收发时顺延
+static void test_idle_timeout() {
+    ASIO::IoContext io;
+    auto work = boost::asio::make_work_guard(io);
+    std::thread th([&]() { io.run(); });
+
+    auto cfg = server_config();
+    cfg.idle_timeout_ms = 300;
+    auto timers = std::make_shared<net::AsioTimerWheel>(io, TimerWheel::Config{10});
+    auto server = std::make_shared<TcpSipTransport>(io, cfg, timers);
+    server->Start();
+
+    ASIO::TcpSocket client(io);
+    client.connect(server->local_endpoint());
+    CHECK(wait_until([&]() { return server->connection_count() == 1; }));
+    auto start = std::chrono::steady_clock::now();
+    // 保活在超时之前不断刷新
+    for (int i = 0; i < 4; ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(150));
+        boost::asio::write(client, boost::asio::buffer("\r\n\r\n", 4));
+    }
+    CHECK(server->connection_count() == 1);
+    CHECK(wait_until([&]() { return server->connection_count() == 0; }, 2000));
+    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+    CHECK(elapsed >= 600 + 300);
+
+    // 对端看到连接被关闭（先读完保活应答）
+    boost::system::error_code ec;
+    char tmp[64];
+    while (!ec) {
+        client.read_some(boost::asio::buffer(tmp), ec);
+    }
+    CHECK(ec == boost::asio::error::eof || ec == boost::asio::error::connection_reset);
+
+    server->Stop();
+    timers->Stop();
+    work.reset();
+    th.join();
+}
+
+int main() {
+    test_stream_framing();
+    test_connection_reuse();
+    test_idle_timeout();
+    if (failures) {
+        std::cerr << failures << " check(s) failed" << std::endl;
+        return 1;
+    }
+    std::cout << "test_sip_tcp_transport passed" << std::endl;
+    return 0;
+}
@@ -0,0 +1,365 @@
+#include <iostream>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "sip/sip_transaction.h"
+
+static int failures = 0;
+#define CHECK(cond) do { if (!(cond)) { std::cerr << "CHECK failed: " #cond " at line " << __LINE__ << std::endl; ++failures; } } while (0)
+
+/// @brief 记录发出的报文，inject模拟从网络收到消息
+class FakeTransport : public SipTransport {
+public:
+    void Start() override {}
+    void Stop() override {}
+
+    bool SendBuffer(const Peer&, Buffer buffer) override {
+        std::lock_guard<std::mutex> lock(mtx_);
+        ++count_;
+        if (record_) {
+            sent_.push_back(*buffer);
+        }
+        return true;
+    }
+
+    void inject(const std::string& data, const char* protocol = "UDP") {
+        SipMessageView view;
+        if (SipMessageView::Parse(data.data(), data.size(), view) != SipMessageView::ParseResult::Ok) {
+            std::cerr << "bad test message" << std::endl;
+            ++failures;
+            return;
+        }
+        view.set_peer({protocol, boost::asio::ip::make_address("127.0.0.1"), 5060});
+        dispatch_message(view);
+    }
+
+    /// @brief 以某个前缀开头的已发报文个数
+    std::size_t count(const std::string& prefix) {
+        std::lock_guard<std::mutex> lock(mtx_);
+        std::size_t n = 0;
+        for (auto& s : sent_) {
+            n += s.compare(0, prefix.size(), prefix) == 0;
+        }
+        return n;
+    }
+
+    std::string last() {
+        std::lock_guard<std::mutex> lock(mtx_);
+        return sent_.empty() ? std::string() : sent_.back();
+    }
+
+    std::size_t total() {
+        std::lock_guard<std::mutex> lock(mtx_);
+        return count_;
+    }
+
+    void set_record(bool record) { record_ = record; }
+
+private:
+    std::mutex mtx_;
+    std::vector<std::string> sent_;
+    std::size_t count_ = 0;
+    bool record_ = true;
+};
+
+static std::string make_request(const std::string& method, const std::string& branch) {
+    return method + " sip:34020000001320000001@3402000000 SIP/2.0\r\n"
+        "Via: SIP/2.0/UDP 127.0.0.1:5060;branch=z9hG4bK" + branch + "\r\n"
+        "From: <sip:34020000002000000001@3402000000>;tag=1\r\n"
+        "To: <sip:34020000001320000001@3402000000>\r\n"
+        "Call-ID: " + branch + "\r\n"
+        "CSeq: 1 " + method + "\r\n"
+        "Content-Length: 0\r\n\r\n";
+}
+
+/// @brief 按已发出的请求构造对端的应答
+static std::string make_response(const std::string& request, int code, const char* reason) {
+    SipMessageView view;
+    SipMessageView::Parse(request.data(), request.size(), view);
+    std::string out;
+    SipResponseOptions opts;
+    opts.to_tag = "remote";
+    view.SerializeResponse(code, reason, out, opts);
+    return out;
+}
+
+static SipMessage outgoing(const std::string& method, const char* protocol = "UDP") {
+    SipMessage req;
+    req.set_method(method);
+    req.set_uri("sip:34020000001320000001@3402000000");
+    req.set_version("SIP/2.0");
+    req.set_header("Via", std::string("SIP/2.0/") + protocol + " 127.0.0.1:5060");
+    req.set_header("From", "<sip:34020000002000000001@3402000000>;tag=9");
+    req.set_header("To", "<sip:34020000001320000001@3402000000>");
+    req.set_header("Call-ID", "out-" + method);
+    req.set_header("CSeq", "1 " + method);
+    req.set_header("Max-Forwards", "70");
+    req.set_remote(SipMessage::RemoteInfo(protocol, "127.0.0.1", 5060));
+    return req;
+}
+
+template <typename Pred>
+static bool wait_until(Pred pred, int ms = 3000) {
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(ms);
+    while (!pred()) {
+        if (std::chrono::steady_clock::now() > deadline) {
+            return false;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    }
+    return true;
+}
+
+struct Fixture {
+    ASIO::IoContext io;
+    boost::asio::executor_work_guard<ASIO::IoContext::executor_type> work{io.get_executor()};
+    std::thread th;
+    std::shared_ptr<net::AsioTimerWheel> timers;
+    std::shared_ptr<FakeTransport> transport = std::make_shared<FakeTransport>();
+    std::shared_ptr<SipTransactionLayer> layer;
+
+    explicit Fixture(SipTransactionLayer::Config cfg = fast_config()) {
+        timers = std::make_shared<net::AsioTimerWheel>(io, TimerWheel::Config{5});
+        layer = std::make_shared<SipTransactionLayer>(transport, timers, cfg);
+        layer->Start();
+        th = std::thread([this]() { io.run(); });
+    }
+
+    ~Fixture() {
+        layer->Stop();
+        timers->Stop();
+        work.reset();
+        th.join();
+    }
+
+    static SipTransactionLayer::Config fast_config() {
+        SipTransactionLayer::Config cfg;
+        cfg.t1_ms = 20;
+        cfg.t2_ms = 80;
+        cfg.t4_ms = 50;
+        return cfg;
+    }
+};
+
+/// @brief 非INVITE服务端事务：重传请求不再交给TU，重发最终应答；Timer J后释放
+static void test_server_non_invite() {
+    Fixture f;
+    std::atomic<int> requests{0};
+    f.layer->SetRequestHandler([&](const SipMessageView& req) {
+        ++requests;
+        f.layer->Respond(req, 200, "OK");
+    });
+    std::string msg = make_request("MESSAGE", "nist");
+    f.transport->inject(msg);
+    f.transport->inject(msg);
+    f.transport->inject(msg);
+    CHECK(requests == 1);
+    CHECK(f.transport->count("SIP/2.0 200") == 3);
+    CHECK(f.layer->size() == 1);
+    CHECK(f.layer->stats().absorbed == 2);
+    // 已给过最终应答
+    SipMessageView view;
+    SipMessageView::Parse(msg.data(), msg.size(), view);
+    CHECK(!f.layer->Respond(view, 500, "Server Error"));
+    CHECK(wait_until([&]() { return f.layer->size() == 0; }));
+    // 事务结束后同一请求视为新请求
+    f.transport->inject(msg);
+    CHECK(requests == 2);
+}
+
+/// @brief INVITE服务端事务：自动100 Trying，非2xx用Timer G重传直到ACK，Timer I后释放
+static void test_server_invite() {
+    Fixture f;
+    std::atomic<int> requests{0};
+    f.layer->SetRequestHandler([&](const SipMessageView&) { ++requests; });
+    std::string invite = make_request("INVITE", "ist");
+    f.transport->inject(invite);
+    CHECK(requests == 1);
+    CHECK(f.transport->count("SIP/2.0 100") == 1);
+    // TU还没应答时重传的INVITE触发重发100
+    f.transport->inject(invite);
+    CHECK(f.transport->count("SIP/2.0 100") == 2);
+    CHECK(requests == 1);
+
+    SipMessageView view;
+    SipMessageView::Parse(invite.data(), invite.size(), view);
+    CHECK(f.layer->Respond(view, 486, "Busy Here"));
+    CHECK(wait_until([&]() { return f.transport->count("SIP/2.0 486") >= 3; }));
+
+    f.transport->inject(make_request("ACK", "ist"));
+    CHECK(requests == 1);
+    std::size_t after_ack = f.transport->count("SIP/2.0 486");
+    CHECK(wait_until([&]() { return f.layer->size() == 0; }));
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    CHECK(f.transport->count("SIP/2.0 486") <= after_ack + 1);
+
+    // 2xx的ACK不属于事务，交给TU
+    f.transport->inject(make_request("ACK", "other"));
+    CHECK(requests == 2);
+}
+
+/// @brief INVITE客户端事务：Timer A重传，1xx后停止；非2xx由事务发ACK，重传的最终应答只重发ACK
+static void test_client_invite() {
+    Fixture f;
+    std::mutex mtx;
+    std::vector<int> codes;
+    CHECK(f.layer->SendRequest(outgoing("INVITE"), [&](const SipMessageView* rsp) {
+        std::lock_guard<std::mutex> lock(mtx);
+        codes.push_back(rsp ? rsp->status_code() : 0);
+    }));
+    CHECK(wait_until([&]() { return f.transport->count("INVITE ") >= 3; }));
+    std::string request = f.transport->last();
+    CHECK(request.find(";branch=z9hG4bK") != std::string::npos);
+
+    f.transport->inject(make_response(request, 180, "Ringing"));
+    std::size_t invites = f.transport->count("INVITE ");
+    std::this_thread::sleep_for(std::chrono::milliseconds(150));
+    CHECK(f.transport->count("INVITE ") <= invites + 1);
+
+    std::string busy = make_response(request, 404, "Not Found");
+    f.transport->inject(busy);
+    CHECK(f.transport->count("ACK ") == 1);
+    CHECK(f.transport->last().find("tag=remote") != std::string::npos);
+    CHECK(f.transport->last().find("CSeq: 1 ACK") != std::string::npos);
+    f.transport->inject(busy);
+    CHECK(f.transport->count("ACK ") == 2);
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        CHECK((codes == std::vector<int>{180, 404}));
+    }
+
+    // 找不到事务的应答
+    std::atomic<int> stray{0};
+    f.layer->SetStrayResponseHandler([&](const SipMessageView&) { ++stray; });
+    f.transport->inject(make_response(make_request("INVITE", "unknown"), 200, "OK"));
+    CHECK(stray == 1);
+}
+
+/// @brief 非INVITE客户端事务超时（Timer F）以nullptr通知
+static void test_client_timeout() {
+    Fixture f;
+    std::atomic<int> timeouts{0};
+    auto start = std::chrono::steady_clock::now();
+    CHECK(f.layer->SendRequest(outgoing("MESSAGE"), [&](const SipMessageView* rsp) {
+        if (!rsp) {
+            ++timeouts;
+        }
+    }));
+    CHECK(wait_until([&]() { return timeouts == 1; }));
+    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+    CHECK(elapsed >= 64 * 20 - 10);
+    // Timer E：20 40 80 80 ... 封顶T2
+    CHECK(f.transport->count("MESSAGE ") >= 10);
+    CHECK(f.layer->size() == 0);
+    CHECK(f.layer->stats().timeouts == 1);
+}
+
+/// @brief 可靠传输不重传，最终应答后立即释放
+static void test_reliable() {
+    Fixture f;
+    std::atomic<int> finals{0};
+    CHECK(f.layer->SendRequest(outgoing("MESSAGE", "TCP"), [&](const SipMessageView* rsp) {
+        if (rsp && rsp->status_code() >= 200) {
+            ++finals;
+        }
+    }));
+    std::this_thread::sleep_for(std::chrono::milliseconds(150));
+    CHECK(f.transport->count("MESSAGE ") == 1);
+    f.transport->inject(make_response(f.transport->last(), 200, "OK"), "TCP");
+    CHECK(finals == 1);
+    CHECK(f.layer->size() == 0);
+
+    f.layer->SetRequestHandler([&](const SipMessageView& req) { f.layer->Respond(req, 200, "OK"); });
+    f.transport->inject(make_request("MESSAGE", "tcp"), "TCP");
+    CHECK(f.layer->size() == 0);
+}
+
+/// @brief 超过上限的新请求无状态回503
+static void test_limit() {
+    auto cfg = Fixture::fast_config();
+    cfg.max_transactions = 2;
+    Fixture f(cfg);
+    std::atomic<int> requests{0};
+    f.layer->SetRequestHandler([&](const SipMessageView&) { ++requests; });
+    f.transport->inject(make_request("MESSAGE", "l1"));
+    f.transport->inject(make_request("MESSAGE", "l2"));
+    f.transport->inject(make_request("MESSAGE", "l3"));
+    CHECK(requests == 2);
+    CHECK(f.transport->count("SIP/2.0 503") == 1);
+    CHECK(f.layer->stats().rejected == 1);
+}
+
+/// @brief 重传定时器密集到期时停止：已从时间轮取下的回调不能再访问被丢弃的事务
+static void test_stop_with_due_timers() {
+    auto cfg = Fixture::fast_config();
+    cfg.t1_ms = 5;
+    cfg.t2_ms = 5;
+    for (int round = 0; round < 20; ++round) {
+        Fixture f(cfg);
+        f.transport->set_record(false);
+        for (int i = 0; i < 200; ++i) {
+            CHECK(f.layer->SendRequest(outgoing("MESSAGE"), nullptr));
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(round % 4 * 5));
+        f.layer->Stop();
+        CHECK(f.layer->size() == 0);
+        std::size_t sent = f.transport->total();
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        CHECK(f.transport->total() == sent);
+        CHECK(!f.layer->SendRequest(outgoing("MESSAGE"), nullptr));
+    }
+}
+
+/// @brief 10万并发服务端事务：建立、吸收重传、结束后复用对象
+static void bench_scale() {
+    constexpr int kCount = 100000;
+    auto cfg = Fixture::fast_config();
+    cfg.t1_ms = 500;
+    Fixture f(cfg);
+    f.transport->set_record(false);
+    f.layer->SetRequestHandler([&](const SipMessageView& req) { f.layer->Respond(req, 200, "OK"); });
+
+    std::vector<std::string> msgs;
+    msgs.reserve(kCount);
+    for (int i = 0; i < kCount; ++i) {
+        msgs.push_back(make_request("MESSAGE", "scale" + std::to_string(i)));
+    }
+    auto run = [&](const char* label) {
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < kCount; ++i) {
+            f.transport->inject(msgs[i]);
+        }
+        double us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+        std::cout << label << ": " << us / kCount << " us/request" << std::endl;
+    };
+    run("new transactions");
+    CHECK(f.layer->size() == static_cast<std::size_t>(kCount));
+    run("retransmissions");
+    CHECK(f.layer->stats().absorbed == static_cast<uint64_t>(kCount));
+    CHECK(f.layer->stats().server_created == static_cast<uint64_t>(kCount));
+    CHECK(f.transport->total() == static_cast<std::size_t>(2 * kCount));
+    CHECK(wait_until([&]() { return f.layer->size() == 0; }, 60000));
+    // 第二轮从复用池取对象
+    run("reused transactions");
+    CHECK(f.layer->size() == static_cast<std::size_t>(kCount));
+}
+
+int main() {
+    test_server_non_invite();
+    test_server_invite();
+    test_client_invite();
+    test_client_timeout();
+    test_reliable();
+    test_limit();
+    test_stop_with_due_timers();
+    bench_scale();
+    if (failures) {
+        std::cerr << failures << " check(s) failed" << std::endl;
+        return 1;
+    }
+    std::cout << "test_sip_transaction passed" << std::endl;
+    return 0;
+}
@@ -0,0 +1,190 @@
+#include <iostream>
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+#include "sip/sip_transport.h"
+
+static int failures = 0;
+#define CHECK(cond) do { if (!(cond)) { std::cerr << "CHECK failed: " #cond " at line " << __LINE__ << std::endl; ++failures; } } while (0)
+
+static std::string make_message(int seq, const std::string& call_id) {
+    std::string body = "<Notify><CmdType>Keepalive</CmdType></Notify>";
+    return "MESSAGE sip:34020000002000000001@3402000000 SIP/2.0\r\n"
+        "Via: SIP/2.0/UDP 127.0.0.1:5060;branch=z9hG4bK" + call_id + "-" + std::to_string(seq) + "\r\n"
+        "From: <sip:34020000001320000001@3402000000>;tag=1\r\n"
+        "To: <sip:34020000002000000001@3402000000>\r\n"
+        "Call-ID: " + call_id + "\r\n"
+        "CSeq: " + std::to_string(seq) + " MESSAGE\r\n"
+        "Content-Length: " + std::to_string(body.size()) + "\r\n\r\n" + body;
+}
+
+template <typename Pred>
+static bool wait_until(Pred pred, int ms = 3000) {
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(ms);
+    while (!pred()) {
+        if (std::chrono::steady_clock::now() > deadline) {
+            return false;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    }
+    return true;
+}
+
+/// @brief 多个SO_REUSEPORT socket共用一个端口，同一对端的消息保序，应答从同一端口发出
+static void test_reuse_port() {
+    ASIO::IoContext io;
+    auto work = boost::asio::make_work_guard(io);
+    std::vector<std::thread> threads;
+    for (int i = 0; i < 4; ++i) {
+        threads.emplace_back([&]() { io.run(); });
+    }
+
+    UdpSipTransport::Config cfg;
+    cfg.listen_ip = "127.0.0.1";
+    cfg.port = 0;
+    cfg.sockets = 4;
+    auto transport = std::make_shared<UdpSipTransport>(io, cfg);
+    CHECK(transport->socket_count() == 4);
+    const uint16_t port = transport->local_endpoint().port();
+
+    std::mutex mtx;
+    std::map<std::string, std::vector<uint32_t>> seqs;
+    std::set<std::thread::id> receivers;
+    std::atomic<int> received{0};
+    transport->SetMsgHandler([&](const SipMessageView& msg) {
+        uint32_t seq = 0;
+        StringView method;
+        CHECK(msg.cseq(seq, method));
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            seqs[std::string(msg.call_id())].push_back(seq);
+            receivers.insert(std::this_thread::get_id());
+        }
+        ++received;
+        transport->SendResponse(msg, 200, "OK");
+    });
+    transport->Start();
+
+    constexpr int kClients = 16;
+    constexpr int kPerClient = 50;
+    std::vector<std::unique_ptr<net::UdpBatchSocket>> clients;
+    std::atomic<int> replies{0};
+    std::atomic<int> wrong_port{0};
+    for (int c = 0; c < kClients; ++c) {
+        clients.push_back(std::make_unique<net::UdpBatchSocket>(io,
+            ASIO::UdpEndpoint(boost::asio::ip::make_address("127.0.0.1"), 0)));
+        clients.back()->StartReceive([&](const net::UdpDatagram* dgrams, size_t count) {
+            for (size_t i = 0; i < count; ++i) {
+                ++replies;
+                if (dgrams[i].from.port() != port) {
+                    ++wrong_port;
+                }
+            }
+        });
+    }
+    for (int i = 0; i < kPerClient; ++i) {
+        for (int c = 0; c < kClients; ++c) {
+            std::string m = make_message(i + 1, "client" + std::to_string(c));
+            clients[c]->SendTo(transport->local_endpoint(), m.data(), m.size());
+        }
+        if (i % 10 == 0) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+    CHECK(wait_until([&]() { return received == kClients * kPerClient; }));
+    CHECK(wait_until([&]() { return replies == kClients * kPerClient; }));
+    CHECK(wrong_port == 0);
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        CHECK(seqs.size() == static_cast<std::size_t>(kClients));
+        for (auto& kv : seqs) {
+            // 同一来源落在同一个socket和strand上，按发送顺序处理
+            bool ordered = kv.second.size() == static_cast<std::size_t>(kPerClient);
+            for (std::size_t i = 0; ordered && i < kv.second.size(); ++i) {
+                ordered = kv.second[i] == i + 1;
+            }
+            CHECK(ordered);
+        }
+        std::cout << "receive threads used: " << receivers.size() << std::endl;
+    }
+
+    transport->Stop();
+    for (auto& c : clients) {
+        c->Close();
+    }
+    work.reset();
+    for (auto& th : threads) {
+        th.join();
+    }
+}
+
+/// @brief 慢监听不阻塞主处理；监听跟不上时丢弃并计数
+static void test_async_taps() {
+    ASIO::IoContext io;
+    auto work = boost::asio::make_work_guard(io);
+    std::thread th([&]() { io.run(); });
+
+    UdpSipTransport::Config cfg;
+    cfg.listen_ip = "127.0.0.1";
+    cfg.port = 0;
+    cfg.recv_buffer = 4 * 1024 * 1024;
+    auto transport = std::make_shared<UdpSipTransport>(io, cfg);
+    std::atomic<bool> release{false};
+    std::atomic<int> tapped{0};
+    std::atomic<int> handled{0};
+    std::thread::id tap_thread;
+    std::thread::id recv_thread;
+    transport->SetTapHandler([&](const SipMessageView& msg) {
+        tap_thread = std::this_thread::get_id();
+        // 视图已被拷贝保留，收包缓冲复用后仍然有效
+        CHECK(msg.retained());
+        CHECK(msg.method() == "MESSAGE");
+        while (!release) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        ++tapped;
+    });
+    transport->SetMsgHandler([&](const SipMessageView&) {
+        recv_thread = std::this_thread::get_id();
+        ++handled;
+    });
+    transport->Start();
+
+    net::UdpBatchSocket tx(io, ASIO::UdpEndpoint(boost::asio::ip::make_address("127.0.0.1"), 0));
+    const int kCount = static_cast<int>(SipTransport::kTapQueueCapacity) + 500;
+    for (int i = 0; i < kCount; ++i) {
+        std::string m = make_message(i + 1, "tap");
+        tx.SendTo(transport->local_endpoint(), m.data(), m.size());
+        if (i % 16 == 0) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+    // 监听卡住时主处理照常完成
+    CHECK(wait_until([&]() { return handled == kCount; }));
+    std::cout << "handled " << handled << ", tap dropped " << transport->tap_dropped() << std::endl;
+    CHECK(tapped == 0);
+    CHECK(transport->tap_dropped() >= 400);
+    release = true;
+    CHECK(wait_until([&]() { return tapped + static_cast<int>(transport->tap_dropped()) == kCount; }));
+    CHECK(tap_thread != recv_thread);
+
+    transport->Stop();
+    work.reset();
+    th.join();
+}
+
+int main() {
+    test_reuse_port();
+    test_async_taps();
+    if (failures) {
+        std::cerr << failures << " check(s) failed" << std::endl;
+        return 1;
+    }
+    std::cout << "test_sip_udp_transport passed" << std::endl;
+    return 0;
+}
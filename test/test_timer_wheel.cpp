@@ -0,0 +1,182 @@
+#include <iostream>
+#include <atomic>
+#include <chrono>
+#include <random>
+#include <thread>
+#include <vector>
+#include "base/timer_wheel.h"
+#include "net/asio_timer_wheel.h"
+
+static int failures = 0;
+#define CHECK(cond) do { if (!(cond)) { std::cerr << "CHECK failed: " #cond " at line " << __LINE__ << std::endl; ++failures; } } while (0)
+
+static void test_basic() {
+    TimerWheel wheel(TimerWheel::Config{10}, 1000);
+    std::vector<int> fired;
+    wheel.Schedule(30, [&]() { fired.push_back(30); });
+    wheel.Schedule(10, [&]() { fired.push_back(10); });
+    auto id = wheel.Schedule(20, [&]() { fired.push_back(20); });
+    wheel.Schedule(0, [&]() { fired.push_back(0); });
+    CHECK(wheel.size() == 4);
+    CHECK(wheel.Advance(1000) == 1);
+    CHECK((fired == std::vector<int>{0}));
+    CHECK(wheel.Cancel(id));
+    CHECK(!wheel.Cancel(id));
+    // 不足一个tick不到期
+    CHECK(wheel.Advance(1009) == 0);
+    CHECK(wheel.Advance(1035) == 2);
+    CHECK((fired == std::vector<int>{0, 10, 30}));
+    CHECK(wheel.empty());
+}
+
+/// @brief 跨越各层的到期时间：不早于设定时间，晚不超过一个tick加一次推进的步长
+static void test_cascade() {
+    const int64_t tick = 10;
+    TimerWheel wheel(TimerWheel::Config{tick}, 0);
+    std::mt19937 rng(42);
+    std::vector<int64_t> delays = {0, 1, 2550, 2560, 2570, 163830, 163840, 163850, 10485750, 10485760, 10485770};
+    for (int i = 0; i < 2000; ++i) {
+        delays.push_back(static_cast<int64_t>(rng() % 20000000));
+    }
+    int64_t now = 0;
+    std::size_t fired = 0;
+    bool ok = true;
+    for (int64_t d : delays) {
+        wheel.Schedule(d, [&, d]() {
+            ++fired;
+            if (now < d || now >= d + 4 * tick) {
+                std::cerr << "delay " << d << " fired at " << now << std::endl;
+                ok = false;
+            }
+        });
+    }
+    // 步长不等于tick，模拟驱动的唤醒抖动
+    while (!wheel.empty() && now < 30000000) {
+        now += tick * (1 + static_cast<int64_t>(rng() % 3));
+        wheel.Advance(now);
+    }
+    CHECK(fired == delays.size());
+    CHECK(ok);
+}
+
+static void test_reschedule_and_reentrancy() {
+    TimerWheel wheel(TimerWheel::Config{10}, 0);
+    int fired = 0;
+    auto id = wheel.Schedule(100, [&]() { ++fired; });
+    wheel.Advance(50);
+    CHECK(wheel.Reschedule(id, 100));
+    wheel.Advance(120);
+    CHECK(fired == 0);
+    wheel.Advance(160);
+    CHECK(fired == 1);
+    CHECK(!wheel.Reschedule(id, 10));
+
+    // 回调中重新挂自己（周期定时器）和取消别人
+    int ticks = 0;
+    TimerWheel::TimerId victim = 0;
+    std::function<void()> periodic = [&]() {
+        if (++ticks < 5) {
+            wheel.Schedule(20, periodic);
+        }
+        wheel.Cancel(victim);
+    };
+    wheel.Schedule(20, periodic);
+    victim = wheel.Schedule(40, [&]() { fired += 100; });
+    for (int64_t t = 160; t <= 400; t += 10) {
+        wheel.Advance(t);
+    }
+    CHECK(ticks == 5);
+    CHECK(fired == 1);
+    CHECK(wheel.empty());
+
+    // 长时间空闲后直接跳到当前时间
+    wheel.Advance(1000000000);
+    int late = 0;
+    wheel.Schedule(10, [&]() { ++late; });
+    wheel.Advance(1000000000);
+    CHECK(late == 0);
+    wheel.Advance(1000000010);
+    CHECK(late == 0);
+    wheel.Advance(1000000020);
+    CHECK(late == 1);
+}
+
+/// @brief 10万个定时器的挂入/取消开销与数量无关
+static void test_scale() {
+    const int n = 100000;
+    TimerWheel wheel(TimerWheel::Config{10}, 0);
+    std::vector<TimerWheel::TimerId> ids;
+    ids.reserve(n);
+    auto t0 = std::chrono::steady_clock::now();
+    for (int i = 0; i < n; ++i) {
+        ids.push_back(wheel.Schedule(60000 + i % 1000, nullptr));
+    }
+    for (int i = 0; i < n; i += 2) {
+        wheel.Cancel(ids[i]);
+    }
+    std::size_t expired = 0;
+    for (int64_t t = 0; t <= 62000; t += 10) {
+        expired += wheel.Advance(t);
+    }
+    auto us = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - t0).count();
+    CHECK(expired == static_cast<std::size_t>(n / 2));
+    CHECK(wheel.empty());
+    std::cout << "timer wheel: " << n << " schedule + " << n / 2 << " cancel + expiry in " << us << " us" << std::endl;
+}
+
+static void test_asio_driver() {
+    ASIO::IoContext io;
+    auto wheel = std::make_shared<net::AsioTimerWheel>(io, TimerWheel::Config{5});
+    std::atomic<int> fired{0};
+    int64_t start = net::AsioTimerWheel::now_ms();
+    int64_t first_ms = 0;
+    wheel->Schedule(30, [&]() {
+        first_ms = net::AsioTimerWheel::now_ms() - start;
+        ++fired;
+        // 回调中继续挂
+        wheel->Schedule(10, [&]() { ++fired; });
+    });
+    auto cancelled = wheel->Schedule(20, [&]() { fired += 100; });
+    CHECK(wheel->Cancel(cancelled));
+    // 轮空后驱动停表，io_context自然退出
+    io.run();
+    CHECK(fired == 2);
+    CHECK(first_ms >= 30 && first_ms < 500);
+    CHECK(wheel->size() == 0);
+
+    // 其他线程挂定时器
+    io.restart();
+    auto work = boost::asio::make_work_guard(io);
+    std::thread th([&]() { io.run(); });
+    std::thread producer([&]() {
+        for (int i = 0; i < 100; ++i) {
+            wheel->Schedule(i % 20, [&]() { ++fired; });
+        }
+    });
+    producer.join();
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(3);
+    while (fired < 102 && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    CHECK(fired == 102);
+    wheel->Schedule(100000, [&]() { ++fired; });
+    wheel->Stop();
+    CHECK(wheel->Schedule(10, [&]() { ++fired; }) == 0);
+    work.reset();
+    th.join();
+    CHECK(fired == 102);
+}
+
+int main() {
+    test_basic();
+    test_cascade();
+    test_reschedule_and_reentrancy();
+    test_scale();
+    test_asio_driver();
+    if (failures) {
+        std::cerr << failures << " check(s) failed" << std::endl;
+        return 1;
+    }
+    std::cout << "test_timer_wheel passed" << std::endl;
+    return 0;
+}
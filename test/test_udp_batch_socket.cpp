@@ -0,0 +1,95 @@
+#include <iostream>
+#include <vector>
+#include <chrono>
+#include <memory>
+#include <thread>
+#include "media/rtp_udp_sender.h"
+
+static int failures = 0;
+#define CHECK(cond) do { if (!(cond)) { std::cerr << "CHECK failed: " #cond " at line " << __LINE__ << std::endl; ++failures; } } while (0)
+
+/// @brief 回环上发一帧RTP（STAP-A + 多个等长FU-A），批量接收后逐包比对
+static void test_loopback_batch() {
+    ASIO::IoContext ctx;
+    auto loopback = boost::asio::ip::make_address("127.0.0.1");
+    net::UdpBatchSocket rx(ctx, ASIO::UdpEndpoint(loopback, 0));
+    net::UdpBatchSocket tx(ctx, ASIO::UdpEndpoint(loopback, 0));
+
+    std::vector<uint8_t> au = {0, 0, 0, 1, 0x67, 0x42, 0x00, 0x1f, 0, 0, 0, 1, 0x68, 0xce, 0, 0, 1, 0x65};
+    for (int i = 0; i < 20000; ++i) {
+        au.push_back(static_cast<uint8_t>(i % 251 + 2));
+    }
+    H264RtpPacketizer::Config cfg;
+    cfg.mtu = 1200;
+    H264RtpPacketizer packetizer(cfg);
+    RtpPacketBatch batch;
+    packetizer.PacketizeAnnexB(au.data(), au.size(), 0, batch);
+
+    RtpUdpSender sender(tx);
+    int sent = sender.Send(rx.local_endpoint(), batch);
+    CHECK(sent == static_cast<int>(batch.size()));
+
+    std::vector<std::vector<uint8_t>> received;
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(2);
+    while (received.size() < batch.size() && std::chrono::steady_clock::now() < deadline) {
+        int n = rx.ReceiveBatch();
+        if (n <= 0) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            continue;
+        }
+        for (int i = 0; i < n; ++i) {
+            const auto& d = rx.datagrams()[i];
+            CHECK(!d.truncated);
+            CHECK(d.from.port() == tx.local_endpoint().port());
+            received.emplace_back(d.data, d.data + d.size);
+        }
+    }
+    CHECK(received.size() == batch.size());
+    for (std::size_t i = 0; i < received.size() && i < batch.size(); ++i) {
+        std::vector<uint8_t> expected(batch.packets[i].size);
+        batch.packets[i].Flatten(expected.data(), expected.size());
+        CHECK(received[i] == expected);
+    }
+}
+
+/// @brief StopReceive(on_stopped)在被取消的等待完成后才回调，回调里析构socket是安全的
+static void test_stop_then_destroy() {
+    ASIO::IoContext ctx;
+    auto strand = boost::asio::make_strand(ctx);
+    auto loopback = boost::asio::ip::make_address("127.0.0.1");
+    auto rx = std::make_unique<net::UdpBatchSocket>(strand, ASIO::UdpEndpoint(loopback, 0), net::UdpBatchSocket::Config{});
+    int batches = 0;
+    rx->StartReceive([&](const net::UdpDatagram*, size_t) { ++batches; }, strand);
+    bool stopped = false;
+    boost::asio::post(strand, [&]() {
+        rx->Close();
+        rx->StopReceive([&]() {
+            stopped = true;
+            rx.reset();
+        });
+    });
+    ctx.run();
+    CHECK(stopped);
+    CHECK(!rx);
+    CHECK(batches == 0);
+
+    // 没有未完成的等待时也回调（经executor转一次）
+    ctx.restart();
+    net::UdpBatchSocket idle(ctx, ASIO::UdpEndpoint(loopback, 0));
+    bool idle_stopped = false;
+    idle.StopReceive([&]() { idle_stopped = true; });
+    CHECK(!idle_stopped);
+    ctx.run();
+    CHECK(idle_stopped);
+}
+
+int main() {
+    test_loopback_batch();
+    test_stop_then_destroy();
+    if (failures) {
+        std::cerr << failures << " check(s) failed" << std::endl;
+        return 1;
+    }
+    std::cout << "test_udp_batch_socket passed" << std::endl;
+    return 0;
+}